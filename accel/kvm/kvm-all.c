@@ -618,6 +618,150 @@ static bool kvm_slot_get_dirty_log(KVMState *s, KVMSlot *slot)
     return ret == 0;
 }
 
+#define KVM_DIRTY_SYNC_MAX_WORKERS   8
+/* Minimum host pages per merge chunk; smaller slots are merged inline */
+#define KVM_DIRTY_SYNC_CHUNK_PAGES   (256 * 1024)
+
+typedef struct KVMDirtySyncJob {
+    KVMSlot *slot;          /* non-NULL: fetch this slot's log from KVM */
+    unsigned long *bitmap;  /* non-NULL: merge this piece of a slot bitmap */
+    ram_addr_t start;
+    ram_addr_t pages;
+    bool ok;
+} KVMDirtySyncJob;
+
+/*
+ * Worker pool for syncing large dirty bitmaps.  Jobs are only ever
+ * dispatched by the sync caller, which holds the slots lock, so a single
+ * static batch description is enough.
+ */
+static struct {
+    int n_workers;
+    QemuThread workers[KVM_DIRTY_SYNC_MAX_WORKERS];
+    QemuSemaphore start_sem;    /* posted once per worker per batch */
+    QemuSemaphore done_sem;     /* posted once per worker per batch */
+    KVMDirtySyncJob *jobs;
+    int n_jobs;
+    int next_job;               /* workers pull jobs with fetch-inc */
+} dirty_sync;
+
+static void kvm_dirty_sync_run_job(KVMDirtySyncJob *job)
+{
+    if (job->slot) {
+        job->ok = kvm_slot_get_dirty_log(kvm_state, job->slot);
+    } else {
+        cpu_physical_memory_set_dirty_lebitmap(job->bitmap, job->start,
+                                               job->pages);
+    }
+}
+
+static void *kvm_dirty_sync_worker_thread(void *data)
+{
+    rcu_register_thread();
+
+    while (true) {
+        qemu_sem_wait(&dirty_sync.start_sem);
+        while (true) {
+            int i = qatomic_fetch_inc(&dirty_sync.next_job);
+
+            if (i >= dirty_sync.n_jobs) {
+                break;
+            }
+            kvm_dirty_sync_run_job(&dirty_sync.jobs[i]);
+        }
+        qemu_sem_post(&dirty_sync.done_sem);
+    }
+
+    rcu_unregister_thread();
+
+    return NULL;
+}
+
+static void kvm_dirty_sync_pool_init(void)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int i;
+
+    dirty_sync.n_workers = MIN(MAX(cpus, 1), KVM_DIRTY_SYNC_MAX_WORKERS);
+    qemu_sem_init(&dirty_sync.start_sem, 0);
+    qemu_sem_init(&dirty_sync.done_sem, 0);
+    for (i = 0; i < dirty_sync.n_workers; i++) {
+        qemu_thread_create(&dirty_sync.workers[i], "kvm-dirty-sync",
+                           kvm_dirty_sync_worker_thread,
+                           NULL, QEMU_THREAD_JOINABLE);
+    }
+}
+
+/* Run @jobs on the worker pool, helping out, and wait for completion */
+static void kvm_dirty_sync_run(KVMDirtySyncJob *jobs, int n_jobs)
+{
+    int i;
+
+    if (!dirty_sync.n_workers) {
+        kvm_dirty_sync_pool_init();
+    }
+
+    dirty_sync.jobs = jobs;
+    dirty_sync.n_jobs = n_jobs;
+    qatomic_set(&dirty_sync.next_job, 0);
+    for (i = 0; i < dirty_sync.n_workers; i++) {
+        qemu_sem_post(&dirty_sync.start_sem);
+    }
+    while (true) {
+        i = qatomic_fetch_inc(&dirty_sync.next_job);
+        if (i >= n_jobs) {
+            break;
+        }
+        kvm_dirty_sync_run_job(&jobs[i]);
+    }
+    for (i = 0; i < dirty_sync.n_workers; i++) {
+        qemu_sem_wait(&dirty_sync.done_sem);
+    }
+    dirty_sync.jobs = NULL;
+    dirty_sync.n_jobs = 0;
+}
+
+/*
+ * The word-by-word fast path in cpu_physical_memory_set_dirty_lebitmap()
+ * requires the slot to start on a bitmap word boundary and host and target
+ * page sizes to match; the parallel merge keeps to the same conditions so
+ * every chunk stays on that path.  total_dirty_pages is updated without
+ * atomics, so stay serial while dirty-rate measurement is running.
+ */
+static bool kvm_slot_can_sync_parallel(KVMSlot *slot, ram_addr_t pages)
+{
+    unsigned long page = slot->ram_start_offset >> TARGET_PAGE_BITS;
+
+    return qemu_real_host_page_size() == TARGET_PAGE_SIZE &&
+           !(page % BITS_PER_LONG) &&
+           pages >= 2 * KVM_DIRTY_SYNC_CHUNK_PAGES &&
+           !(global_dirty_tracking & GLOBAL_DIRTY_DIRTY_RATE);
+}
+
+/* As kvm_slot_sync_dirty_pages(), splitting the bitmap across the pool */
+static void kvm_slot_sync_dirty_pages_parallel(KVMSlot *slot,
+                                               ram_addr_t pages)
+{
+    g_autofree KVMDirtySyncJob *jobs = NULL;
+    ram_addr_t chunk, off;
+    int n_jobs = 0;
+
+    if (!dirty_sync.n_workers) {
+        kvm_dirty_sync_pool_init();
+    }
+    chunk = QEMU_ALIGN_UP(DIV_ROUND_UP(pages, dirty_sync.n_workers + 1),
+                          BITS_PER_LONG);
+    jobs = g_new0(KVMDirtySyncJob, DIV_ROUND_UP(pages, chunk));
+    for (off = 0; off < pages; off += chunk) {
+        jobs[n_jobs++] = (KVMDirtySyncJob) {
+            .bitmap = slot->dirty_bmap + BIT_WORD(off),
+            .start = slot->ram_start_offset + off * TARGET_PAGE_SIZE,
+            .pages = MIN(chunk, pages - off),
+        };
+    }
+    kvm_dirty_sync_run(jobs, n_jobs);
+}
+
 /* Should be with all slots_lock held for the address spaces. */
 static void kvm_dirty_ring_mark_page(KVMState *s, uint32_t as_id,
                                      uint32_t slot_id, uint64_t offset)
@@ -830,25 +974,52 @@ static void kvm_dirty_ring_flush(void)
 static void kvm_physical_sync_dirty_bitmap(KVMMemoryListener *kml,
                                            MemoryRegionSection *section)
 {
-    KVMState *s = kvm_state;
-    KVMSlot *mem;
+    g_autofree KVMDirtySyncJob *jobs = NULL;
     hwaddr start_addr, size;
     hwaddr slot_size;
+    int n_slots = 0, i;
 
     size = kvm_align_section(section, &start_addr);
+    if (!size) {
+        return;
+    }
+
+    jobs = g_new0(KVMDirtySyncJob,
+                  DIV_ROUND_UP(size, MIN(kvm_max_slot_size, size)));
     while (size) {
+        KVMSlot *mem;
+
         slot_size = MIN(kvm_max_slot_size, size);
         mem = kvm_lookup_matching_slot(kml, start_addr, slot_size);
         if (!mem) {
             /* We don't have a slot if we want to trap every access. */
             return;
         }
-        if (kvm_slot_get_dirty_log(s, mem)) {
-            kvm_slot_sync_dirty_pages(mem);
-        }
+        jobs[n_slots++] = (KVMDirtySyncJob) { .slot = mem };
         start_addr += slot_size;
         size -= slot_size;
     }
+
+    /* Fetch the logs, in parallel when the section spans several slots */
+    if (n_slots > 1) {
+        kvm_dirty_sync_run(jobs, n_slots);
+    } else {
+        kvm_dirty_sync_run_job(&jobs[0]);
+    }
+
+    for (i = 0; i < n_slots; i++) {
+        KVMSlot *mem = jobs[i].slot;
+        ram_addr_t pages = mem->memory_size / qemu_real_host_page_size();
+
+        if (!jobs[i].ok) {
+            continue;
+        }
+        if (kvm_slot_can_sync_parallel(mem, pages)) {
+            kvm_slot_sync_dirty_pages_parallel(mem, pages);
+        } else {
+            kvm_slot_sync_dirty_pages(mem);
+        }
+    }
 }
 
 /* Alignment requirement for KVM_CLEAR_DIRTY_LOG - 64 pages */
@@ -1389,9 +1560,10 @@ static void *kvm_dirty_ring_reaper_thread(void *data)
         r->reaper_state = KVM_DIRTY_RING_REAPER_WAIT;
         trace_kvm_dirty_ring_reaper("wait");
         /*
-         * TODO: provide a smarter timeout rather than a constant?
+         * Collect in the background once per second, or right away when
+         * a vcpu hits a full ring and kicks us.
          */
-        sleep(1);
+        qemu_sem_timedwait(&r->reaper_sem, 1000);
 
         /* keep sleeping so that dirtylimit not be interfered by reaper */
         if (dirtylimit_in_service()) {
@@ -1419,11 +1591,18 @@ static void kvm_dirty_ring_reaper_init(KVMState *s)
 {
     struct KVMDirtyRingReaper *r = &s->reaper;
 
+    qemu_sem_init(&r->reaper_sem, 0);
     qemu_thread_create(&r->reaper_thr, "kvm-reaper",
                        kvm_dirty_ring_reaper_thread,
                        s, QEMU_THREAD_JOINABLE);
 }
 
+/* Ask the reaper thread to collect all vcpu rings as soon as possible */
+static void kvm_dirty_ring_reaper_kick(KVMState *s)
+{
+    qemu_sem_post(&s->reaper.reaper_sem);
+}
+
 static int kvm_dirty_ring_init(KVMState *s)
 {
     uint32_t ring_size = s->kvm_dirty_ring_size;
@@ -2664,6 +2843,19 @@ static int kvm_handle_internal_error(CPUState *cpu, struct kvm_run *run)
     return -1;
 }
 
+/* Does the write target a region that only wants the last value? */
+static bool kvm_coalesced_write_mergeable(struct kvm_coalesced_mmio *ent)
+{
+    AddressSpace *as = ent->pio ? &address_space_io : &address_space_memory;
+    hwaddr xlat, len = ent->len;
+    MemoryRegion *mr;
+
+    RCU_READ_LOCK_GUARD();
+    mr = address_space_translate(as, ent->phys_addr, &xlat, &len,
+                                 true, MEMTXATTRS_UNSPECIFIED);
+    return len >= ent->len && memory_region_get_coalesced_write_merging(mr);
+}
+
 void kvm_flush_coalesced_mmio_buffer(void)
 {
     KVMState *s = kvm_state;
@@ -2677,10 +2869,37 @@ void kvm_flush_coalesced_mmio_buffer(void)
     if (s->coalesced_mmio_ring) {
         struct kvm_coalesced_mmio_ring *ring = s->coalesced_mmio_ring;
         while (ring->first != ring->last) {
-            struct kvm_coalesced_mmio *ent;
+            struct kvm_coalesced_mmio *ent, *next;
+            uint32_t peek;
+            int merge = -1; /* lazily resolved for this run */
 
             ent = &ring->coalesced_mmio[ring->first];
 
+            /*
+             * Collapse a run of writes to the same posted register when
+             * the device asked for it, delivering only the last value.
+             * The translation is only looked up once a run is seen.
+             */
+            peek = (ring->first + 1) % KVM_COALESCED_MMIO_MAX;
+            while (peek != ring->last) {
+                next = &ring->coalesced_mmio[peek];
+                if (next->pio != ent->pio ||
+                    next->phys_addr != ent->phys_addr ||
+                    next->len != ent->len) {
+                    break;
+                }
+                if (merge < 0) {
+                    merge = kvm_coalesced_write_mergeable(ent);
+                }
+                if (!merge) {
+                    break;
+                }
+                ent = next;
+                smp_wmb();
+                ring->first = peek;
+                peek = (peek + 1) % KVM_COALESCED_MMIO_MAX;
+            }
+
             if (ent->pio == 1) {
                 address_space_write(&address_space_io, ent->phys_addr,
                                     MEMTXATTRS_UNSPECIFIED, ent->data,
@@ -2944,17 +3163,17 @@ int kvm_cpu_exec(CPUState *cpu)
             trace_kvm_dirty_ring_full(cpu->cpu_index);
             bql_lock();
             /*
-             * We throttle vCPU by making it sleep once it exit from kernel
-             * due to dirty ring full. In the dirtylimit scenario, reaping
-             * all vCPUs after a single vCPU dirty ring get full result in
-             * the miss of sleep, so just reap the ring-fulled vCPU.
+             * Only drain the ring that is actually full so the vcpu can
+             * resume quickly, and leave the other rings to the reaper
+             * thread.  This also keeps the dirtylimit throttle working:
+             * reaping all vCPUs after a single ring gets full would make
+             * the others miss their sleep.
              */
-            if (dirtylimit_in_service()) {
-                kvm_dirty_ring_reap(kvm_state, cpu);
-            } else {
-                kvm_dirty_ring_reap(kvm_state, NULL);
-            }
+            kvm_dirty_ring_reap(kvm_state, cpu);
             bql_unlock();
+            if (!dirtylimit_in_service()) {
+                kvm_dirty_ring_reaper_kick(kvm_state);
+            }
             dirtylimit_vcpu_execute(cpu);
             ret = 0;
             break;
@@ -30,24 +30,28 @@
 # define DATA_TYPE  aligned_uint64_t
 # define SDATA_TYPE aligned_int64_t
 # define BSWAP      bswap64
+# define LD_HE      ldq_he_p
 # define SHIFT      3
 #elif DATA_SIZE == 4
 # define SUFFIX     l
 # define DATA_TYPE  uint32_t
 # define SDATA_TYPE int32_t
 # define BSWAP      bswap32
+# define LD_HE      ldl_he_p
 # define SHIFT      2
 #elif DATA_SIZE == 2
 # define SUFFIX     w
 # define DATA_TYPE  uint16_t
 # define SDATA_TYPE int16_t
 # define BSWAP      bswap16
+# define LD_HE      lduw_he_p
 # define SHIFT      1
 #elif DATA_SIZE == 1
 # define SUFFIX     b
 # define DATA_TYPE  uint8_t
 # define SDATA_TYPE int8_t
 # define BSWAP
+# define LD_HE      ldub_p
 # define SHIFT      0
 #else
 # error unsupported data size
@@ -59,6 +63,38 @@
 # define ABI_TYPE  uint32_t
 #endif
 
+/*
+ * Operations at an address not aligned to DATA_SIZE are emulated via a
+ * host compare-and-swap on the naturally aligned quantity containing
+ * the operand, see cmpxchg_unaligned.  atomic_mmu_lookup has already
+ * excluded operands that no host primitive covers.
+ */
+#if DATA_SIZE > 1 && DATA_SIZE < 16
+# define UNALIGNED(haddr)  unlikely((uintptr_t)(haddr) & (DATA_SIZE - 1))
+
+static DATA_TYPE glue(cmpxchg_unal_, SUFFIX)(CPUState *cpu, uintptr_t ra,
+                                             DATA_TYPE *haddr,
+                                             DATA_TYPE cmpv, DATA_TYPE newv)
+{
+    uint64_t old;
+
+    if (HOST_BIG_ENDIAN) {
+        cmpv = BSWAP(cmpv);
+        newv = BSWAP(newv);
+    }
+    old = cmpxchg_unaligned(cpu, ra, haddr, DATA_SIZE, cmpv, newv);
+    return HOST_BIG_ENDIAN ? BSWAP((DATA_TYPE)old) : (DATA_TYPE)old;
+}
+
+# define CMPXCHG_UNAL(env, ra, haddr, cmpv, newv) \
+    glue(cmpxchg_unal_, SUFFIX)(env_cpu(env), ra, (DATA_TYPE *)(haddr), \
+                                cmpv, newv)
+#else
+# define UNALIGNED(haddr)  false
+# define CMPXCHG_UNAL(env, ra, haddr, cmpv, newv) \
+    qatomic_cmpxchg__nocheck((DATA_TYPE *)(haddr), cmpv, newv)
+#endif
+
 /* Define host-endian atomic operations.  Note that END is used within
    the ATOMIC_NAME macro, and redefined below.  */
 #if DATA_SIZE == 1
@@ -80,7 +116,11 @@ ABI_TYPE ATOMIC_NAME(cmpxchg)(CPUArchState *env, abi_ptr addr,
 #if DATA_SIZE == 16
     ret = atomic16_cmpxchg(haddr, cmpv, newv);
 #else
-    ret = qatomic_cmpxchg__nocheck(haddr, cmpv, newv);
+    if (UNALIGNED(haddr)) {
+        ret = CMPXCHG_UNAL(env, retaddr, haddr, cmpv, newv);
+    } else {
+        ret = qatomic_cmpxchg__nocheck(haddr, cmpv, newv);
+    }
 #endif
     ATOMIC_MMU_CLEANUP;
     atomic_trace_rmw_post(env, addr, oi);
@@ -95,33 +135,61 @@ ABI_TYPE ATOMIC_NAME(xchg)(CPUArchState *env, abi_ptr addr, ABI_TYPE val,
                                          DATA_SIZE, retaddr);
     DATA_TYPE ret;
 
-    ret = qatomic_xchg__nocheck(haddr, val);
+    if (UNALIGNED(haddr)) {
+        DATA_TYPE ldo, ldn = LD_HE(haddr);
+
+        do {
+            ldo = ldn;
+            ldn = CMPXCHG_UNAL(env, retaddr, haddr, ldo, val);
+        } while (ldn != ldo);
+        ret = ldn;
+    } else {
+        ret = qatomic_xchg__nocheck(haddr, val);
+    }
     ATOMIC_MMU_CLEANUP;
     atomic_trace_rmw_post(env, addr, oi);
     return ret;
 }
 
-#define GEN_ATOMIC_HELPER(X)                                        \
+#define GEN_ATOMIC_HELPER(X, FN, RET)                               \
 ABI_TYPE ATOMIC_NAME(X)(CPUArchState *env, abi_ptr addr,            \
                         ABI_TYPE val, MemOpIdx oi, uintptr_t retaddr) \
 {                                                                   \
     DATA_TYPE *haddr, ret;                                          \
     haddr = atomic_mmu_lookup(env_cpu(env), addr, oi, DATA_SIZE, retaddr);   \
-    ret = qatomic_##X(haddr, val);                                  \
+    if (UNALIGNED(haddr)) {                                         \
+        DATA_TYPE old, new, cmp = LD_HE(haddr);                     \
+        do {                                                        \
+            old = cmp; new = FN(old, val);                          \
+            cmp = CMPXCHG_UNAL(env, retaddr, haddr, old, new);      \
+        } while (cmp != old);                                       \
+        ret = RET;                                                  \
+    } else {                                                        \
+        ret = qatomic_##X(haddr, val);                              \
+    }                                                               \
     ATOMIC_MMU_CLEANUP;                                             \
     atomic_trace_rmw_post(env, addr, oi);                           \
     return ret;                                                     \
 }
 
-GEN_ATOMIC_HELPER(fetch_add)
-GEN_ATOMIC_HELPER(fetch_and)
-GEN_ATOMIC_HELPER(fetch_or)
-GEN_ATOMIC_HELPER(fetch_xor)
-GEN_ATOMIC_HELPER(add_fetch)
-GEN_ATOMIC_HELPER(and_fetch)
-GEN_ATOMIC_HELPER(or_fetch)
-GEN_ATOMIC_HELPER(xor_fetch)
+#define ADD(X, Y)   (X + Y)
+#define AND(X, Y)   (X & Y)
+#define OR(X, Y)    (X | Y)
+#define XOR(X, Y)   (X ^ Y)
+
+GEN_ATOMIC_HELPER(fetch_add, ADD, old)
+GEN_ATOMIC_HELPER(fetch_and, AND, old)
+GEN_ATOMIC_HELPER(fetch_or, OR, old)
+GEN_ATOMIC_HELPER(fetch_xor, XOR, old)
+GEN_ATOMIC_HELPER(add_fetch, ADD, new)
+GEN_ATOMIC_HELPER(and_fetch, AND, new)
+GEN_ATOMIC_HELPER(or_fetch, OR, new)
+GEN_ATOMIC_HELPER(xor_fetch, XOR, new)
 
+#undef ADD
+#undef AND
+#undef OR
+#undef XOR
 #undef GEN_ATOMIC_HELPER
 
 /*
@@ -139,11 +207,19 @@ ABI_TYPE ATOMIC_NAME(X)(CPUArchState *env, abi_ptr addr,            \
     XDATA_TYPE *haddr, cmp, old, new, val = xval;                   \
     haddr = atomic_mmu_lookup(env_cpu(env), addr, oi, DATA_SIZE, retaddr);   \
     smp_mb();                                                       \
-    cmp = qatomic_read__nocheck(haddr);                             \
-    do {                                                            \
-        old = cmp; new = FN(old, val);                              \
-        cmp = qatomic_cmpxchg__nocheck(haddr, old, new);            \
-    } while (cmp != old);                                           \
+    if (UNALIGNED(haddr)) {                                         \
+        cmp = LD_HE(haddr);                                         \
+        do {                                                        \
+            old = cmp; new = FN(old, val);                          \
+            cmp = CMPXCHG_UNAL(env, retaddr, haddr, old, new);      \
+        } while (cmp != old);                                       \
+    } else {                                                        \
+        cmp = qatomic_read__nocheck(haddr);                         \
+        do {                                                        \
+            old = cmp; new = FN(old, val);                          \
+            cmp = qatomic_cmpxchg__nocheck(haddr, old, new);        \
+        } while (cmp != old);                                       \
+    }                                                               \
     ATOMIC_MMU_CLEANUP;                                             \
     atomic_trace_rmw_post(env, addr, oi);                           \
     return RET;                                                     \
@@ -185,7 +261,11 @@ ABI_TYPE ATOMIC_NAME(cmpxchg)(CPUArchState *env, abi_ptr addr,
 #if DATA_SIZE == 16
     ret = atomic16_cmpxchg(haddr, BSWAP(cmpv), BSWAP(newv));
 #else
-    ret = qatomic_cmpxchg__nocheck(haddr, BSWAP(cmpv), BSWAP(newv));
+    if (UNALIGNED(haddr)) {
+        ret = CMPXCHG_UNAL(env, retaddr, haddr, BSWAP(cmpv), BSWAP(newv));
+    } else {
+        ret = qatomic_cmpxchg__nocheck(haddr, BSWAP(cmpv), BSWAP(newv));
+    }
 #endif
     ATOMIC_MMU_CLEANUP;
     atomic_trace_rmw_post(env, addr, oi);
@@ -200,31 +280,57 @@ ABI_TYPE ATOMIC_NAME(xchg)(CPUArchState *env, abi_ptr addr, ABI_TYPE val,
                                          DATA_SIZE, retaddr);
     ABI_TYPE ret;
 
-    ret = qatomic_xchg__nocheck(haddr, BSWAP(val));
+    if (UNALIGNED(haddr)) {
+        DATA_TYPE ldo, ldn = LD_HE(haddr);
+
+        do {
+            ldo = ldn;
+            ldn = CMPXCHG_UNAL(env, retaddr, haddr, ldo, BSWAP(val));
+        } while (ldn != ldo);
+        ret = ldn;
+    } else {
+        ret = qatomic_xchg__nocheck(haddr, BSWAP(val));
+    }
     ATOMIC_MMU_CLEANUP;
     atomic_trace_rmw_post(env, addr, oi);
     return BSWAP(ret);
 }
 
-#define GEN_ATOMIC_HELPER(X)                                        \
+#define GEN_ATOMIC_HELPER(X, FN, RET)                               \
 ABI_TYPE ATOMIC_NAME(X)(CPUArchState *env, abi_ptr addr,            \
                         ABI_TYPE val, MemOpIdx oi, uintptr_t retaddr) \
 {                                                                   \
     DATA_TYPE *haddr, ret;                                          \
     haddr = atomic_mmu_lookup(env_cpu(env), addr, oi, DATA_SIZE, retaddr);   \
-    ret = qatomic_##X(haddr, BSWAP(val));                           \
+    if (UNALIGNED(haddr)) {                                         \
+        DATA_TYPE old, new, cmp = LD_HE(haddr);                     \
+        do {                                                        \
+            old = cmp; new = FN(old, BSWAP(val));                   \
+            cmp = CMPXCHG_UNAL(env, retaddr, haddr, old, new);      \
+        } while (cmp != old);                                       \
+        ret = RET;                                                  \
+    } else {                                                        \
+        ret = qatomic_##X(haddr, BSWAP(val));                       \
+    }                                                               \
     ATOMIC_MMU_CLEANUP;                                             \
     atomic_trace_rmw_post(env, addr, oi);                           \
     return BSWAP(ret);                                              \
 }
 
-GEN_ATOMIC_HELPER(fetch_and)
-GEN_ATOMIC_HELPER(fetch_or)
-GEN_ATOMIC_HELPER(fetch_xor)
-GEN_ATOMIC_HELPER(and_fetch)
-GEN_ATOMIC_HELPER(or_fetch)
-GEN_ATOMIC_HELPER(xor_fetch)
+#define AND(X, Y)   (X & Y)
+#define OR(X, Y)    (X | Y)
+#define XOR(X, Y)   (X ^ Y)
+
+GEN_ATOMIC_HELPER(fetch_and, AND, old)
+GEN_ATOMIC_HELPER(fetch_or, OR, old)
+GEN_ATOMIC_HELPER(fetch_xor, XOR, old)
+GEN_ATOMIC_HELPER(and_fetch, AND, new)
+GEN_ATOMIC_HELPER(or_fetch, OR, new)
+GEN_ATOMIC_HELPER(xor_fetch, XOR, new)
 
+#undef AND
+#undef OR
+#undef XOR
 #undef GEN_ATOMIC_HELPER
 
 /* These helpers are, as a whole, full barriers.  Within the helper,
@@ -241,11 +347,19 @@ ABI_TYPE ATOMIC_NAME(X)(CPUArchState *env, abi_ptr addr,            \
     XDATA_TYPE *haddr, ldo, ldn, old, new, val = xval;              \
     haddr = atomic_mmu_lookup(env_cpu(env), addr, oi, DATA_SIZE, retaddr);   \
     smp_mb();                                                       \
-    ldn = qatomic_read__nocheck(haddr);                             \
-    do {                                                            \
-        ldo = ldn; old = BSWAP(ldo); new = FN(old, val);            \
-        ldn = qatomic_cmpxchg__nocheck(haddr, ldo, BSWAP(new));     \
-    } while (ldo != ldn);                                           \
+    if (UNALIGNED(haddr)) {                                         \
+        ldn = LD_HE(haddr);                                         \
+        do {                                                        \
+            ldo = ldn; old = BSWAP(ldo); new = FN(old, val);        \
+            ldn = CMPXCHG_UNAL(env, retaddr, haddr, ldo, BSWAP(new)); \
+        } while (ldo != ldn);                                       \
+    } else {                                                        \
+        ldn = qatomic_read__nocheck(haddr);                         \
+        do {                                                        \
+            ldo = ldn; old = BSWAP(ldo); new = FN(old, val);        \
+            ldn = qatomic_cmpxchg__nocheck(haddr, ldo, BSWAP(new)); \
+        } while (ldo != ldn);                                       \
+    }                                                               \
     ATOMIC_MMU_CLEANUP;                                             \
     atomic_trace_rmw_post(env, addr, oi);                           \
     return RET;                                                     \
@@ -281,3 +395,6 @@ GEN_ATOMIC_HELPER_FN(add_fetch, ADD, DATA_TYPE, new)
 #undef SUFFIX
 #undef DATA_SIZE
 #undef SHIFT
+#undef LD_HE
+#undef UNALIGNED
+#undef CMPXCHG_UNAL
@@ -144,6 +144,17 @@ static void init_delay_params(SyncClocks *sc, const CPUState *cpu)
 }
 #endif /* CONFIG USER ONLY */
 
+/* Insn budget for first-tier translations with two-tier-tb enabled. */
+#define TCG_TIER1_INSN_BUDGET   32
+/* Number of executions after which a first-tier TB is recompiled. */
+#define TCG_TIER2_EXEC_THRESHOLD 512
+/* cflags added for a first-tier translation ... */
+#define TCG_TIER1_CFLAGS \
+    (CF_TIER1 | CF_NO_GOTO_TB | CF_NO_GOTO_PTR | TCG_TIER1_INSN_BUDGET)
+/* ... and cleared again when the TB is promoted to the second tier. */
+#define TCG_TIER1_CFLAGS_MASK \
+    (CF_TIER1 | CF_NO_GOTO_TB | CF_NO_GOTO_PTR | CF_COUNT_MASK)
+
 uint32_t curr_cflags(CPUState *cpu)
 {
     uint32_t cflags = cpu->tcg_cflags;
@@ -161,6 +172,13 @@ uint32_t curr_cflags(CPUState *cpu)
         cflags |= CF_NO_GOTO_TB | 1;
     } else if (qemu_loglevel_mask(CPU_LOG_TB_NOCHAIN)) {
         cflags |= CF_NO_GOTO_TB;
+    } else if (qatomic_read(&two_tier_tb)) {
+        /*
+         * First-tier blocks are kept short and unchained, so that every
+         * execution comes back through tb_lookup and bumps exec_count;
+         * hot blocks are then recompiled at full size with chaining.
+         */
+        cflags |= TCG_TIER1_CFLAGS;
     }
 
     return cflags;
@@ -232,7 +250,8 @@ static TranslationBlock *tb_htable_lookup(CPUState *cpu, vaddr pc,
     desc.page_addr0 = phys_pc;
     h = tb_hash_func(phys_pc, (cflags & CF_PCREL ? 0 : pc),
                      flags, cs_base, cflags);
-    return qht_lookup_custom(&tb_ctx.htable, &desc, h, tb_lookup_cmp);
+    return qht_lookup_custom(tb_htable_shard(phys_pc), &desc, h,
+                             tb_lookup_cmp);
 }
 
 /* Might cause an exception, so have a longjmp destination ready */
@@ -243,10 +262,24 @@ static inline TranslationBlock *tb_lookup(CPUState *cpu, vaddr pc,
     TranslationBlock *tb;
     CPUJumpCache *jc;
     uint32_t hash;
+    unsigned set;
 
     /* we should never be trying to look up an INVALID tb */
     tcg_debug_assert(!(cflags & CF_INVALID));
 
+    /*
+     * With two-tier-tb, this pc may already have been promoted to a
+     * full-size translation under the second-tier cflags; prefer it.
+     * For hot code this resolves from the jump cache immediately.
+     */
+    if (unlikely(cflags & CF_TIER1)) {
+        tb = tb_lookup(cpu, pc, cs_base, flags,
+                       cflags & ~TCG_TIER1_CFLAGS_MASK);
+        if (tb) {
+            return tb;
+        }
+    }
+
     hash = tb_jmp_cache_hash_func(pc);
     jc = cpu->tb_jmp_cache;
 
@@ -259,11 +292,44 @@ static inline TranslationBlock *tb_lookup(CPUState *cpu, vaddr pc,
         goto hit;
     }
 
+    /*
+     * Probe the victim tier before falling through to the qht lookup.
+     * On a hit, swap the victim entry with the direct-mapped one, so
+     * that two PCs aliasing to the same slot keep ping-ponging between
+     * the two tiers instead of being re-resolved through the hash table.
+     */
+    set = tb_jmp_cache_victim_set(hash);
+    for (int way = 0; way < TB_JMP_VICTIM_WAYS; way++) {
+        TranslationBlock *vtb = qatomic_read(&jc->victim[set].way[way].tb);
+
+        if (vtb &&
+            jc->victim[set].way[way].pc == pc &&
+            vtb->cs_base == cs_base &&
+            vtb->flags == flags &&
+            tb_cflags(vtb) == cflags) {
+            jc->victim[set].way[way].pc = jc->array[hash].pc;
+            qatomic_set(&jc->victim[set].way[way].tb, tb);
+            jc->array[hash].pc = pc;
+            qatomic_set(&jc->array[hash].tb, vtb);
+            tb = vtb;
+            goto hit;
+        }
+    }
+
     tb = tb_htable_lookup(cpu, pc, cs_base, flags, cflags);
     if (tb == NULL) {
         return NULL;
     }
 
+    /* Park the displaced entry in the victim tier, round-robin per set. */
+    if (qatomic_read(&jc->array[hash].tb)) {
+        unsigned way = jc->victim[set].next_way++ % TB_JMP_VICTIM_WAYS;
+
+        jc->victim[set].way[way].pc = jc->array[hash].pc;
+        qatomic_set(&jc->victim[set].way[way].tb,
+                    qatomic_read(&jc->array[hash].tb));
+    }
+
     jc->array[hash].pc = pc;
     qatomic_set(&jc->array[hash].tb, tb);
 
@@ -997,6 +1063,27 @@ cpu_exec_loop(CPUState *cpu, SyncClocks *sc)
                 jc = cpu->tb_jmp_cache;
                 jc->array[h].pc = pc;
                 qatomic_set(&jc->array[h].tb, tb);
+            } else if (unlikely(tb_cflags(tb) & CF_TIER1) &&
+                       qatomic_fetch_inc(&tb->exec_count)
+                       == TCG_TIER2_EXEC_THRESHOLD) {
+                CPUJumpCache *jc;
+                uint32_t h;
+
+                /*
+                 * The block has proven hot: replace the first-tier copy
+                 * with a full-size, chainable translation.  The fetch-inc
+                 * equality test ensures only one vCPU does the recompile.
+                 */
+                cflags &= ~TCG_TIER1_CFLAGS_MASK;
+                mmap_lock();
+                tb_phys_invalidate(tb, -1);
+                tb = tb_gen_code(cpu, pc, cs_base, flags, cflags);
+                mmap_unlock();
+
+                h = tb_jmp_cache_hash_func(pc);
+                jc = cpu->tb_jmp_cache;
+                jc->array[h].pc = pc;
+                qatomic_set(&jc->array[h].tb, tb);
             }
 
 #ifndef CONFIG_USER_ONLY
@@ -1012,6 +1099,34 @@ cpu_exec_loop(CPUState *cpu, SyncClocks *sc)
 #endif
             /* See if we can patch the calling TB. */
             if (last_tb) {
+                /*
+                 * With two-tier-tb, a hot predecessor that leaves a
+                 * known constant in a global lets us chain to a copy of
+                 * the successor specialized on that constant.  The
+                 * specialized TB re-checks the assumption on entry, so
+                 * a stale or colliding specialization (two vCPUs racing
+                 * with different values) only costs a side exit.
+                 */
+                if (qatomic_read(&two_tier_tb)
+                    && last_tb->exit_spec_reg[tb_exit] >= 0
+                    && !(tb_cflags(tb) & (CF_TIER1 | CF_SPEC))) {
+                    uint32_t spec_cflags = tb_cflags(tb) | CF_SPEC;
+                    TranslationBlock *spec;
+
+                    spec = tb_lookup(cpu, pc, cs_base, flags, spec_cflags);
+                    if (spec == NULL) {
+                        tcg_ctx->tb_entry_spec_reg =
+                            last_tb->exit_spec_reg[tb_exit];
+                        tcg_ctx->tb_entry_spec_val =
+                            last_tb->exit_spec_val[tb_exit];
+                        mmap_lock();
+                        spec = tb_gen_code(cpu, pc, cs_base, flags,
+                                           spec_cflags);
+                        mmap_unlock();
+                        tcg_ctx->tb_entry_spec_reg = -1;
+                    }
+                    tb = spec;
+                }
                 tb_add_jump(last_tb, tb_exit, tb);
             }
 
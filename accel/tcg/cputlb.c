@@ -100,6 +100,8 @@ static void tlb_window_reset(CPUTLBDesc *desc, int64_t ns,
 {
     desc->window_begin_ns = ns;
     desc->window_max_entries = max_entries;
+    desc->window_vtlb_hits = desc->vtlb_hits;
+    desc->window_walk_count = desc->walk_count;
 }
 
 static void tb_jmp_cache_clear_page(CPUState *cpu, vaddr page_addr)
@@ -115,6 +117,16 @@ static void tb_jmp_cache_clear_page(CPUState *cpu, vaddr page_addr)
     for (i = 0; i < TB_JMP_PAGE_SIZE; i++) {
         qatomic_set(&jc->array[i0 + i].tb, NULL);
     }
+
+    /* The victim tier is small enough to scan in full. */
+    for (i = 0; i < TB_JMP_VICTIM_SETS; i++) {
+        for (int way = 0; way < TB_JMP_VICTIM_WAYS; way++) {
+            if (jc->victim[i].way[way].tb &&
+                (jc->victim[i].way[way].pc & TARGET_PAGE_MASK) == page_addr) {
+                qatomic_set(&jc->victim[i].way[way].tb, NULL);
+            }
+        }
+    }
 }
 
 /**
@@ -163,6 +175,7 @@ static void tlb_mmu_resize_locked(CPUTLBDesc *desc, CPUTLBDescFast *fast,
     size_t old_size = tlb_n_entries(fast);
     size_t rate;
     size_t new_size = old_size;
+    size_t new_vsize = desc->vsize;
     int64_t window_len_ms = 100;
     int64_t window_len_ns = window_len_ms * 1000 * 1000;
     bool window_expired = now > desc->window_begin_ns + window_len_ns;
@@ -172,6 +185,30 @@ static void tlb_mmu_resize_locked(CPUTLBDesc *desc, CPUTLBDescFast *fast,
     }
     rate = desc->window_max_entries * 100 / old_size;
 
+    /*
+     * Size the victim table from the same window: if the victim tier
+     * absorbed a large share of the fast-tlb misses, growing it is
+     * likely to absorb more; if it was barely hit, shrink it back.
+     */
+    if (window_expired) {
+        size_t vhits = desc->vtlb_hits - desc->window_vtlb_hits;
+        size_t walks = desc->walk_count - desc->window_walk_count;
+
+        if (vhits * 2 > walks) {
+            new_vsize = MIN(desc->vsize << 1, CPU_VTLB_MAX_SIZE);
+        } else if (vhits * 16 < walks) {
+            new_vsize = MAX(desc->vsize >> 1, CPU_VTLB_MIN_SIZE);
+        }
+    }
+    if (new_vsize != desc->vsize) {
+        g_free(desc->vtable);
+        g_free(desc->vfulltlb);
+        desc->vsize = new_vsize;
+        desc->vtable = g_new(CPUTLBEntry, new_vsize);
+        desc->vfulltlb = g_new(CPUTLBEntryFull, new_vsize);
+        desc->vindex = 0;
+    }
+
     if (rate > 70) {
         new_size = MIN(old_size << 1, 1 << CPU_TLB_DYN_MAX_BITS);
     } else if (rate < 30 && window_expired) {
@@ -239,7 +276,7 @@ static void tlb_mmu_flush_locked(CPUTLBDesc *desc, CPUTLBDescFast *fast)
     desc->large_page_mask = -1;
     desc->vindex = 0;
     memset(fast->table, -1, sizeof_tlb(fast));
-    memset(desc->vtable, -1, sizeof(desc->vtable));
+    memset(desc->vtable, -1, desc->vsize * sizeof(CPUTLBEntry));
 }
 
 static void tlb_flush_one_mmuidx_locked(CPUState *cpu, int mmu_idx,
@@ -256,11 +293,16 @@ static void tlb_mmu_init(CPUTLBDesc *desc, CPUTLBDescFast *fast, int64_t now)
 {
     size_t n_entries = 1 << CPU_TLB_DYN_DEFAULT_BITS;
 
+    desc->vtlb_hits = 0;
+    desc->walk_count = 0;
     tlb_window_reset(desc, now, 0);
     desc->n_used_entries = 0;
     fast->mask = (n_entries - 1) << CPU_TLB_ENTRY_BITS;
     fast->table = g_new(CPUTLBEntry, n_entries);
     desc->fulltlb = g_new(CPUTLBEntryFull, n_entries);
+    desc->vsize = CPU_VTLB_MIN_SIZE;
+    desc->vtable = g_new(CPUTLBEntry, desc->vsize);
+    desc->vfulltlb = g_new(CPUTLBEntryFull, desc->vsize);
     tlb_mmu_flush_locked(desc, fast);
 }
 
@@ -300,6 +342,8 @@ void tlb_destroy(CPUState *cpu)
 
         g_free(fast->table);
         g_free(desc->fulltlb);
+        g_free(desc->vtable);
+        g_free(desc->vfulltlb);
     }
 }
 
@@ -460,7 +504,7 @@ static void tlb_flush_vtlb_page_mask_locked(CPUState *cpu, int mmu_idx,
     int k;
 
     assert_cpu_is_self(cpu);
-    for (k = 0; k < CPU_VTLB_SIZE; k++) {
+    for (k = 0; k < d->vsize; k++) {
         if (tlb_flush_entry_mask_locked(&d->vtable[k], page, mask)) {
             tlb_n_used_entries_dec(cpu, mmu_idx);
         }
@@ -926,6 +970,122 @@ void tlb_flush_range_by_mmuidx_all_cpus_synced(CPUState *src_cpu,
                           RUN_ON_CPU_HOST_PTR(p));
 }
 
+typedef struct {
+    vaddr addr;
+    vaddr len;
+} TLBFlushRun;
+
+typedef struct {
+    uint16_t idxmap;
+    uint16_t nruns;
+    TLBFlushRun runs[];
+} TLBFlushPageListData;
+
+static void tlb_flush_page_list_by_mmuidx_async_1(CPUState *cpu,
+                                                  run_on_cpu_data data)
+{
+    TLBFlushPageListData *d = data.host_ptr;
+    int mmu_idx;
+
+    assert_cpu_is_self(cpu);
+
+    tlb_debug("page list: %u runs mmu_map:0x%x\n", d->nruns, d->idxmap);
+
+    /* Process all runs in a single pass over the locked TLB. */
+    qemu_spin_lock(&cpu->neg.tlb.c.lock);
+    for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
+        if ((d->idxmap >> mmu_idx) & 1) {
+            for (int i = 0; i < d->nruns; i++) {
+                tlb_flush_range_locked(cpu, mmu_idx, d->runs[i].addr,
+                                       d->runs[i].len, TARGET_LONG_BITS);
+            }
+        }
+    }
+    qemu_spin_unlock(&cpu->neg.tlb.c.lock);
+
+    for (int i = 0; i < d->nruns; i++) {
+        vaddr addr = d->runs[i].addr - TARGET_PAGE_SIZE;
+
+        for (vaddr j = 0, n = d->runs[i].len / TARGET_PAGE_SIZE + 1;
+             j < n; j++) {
+            tb_jmp_cache_clear_page(cpu, addr);
+            addr += TARGET_PAGE_SIZE;
+        }
+    }
+    g_free(d);
+}
+
+static int tlb_flush_page_cmp(const void *ap, const void *bp)
+{
+    vaddr a = *(const vaddr *)ap;
+    vaddr b = *(const vaddr *)bp;
+
+    return a < b ? -1 : a > b;
+}
+
+void tlb_flush_page_list_by_mmuidx_all_cpus_synced(CPUState *src_cpu,
+                                                   const vaddr *pages,
+                                                   size_t num_pages,
+                                                   uint16_t idxmap)
+{
+    g_autofree vaddr *sorted = NULL;
+    TLBFlushPageListData *d;
+    CPUState *dst_cpu;
+    size_t size, nruns;
+
+    if (num_pages == 0) {
+        return;
+    }
+    if (num_pages == 1) {
+        tlb_flush_page_by_mmuidx_all_cpus_synced(src_cpu, pages[0], idxmap);
+        return;
+    }
+    if (num_pages > UINT16_MAX) {
+        /* A full flush is cheaper than walking a list this long. */
+        tlb_flush_by_mmuidx_all_cpus_synced(src_cpu, idxmap);
+        return;
+    }
+
+    /* Sort the pages and coalesce adjacent ones into runs. */
+    sorted = g_memdup2(pages, num_pages * sizeof(vaddr));
+    for (size_t i = 0; i < num_pages; i++) {
+        sorted[i] &= TARGET_PAGE_MASK;
+    }
+    qsort(sorted, num_pages, sizeof(vaddr), tlb_flush_page_cmp);
+
+    size = sizeof(*d) + num_pages * sizeof(TLBFlushRun);
+    d = g_malloc(size);
+    d->idxmap = idxmap;
+    nruns = 0;
+    for (size_t i = 0; i < num_pages; i++) {
+        if (nruns &&
+            d->runs[nruns - 1].addr + d->runs[nruns - 1].len == sorted[i]) {
+            d->runs[nruns - 1].len += TARGET_PAGE_SIZE;
+        } else if (nruns && d->runs[nruns - 1].addr + d->runs[nruns - 1].len
+                   > sorted[i]) {
+            /* duplicate page */
+            continue;
+        } else {
+            d->runs[nruns].addr = sorted[i];
+            d->runs[nruns].len = TARGET_PAGE_SIZE;
+            nruns++;
+        }
+    }
+    d->nruns = nruns;
+    size = sizeof(*d) + nruns * sizeof(TLBFlushRun);
+
+    /* Allocate a separate data block for each destination cpu.  */
+    CPU_FOREACH(dst_cpu) {
+        if (dst_cpu != src_cpu) {
+            async_run_on_cpu(dst_cpu, tlb_flush_page_list_by_mmuidx_async_1,
+                             RUN_ON_CPU_HOST_PTR(g_memdup2(d, size)));
+        }
+    }
+
+    async_safe_run_on_cpu(src_cpu, tlb_flush_page_list_by_mmuidx_async_1,
+                          RUN_ON_CPU_HOST_PTR(d));
+}
+
 void tlb_flush_page_bits_by_mmuidx_all_cpus_synced(CPUState *src_cpu,
                                                    vaddr addr,
                                                    uint16_t idxmap,
@@ -1020,7 +1180,7 @@ void tlb_reset_dirty(CPUState *cpu, ram_addr_t start1, ram_addr_t length)
                                          start1, length);
         }
 
-        for (i = 0; i < CPU_VTLB_SIZE; i++) {
+        for (i = 0; i < cpu->neg.tlb.d[mmu_idx].vsize; i++) {
             tlb_reset_dirty_range_locked(&cpu->neg.tlb.d[mmu_idx].vtable[i],
                                          start1, length);
         }
@@ -1053,7 +1213,7 @@ void tlb_set_dirty(CPUState *cpu, vaddr addr)
 
     for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
         int k;
-        for (k = 0; k < CPU_VTLB_SIZE; k++) {
+        for (k = 0; k < cpu->neg.tlb.d[mmu_idx].vsize; k++) {
             tlb_set_dirty1_locked(&cpu->neg.tlb.d[mmu_idx].vtable[k], addr);
         }
     }
@@ -1125,6 +1285,7 @@ void tlb_set_page_full(CPUState *cpu, int mmu_idx,
     bool is_ram, is_romd;
 
     assert_cpu_is_self(cpu);
+    qatomic_set(&desc->walk_count, desc->walk_count + 1);
 
     if (full->lg_page_size <= TARGET_PAGE_BITS) {
         sz = TARGET_PAGE_SIZE;
@@ -1217,7 +1378,7 @@ void tlb_set_page_full(CPUState *cpu, int mmu_idx,
      * different page; otherwise just overwrite the stale data.
      */
     if (!tlb_hit_page_anyprot(te, addr_page) && !tlb_entry_is_empty(te)) {
-        unsigned vidx = desc->vindex++ % CPU_VTLB_SIZE;
+        unsigned vidx = desc->vindex++ % desc->vsize;
         CPUTLBEntry *tv = &desc->vtable[vidx];
 
         /* Evict the old entry into the victim tlb.  */
@@ -1359,10 +1520,11 @@ static void io_failed(CPUState *cpu, CPUTLBEntryFull *full, vaddr addr,
 static bool victim_tlb_hit(CPUState *cpu, size_t mmu_idx, size_t index,
                            MMUAccessType access_type, vaddr page)
 {
+    CPUTLBDesc *desc = &cpu->neg.tlb.d[mmu_idx];
     size_t vidx;
 
     assert_cpu_is_self(cpu);
-    for (vidx = 0; vidx < CPU_VTLB_SIZE; ++vidx) {
+    for (vidx = 0; vidx < desc->vsize; ++vidx) {
         CPUTLBEntry *vtlb = &cpu->neg.tlb.d[mmu_idx].vtable[vidx];
         uint64_t cmp = tlb_read_idx(vtlb, access_type);
 
@@ -1380,6 +1542,7 @@ static bool victim_tlb_hit(CPUState *cpu, size_t mmu_idx, size_t index,
             CPUTLBEntryFull *f2 = &cpu->neg.tlb.d[mmu_idx].vfulltlb[vidx];
             CPUTLBEntryFull tmpf;
             tmpf = *f1; *f1 = *f2; *f2 = tmpf;
+            qatomic_set(&desc->vtlb_hits, desc->vtlb_hits + 1);
             return true;
         }
     }
@@ -1864,8 +2027,9 @@ static bool mmu_lookup(CPUState *cpu, vaddr addr, MemOpIdx oi,
 }
 
 /*
- * Probe for an atomic operation.  Do not allow unaligned operations,
- * or io operations to proceed.  Return the host address.
+ * Probe for an atomic operation.  Do not allow io operations, or
+ * unaligned operations that no host compare-and-swap can cover, to
+ * proceed.  Return the host address.
  */
 static void *atomic_mmu_lookup(CPUState *cpu, vaddr addr, MemOpIdx oi,
                                int size, uintptr_t retaddr)
@@ -1893,11 +2057,17 @@ static void *atomic_mmu_lookup(CPUState *cpu, vaddr addr, MemOpIdx oi,
 
     /* Enforce qemu required alignment.  */
     if (unlikely(addr & (size - 1))) {
-        /* We get here if guest alignment was not requested,
-           or was not enforced by cpu_unaligned_access above.
-           We might widen the access and emulate, but for now
-           mark an exception and exit the cpu loop.  */
-        goto stop_the_world;
+        /*
+         * We get here if guest alignment was not requested, or was not
+         * enforced by cpu_unaligned_access above.  If a host compare-
+         * and-swap covers the naturally aligned quantity containing the
+         * operand, the helpers emulate the access with a cmpxchg loop;
+         * otherwise mark an exception and exit the cpu loop.
+         */
+        if (!(HAVE_al8 && (addr & 7) + size <= 8)
+            && !(HAVE_CMPXCHG128 && (addr & 15) + size <= 16)) {
+            goto stop_the_world;
+        }
     }
 
     index = tlb_index(cpu, mmu_idx, addr);
@@ -2050,6 +2220,12 @@ static uint64_t do_ld_mmio_beN(CPUState *cpu, CPUTLBEntryFull *full,
     section = io_prepare(&mr_offset, cpu, full->xlat_section, attrs, addr, ra);
     mr = section->mr;
 
+    /* Regions with side-effect-free reads may dispatch without the BQL. */
+    if (mr->lockless_read) {
+        return int_ld_mmio_beN(cpu, full, ret_be, addr, size, mmu_idx,
+                               type, ra, mr, mr_offset);
+    }
+
     BQL_LOCK_GUARD();
     return int_ld_mmio_beN(cpu, full, ret_be, addr, size, mmu_idx,
                            type, ra, mr, mr_offset);
@@ -2071,6 +2247,14 @@ static Int128 do_ld16_mmio_beN(CPUState *cpu, CPUTLBEntryFull *full,
     section = io_prepare(&mr_offset, cpu, full->xlat_section, attrs, addr, ra);
     mr = section->mr;
 
+    if (mr->lockless_read) {
+        a = int_ld_mmio_beN(cpu, full, ret_be, addr, size - 8, mmu_idx,
+                            MMU_DATA_LOAD, ra, mr, mr_offset);
+        b = int_ld_mmio_beN(cpu, full, ret_be, addr + size - 8, 8, mmu_idx,
+                            MMU_DATA_LOAD, ra, mr, mr_offset + size - 8);
+        return int128_make128(b, a);
+    }
+
     BQL_LOCK_GUARD();
     a = int_ld_mmio_beN(cpu, full, ret_be, addr, size - 8, mmu_idx,
                         MMU_DATA_LOAD, ra, mr, mr_offset);
@@ -94,6 +94,7 @@ static inline vaddr log_pc(CPUState *cpu, const TranslationBlock *tb)
 }
 
 extern bool one_insn_per_tb;
+extern bool two_tier_tb;
 
 /**
  * tcg_req_mo:
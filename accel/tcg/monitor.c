@@ -141,9 +141,25 @@ static void tlb_flush_counts(size_t *pfull, size_t *ppart, size_t *pelide)
     *pelide = elide;
 }
 
+static void tlb_miss_counts(size_t *pvhits, size_t *pwalks)
+{
+    CPUState *cpu;
+    size_t vhits = 0, walks = 0;
+
+    CPU_FOREACH(cpu) {
+        for (int i = 0; i < NB_MMU_MODES; i++) {
+            vhits += qatomic_read(&cpu->neg.tlb.d[i].vtlb_hits);
+            walks += qatomic_read(&cpu->neg.tlb.d[i].walk_count);
+        }
+    }
+    *pvhits = vhits;
+    *pwalks = walks;
+}
+
 static void tcg_dump_info(GString *buf)
 {
-    g_string_append_printf(buf, "[TCG profiler not compiled]\n");
+    g_string_append_printf(buf, "\nTranslation cost:\n");
+    tcg_dump_stats(buf);
 }
 
 static void dump_exec_info(GString *buf)
@@ -151,6 +167,7 @@ static void dump_exec_info(GString *buf)
     struct tb_tree_stats tst = {};
     struct qht_stats hst;
     size_t nb_tbs, flush_full, flush_part, flush_elide;
+    size_t victim_hits, walks;
 
     tcg_tb_foreach(tb_tree_stats_iter, &tst);
     nb_tbs = tst.nb_tbs;
@@ -182,9 +199,12 @@ static void dump_exec_info(GString *buf)
                            tst.direct_jmp2_count,
                            nb_tbs ? (tst.direct_jmp2_count * 100) / nb_tbs : 0);
 
-    qht_statistics_init(&tb_ctx.htable, &hst);
-    print_qht_statistics(hst, buf);
-    qht_statistics_destroy(&hst);
+    for (int i = 0; i < TB_HTABLE_SHARDS; i++) {
+        g_string_append_printf(buf, "TB hash shard       %d\n", i);
+        qht_statistics_init(&tb_ctx.htable[i], &hst);
+        print_qht_statistics(hst, buf);
+        qht_statistics_destroy(&hst);
+    }
 
     g_string_append_printf(buf, "\nStatistics:\n");
     g_string_append_printf(buf, "TB flush count      %u\n",
@@ -196,6 +216,10 @@ static void dump_exec_info(GString *buf)
     g_string_append_printf(buf, "TLB full flushes    %zu\n", flush_full);
     g_string_append_printf(buf, "TLB partial flushes %zu\n", flush_part);
     g_string_append_printf(buf, "TLB elided flushes  %zu\n", flush_elide);
+
+    tlb_miss_counts(&victim_hits, &walks);
+    g_string_append_printf(buf, "TLB victim hits     %zu\n", victim_hits);
+    g_string_append_printf(buf, "TLB page walks      %zu\n", walks);
     tcg_dump_info(buf);
 }
 
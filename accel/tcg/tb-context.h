@@ -26,11 +26,20 @@
 #define CODE_GEN_HTABLE_BITS     15
 #define CODE_GEN_HTABLE_SIZE     (1 << CODE_GEN_HTABLE_BITS)
 
+/*
+ * The TB hash table is split into independently locked and resized
+ * shards, selected by bits of the physical page number, so that vCPUs
+ * concurrently looking up or inserting TBs rarely contend on the same
+ * qht instance.
+ */
+#define TB_HTABLE_SHARD_BITS     3
+#define TB_HTABLE_SHARDS         (1 << TB_HTABLE_SHARD_BITS)
+
 typedef struct TBContext TBContext;
 
 struct TBContext {
 
-    struct qht htable;
+    struct qht htable[TB_HTABLE_SHARDS];
 
     /* statistics */
     unsigned tb_flush_count;
@@ -23,6 +23,7 @@
 #include "exec/cpu-defs.h"
 #include "exec/exec-all.h"
 #include "qemu/xxhash.h"
+#include "tb-context.h"
 #include "tb-jmp-cache.h"
 
 #ifdef CONFIG_SOFTMMU
@@ -67,4 +68,17 @@ uint32_t tb_hash_func(tb_page_addr_t phys_pc, vaddr pc,
     return qemu_xxhash8(phys_pc, pc, flags2, flags, cf_mask);
 }
 
+/*
+ * Select the hash table shard for @phys_pc.  Mix bits above the page
+ * number so that both large contiguous code regions and page-aliased
+ * mappings spread across the shards.
+ */
+static inline struct qht *tb_htable_shard(tb_page_addr_t phys_pc)
+{
+    tb_page_addr_t page = phys_pc >> TARGET_PAGE_BITS;
+
+    return &tb_ctx.htable[(page ^ (page >> TB_HTABLE_SHARD_BITS))
+                          & (TB_HTABLE_SHARDS - 1)];
+}
+
 #endif
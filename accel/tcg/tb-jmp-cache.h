@@ -12,6 +12,16 @@
 #define TB_JMP_CACHE_BITS 12
 #define TB_JMP_CACHE_SIZE (1 << TB_JMP_CACHE_BITS)
 
+/*
+ * Small set-associative victim tier behind the direct-mapped array.
+ * Entries displaced from the main array are parked here, so that two
+ * hot PCs aliasing to the same direct-mapped slot do not thrash
+ * straight into the qht lookup.
+ */
+#define TB_JMP_VICTIM_WAYS     4
+#define TB_JMP_VICTIM_SET_BITS 6
+#define TB_JMP_VICTIM_SETS     (1 << TB_JMP_VICTIM_SET_BITS)
+
 /*
  * Invalidated in parallel; all accesses to 'tb' must be atomic.
  * A valid entry is read/written by a single CPU, therefore there is
@@ -25,6 +35,18 @@ struct CPUJumpCache {
         TranslationBlock *tb;
         vaddr pc;
     } array[TB_JMP_CACHE_SIZE];
+    struct {
+        struct {
+            TranslationBlock *tb;
+            vaddr pc;
+        } way[TB_JMP_VICTIM_WAYS];
+        unsigned next_way;
+    } victim[TB_JMP_VICTIM_SETS];
 };
 
+static inline unsigned int tb_jmp_cache_victim_set(uint32_t hash)
+{
+    return hash & (TB_JMP_VICTIM_SETS - 1);
+}
+
 #endif /* ACCEL_TCG_TB_JMP_CACHE_H */
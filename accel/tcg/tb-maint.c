@@ -58,8 +58,12 @@ static bool tb_cmp(const void *ap, const void *bp)
 void tb_htable_init(void)
 {
     unsigned int mode = QHT_MODE_AUTO_RESIZE;
+    int i;
 
-    qht_init(&tb_ctx.htable, tb_cmp, CODE_GEN_HTABLE_SIZE, mode);
+    for (i = 0; i < TB_HTABLE_SHARDS; i++) {
+        qht_init(&tb_ctx.htable[i], tb_cmp,
+                 CODE_GEN_HTABLE_SIZE >> TB_HTABLE_SHARD_BITS, mode);
+    }
 }
 
 typedef struct PageDesc PageDesc;
@@ -180,8 +184,8 @@ static void *l1_map[V_L1_MAX_SIZE];
 
 struct PageDesc {
     QemuSpin lock;
-    /* list of TBs intersecting this ram page */
-    uintptr_t first_tb;
+    /* TBs intersecting this ram page, keyed by their byte range on it */
+    IntervalTreeRoot itree;
 };
 
 void page_table_config_init(void)
@@ -308,9 +312,22 @@ struct page_collection {
     struct page_entry *max;
 };
 
-typedef int PageForEachNext;
-#define PAGE_FOR_EACH_TB(start, last, pagedesc, tb, n) \
-    TB_FOR_EACH_TAGGED((pagedesc)->first_tb, tb, n, page_next)
+typedef IntervalTreeNode *PageForEachNext;
+
+static inline TranslationBlock *page_node_tb(IntervalTreeNode *n)
+{
+    return container_of(n, struct PageTBNode, itree)->tb;
+}
+
+/*
+ * The iterator is advanced before the body runs, so the current TB
+ * may be invalidated (removing its node) from within the loop.
+ */
+#define PAGE_FOR_EACH_TB(start, last, pagedesc, tb, n)                  \
+    for (n = interval_tree_iter_first(&(pagedesc)->itree, start, last); \
+         n != NULL                                                      \
+         && ((tb) = page_node_tb(n),                                    \
+             (n) = interval_tree_iter_next((n), start, last), true); )
 
 #ifdef CONFIG_DEBUG_TCG
 
@@ -629,7 +646,9 @@ static struct page_collection *page_collection_lock(tb_page_addr_t start,
             goto retry;
         }
         assert_page_locked(pd);
-        PAGE_FOR_EACH_TB(unused, unused, pd, tb, n) {
+        PAGE_FOR_EACH_TB(index << TARGET_PAGE_BITS,
+                         (index << TARGET_PAGE_BITS) | ~TARGET_PAGE_MASK,
+                         pd, tb, n) {
             if (page_trylock_add(set, tb_page_addr0(tb)) ||
                 (tb_page_addr1(tb) != -1 &&
                  page_trylock_add(set, tb_page_addr1(tb)))) {
@@ -649,7 +668,7 @@ static void page_collection_unlock(struct page_collection *set)
     g_free(set);
 }
 
-/* Set to NULL all the 'first_tb' fields in all PageDescs. */
+/* Empty the TB interval tree in all PageDescs. */
 static void tb_remove_all_1(int level, void **lp)
 {
     int i;
@@ -662,7 +681,7 @@ static void tb_remove_all_1(int level, void **lp)
 
         for (i = 0; i < V_L2_SIZE; ++i) {
             page_lock(&pd[i]);
-            pd[i].first_tb = (uintptr_t)NULL;
+            memset(&pd[i].itree, 0, sizeof(pd[i].itree));
             page_unlock(&pd[i]);
         }
     } else {
@@ -689,13 +708,24 @@ static void tb_remove_all(void)
  */
 static void tb_page_add(PageDesc *p, TranslationBlock *tb, unsigned int n)
 {
+    struct PageTBNode *pn = &tb->page_node[n];
+    tb_page_addr_t tb_last = tb_page_addr0(tb) + tb->size - 1;
     bool page_already_protected;
 
     assert_page_locked(p);
 
-    tb->page_next[n] = p->first_tb;
-    page_already_protected = p->first_tb != 0;
-    p->first_tb = (uintptr_t)tb | n;
+    /* Clip the TB's code range to the part that lies on this page. */
+    pn->tb = tb;
+    if (n == 0) {
+        pn->itree.start = tb_page_addr0(tb);
+        pn->itree.last = MIN(tb_last,
+                             tb_page_addr0(tb) | ~TARGET_PAGE_MASK);
+    } else {
+        pn->itree.start = tb_page_addr1(tb);
+        pn->itree.last = tb_page_addr1(tb) + (tb_last & ~TARGET_PAGE_MASK);
+    }
+    page_already_protected = !interval_tree_is_empty(&p->itree);
+    interval_tree_insert(&pn->itree, &p->itree);
 
     /*
      * If some code is already present, then the pages are already
@@ -712,7 +742,7 @@ static void tb_record(TranslationBlock *tb)
     tb_page_addr_t paddr0 = tb_page_addr0(tb);
     tb_page_addr_t paddr1 = tb_page_addr1(tb);
     tb_page_addr_t pindex0 = paddr0 >> TARGET_PAGE_BITS;
-    tb_page_addr_t pindex1 = paddr0 >> TARGET_PAGE_BITS;
+    tb_page_addr_t pindex1 = paddr1 >> TARGET_PAGE_BITS;
 
     assert(paddr0 != -1);
     if (unlikely(paddr1 != -1) && pindex0 != pindex1) {
@@ -721,22 +751,10 @@ static void tb_record(TranslationBlock *tb)
     tb_page_add(page_find_alloc(pindex0, false), tb, 0);
 }
 
-static void tb_page_remove(PageDesc *pd, TranslationBlock *tb)
+static void tb_page_remove(PageDesc *pd, TranslationBlock *tb, unsigned int n)
 {
-    TranslationBlock *tb1;
-    uintptr_t *pprev;
-    PageForEachNext n1;
-
     assert_page_locked(pd);
-    pprev = &pd->first_tb;
-    PAGE_FOR_EACH_TB(unused, unused, pd, tb1, n1) {
-        if (tb1 == tb) {
-            *pprev = tb1->page_next[n1];
-            return;
-        }
-        pprev = &tb1->page_next[n1];
-    }
-    g_assert_not_reached();
+    interval_tree_remove(&tb->page_node[n].itree, &pd->itree);
 }
 
 static void tb_remove(TranslationBlock *tb)
@@ -744,13 +762,13 @@ static void tb_remove(TranslationBlock *tb)
     tb_page_addr_t paddr0 = tb_page_addr0(tb);
     tb_page_addr_t paddr1 = tb_page_addr1(tb);
     tb_page_addr_t pindex0 = paddr0 >> TARGET_PAGE_BITS;
-    tb_page_addr_t pindex1 = paddr0 >> TARGET_PAGE_BITS;
+    tb_page_addr_t pindex1 = paddr1 >> TARGET_PAGE_BITS;
 
     assert(paddr0 != -1);
     if (unlikely(paddr1 != -1) && pindex0 != pindex1) {
-        tb_page_remove(page_find_alloc(pindex1, false), tb);
+        tb_page_remove(page_find_alloc(pindex1, false), tb, 1);
     }
-    tb_page_remove(page_find_alloc(pindex0, false), tb);
+    tb_page_remove(page_find_alloc(pindex0, false), tb, 0);
 }
 #endif /* CONFIG_USER_ONLY */
 
@@ -770,7 +788,10 @@ static void do_tb_flush(CPUState *cpu, run_on_cpu_data tb_flush_count)
         tcg_flush_jmp_cache(cpu);
     }
 
-    qht_reset_size(&tb_ctx.htable, CODE_GEN_HTABLE_SIZE);
+    for (int i = 0; i < TB_HTABLE_SHARDS; i++) {
+        qht_reset_size(&tb_ctx.htable[i],
+                       CODE_GEN_HTABLE_SIZE >> TB_HTABLE_SHARD_BITS);
+    }
     tb_remove_all();
 
     tcg_region_reset_all();
@@ -885,6 +906,7 @@ static void tb_jmp_cache_inval_tb(TranslationBlock *tb)
         }
     } else {
         uint32_t h = tb_jmp_cache_hash_func(tb->pc);
+        unsigned set = tb_jmp_cache_victim_set(h);
 
         CPU_FOREACH(cpu) {
             CPUJumpCache *jc = cpu->tb_jmp_cache;
@@ -892,6 +914,11 @@ static void tb_jmp_cache_inval_tb(TranslationBlock *tb)
             if (qatomic_read(&jc->array[h].tb) == tb) {
                 qatomic_set(&jc->array[h].tb, NULL);
             }
+            for (int way = 0; way < TB_JMP_VICTIM_WAYS; way++) {
+                if (qatomic_read(&jc->victim[set].way[way].tb) == tb) {
+                    qatomic_set(&jc->victim[set].way[way].tb, NULL);
+                }
+            }
         }
     }
 }
@@ -918,7 +945,7 @@ static void do_tb_phys_invalidate(TranslationBlock *tb, bool rm_from_page_list)
     phys_pc = tb_page_addr0(tb);
     h = tb_hash_func(phys_pc, (orig_cflags & CF_PCREL ? 0 : tb->pc),
                      tb->flags, tb->cs_base, orig_cflags);
-    if (!qht_remove(&tb_ctx.htable, tb, h)) {
+    if (!qht_remove(tb_htable_shard(phys_pc), tb, h)) {
         return;
     }
 
@@ -985,7 +1012,7 @@ TranslationBlock *tb_link_page(TranslationBlock *tb)
     /* add in the hash table */
     h = tb_hash_func(tb_page_addr0(tb), (tb->cflags & CF_PCREL ? 0 : tb->pc),
                      tb->flags, tb->cs_base, tb->cflags);
-    qht_insert(&tb_ctx.htable, tb, h, &existing_tb);
+    qht_insert(tb_htable_shard(tb_page_addr0(tb)), tb, h, &existing_tb);
 
     /* remove TB from the page(s) if we couldn't insert it */
     if (unlikely(existing_tb)) {
@@ -1110,42 +1137,30 @@ tb_invalidate_phys_page_range__locked(struct page_collection *pages,
     tcg_debug_assert(((start ^ last) & TARGET_PAGE_MASK) == 0);
 
     /*
-     * We remove all the TBs in the range [start, last].
-     * XXX: see if in some cases it could be faster to invalidate all the code
+     * We remove all the TBs in the range [start, last].  The page
+     * interval tree hands back only the TBs whose code bytes truly
+     * overlap the written range; the rest of the page is not scanned.
      */
     PAGE_FOR_EACH_TB(start, last, p, tb, n) {
-        tb_page_addr_t tb_start, tb_last;
-
-        /* NOTE: this is subtle as a TB may span two physical pages */
-        tb_start = tb_page_addr0(tb);
-        tb_last = tb_start + tb->size - 1;
-        if (n == 0) {
-            tb_last = MIN(tb_last, tb_start | ~TARGET_PAGE_MASK);
-        } else {
-            tb_start = tb_page_addr1(tb);
-            tb_last = tb_start + (tb_last & ~TARGET_PAGE_MASK);
-        }
-        if (!(tb_last < start || tb_start > last)) {
 #ifdef TARGET_HAS_PRECISE_SMC
-            if (current_tb == tb &&
-                (tb_cflags(current_tb) & CF_COUNT_MASK) != 1) {
-                /*
-                 * If we are modifying the current TB, we must stop
-                 * its execution. We could be more precise by checking
-                 * that the modification is after the current PC, but it
-                 * would require a specialized function to partially
-                 * restore the CPU state.
-                 */
-                current_tb_modified = true;
-                cpu_restore_state_from_tb(current_cpu, current_tb, retaddr);
-            }
-#endif /* TARGET_HAS_PRECISE_SMC */
-            tb_phys_invalidate__locked(tb);
+        if (current_tb == tb &&
+            (tb_cflags(current_tb) & CF_COUNT_MASK) != 1) {
+            /*
+             * If we are modifying the current TB, we must stop
+             * its execution. We could be more precise by checking
+             * that the modification is after the current PC, but it
+             * would require a specialized function to partially
+             * restore the CPU state.
+             */
+            current_tb_modified = true;
+            cpu_restore_state_from_tb(current_cpu, current_tb, retaddr);
         }
+#endif /* TARGET_HAS_PRECISE_SMC */
+        tb_phys_invalidate__locked(tb);
     }
 
     /* if no code remaining, no need to continue to use slow writes */
-    if (!p->first_tb) {
+    if (interval_tree_is_empty(&p->itree)) {
         tlb_unprotect_code(start);
     }
 
@@ -1169,27 +1184,39 @@ tb_invalidate_phys_page_range__locked(struct page_collection *pages,
  */
 void tb_invalidate_phys_range(tb_page_addr_t start, tb_page_addr_t last)
 {
-    struct page_collection *pages;
     tb_page_addr_t index, index_last;
 
-    pages = page_collection_lock(start, last);
-
+    /*
+     * Lock and invalidate one page at a time, rather than taking a
+     * page collection covering the whole range.  Each iteration only
+     * holds the locks for one page (plus the second pages of any
+     * spanning TBs, via page_collection_lock), so for large ranges
+     * concurrent vCPUs faulting on unrelated pages are not serialized
+     * behind the full walk, and the lock array stays small.
+     */
     index_last = last >> TARGET_PAGE_BITS;
     for (index = start >> TARGET_PAGE_BITS; index <= index_last; index++) {
+        struct page_collection *pages;
         PageDesc *pd = page_find(index);
         tb_page_addr_t page_start, page_last;
 
         if (pd == NULL) {
             continue;
         }
-        assert_page_locked(pd);
         page_start = index << TARGET_PAGE_BITS;
         page_last = page_start | ~TARGET_PAGE_MASK;
         page_last = MIN(page_last, last);
-        tb_invalidate_phys_page_range__locked(pages, pd,
-                                              page_start, page_last, 0);
+
+        pages = page_collection_lock(page_start, page_last);
+        /* The page may have lost all its TBs while unlocked. */
+        pd = page_find(index);
+        if (pd != NULL) {
+            assert_page_locked(pd);
+            tb_invalidate_phys_page_range__locked(pages, pd,
+                                                  page_start, page_last, 0);
+        }
+        page_collection_unlock(pages);
     }
-    page_collection_unlock(pages);
 }
 
 /*
@@ -45,6 +45,8 @@ struct TCGState {
 
     bool mttcg_enabled;
     bool one_insn_per_tb;
+    bool two_tier_tb;
+    bool numa_regions;
     int splitwx_enabled;
     unsigned long tb_size;
 };
@@ -99,6 +101,7 @@ static void tcg_accel_instance_init(Object *obj)
 
 bool mttcg_enabled;
 bool one_insn_per_tb;
+bool two_tier_tb;
 
 static int tcg_init_machine(MachineState *ms)
 {
@@ -207,6 +210,40 @@ static void tcg_set_one_insn_per_tb(Object *obj, bool value, Error **errp)
     qatomic_set(&one_insn_per_tb, value);
 }
 
+static bool tcg_get_numa_regions(Object *obj, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    return s->numa_regions;
+}
+
+static void tcg_set_numa_regions(Object *obj, bool value, Error **errp)
+{
+#ifndef CONFIG_NUMA
+    if (value) {
+        error_setg(errp, "numa-regions requires libnuma support");
+        return;
+    }
+#endif
+    TCGState *s = TCG_STATE(obj);
+    s->numa_regions = value;
+    /* Set the global also: this changes the behaviour */
+    qatomic_set(&tcg_numa_regions, value);
+}
+
+static bool tcg_get_two_tier_tb(Object *obj, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    return s->two_tier_tb;
+}
+
+static void tcg_set_two_tier_tb(Object *obj, bool value, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    s->two_tier_tb = value;
+    /* Set the global also: this changes the behaviour */
+    qatomic_set(&two_tier_tb, value);
+}
+
 static int tcg_gdbstub_supported_sstep_flags(void)
 {
     /*
@@ -252,6 +289,18 @@ static void tcg_accel_class_init(ObjectClass *oc, void *data)
                                    tcg_set_one_insn_per_tb);
     object_class_property_set_description(oc, "one-insn-per-tb",
         "Only put one guest insn in each translation block");
+
+    object_class_property_add_bool(oc, "two-tier-tb",
+                                   tcg_get_two_tier_tb,
+                                   tcg_set_two_tier_tb);
+    object_class_property_set_description(oc, "two-tier-tb",
+        "Translate quickly at first and recompile hot blocks at full size");
+
+    object_class_property_add_bool(oc, "numa-regions",
+                                   tcg_get_numa_regions,
+                                   tcg_set_numa_regions);
+    object_class_property_set_description(oc, "numa-regions",
+        "Bind TCG code regions to the NUMA node of the owning vCPU thread");
 }
 
 static const TypeInfo tcg_accel_type = {
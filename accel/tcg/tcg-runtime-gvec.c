@@ -24,6 +24,25 @@
 #include "tcg/tcg-gvec-desc.h"
 
 
+/*
+ * Host-vector fast paths.  Where the operation size is a multiple of
+ * 16 bytes, process the bulk of the data through the compiler's
+ * generic vector extensions, which map onto whatever the host build
+ * target provides (SSE2/AVX on x86, AdvSIMD on Arm, VSX on Power).
+ * check_size_align() in tcg-op-gvec.c guarantees that vectors of 16
+ * bytes or more are 16-byte aligned; smaller operands (oprsz == 8)
+ * take the scalar tail loop.
+ */
+#define GVEC_VECTOR_ATTR __attribute__((vector_size(16), may_alias))
+typedef uint8_t  vec8  GVEC_VECTOR_ATTR;
+typedef uint16_t vec16 GVEC_VECTOR_ATTR;
+typedef uint32_t vec32 GVEC_VECTOR_ATTR;
+typedef uint64_t vec64 GVEC_VECTOR_ATTR;
+typedef int8_t  svec8  GVEC_VECTOR_ATTR;
+typedef int16_t svec16 GVEC_VECTOR_ATTR;
+typedef int32_t svec32 GVEC_VECTOR_ATTR;
+typedef int64_t svec64 GVEC_VECTOR_ATTR;
+
 static inline void clear_high(void *d, intptr_t oprsz, uint32_t desc)
 {
     intptr_t maxsz = simd_maxsz(desc);
@@ -39,9 +58,12 @@ static inline void clear_high(void *d, intptr_t oprsz, uint32_t desc)
 void HELPER(gvec_add8)(void *d, void *a, void *b, uint32_t desc)
 {
     intptr_t oprsz = simd_oprsz(desc);
-    intptr_t i;
+    intptr_t i = 0;
 
-    for (i = 0; i < oprsz; i += sizeof(uint8_t)) {
+    for (; i + sizeof(vec8) <= oprsz; i += sizeof(vec8)) {
+        *(vec8 *)(d + i) = *(vec8 *)(a + i) + *(vec8 *)(b + i);
+    }
+    for (; i < oprsz; i += sizeof(uint8_t)) {
         *(uint8_t *)(d + i) = *(uint8_t *)(a + i) + *(uint8_t *)(b + i);
     }
     clear_high(d, oprsz, desc);
@@ -50,9 +72,12 @@ void HELPER(gvec_add8)(void *d, void *a, void *b, uint32_t desc)
 void HELPER(gvec_add16)(void *d, void *a, void *b, uint32_t desc)
 {
     intptr_t oprsz = simd_oprsz(desc);
-    intptr_t i;
+    intptr_t i = 0;
 
-    for (i = 0; i < oprsz; i += sizeof(uint16_t)) {
+    for (; i + sizeof(vec16) <= oprsz; i += sizeof(vec16)) {
+        *(vec16 *)(d + i) = *(vec16 *)(a + i) + *(vec16 *)(b + i);
+    }
+    for (; i < oprsz; i += sizeof(uint16_t)) {
         *(uint16_t *)(d + i) = *(uint16_t *)(a + i) + *(uint16_t *)(b + i);
     }
     clear_high(d, oprsz, desc);
@@ -61,9 +86,12 @@ void HELPER(gvec_add16)(void *d, void *a, void *b, uint32_t desc)
 void HELPER(gvec_add32)(void *d, void *a, void *b, uint32_t desc)
 {
     intptr_t oprsz = simd_oprsz(desc);
-    intptr_t i;
+    intptr_t i = 0;
 
-    for (i = 0; i < oprsz; i += sizeof(uint32_t)) {
+    for (; i + sizeof(vec32) <= oprsz; i += sizeof(vec32)) {
+        *(vec32 *)(d + i) = *(vec32 *)(a + i) + *(vec32 *)(b + i);
+    }
+    for (; i < oprsz; i += sizeof(uint32_t)) {
         *(uint32_t *)(d + i) = *(uint32_t *)(a + i) + *(uint32_t *)(b + i);
     }
     clear_high(d, oprsz, desc);
@@ -72,9 +100,12 @@ void HELPER(gvec_add32)(void *d, void *a, void *b, uint32_t desc)
 void HELPER(gvec_add64)(void *d, void *a, void *b, uint32_t desc)
 {
     intptr_t oprsz = simd_oprsz(desc);
-    intptr_t i;
+    intptr_t i = 0;
 
-    for (i = 0; i < oprsz; i += sizeof(uint64_t)) {
+    for (; i + sizeof(vec64) <= oprsz; i += sizeof(vec64)) {
+        *(vec64 *)(d + i) = *(vec64 *)(a + i) + *(vec64 *)(b + i);
+    }
+    for (; i < oprsz; i += sizeof(uint64_t)) {
         *(uint64_t *)(d + i) = *(uint64_t *)(a + i) + *(uint64_t *)(b + i);
     }
     clear_high(d, oprsz, desc);
@@ -1015,24 +1046,28 @@ void HELPER(gvec_rotr64v)(void *d, void *a, void *b, uint32_t desc)
     clear_high(d, oprsz, desc);
 }
 
-#define DO_CMP1(NAME, TYPE, OP)                                            \
+#define DO_CMP1(NAME, TYPE, VTYPE, OP)                                     \
 void HELPER(NAME)(void *d, void *a, void *b, uint32_t desc)                \
 {                                                                          \
     intptr_t oprsz = simd_oprsz(desc);                                     \
-    intptr_t i;                                                            \
-    for (i = 0; i < oprsz; i += sizeof(TYPE)) {                            \
+    intptr_t i = 0;                                                        \
+    for (; i + sizeof(VTYPE) <= oprsz; i += sizeof(VTYPE)) {               \
+        *(VTYPE *)(d + i) =                                                \
+            (VTYPE)(*(VTYPE *)(a + i) OP *(VTYPE *)(b + i));               \
+    }                                                                      \
+    for (; i < oprsz; i += sizeof(TYPE)) {                                 \
         *(TYPE *)(d + i) = -(*(TYPE *)(a + i) OP *(TYPE *)(b + i));        \
     }                                                                      \
     clear_high(d, oprsz, desc);                                            \
 }
 
 #define DO_CMP2(SZ) \
-    DO_CMP1(gvec_eq##SZ, uint##SZ##_t, ==)    \
-    DO_CMP1(gvec_ne##SZ, uint##SZ##_t, !=)    \
-    DO_CMP1(gvec_lt##SZ, int##SZ##_t, <)      \
-    DO_CMP1(gvec_le##SZ, int##SZ##_t, <=)     \
-    DO_CMP1(gvec_ltu##SZ, uint##SZ##_t, <)    \
-    DO_CMP1(gvec_leu##SZ, uint##SZ##_t, <=)
+    DO_CMP1(gvec_eq##SZ, uint##SZ##_t, vec##SZ, ==)    \
+    DO_CMP1(gvec_ne##SZ, uint##SZ##_t, vec##SZ, !=)    \
+    DO_CMP1(gvec_lt##SZ, int##SZ##_t, svec##SZ, <)     \
+    DO_CMP1(gvec_le##SZ, int##SZ##_t, svec##SZ, <=)    \
+    DO_CMP1(gvec_ltu##SZ, uint##SZ##_t, vec##SZ, <)    \
+    DO_CMP1(gvec_leu##SZ, uint##SZ##_t, vec##SZ, <=)
 
 DO_CMP2(8)
 DO_CMP2(16)
@@ -1561,7 +1596,13 @@ void HELPER(gvec_bitsel)(void *d, void *a, void *b, void *c, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
-    for (i = 0; i < oprsz; i += sizeof(uint64_t)) {
+    for (i = 0; i + sizeof(vec64) <= oprsz; i += sizeof(vec64)) {
+        vec64 aa = *(vec64 *)(a + i);
+        vec64 bb = *(vec64 *)(b + i);
+        vec64 cc = *(vec64 *)(c + i);
+        *(vec64 *)(d + i) = (bb & aa) | (cc & ~aa);
+    }
+    for (; i < oprsz; i += sizeof(uint64_t)) {
         uint64_t aa = *(uint64_t *)(a + i);
         uint64_t bb = *(uint64_t *)(b + i);
         uint64_t cc = *(uint64_t *)(c + i);
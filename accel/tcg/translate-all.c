@@ -428,6 +428,12 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
     }
     tb->tc.size = gen_code_size;
 
+    /* Publish what the optimizer proved at each chainable exit. */
+    tb->exit_spec_reg[0] = tcg_ctx->tb_exit_spec_reg[0];
+    tb->exit_spec_reg[1] = tcg_ctx->tb_exit_spec_reg[1];
+    tb->exit_spec_val[0] = tcg_ctx->tb_exit_spec_val[0];
+    tb->exit_spec_val[1] = tcg_ctx->tb_exit_spec_val[1];
+
     /*
      * For CF_PCREL, attribute all executions of the generated code
      * to its first mapping.
@@ -671,4 +677,9 @@ void tcg_flush_jmp_cache(CPUState *cpu)
     for (int i = 0; i < TB_JMP_CACHE_SIZE; i++) {
         qatomic_set(&jc->array[i].tb, NULL);
     }
+    for (int i = 0; i < TB_JMP_VICTIM_SETS; i++) {
+        for (int way = 0; way < TB_JMP_VICTIM_WAYS; way++) {
+            qatomic_set(&jc->victim[i].way[way].tb, NULL);
+        }
+    }
 }
@@ -117,6 +117,7 @@ void translator_loop(CPUState *cpu, TranslationBlock *tb, int *max_insns,
     uint32_t cflags = tb_cflags(tb);
     TCGOp *icount_start_insn;
     TCGOp *first_insn_start = NULL;
+    TCGLabel *spec_fail = NULL;
     bool plugin_enabled;
 
     /* Initialize DisasContext */
@@ -139,6 +140,27 @@ void translator_loop(CPUState *cpu, TranslationBlock *tb, int *max_insns,
     ops->tb_start(db, cpu);
     tcg_debug_assert(db->is_jmp == DISAS_NEXT);  /* no early exit */
 
+    /*
+     * For a specialized translation, guard the constant assumed by the
+     * chained predecessor.  If the global does not hold the expected
+     * value, side-exit before the first insn; the looked-up replacement
+     * will be the generic translation of this pc.  The brcond also
+     * teaches the optimizer the constant on the fall-through path.
+     */
+    if (unlikely(cflags & CF_SPEC) && tcg_ctx->tb_entry_spec_reg >= 0) {
+        TCGTemp *ts = &tcg_ctx->temps[tcg_ctx->tb_entry_spec_reg];
+
+        spec_fail = gen_new_label();
+        if (ts->type == TCG_TYPE_I32) {
+            tcg_gen_brcondi_i32(TCG_COND_NE, temp_tcgv_i32(ts),
+                                tcg_ctx->tb_entry_spec_val, spec_fail);
+        } else {
+            tcg_gen_brcondi_i64(TCG_COND_NE, temp_tcgv_i64(ts),
+                                tcg_ctx->tb_entry_spec_val, spec_fail);
+        }
+        tcg_ctx->tb_entry_spec_reg = -1;
+    }
+
     plugin_enabled = plugin_gen_tb_start(cpu, db, cflags & CF_MEMI_ONLY);
     db->plugin_enabled = plugin_enabled;
 
@@ -193,6 +215,12 @@ void translator_loop(CPUState *cpu, TranslationBlock *tb, int *max_insns,
     ops->tb_stop(db, cpu);
     gen_tb_end(tb, cflags, icount_start_insn, db->num_insns);
 
+    if (spec_fail) {
+        /* Nothing has executed yet, a plain exit is all that is needed. */
+        gen_set_label(spec_fail);
+        tcg_gen_exit_tb(NULL, 0);
+    }
+
     /*
      * Manage can_do_io for the translation block: set to false before
      * the first insn and set to true before the last insn.
@@ -1226,7 +1226,8 @@ uint64_t cpu_ldq_code_mmu(CPUArchState *env, abi_ptr addr,
 #include "ldst_common.c.inc"
 
 /*
- * Do not allow unaligned operations to proceed.  Return the host address.
+ * Do not allow unaligned operations that no host compare-and-swap
+ * can cover to proceed.  Return the host address.
  */
 static void *atomic_mmu_lookup(CPUState *cpu, vaddr addr, MemOpIdx oi,
                                int size, uintptr_t retaddr)
@@ -1240,8 +1241,15 @@ static void *atomic_mmu_lookup(CPUState *cpu, vaddr addr, MemOpIdx oi,
         cpu_loop_exit_sigbus(cpu, addr, MMU_DATA_STORE, retaddr);
     }
 
-    /* Enforce qemu required alignment.  */
-    if (unlikely(addr & (size - 1))) {
+    /*
+     * Enforce qemu required alignment.  The helpers emulate an
+     * unaligned operation with a cmpxchg loop on the naturally
+     * aligned quantity containing the operand, when a host
+     * compare-and-swap covers it.
+     */
+    if (unlikely(addr & (size - 1))
+        && !(HAVE_al8 && (addr & 7) + size <= 8)
+        && !(HAVE_CMPXCHG128 && (addr & 15) + size <= 16)) {
         cpu_loop_exit_atomic(cpu, retaddr);
     }
 
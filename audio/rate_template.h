@@ -34,6 +34,7 @@ void NAME (void *opaque, struct st_sample *ibuf, struct st_sample *obuf,
     struct st_sample *istart, *iend;
     struct st_sample *ostart, *oend;
     struct st_sample ilast, icur, out;
+    uint64_t n, i;
 #ifdef FLOAT_MIXENG
     mixeng_real t;
 #else
@@ -91,26 +92,37 @@ void NAME (void *opaque, struct st_sample *ibuf, struct st_sample *obuf,
             rate->opos &= 0xffffffff;
         }
 
-        /* interpolate */
+        /*
+         * Every output sample until opos catches up with ipos
+         * interpolates between the same input pair, so the whole run
+         * can be emitted in one tight loop.
+         */
+        n = DIV_ROUND_UP(((uint64_t) rate->ipos << 32) - rate->opos,
+                         rate->opos_inc);
+        n = MIN(n, (uint64_t) (oend - obuf));
+
+        for (i = 0; i < n; i++) {
+            /* interpolate */
 #ifdef FLOAT_MIXENG
 #ifdef RECIPROCAL
-        t = (rate->opos & UINT_MAX) * (1.f / UINT_MAX);
+            t = (rate->opos & UINT_MAX) * (1.f / UINT_MAX);
 #else
-        t = (rate->opos & UINT_MAX) / (mixeng_real) UINT_MAX;
+            t = (rate->opos & UINT_MAX) / (mixeng_real) UINT_MAX;
 #endif
-        out.l = (ilast.l * (1.0 - t)) + icur.l * t;
-        out.r = (ilast.r * (1.0 - t)) + icur.r * t;
+            out.l = (ilast.l * (1.0 - t)) + icur.l * t;
+            out.r = (ilast.r * (1.0 - t)) + icur.r * t;
 #else
-        t = rate->opos & 0xffffffff;
-        out.l = (ilast.l * ((int64_t) UINT_MAX - t) + icur.l * t) >> 32;
-        out.r = (ilast.r * ((int64_t) UINT_MAX - t) + icur.r * t) >> 32;
+            t = rate->opos & 0xffffffff;
+            out.l = (ilast.l * ((int64_t) UINT_MAX - t) + icur.l * t) >> 32;
+            out.r = (ilast.r * ((int64_t) UINT_MAX - t) + icur.r * t) >> 32;
 #endif
 
-        /* output sample & increment position */
-        OP (obuf->l, out.l);
-        OP (obuf->r, out.r);
-        obuf += 1;
-        rate->opos += rate->opos_inc;
+            /* output sample & increment position */
+            OP (obuf[i].l, out.l);
+            OP (obuf[i].r, out.r);
+            rate->opos += rate->opos_inc;
+        }
+        obuf += n;
     }
 
 the_end:
@@ -31,6 +31,10 @@
 
 #define BLOCK_COPY_MAX_COPY_RANGE (16 * MiB)
 #define BLOCK_COPY_MAX_BUFFER (1 * MiB)
+/* Upper bound for the adaptively grown buffered chunk size */
+#define BLOCK_COPY_MAX_BUFFER_GROWN (16 * MiB)
+/* Number of consecutive full-sized chunks before growing the chunk size */
+#define BLOCK_COPY_FULL_CHUNKS_TO_GROW 16
 #define BLOCK_COPY_MAX_MEM (128 * MiB)
 #define BLOCK_COPY_MAX_WORKERS 64
 #define BLOCK_COPY_SLICE_TIME 100000000ULL /* ns */
@@ -137,6 +141,14 @@ typedef struct BlockCopyState {
     CoMutex lock;
     int64_t in_flight_bytes;
     BlockCopyMethod method;
+    /*
+     * Chunk size limit for buffered copying.  Starts at
+     * BLOCK_COPY_MAX_BUFFER and grows while the dirty areas being
+     * copied keep filling whole chunks (i.e. the copy is sequential
+     * rather than limited by bitmap fragmentation).
+     */
+    int64_t buf_chunk_size;
+    unsigned full_chunk_streak;
     BlockReqList reqs;
     QLIST_HEAD(, BlockCopyCallState) calls;
     /*
@@ -169,7 +181,7 @@ static int64_t block_copy_chunk_size(BlockCopyState *s)
         return s->cluster_size;
     case COPY_READ_WRITE:
     case COPY_RANGE_SMALL:
-        return MIN(MAX(s->cluster_size, BLOCK_COPY_MAX_BUFFER),
+        return MIN(MAX(s->cluster_size, s->buf_chunk_size),
                    s->max_transfer);
     case COPY_RANGE_FULL:
         return MIN(MAX(s->cluster_size, BLOCK_COPY_MAX_COPY_RANGE),
@@ -180,6 +192,27 @@ static int64_t block_copy_chunk_size(BlockCopyState *s)
     }
 }
 
+/*
+ * Grow the buffered chunk size while successive tasks keep copying
+ * full-sized chunks.  Tasks smaller than the current limit mean the
+ * dirty bitmap is fragmented and the chunk size is not what limits
+ * throughput, so the streak starts over.  Called with lock held.
+ */
+static void block_copy_chunk_adapt(BlockCopyState *s, int64_t task_bytes)
+{
+    if (task_bytes < block_copy_chunk_size(s)) {
+        s->full_chunk_streak = 0;
+        return;
+    }
+
+    if (++s->full_chunk_streak >= BLOCK_COPY_FULL_CHUNKS_TO_GROW &&
+        s->buf_chunk_size < BLOCK_COPY_MAX_BUFFER_GROWN)
+    {
+        s->buf_chunk_size *= 2;
+        s->full_chunk_streak = 0;
+    }
+}
+
 /*
  * Search for the first dirty area in offset/bytes range and create task at
  * the beginning of it.
@@ -415,6 +448,7 @@ BlockCopyState *block_copy_state_new(BdrvChild *source, BdrvChild *target,
         .max_transfer = QEMU_ALIGN_DOWN(
                                     block_copy_max_transfer(source, target),
                                     cluster_size),
+        .buf_chunk_size = BLOCK_COPY_MAX_BUFFER,
     };
 
     block_copy_set_copy_opts(s, false, false);
@@ -581,8 +615,11 @@ static coroutine_fn int block_copy_task_entry(AioTask *task)
                 t->call_state->ret = ret;
                 t->call_state->error_is_read = error_is_read;
             }
-        } else if (s->progress) {
-            progress_work_done(s->progress, t->req.bytes);
+        } else {
+            block_copy_chunk_adapt(s, t->req.bytes);
+            if (s->progress) {
+                progress_work_done(s->progress, t->req.bytes);
+            }
         }
     }
     co_put_to_shres(s->mem, t->req.bytes);
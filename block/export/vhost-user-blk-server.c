@@ -10,6 +10,7 @@
  * later.  See the COPYING file in the top-level directory.
  */
 #include "qemu/osdep.h"
+#include "qemu/defer-call.h"
 #include "qemu/error-report.h"
 #include "block/block.h"
 #include "subprojects/libvhost-user/libvhost-user.h" /* only for the type definitions */
@@ -31,6 +32,17 @@ typedef struct VuBlkReq {
     struct VuVirtq *vq;
 } VuBlkReq;
 
+/*
+ * Per-virtqueue notification state. Serves as a stable defer_call() opaque so
+ * that completions arriving in the same defer_call_begin()/defer_call_end()
+ * section (e.g. a batch of thread pool or io_uring completions) are coalesced
+ * into a single guest notification per virtqueue.
+ */
+typedef struct {
+    VuServer *server;
+    VuVirtq *vq;
+} VuBlkNotifier;
+
 /* vhost user block device */
 typedef struct {
     BlockExport export;
@@ -38,14 +50,27 @@ typedef struct {
     VirtioBlkHandler handler;
     QIOChannelSocket *sioc;
     struct virtio_blk_config blkcfg;
+    VuBlkNotifier *notifiers; /* one per virtqueue */
 } VuBlkExport;
 
+static void vu_blk_notify_fn(void *opaque)
+{
+    VuBlkNotifier *n = opaque;
+
+    vu_queue_notify(&n->server->vu_dev, n->vq);
+}
+
 static void vu_blk_req_complete(VuBlkReq *req, size_t in_len)
 {
     VuDev *vu_dev = &req->server->vu_dev;
+    VuBlkExport *vexp = container_of(req->server, VuBlkExport, vu_server);
+    VuBlkNotifier *n = &vexp->notifiers[req->vq - vu_dev->vq];
 
     vu_queue_push(vu_dev, req->vq, &req->elem, in_len);
-    vu_queue_notify(vu_dev, req->vq);
+
+    n->server = req->server;
+    n->vq = req->vq;
+    defer_call(vu_blk_notify_fn, n);
 
     free(req);
 }
@@ -84,6 +109,13 @@ static void vu_blk_process_vq(VuDev *vu_dev, int idx)
     VuServer *server = container_of(vu_dev, VuServer, vu_dev);
     VuVirtq *vq = vu_get_queue(vu_dev, idx);
 
+    /*
+     * Batch I/O submission (and synchronous completions) for all requests
+     * behind this kick into a single defer_call_begin()/defer_call_end()
+     * section, so that aio backends can submit them with one system call.
+     */
+    defer_call_begin();
+
     while (1) {
         VuBlkReq *req;
 
@@ -101,6 +133,8 @@ static void vu_blk_process_vq(VuDev *vu_dev, int idx)
         vhost_user_server_inc_in_flight(server);
         qemu_coroutine_enter(co);
     }
+
+    defer_call_end();
 }
 
 static void vu_blk_queue_set_started(VuDev *vu_dev, int idx, bool started)
@@ -344,6 +378,7 @@ static int vu_blk_exp_create(BlockExport *exp, BlockExportOptions *opts,
         error_setg(errp, "num-queues must be greater than 0");
         return -EINVAL;
     }
+    vexp->notifiers = g_new0(VuBlkNotifier, num_queues);
     vexp->handler.blk = exp->blk;
     vexp->handler.serial = g_strdup("vhost_user_blk");
     vexp->handler.logical_block_size = logical_block_size;
@@ -362,6 +397,7 @@ static int vu_blk_exp_create(BlockExport *exp, BlockExportOptions *opts,
         blk_remove_aio_context_notifier(exp->blk, blk_aio_attached,
                                         blk_aio_detach, vexp);
         g_free(vexp->handler.serial);
+        g_free(vexp->notifiers);
         return -EADDRNOTAVAIL;
     }
 
@@ -375,6 +411,7 @@ static void vu_blk_exp_delete(BlockExport *exp)
     blk_remove_aio_context_notifier(exp->blk, blk_aio_attached, blk_aio_detach,
                                     vexp);
     g_free(vexp->handler.serial);
+    g_free(vexp->notifiers);
 }
 
 const BlockExportDriver blk_exp_vhost_user_blk = {
@@ -158,6 +158,7 @@ typedef struct BDRVRawState {
 
     bool has_discard:1;
     bool has_write_zeroes:1;
+    bool has_clone_range:1;
     bool use_linux_aio:1;
     bool use_linux_io_uring:1;
     int page_cache_inconsistent; /* errno from fdatasync failure */
@@ -738,6 +739,9 @@ static int raw_open_common(BlockDriverState *bs, QDict *options,
 
     s->has_discard = true;
     s->has_write_zeroes = true;
+#ifdef FICLONERANGE
+    s->has_clone_range = true;
+#endif
 
     if (fstat(s->fd, &st) < 0) {
         ret = -errno;
@@ -1458,7 +1462,9 @@ static void raw_refresh_zoned_limits(BlockDriverState *bs, struct stat *st,
         error_setg_errno(errp, -ret, "report wps failed");
         goto no_zoned;
     }
-    qemu_co_mutex_init(&bs->wps->colock);
+    for (int i = 0; i < BLK_ZONE_WPS_SHARDS; i++) {
+        qemu_co_mutex_init(&bs->wps->colock[i]);
+    }
     return;
 
 no_zoned:
@@ -2160,6 +2166,33 @@ static int handle_aiocb_copy_range(void *opaque)
     uint64_t bytes = aiocb->aio_nbytes;
     off_t in_off = aiocb->aio_offset;
     off_t out_off = aiocb->copy_range.aio_offset2;
+#ifdef FICLONERANGE
+    BDRVRawState *s = aiocb->bs->opaque;
+
+    /*
+     * Try to reflink the range first: on filesystems that support it
+     * (XFS, btrfs) this shares the extents instead of copying them, no
+     * matter how large the request is.  Alignment or cross-filesystem
+     * problems affect only the individual request, but if the
+     * filesystem cannot clone at all, remember that and do not ask
+     * again.
+     */
+    if (s->has_clone_range) {
+        struct file_clone_range fcr = {
+            .src_fd = aiocb->aio_fildes,
+            .src_offset = in_off,
+            .src_length = bytes,
+            .dest_offset = out_off,
+        };
+
+        if (ioctl(aiocb->copy_range.aio_fd2, FICLONERANGE, &fcr) == 0) {
+            return 0;
+        }
+        if (errno == ENOTTY || errno == EOPNOTSUPP) {
+            s->has_clone_range = false;
+        }
+    }
+#endif
 
     while (bytes) {
         ssize_t ret = copy_file_range(aiocb->aio_fildes, &in_off,
@@ -2484,11 +2517,21 @@ static int coroutine_fn raw_co_prw(BlockDriverState *bs, int64_t *offset_ptr,
     if (fd_open(bs) < 0)
         return -EIO;
 #if defined(CONFIG_BLKZONED)
+    int zone_shard = -1;
+
     if ((type & (QEMU_AIO_WRITE | QEMU_AIO_ZONE_APPEND)) &&
         bs->bl.zoned != BLK_Z_NONE) {
-        qemu_co_mutex_lock(&bs->wps->colock);
+        int index = offset / bs->bl.zone_size;
+
+        /*
+         * Requests never cross zone boundaries, so only the shard
+         * covering this zone's write pointer needs to be held; an
+         * emulated append stays in its zone even after the offset is
+         * rewritten below.
+         */
+        zone_shard = index % BLK_ZONE_WPS_SHARDS;
+        qemu_co_mutex_lock(&bs->wps->colock[zone_shard]);
         if (type & QEMU_AIO_ZONE_APPEND) {
-            int index = offset / bs->bl.zone_size;
             offset = bs->wps->wp[index];
         }
     }
@@ -2558,7 +2601,7 @@ out:
             update_zones_wp(bs, s->fd, offset, 1);
         }
 
-        qemu_co_mutex_unlock(&wps->colock);
+        qemu_co_mutex_unlock(&wps->colock[zone_shard]);
     }
 #endif
     return ret;
@@ -2610,6 +2653,9 @@ static void raw_close(BlockDriverState *bs)
     if (s->fd >= 0) {
 #if defined(CONFIG_BLKZONED)
         g_free(bs->wps);
+#endif
+#ifdef CONFIG_LINUX_IO_URING
+        luring_fd_unregister(s->fd);
 #endif
         qemu_close(s->fd);
         s->fd = -1;
@@ -3556,6 +3602,22 @@ raw_do_pdiscard(BlockDriverState *bs, int64_t offset, int64_t bytes,
         acb.aio_type |= QEMU_AIO_BLKDEV;
     }
 
+#ifdef CONFIG_LINUX_IO_URING
+    /*
+     * Regular files can punch holes through io_uring, which keeps trim
+     * storms from tying up thread pool workers.  Block devices need the
+     * BLKDISCARD ioctl and stay on the thread pool.
+     */
+    if (!blkdev && s->has_discard && raw_check_linux_io_uring(s)) {
+        ret = luring_co_pdiscard(bs, s->fd, offset, bytes);
+        if (ret != -ENOTSUP) {
+            raw_account_discard(s, bytes, ret);
+            return ret;
+        }
+        /* Let the thread pool probe and record the fallback */
+    }
+#endif
+
     ret = raw_thread_pool_submit(handle_aiocb_discard, &acb);
     raw_account_discard(s, bytes, ret);
     return ret;
@@ -3802,6 +3864,9 @@ static void raw_set_perm(BlockDriverState *bs, uint64_t perm, uint64_t shared)
     /* For reopen, we have already switched to the new fd (.bdrv_set_perm is
      * called after .bdrv_reopen_commit) */
     if (s->perm_change_fd && s->fd != s->perm_change_fd) {
+#ifdef CONFIG_LINUX_IO_URING
+        luring_fd_unregister(s->fd);
+#endif
         qemu_close(s->fd);
         s->fd = s->perm_change_fd;
         s->open_flags = s->perm_change_flags;
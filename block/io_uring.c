@@ -10,7 +10,11 @@
  */
 #include "qemu/osdep.h"
 #include <liburing.h>
+#ifdef CONFIG_FALLOCATE_PUNCH_HOLE
+#include <linux/falloc.h>
+#endif
 #include "block/aio.h"
+#include "qemu/lockable.h"
 #include "qemu/queue.h"
 #include "block/block.h"
 #include "block/raw-aio.h"
@@ -26,6 +30,9 @@
 /* io_uring ring size */
 #define MAX_ENTRIES 128
 
+/* Size of the registered ("fixed") file table */
+#define MAX_FIXED_FILES 16
+
 typedef struct LuringAIOCB {
     Coroutine *co;
     struct io_uring_sqe sqeq;
@@ -58,8 +65,90 @@ struct LuringState {
     LuringQueue io_q;
 
     QEMUBH *completion_bh;
+
+    /*
+     * Registered ("fixed") file table, -1 = free slot.  Using registered
+     * files lets the kernel skip the per-request fdtable lookup and
+     * reference counting.  Protected by luring_states_lock because
+     * luring_fd_unregister() can be called from any thread.
+     */
+    bool fixed_files;
+    int fixed_fds[MAX_FIXED_FILES];
+
+    QTAILQ_ENTRY(LuringState) next;
 };
 
+static QemuMutex luring_states_lock;
+static QTAILQ_HEAD(, LuringState) luring_states =
+    QTAILQ_HEAD_INITIALIZER(luring_states);
+
+static void __attribute__((constructor)) luring_states_lock_init(void)
+{
+    qemu_mutex_init(&luring_states_lock);
+}
+
+/**
+ * luring_fixed_file_index:
+ *
+ * Return the registered file slot for @fd, registering it on first use.
+ * Returns a negative errno if the table is full or the kernel refused the
+ * update; the caller then falls back to submitting with the plain fd.
+ */
+static int luring_fixed_file_index(LuringState *s, int fd)
+{
+    int free_slot = -1;
+    int i, rc;
+
+    QEMU_LOCK_GUARD(&luring_states_lock);
+
+    for (i = 0; i < MAX_FIXED_FILES; i++) {
+        if (s->fixed_fds[i] == fd) {
+            return i;
+        }
+        if (free_slot < 0 && s->fixed_fds[i] == -1) {
+            free_slot = i;
+        }
+    }
+    if (free_slot < 0) {
+        return -ENOSPC;
+    }
+
+    rc = io_uring_register_files_update(&s->ring, free_slot, &fd, 1);
+    if (rc < 0) {
+        return rc;
+    }
+    s->fixed_fds[free_slot] = fd;
+    return free_slot;
+}
+
+void luring_fd_unregister(int fd)
+{
+    LuringState *s;
+    int i;
+
+    QEMU_LOCK_GUARD(&luring_states_lock);
+
+    QTAILQ_FOREACH(s, &luring_states, next) {
+        if (!s->fixed_files) {
+            continue;
+        }
+        for (i = 0; i < MAX_FIXED_FILES; i++) {
+            if (s->fixed_fds[i] == fd) {
+                int invalid_fd = -1;
+
+                /*
+                 * Drop the kernel's reference so that closing @fd
+                 * actually releases the file.  In-flight requests keep
+                 * their own reference and complete normally.
+                 */
+                io_uring_register_files_update(&s->ring, i, &invalid_fd, 1);
+                s->fixed_fds[i] = -1;
+                break;
+            }
+        }
+    }
+}
+
 /**
  * luring_resubmit:
  *
@@ -329,13 +418,14 @@ static void luring_deferred_fn(void *opaque)
  * @luringcb: AIO control block
  * @s: AIO state
  * @offset: offset for request
+ * @nbytes: request length, only used for requests without a qiov
  * @type: type of request
  *
  * Fetches sqes from ring, adds to pending queue and preps them
  *
  */
 static int luring_do_submit(int fd, LuringAIOCB *luringcb, LuringState *s,
-                            uint64_t offset, int type)
+                            uint64_t offset, uint64_t nbytes, int type)
 {
     int ret;
     struct io_uring_sqe *sqes = &luringcb->sqeq;
@@ -356,6 +446,13 @@ static int luring_do_submit(int fd, LuringAIOCB *luringcb, LuringState *s,
     case QEMU_AIO_FLUSH:
         io_uring_prep_fsync(sqes, fd, IORING_FSYNC_DATASYNC);
         break;
+#ifdef CONFIG_FALLOCATE_PUNCH_HOLE
+    case QEMU_AIO_DISCARD:
+        io_uring_prep_fallocate(sqes, fd,
+                                FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                                offset, nbytes);
+        break;
+#endif
     default:
         fprintf(stderr, "%s: invalid AIO request type, aborting 0x%x.\n",
                         __func__, type);
@@ -363,6 +460,14 @@ static int luring_do_submit(int fd, LuringAIOCB *luringcb, LuringState *s,
     }
     io_uring_sqe_set_data(sqes, luringcb);
 
+    if (s->fixed_files) {
+        int fixed = luring_fixed_file_index(s, fd);
+        if (fixed >= 0) {
+            sqes->fd = fixed;
+            sqes->flags |= IOSQE_FIXED_FILE;
+        }
+    }
+
     QSIMPLEQ_INSERT_TAIL(&s->io_q.submit_queue, luringcb, next);
     s->io_q.in_queue++;
     trace_luring_do_submit(s, s->io_q.blocked, s->io_q.in_queue,
@@ -393,7 +498,34 @@ int coroutine_fn luring_co_submit(BlockDriverState *bs, int fd, uint64_t offset,
     };
     trace_luring_co_submit(bs, s, &luringcb, fd, offset, qiov ? qiov->size : 0,
                            type);
-    ret = luring_do_submit(fd, &luringcb, s, offset, type);
+    ret = luring_do_submit(fd, &luringcb, s, offset, qiov ? qiov->size : 0,
+                           type);
+
+    if (ret < 0) {
+        return ret;
+    }
+
+    if (luringcb.ret == -EINPROGRESS) {
+        qemu_coroutine_yield();
+    }
+    return luringcb.ret;
+}
+
+int coroutine_fn luring_co_pdiscard(BlockDriverState *bs, int fd,
+                                    uint64_t offset, uint64_t bytes)
+{
+#ifdef CONFIG_FALLOCATE_PUNCH_HOLE
+    int ret;
+    AioContext *ctx = qemu_get_current_aio_context();
+    LuringState *s = aio_get_linux_io_uring(ctx);
+    LuringAIOCB luringcb = {
+        .co         = qemu_coroutine_self(),
+        .ret        = -EINPROGRESS,
+    };
+
+    trace_luring_co_submit(bs, s, &luringcb, fd, offset, bytes,
+                           QEMU_AIO_DISCARD);
+    ret = luring_do_submit(fd, &luringcb, s, offset, bytes, QEMU_AIO_DISCARD);
 
     if (ret < 0) {
         return ret;
@@ -403,6 +535,9 @@ int coroutine_fn luring_co_submit(BlockDriverState *bs, int fd, uint64_t offset,
         qemu_coroutine_yield();
     }
     return luringcb.ret;
+#else
+    return -ENOTSUP;
+#endif
 }
 
 void luring_detach_aio_context(LuringState *s, AioContext *old_context)
@@ -437,6 +572,20 @@ LuringState *luring_init(Error **errp)
         return NULL;
     }
 
+    /*
+     * Register a sparse file table up front; individual fds are added
+     * lazily with io_uring_register_files_update().  Kernels that do not
+     * support sparse tables refuse the registration and we simply keep
+     * submitting with plain fds.
+     */
+    memset(s->fixed_fds, -1, sizeof(s->fixed_fds));
+    rc = io_uring_register_files(ring, s->fixed_fds, MAX_FIXED_FILES);
+    s->fixed_files = rc == 0;
+
+    WITH_QEMU_LOCK_GUARD(&luring_states_lock) {
+        QTAILQ_INSERT_TAIL(&luring_states, s, next);
+    }
+
     ioq_init(&s->io_q);
     return s;
 
@@ -444,6 +593,9 @@ LuringState *luring_init(Error **errp)
 
 void luring_cleanup(LuringState *s)
 {
+    WITH_QEMU_LOCK_GUARD(&luring_states_lock) {
+        QTAILQ_REMOVE(&luring_states, s, next);
+    }
     io_uring_queue_exit(&s->ring);
     trace_luring_cleanup_state(s);
     g_free(s);
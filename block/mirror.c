@@ -517,26 +517,37 @@ static void coroutine_fn GRAPH_UNLOCKED mirror_iteration(MirrorBlockJob *s)
     /* Find the number of consecutive dirty chunks following the first dirty
      * one, and wait for in flight requests in them. */
     bdrv_dirty_bitmap_lock(s->dirty_bitmap);
-    while (nb_chunks * s->granularity < s->buf_size) {
-        int64_t next_dirty;
-        int64_t next_offset = offset + nb_chunks * s->granularity;
-        int64_t next_chunk = next_offset / s->granularity;
-        if (next_offset >= s->bdev_length ||
-            !bdrv_dirty_bitmap_get_locked(s->dirty_bitmap, next_offset)) {
-            break;
-        }
-        if (test_bit(next_chunk, s->in_flight_bitmap)) {
-            break;
+    {
+        int64_t chunk = offset / s->granularity;
+        int64_t dirty_start, dirty_count;
+        unsigned long first_in_flight;
+
+        /*
+         * One locked query returns the whole contiguous dirty run starting
+         * at @offset instead of one bitmap lookup per chunk.  The run may
+         * be empty if an active write cleared the bits while we waited for
+         * conflicts above; the first chunk is still copied then.
+         */
+        if (bdrv_dirty_bitmap_next_dirty_area(s->dirty_bitmap, offset,
+                                              s->bdev_length, s->buf_size,
+                                              &dirty_start, &dirty_count) &&
+            dirty_start == offset) {
+            nb_chunks = DIV_ROUND_UP(dirty_count, s->granularity);
         }
 
-        next_dirty = bdrv_dirty_iter_next(s->dbi);
-        if (next_dirty > next_offset || next_dirty < 0) {
-            /* The bitmap iterator's cache is stale, refresh it */
-            bdrv_set_dirty_iter(s->dbi, next_offset);
-            next_dirty = bdrv_dirty_iter_next(s->dbi);
+        /* Stop at the first chunk that has a request in flight */
+        first_in_flight = find_next_bit(s->in_flight_bitmap,
+                                        chunk + nb_chunks, chunk + 1);
+        nb_chunks = MIN(nb_chunks, (int)(first_in_flight - chunk));
+
+        /*
+         * Keep the iterator in step with what this iteration consumes.  If
+         * the run reaches the end of the device, leave the iterator alone:
+         * the next call returns -1 and restarts from the top of the bitmap.
+         */
+        if (offset + nb_chunks * s->granularity < s->bdev_length) {
+            bdrv_set_dirty_iter(s->dbi, offset + nb_chunks * s->granularity);
         }
-        assert(next_dirty == next_offset);
-        nb_chunks++;
     }
 
     /* Clear dirty bits before querying the block status, because
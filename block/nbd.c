@@ -48,7 +48,12 @@
 #include "qemu/yank.h"
 
 #define EN_OPTSTR ":exportname="
-#define MAX_NBD_REQUESTS    16
+/*
+ * With a single connection per export, the request window is all that
+ * hides the round trip time; 16 slots were not enough to fill
+ * high-bandwidth, high-latency links.
+ */
+#define MAX_NBD_REQUESTS    64
 
 #define COOKIE_TO_INDEX(cookie) ((cookie) - 1)
 #define INDEX_TO_COOKIE(index)  ((index) + 1)
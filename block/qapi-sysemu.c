@@ -36,6 +36,7 @@
 #include "qapi/error.h"
 #include "qapi/qapi-commands-block.h"
 #include "qapi/qmp/qdict.h"
+#include "qapi/util.h"
 #include "sysemu/block-backend.h"
 #include "sysemu/blockdev.h"
 
@@ -513,9 +514,11 @@ void qmp_block_latency_histogram_set(
     bool has_boundaries_write, uint64List *boundaries_write,
     bool has_boundaries_append, uint64List *boundaries_append,
     bool has_boundaries_flush, uint64List *boundaries_flush,
+    bool has_log_scale, bool log_scale,
     Error **errp)
 {
     BlockBackend *blk = qmp_get_blk(NULL, id, errp);
+    g_autoptr(uint64List) log_boundaries = NULL;
     BlockAcctStats *stats;
     int ret;
 
@@ -525,6 +528,17 @@ void qmp_block_latency_histogram_set(
 
     stats = blk_get_stats(blk);
 
+    if (has_log_scale && log_scale && !has_boundaries) {
+        uint64_t ns;
+
+        /* Power-of-two buckets from 1 us up to about 17 s */
+        for (ns = 1ULL << 34; ns >= 1024; ns >>= 1) {
+            QAPI_LIST_PREPEND(log_boundaries, ns);
+        }
+        boundaries = log_boundaries;
+        has_boundaries = true;
+    }
+
     if (!has_boundaries && !has_boundaries_read && !has_boundaries_write &&
         !has_boundaries_flush)
     {
@@ -237,22 +237,156 @@ qcow2_cache_entry_flush(BlockDriverState *bs, Qcow2Cache *c, int i)
     return 0;
 }
 
+/* Upper bound for merging adjacent tables into a single write */
+#define QCOW2_CACHE_MAX_BATCH_SIZE (1024 * 1024)
+
+typedef struct Qcow2DirtyTable {
+    int64_t offset;
+    int idx;
+} Qcow2DirtyTable;
+
+static int qcow2_dirty_table_cmp(const void *a, const void *b)
+{
+    const Qcow2DirtyTable *ta = a;
+    const Qcow2DirtyTable *tb = b;
+
+    return ta->offset < tb->offset ? -1 : ta->offset > tb->offset;
+}
+
+/*
+ * Write back all dirty tables, merging tables that are adjacent in the
+ * image file into single large writes.  Random-write-heavy guests
+ * dirty many refcount blocks and L2 tables that sit next to each other
+ * on disk, and writing them out sequentially in one request instead of
+ * one request per table cuts the metadata write amplification
+ * considerably.
+ */
 int qcow2_cache_write(BlockDriverState *bs, Qcow2Cache *c)
 {
     BDRVQcow2State *s = bs->opaque;
+    g_autofree Qcow2DirtyTable *dirty = NULL;
+    uint8_t *buf = NULL;
     int result = 0;
-    int ret;
-    int i;
+    int ret = 0;
+    int i, n = 0;
 
     trace_qcow2_cache_flush(qemu_coroutine_self(), c == s->l2_table_cache);
 
+    dirty = g_new(Qcow2DirtyTable, c->size);
     for (i = 0; i < c->size; i++) {
-        ret = qcow2_cache_entry_flush(bs, c, i);
-        if (ret < 0 && result != -ENOSPC) {
-            result = ret;
+        if (c->entries[i].dirty && c->entries[i].offset) {
+            dirty[n].offset = c->entries[i].offset;
+            dirty[n].idx = i;
+            n++;
+        }
+    }
+    if (n == 0) {
+        return 0;
+    }
+
+    /* Resolve the dependencies once for the whole cache */
+    if (c->depends) {
+        ret = qcow2_cache_flush_dependency(bs, c);
+    } else if (c->depends_on_flush) {
+        ret = bdrv_flush(bs->file->bs);
+        if (ret >= 0) {
+            c->depends_on_flush = false;
         }
     }
+    if (ret < 0) {
+        return ret;
+    }
+
+    buf = qemu_try_blockalign(bs->file->bs,
+                              MIN((int64_t)n * c->table_size,
+                                  QCOW2_CACHE_MAX_BATCH_SIZE));
+    if (buf == NULL) {
+        /* No memory for merging, write the tables one by one */
+        for (i = 0; i < n; i++) {
+            ret = qcow2_cache_entry_flush(bs, c, dirty[i].idx);
+            if (ret < 0 && result != -ENOSPC) {
+                result = ret;
+            }
+        }
+        return result;
+    }
+
+    qsort(dirty, n, sizeof(*dirty), qcow2_dirty_table_cmp);
+
+    i = 0;
+    while (i < n) {
+        int64_t offset = dirty[i].offset;
+        bool skip_failed = false;
+        int run = 1;
+        int k;
+
+        while (i + run < n &&
+               dirty[i + run].offset ==
+                   offset + (int64_t)run * c->table_size &&
+               (run + 1) * c->table_size <= QCOW2_CACHE_MAX_BATCH_SIZE) {
+            run++;
+        }
+
+        for (k = 0; k < run; k++) {
+            if (c == s->refcount_block_cache) {
+                ret = qcow2_pre_write_overlap_check(bs, QCOW2_OL_REFCOUNT_BLOCK,
+                        dirty[i + k].offset, c->table_size, false);
+            } else if (c == s->l2_table_cache) {
+                ret = qcow2_pre_write_overlap_check(bs, QCOW2_OL_ACTIVE_L2,
+                        dirty[i + k].offset, c->table_size, false);
+            } else {
+                ret = qcow2_pre_write_overlap_check(bs, 0,
+                        dirty[i + k].offset, c->table_size, false);
+            }
+            if (ret < 0) {
+                break;
+            }
+        }
+        if (ret < 0) {
+            if (result != -ENOSPC) {
+                result = ret;
+            }
+            /* Write what passed the check, step over the failing table */
+            run = k;
+            skip_failed = true;
+            if (run == 0) {
+                i++;
+                continue;
+            }
+        }
+
+        if (c == s->refcount_block_cache) {
+            BLKDBG_EVENT(bs->file, BLKDBG_REFBLOCK_UPDATE_PART);
+        } else if (c == s->l2_table_cache) {
+            BLKDBG_EVENT(bs->file, BLKDBG_L2_UPDATE);
+        }
+
+        if (run == 1) {
+            ret = bdrv_pwrite(bs->file, offset, c->table_size,
+                              qcow2_cache_get_table_addr(c, dirty[i].idx), 0);
+        } else {
+            for (k = 0; k < run; k++) {
+                memcpy(buf + (size_t)k * c->table_size,
+                       qcow2_cache_get_table_addr(c, dirty[i + k].idx),
+                       c->table_size);
+            }
+            ret = bdrv_pwrite(bs->file, offset,
+                              (int64_t)run * c->table_size, buf, 0);
+        }
+        if (ret < 0) {
+            if (result != -ENOSPC) {
+                result = ret;
+            }
+        } else {
+            for (k = 0; k < run; k++) {
+                c->entries[dirty[i + k].idx].dirty = false;
+            }
+        }
+
+        i += run + (skip_failed ? 1 : 0);
+    }
 
+    qemu_vfree(buf);
     return result;
 }
 
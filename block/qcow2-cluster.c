@@ -219,6 +219,90 @@ l2_load(BlockDriverState *bs, uint64_t offset,
                            (void **)l2_slice);
 }
 
+/*
+ * Number of consecutive contiguous lookups after which the access
+ * pattern is considered sequential and the next L2 slice is read
+ * ahead into the cache.
+ */
+#define QCOW2_L2_PREFETCH_STREAK 4
+
+typedef struct Qcow2L2Prefetch {
+    BlockDriverState *bs;
+    uint64_t offset; /* guest offset covered by the L2 slice to load */
+} Qcow2L2Prefetch;
+
+static void coroutine_fn qcow2_l2_prefetch_co_entry(void *opaque)
+{
+    Qcow2L2Prefetch *p = opaque;
+    BlockDriverState *bs = p->bs;
+    BDRVQcow2State *s = bs->opaque;
+    uint64_t l1_index, l2_offset, *l2_slice;
+
+    bdrv_graph_co_rdlock();
+    qemu_co_mutex_lock(&s->lock);
+
+    l1_index = offset_to_l1_index(s, p->offset);
+    if (l1_index < s->l1_size) {
+        l2_offset = s->l1_table[l1_index] & L1E_OFFSET_MASK;
+        if (l2_offset && !offset_into_cluster(s, l2_offset) &&
+            l2_load(bs, p->offset, l2_offset, &l2_slice) == 0) {
+            /* All we wanted was to populate the cache */
+            qcow2_cache_put(s->l2_table_cache, (void **)&l2_slice);
+        }
+    }
+
+    s->l2_prefetch_busy = false;
+    qemu_co_mutex_unlock(&s->lock);
+    bdrv_graph_co_rdunlock();
+    bdrv_dec_in_flight(bs);
+    g_free(p);
+}
+
+/*
+ * Called with s->lock held after a successful lookup of @bytes bytes
+ * at guest @offset.  If the last few lookups were contiguous, load the
+ * next L2 slice into the cache in the background so that the lookup
+ * that eventually crosses the slice boundary does not have to wait
+ * for the read of the slice itself.
+ */
+static void l2_prefetch_update(BlockDriverState *bs, uint64_t offset,
+                               uint64_t bytes)
+{
+    BDRVQcow2State *s = bs->opaque;
+    uint64_t slice_cov = (uint64_t)s->l2_slice_size << s->cluster_bits;
+    uint64_t target;
+    Qcow2L2Prefetch *p;
+    Coroutine *co;
+
+    if (offset != s->l2_prefetch_next) {
+        s->l2_prefetch_streak = 0;
+    } else if (s->l2_prefetch_streak < QCOW2_L2_PREFETCH_STREAK) {
+        s->l2_prefetch_streak++;
+    }
+    s->l2_prefetch_next = offset + bytes;
+
+    if (s->l2_prefetch_streak < QCOW2_L2_PREFETCH_STREAK ||
+        s->l2_prefetch_busy) {
+        return;
+    }
+
+    target = QEMU_ALIGN_DOWN(offset, slice_cov) + slice_cov;
+    if (target == s->l2_prefetch_target) {
+        /* Already prefetched (or being prefetched) */
+        return;
+    }
+    s->l2_prefetch_target = target;
+    s->l2_prefetch_busy = true;
+
+    p = g_new(Qcow2L2Prefetch, 1);
+    p->bs = bs;
+    p->offset = target;
+
+    bdrv_inc_in_flight(bs);
+    co = qemu_coroutine_create(qcow2_l2_prefetch_co_entry, p);
+    aio_co_schedule(bdrv_get_aio_context(bs), co);
+}
+
 /*
  * Writes an L1 entry to disk (note that depending on the alignment
  * requirements this function may write more that just one entry in
@@ -735,6 +819,8 @@ out:
 
     *subcluster_type = type;
 
+    l2_prefetch_update(bs, offset, *bytes);
+
     return 0;
 
 fail:
@@ -1154,6 +1240,14 @@ void coroutine_fn qcow2_alloc_cluster_abort(BlockDriverState *bs, QCowL2Meta *m)
  * allocated and will be overwritten. If false then the clusters are
  * new and we have to decrease the reference count of the old ones.
  *
+ * The COW regions are computed at subcluster granularity: a request
+ * whose head and tail fall on subcluster boundaries produces empty COW
+ * regions and therefore no read-modify-write, regardless of whether
+ * the touched subclusters are allocated, zero or unallocated.  The one
+ * exception is a partial rewrite of a compressed cluster: the old
+ * cluster is replaced as a whole, so the subclusters around the write
+ * must be copied out of it no matter how the request is aligned.
+ *
  * Returns 0 on success, -errno on failure.
  */
 static int coroutine_fn GRAPH_RDLOCK
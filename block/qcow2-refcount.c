@@ -27,6 +27,7 @@
 #include "qapi/error.h"
 #include "qcow2.h"
 #include "qemu/range.h"
+#include "qemu/units.h"
 #include "qemu/bswap.h"
 #include "qemu/cutils.h"
 #include "qemu/memalign.h"
@@ -1302,6 +1303,8 @@ int qcow2_update_snapshot_refcount(BlockDriverState *bs,
             }
 
             for (slice = 0; slice < n_slices; slice++) {
+                int updated_until = 0;
+
                 ret = qcow2_cache_get(bs, s->l2_table_cache,
                                       l2_offset + slice * slice_size2,
                                       (void **) &l2_slice);
@@ -1355,10 +1358,40 @@ int qcow2_update_snapshot_refcount(BlockDriverState *bs,
 
                         cluster_index = offset >> s->cluster_bits;
                         assert(cluster_index);
-                        if (addend != 0) {
-                            ret = qcow2_update_cluster_refcount(
-                                bs, cluster_index, abs(addend), addend < 0,
-                                QCOW2_DISCARD_SNAPSHOT);
+                        if (addend != 0 && j >= updated_until) {
+                            int run = 1;
+
+                            /*
+                             * Consecutive L2 entries frequently map
+                             * contiguous host clusters; apply the refcount
+                             * change for the whole run with one call, so
+                             * that each affected refcount block is looked
+                             * up and marked dirty once rather than once
+                             * per cluster.
+                             */
+                            while (j + run < s->l2_slice_size) {
+                                uint64_t next_entry =
+                                    get_l2_entry(s, l2_slice, j + run) &
+                                    ~QCOW_OFLAG_COPIED;
+                                QCow2ClusterType next_type =
+                                    qcow2_get_cluster_type(bs, next_entry);
+
+                                if ((next_type != QCOW2_CLUSTER_NORMAL &&
+                                     next_type != QCOW2_CLUSTER_ZERO_ALLOC) ||
+                                    (next_entry & L2E_OFFSET_MASK) !=
+                                        offset + (uint64_t)run *
+                                                 s->cluster_size) {
+                                    break;
+                                }
+                                run++;
+                            }
+                            updated_until = j + run;
+
+                            ret = update_refcount(bs, offset,
+                                                  (int64_t)run *
+                                                  s->cluster_size,
+                                                  abs(addend), addend < 0,
+                                                  QCOW2_DISCARD_SNAPSHOT);
                             if (ret < 0) {
                                 goto fail;
                             }
@@ -1590,6 +1623,12 @@ enum {
     CHECK_FRAG_INFO = 0x2,      /* update BlockFragInfo counters */
 };
 
+/*
+ * Upper bound on how much contiguous L2 table data check_refcounts_l1()
+ * reads with a single request.
+ */
+#define CHECK_L2_BATCH_SIZE (4 * MiB)
+
 /*
  * Fix L2 entry by making it QCOW2_CLUSTER_ZERO_PLAIN (or making all its present
  * subclusters QCOW2_SUBCLUSTER_ZERO_PLAIN).
@@ -1656,6 +1695,9 @@ fail:
  * referenced in the L2 table. While doing so, performs some checks on L2
  * entries.
  *
+ * @l2_table contains the raw (big-endian) L2 table, which the caller has
+ * already read from @l2_offset.
+ *
  * Returns the number of errors found by the checks or -errno if an internal
  * error occurred.
  */
@@ -1663,24 +1705,15 @@ static int coroutine_fn GRAPH_RDLOCK
 check_refcounts_l2(BlockDriverState *bs, BdrvCheckResult *res,
                    void **refcount_table,
                    int64_t *refcount_table_size, int64_t l2_offset,
-                   int flags, BdrvCheckMode fix, bool active)
+                   uint64_t *l2_table, int flags, BdrvCheckMode fix,
+                   bool active)
 {
     BDRVQcow2State *s = bs->opaque;
     uint64_t l2_entry, l2_bitmap;
     uint64_t next_contiguous_offset = 0;
     int i, ret;
-    size_t l2_size_bytes = s->l2_size * l2_entry_size(s);
-    g_autofree uint64_t *l2_table = g_malloc(l2_size_bytes);
     bool metadata_overlap;
 
-    /* Read L2 table from disk */
-    ret = bdrv_co_pread(bs->file, l2_offset, l2_size_bytes, l2_table, 0);
-    if (ret < 0) {
-        fprintf(stderr, "ERROR: I/O error in check_refcounts_l2\n");
-        res->check_errors++;
-        return ret;
-    }
-
     /* Do the actual checks */
     for (i = 0; i < s->l2_size; i++) {
         uint64_t coffset;
@@ -1869,7 +1902,7 @@ check_refcounts_l1(BlockDriverState *bs, BdrvCheckResult *res,
     size_t l1_size_bytes = l1_size * L1E_SIZE;
     g_autofree uint64_t *l1_table = NULL;
     uint64_t l2_offset;
-    int i, ret;
+    int i, n, ret;
 
     if (!l1_size) {
         return 0;
@@ -1901,41 +1934,93 @@ check_refcounts_l1(BlockDriverState *bs, BdrvCheckResult *res,
     }
 
     /* Do the actual checks */
-    for (i = 0; i < l1_size; i++) {
+    for (i = 0; i < l1_size; i += n) {
+        size_t l2_size_bytes = s->l2_size * l2_entry_size(s);
+        int max_batch = MAX(CHECK_L2_BATCH_SIZE / l2_size_bytes, 1);
+        g_autofree uint8_t *l2_tables = NULL;
+        bool batched;
+        int j;
+
+        n = 1;
         if (!l1_table[i]) {
             continue;
         }
 
-        if (l1_table[i] & L1E_RESERVED_MASK) {
-            fprintf(stderr, "ERROR found L1 entry with reserved bits set: "
-                    "%" PRIx64 "\n", l1_table[i]);
-            res->corruptions++;
-        }
-
         l2_offset = l1_table[i] & L1E_OFFSET_MASK;
 
-        /* Mark L2 table as used */
-        ret = qcow2_inc_refcounts_imrt(bs, res,
-                                       refcount_table, refcount_table_size,
-                                       l2_offset, s->cluster_size);
-        if (ret < 0) {
-            return ret;
+        /*
+         * L2 tables referenced by consecutive L1 entries are very often
+         * allocated back to back, so batch runs of contiguous tables
+         * into a single read instead of paying one request round trip
+         * per table.
+         */
+        if (!offset_into_cluster(s, l2_offset)) {
+            while (n < max_batch && i + n < l1_size && l1_table[i + n] &&
+                   (l1_table[i + n] & L1E_OFFSET_MASK) ==
+                       l2_offset + (uint64_t)n * l2_size_bytes) {
+                n++;
+            }
         }
 
-        /* L2 tables are cluster aligned */
-        if (offset_into_cluster(s, l2_offset)) {
-            fprintf(stderr, "ERROR l2_offset=%" PRIx64 ": Table is not "
-                "cluster aligned; L1 entry corrupted\n", l2_offset);
-            res->corruptions++;
+        l2_tables = g_try_malloc(n * l2_size_bytes);
+        if (l2_tables == NULL) {
+            res->check_errors++;
+            return -ENOMEM;
         }
 
-        /* Process and check L2 entries */
-        ret = check_refcounts_l2(bs, res, refcount_table,
-                                 refcount_table_size, l2_offset, flags,
-                                 fix, active);
-        if (ret < 0) {
+        ret = bdrv_co_pread(bs->file, l2_offset, n * l2_size_bytes,
+                            l2_tables, 0);
+        if (ret < 0 && n == 1) {
+            fprintf(stderr, "ERROR: I/O error in check_refcounts_l2\n");
+            res->check_errors++;
             return ret;
         }
+        /* On a batched read error, retry each table individually below */
+        batched = ret >= 0;
+
+        for (j = 0; j < n; j++) {
+            uint64_t *l2_table = (uint64_t *)(l2_tables + j * l2_size_bytes);
+            int64_t table_offset = l2_offset + (uint64_t)j * l2_size_bytes;
+
+            if (l1_table[i + j] & L1E_RESERVED_MASK) {
+                fprintf(stderr, "ERROR found L1 entry with reserved bits set: "
+                        "%" PRIx64 "\n", l1_table[i + j]);
+                res->corruptions++;
+            }
+
+            /* Mark L2 table as used */
+            ret = qcow2_inc_refcounts_imrt(bs, res,
+                                           refcount_table, refcount_table_size,
+                                           table_offset, s->cluster_size);
+            if (ret < 0) {
+                return ret;
+            }
+
+            /* L2 tables are cluster aligned */
+            if (offset_into_cluster(s, table_offset)) {
+                fprintf(stderr, "ERROR l2_offset=%" PRIx64 ": Table is not "
+                    "cluster aligned; L1 entry corrupted\n", table_offset);
+                res->corruptions++;
+            }
+
+            if (!batched) {
+                ret = bdrv_co_pread(bs->file, table_offset, l2_size_bytes,
+                                    l2_table, 0);
+                if (ret < 0) {
+                    fprintf(stderr, "ERROR: I/O error in check_refcounts_l2\n");
+                    res->check_errors++;
+                    return ret;
+                }
+            }
+
+            /* Process and check L2 entries */
+            ret = check_refcounts_l2(bs, res, refcount_table,
+                                     refcount_table_size, table_offset,
+                                     l2_table, flags, fix, active);
+            if (ret < 0) {
+                return ret;
+            }
+        }
     }
 
     return 0;
@@ -24,28 +24,37 @@
  */
 
 #include "qemu/osdep.h"
-
-#define ZLIB_CONST
-#include <zlib.h>
-
-#ifdef CONFIG_ZSTD
-#include <zstd.h>
-#include <zstd_errors.h>
-#endif
-
+#include "qemu/compress.h"
 #include "qcow2.h"
 #include "block/block-io.h"
 #include "block/thread-pool.h"
 #include "crypto.h"
 
+/*
+ * Compression tasks are pure CPU work on private buffers, so they may
+ * scale with the host. Encryption tasks stay within QCOW2_MAX_THREADS,
+ * which also sizes the pool of cipher contexts in the crypto layer.
+ */
+static int qcow2_max_compress_threads(void)
+{
+    static int max;
+
+    if (!max) {
+        max = MIN(MAX(g_get_num_processors(), QCOW2_MAX_THREADS),
+                  QCOW2_MAX_COMPRESS_THREADS);
+    }
+    return max;
+}
+
 static int coroutine_fn
-qcow2_co_process(BlockDriverState *bs, ThreadPoolFunc *func, void *arg)
+qcow2_co_process(BlockDriverState *bs, ThreadPoolFunc *func, void *arg,
+                 int max_threads)
 {
     int ret;
     BDRVQcow2State *s = bs->opaque;
 
     qemu_co_mutex_lock(&s->lock);
-    while (s->nb_threads >= QCOW2_MAX_THREADS) {
+    while (s->nb_threads >= max_threads) {
         qemu_co_queue_wait(&s->thread_task_queue, &s->lock);
     }
     s->nb_threads++;
@@ -93,36 +102,9 @@ typedef struct Qcow2CompressData {
 static ssize_t qcow2_zlib_compress(void *dest, size_t dest_size,
                                    const void *src, size_t src_size)
 {
-    ssize_t ret;
-    z_stream strm;
-
-    /* best compression, small window, no zlib header */
-    memset(&strm, 0, sizeof(strm));
-    ret = deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
-                       -12, 9, Z_DEFAULT_STRATEGY);
-    if (ret != Z_OK) {
-        return -EIO;
-    }
-
-    /*
-     * strm.next_in is not const in old zlib versions, such as those used on
-     * OpenBSD/NetBSD, so cast the const away
-     */
-    strm.avail_in = src_size;
-    strm.next_in = (void *) src;
-    strm.avail_out = dest_size;
-    strm.next_out = dest;
-
-    ret = deflate(&strm, Z_FINISH);
-    if (ret == Z_STREAM_END) {
-        ret = dest_size - strm.avail_out;
-    } else {
-        ret = (ret == Z_OK ? -ENOMEM : -EIO);
-    }
-
-    deflateEnd(&strm);
-
-    return ret;
+    /* default compression, small window, no zlib header */
+    return qemu_compress_one(QEMU_COMPRESS_FMT_ZLIB, 0, -12,
+                             dest, dest_size, src, src_size);
 }
 
 /*
@@ -140,35 +122,15 @@ static ssize_t qcow2_zlib_compress(void *dest, size_t dest_size,
 static ssize_t qcow2_zlib_decompress(void *dest, size_t dest_size,
                                      const void *src, size_t src_size)
 {
-    int ret;
-    z_stream strm;
-
-    memset(&strm, 0, sizeof(strm));
-    strm.avail_in = src_size;
-    strm.next_in = (void *) src;
-    strm.avail_out = dest_size;
-    strm.next_out = dest;
+    ssize_t ret;
 
-    ret = inflateInit2(&strm, -12);
-    if (ret != Z_OK) {
+    ret = qemu_decompress_one(QEMU_COMPRESS_FMT_ZLIB, -12,
+                              dest, dest_size, src, src_size);
+    if (ret < 0) {
         return -EIO;
     }
-
-    ret = inflate(&strm, Z_FINISH);
-    if ((ret == Z_STREAM_END || ret == Z_BUF_ERROR) && strm.avail_out == 0) {
-        /*
-         * We approve Z_BUF_ERROR because we need @dest buffer to be filled, but
-         * @src buffer may be processed partly (because in qcow2 we know size of
-         * compressed data with precision of one sector)
-         */
-        ret = 0;
-    } else {
-        ret = -EIO;
-    }
-
-    inflateEnd(&strm);
-
-    return ret;
+    /* the cluster is damaged unless we produced exactly @dest_size bytes */
+    return ret == dest_size ? 0 : -EIO;
 }
 
 #ifdef CONFIG_ZSTD
@@ -188,57 +150,8 @@ static ssize_t qcow2_zlib_decompress(void *dest, size_t dest_size,
 static ssize_t qcow2_zstd_compress(void *dest, size_t dest_size,
                                    const void *src, size_t src_size)
 {
-    ssize_t ret;
-    size_t zstd_ret;
-    ZSTD_outBuffer output = {
-        .dst = dest,
-        .size = dest_size,
-        .pos = 0
-    };
-    ZSTD_inBuffer input = {
-        .src = src,
-        .size = src_size,
-        .pos = 0
-    };
-    ZSTD_CCtx *cctx = ZSTD_createCCtx();
-
-    if (!cctx) {
-        return -EIO;
-    }
-    /*
-     * Use the zstd streamed interface for symmetry with decompression,
-     * where streaming is essential since we don't record the exact
-     * compressed size.
-     *
-     * ZSTD_compressStream2() tries to compress everything it could
-     * with a single call. Although, ZSTD docs says that:
-     * "You must continue calling ZSTD_compressStream2() with ZSTD_e_end
-     * until it returns 0, at which point you are free to start a new frame",
-     * in out tests we saw the only case when it returned with >0 -
-     * when the output buffer was too small. In that case,
-     * ZSTD_compressStream2() expects a bigger buffer on the next call.
-     * We can't provide a bigger buffer because we are limited with dest_size
-     * which we pass to the ZSTD_compressStream2() at once.
-     * So, we don't need any loops and just abort the compression when we
-     * don't get 0 result on the first call.
-     */
-    zstd_ret = ZSTD_compressStream2(cctx, &output, &input, ZSTD_e_end);
-
-    if (zstd_ret) {
-        if (zstd_ret > output.size - output.pos) {
-            ret = -ENOMEM;
-        } else {
-            ret = -EIO;
-        }
-        goto out;
-    }
-
-    /* make sure that zstd didn't overflow the dest buffer */
-    assert(output.pos <= dest_size);
-    ret = output.pos;
-out:
-    ZSTD_freeCCtx(cctx);
-    return ret;
+    return qemu_compress_one(QEMU_COMPRESS_FMT_ZSTD, 0, 0,
+                             dest, dest_size, src, src_size);
 }
 
 /*
@@ -256,72 +169,15 @@ out:
 static ssize_t qcow2_zstd_decompress(void *dest, size_t dest_size,
                                      const void *src, size_t src_size)
 {
-    size_t zstd_ret = 0;
-    ssize_t ret = 0;
-    ZSTD_outBuffer output = {
-        .dst = dest,
-        .size = dest_size,
-        .pos = 0
-    };
-    ZSTD_inBuffer input = {
-        .src = src,
-        .size = src_size,
-        .pos = 0
-    };
-    ZSTD_DCtx *dctx = ZSTD_createDCtx();
+    ssize_t ret;
 
-    if (!dctx) {
+    ret = qemu_decompress_one(QEMU_COMPRESS_FMT_ZSTD, 0,
+                              dest, dest_size, src, src_size);
+    if (ret < 0) {
         return -EIO;
     }
-
-    /*
-     * The compressed stream from the input buffer may consist of more
-     * than one zstd frame. So we iterate until we get a fully
-     * uncompressed cluster.
-     * From zstd docs related to ZSTD_decompressStream:
-     * "return : 0 when a frame is completely decoded and fully flushed"
-     * We suppose that this means: each time ZSTD_decompressStream reads
-     * only ONE full frame and returns 0 if and only if that frame
-     * is completely decoded and flushed. Only after returning 0,
-     * ZSTD_decompressStream reads another ONE full frame.
-     */
-    while (output.pos < output.size) {
-        size_t last_in_pos = input.pos;
-        size_t last_out_pos = output.pos;
-        zstd_ret = ZSTD_decompressStream(dctx, &output, &input);
-
-        if (ZSTD_isError(zstd_ret)) {
-            ret = -EIO;
-            break;
-        }
-
-        /*
-         * The ZSTD manual is vague about what to do if it reads
-         * the buffer partially, and we don't want to get stuck
-         * in an infinite loop where ZSTD_decompressStream
-         * returns > 0 waiting for another input chunk. So, we add
-         * a check which ensures that the loop makes some progress
-         * on each step.
-         */
-        if (last_in_pos >= input.pos &&
-            last_out_pos >= output.pos) {
-            ret = -EIO;
-            break;
-        }
-    }
-    /*
-     * Make sure that we have the frame fully flushed here
-     * if not, we somehow managed to get uncompressed cluster
-     * greater then the cluster size, possibly because of its
-     * damage.
-     */
-    if (zstd_ret > 0) {
-        ret = -EIO;
-    }
-
-    ZSTD_freeDCtx(dctx);
-    assert(ret == 0 || ret == -EIO);
-    return ret;
+    /* the cluster is damaged unless we produced exactly @dest_size bytes */
+    return ret == dest_size ? 0 : -EIO;
 }
 #endif
 
@@ -347,7 +203,8 @@ qcow2_co_do_compress(BlockDriverState *bs, void *dest, size_t dest_size,
         .func = func,
     };
 
-    qcow2_co_process(bs, qcow2_compress_pool_func, &arg);
+    qcow2_co_process(bs, qcow2_compress_pool_func, &arg,
+                     qcow2_max_compress_threads());
 
     return arg.ret;
 }
@@ -475,7 +332,8 @@ qcow2_co_encdec(BlockDriverState *bs, uint64_t host_offset,
     assert(QEMU_IS_ALIGNED(host_offset, sector_size));
     assert(QEMU_IS_ALIGNED(len, sector_size));
 
-    return len == 0 ? 0 : qcow2_co_process(bs, qcow2_encdec_pool_func, &arg);
+    return len == 0 ? 0 : qcow2_co_process(bs, qcow2_encdec_pool_func, &arg,
+                                           QCOW2_MAX_THREADS);
 }
 
 /*
@@ -1946,7 +1946,7 @@ static int qcow2_open(BlockDriverState *bs, QDict *options, int flags,
     }
 
     /* Initialise locks */
-    qemu_co_mutex_init(&s->lock);
+    qemu_co_mutex_init_profiled(&s->lock, "qcow2-metadata");
 
     assert(!qemu_in_coroutine());
     assert(qemu_get_current_aio_context() == qemu_get_aio_context());
@@ -323,6 +323,8 @@ typedef struct Qcow2BitmapHeaderExt {
 } QEMU_PACKED Qcow2BitmapHeaderExt;
 
 #define QCOW2_MAX_THREADS 4
+/* Upper bound for compression worker tasks, see qcow2-threads.c */
+#define QCOW2_MAX_COMPRESS_THREADS 64
 
 typedef struct BDRVQcow2State {
     int cluster_bits;
@@ -348,6 +350,12 @@ typedef struct BDRVQcow2State {
     QEMUTimer *cache_clean_timer;
     unsigned cache_clean_interval;
 
+    /* Sequential-access detection for L2 slice readahead */
+    uint64_t l2_prefetch_next;
+    uint64_t l2_prefetch_target;
+    unsigned l2_prefetch_streak;
+    bool l2_prefetch_busy;
+
     QLIST_HEAD(, QCowL2Meta) cluster_allocs;
 
     uint64_t *refcount_table;
@@ -69,6 +69,16 @@ struct ThrottleGroup {
     /* refuse individual property change if initialization is complete */
     bool is_initialized;
     char *name; /* This is constant during the lifetime of the group */
+    char *parent_name; /* Requested parent, only used before initialization */
+
+    /* Optional parent group whose limits apply on top of this group's
+     * own limits. Resolved during initialization and constant afterwards;
+     * this group holds a reference on it. The parent's ThrottleState is
+     * only accessed under the parent's lock, which is always taken after
+     * the child's (never the other way round), so members of different
+     * children of the same parent cannot deadlock against each other.
+     */
+    ThrottleGroup *parent;
 
     QemuMutex lock; /* This lock protects the following four fields */
     ThrottleState ts;
@@ -269,6 +279,7 @@ static bool throttle_group_schedule_timer(ThrottleGroupMember *tgm,
 {
     ThrottleState *ts = tgm->throttle_state;
     ThrottleGroup *tg = container_of(ts, ThrottleGroup, ts);
+    ThrottleGroup *parent;
     ThrottleTimers *tt = &tgm->throttle_timers;
     bool must_wait;
 
@@ -283,6 +294,19 @@ static bool throttle_group_schedule_timer(ThrottleGroupMember *tgm,
 
     must_wait = throttle_schedule_timer(ts, tt, direction);
 
+    /* The request must also fit in the buckets of all ancestor groups.
+     * A child with spare credit of its own can still be delayed here if
+     * its siblings have used up the parent's budget; conversely, idle
+     * siblings leave the whole parent budget available to this child.
+     * The timer is armed on tgm, so the request is retried (and the
+     * ancestors re-checked) when the parent's deadline expires.
+     */
+    for (parent = tg->parent; parent && !must_wait; parent = parent->parent) {
+        qemu_mutex_lock(&parent->lock);
+        must_wait = throttle_schedule_timer(&parent->ts, tt, direction);
+        qemu_mutex_unlock(&parent->lock);
+    }
+
     /* If a timer just got armed, set tgm as the current token */
     if (must_wait) {
         tg->tokens[direction] = tgm;
@@ -365,6 +389,7 @@ void coroutine_fn throttle_group_co_io_limits_intercept(ThrottleGroupMember *tgm
     bool must_wait;
     ThrottleGroupMember *token;
     ThrottleGroup *tg = container_of(tgm->throttle_state, ThrottleGroup, ts);
+    ThrottleGroup *parent;
 
     assert(bytes >= 0);
     assert(direction < THROTTLE_MAX);
@@ -387,8 +412,14 @@ void coroutine_fn throttle_group_co_io_limits_intercept(ThrottleGroupMember *tgm
         tgm->pending_reqs[direction]--;
     }
 
-    /* The I/O will be executed, so do the accounting */
+    /* The I/O will be executed, so do the accounting, charging every
+     * ancestor group as well so that siblings see the credit as spent. */
     throttle_account(tgm->throttle_state, direction, bytes);
+    for (parent = tg->parent; parent; parent = parent->parent) {
+        qemu_mutex_lock(&parent->lock);
+        throttle_account(&parent->ts, direction, bytes);
+        qemu_mutex_unlock(&parent->lock);
+    }
 
     /* Schedule the next request */
     schedule_next_request(tgm, direction);
@@ -786,6 +817,20 @@ static void throttle_group_obj_complete(UserCreatable *obj, Error **errp)
         return;
     }
 
+    /* Resolve the parent group, if any. The parent must already exist, so
+     * a group can never be its own ancestor and the hierarchy is acyclic.
+     */
+    if (tg->parent_name) {
+        ThrottleGroup *parent = throttle_group_by_name(tg->parent_name);
+        if (!parent) {
+            error_setg(errp, "Parent throttle group '%s' does not exist",
+                       tg->parent_name);
+            return;
+        }
+        object_ref(OBJECT(parent));
+        tg->parent = parent;
+    }
+
     /* check validity */
     throttle_get_config(&tg->ts, &cfg);
     if (!throttle_is_valid(&cfg, errp)) {
@@ -804,7 +849,11 @@ static void throttle_group_obj_finalize(Object *obj)
     if (tg->is_initialized) {
         QTAILQ_REMOVE(&throttle_groups, tg, list);
     }
+    if (tg->parent) {
+        object_unref(OBJECT(tg->parent));
+    }
     qemu_mutex_destroy(&tg->lock);
+    g_free(tg->parent_name);
     g_free(tg->name);
 }
 
@@ -929,6 +978,27 @@ static void throttle_group_get_limits(Object *obj, Visitor *v,
     visit_type_ThrottleLimits(v, name, &argp, errp);
 }
 
+static void throttle_group_set_parent(Object *obj, const char *value,
+                                      Error **errp)
+{
+    ThrottleGroup *tg = THROTTLE_GROUP(obj);
+
+    if (tg->is_initialized) {
+        error_setg(errp, "Property cannot be set after initialization");
+        return;
+    }
+
+    g_free(tg->parent_name);
+    tg->parent_name = g_strdup(value);
+}
+
+static char *throttle_group_get_parent(Object *obj, Error **errp)
+{
+    ThrottleGroup *tg = THROTTLE_GROUP(obj);
+
+    return g_strdup(tg->parent ? tg->parent->name : tg->parent_name);
+}
+
 static bool throttle_group_can_be_deleted(UserCreatable *uc)
 {
     return OBJECT(uc)->ref == 1;
@@ -952,6 +1022,11 @@ static void throttle_group_obj_class_init(ObjectClass *klass, void *class_data)
                                   NULL, &properties[i]);
     }
 
+    /* parent group, for hierarchical limits */
+    object_class_property_add_str(klass, "parent",
+                                  throttle_group_get_parent,
+                                  throttle_group_set_parent);
+
     /* ThrottleLimits */
     object_class_property_add(klass,
                               "limits", "ThrottleLimits",
@@ -1751,18 +1751,29 @@ get_cluster_offset(BlockDriverState *bs, VmdkExtent *extent,
 static VmdkExtent *find_extent(BDRVVmdkState *s,
                                 int64_t sector_num, VmdkExtent *start_hint)
 {
-    VmdkExtent *extent = start_hint;
+    int lo = start_hint ? start_hint - s->extents : 0;
+    int hi = s->num_extents;
 
-    if (!extent) {
-        extent = &s->extents[0];
+    /* Callers walking forward usually stay within the hinted extent */
+    if (start_hint && sector_num < start_hint->end_sector) {
+        return start_hint;
     }
-    while (extent < &s->extents[s->num_extents]) {
-        if (sector_num < extent->end_sector) {
-            return extent;
+
+    /*
+     * Extents are sorted by end_sector; binary search for the first one
+     * ending past sector_num so that lookups stay cheap on images split
+     * into many extents.
+     */
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+
+        if (sector_num < s->extents[mid].end_sector) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
         }
-        extent++;
     }
-    return NULL;
+    return lo < s->num_extents ? &s->extents[lo] : NULL;
 }
 
 static inline uint64_t vmdk_find_offset_in_cluster(VmdkExtent *extent,
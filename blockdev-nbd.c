@@ -20,6 +20,7 @@
 #include "block/nbd.h"
 #include "io/channel-socket.h"
 #include "io/net-listener.h"
+#include "sysemu/iothread.h"
 
 typedef struct NBDServerData {
     QIONetListener *listener;
@@ -27,6 +28,11 @@ typedef struct NBDServerData {
     char *tlsauthz;
     uint32_t max_connections;
     uint32_t connections;
+
+    /* IOThreads that incoming connections are spread across */
+    AioContext **ctxs;
+    unsigned n_ctxs;
+    unsigned next_ctx;
 } NBDServerData;
 
 static NBDServerData *nbd_server;
@@ -60,11 +66,17 @@ static void nbd_blockdev_client_closed(NBDClient *client, bool ignored)
 static void nbd_accept(QIONetListener *listener, QIOChannelSocket *cioc,
                        gpointer opaque)
 {
+    AioContext *ctx = NULL;
+
     nbd_server->connections++;
     nbd_update_server_watch(nbd_server);
 
+    if (nbd_server->n_ctxs) {
+        ctx = nbd_server->ctxs[nbd_server->next_ctx++ % nbd_server->n_ctxs];
+    }
+
     qio_channel_set_name(QIO_CHANNEL(cioc), "nbd-server");
-    nbd_client_new(cioc, nbd_server->tlscreds, nbd_server->tlsauthz,
+    nbd_client_new(cioc, ctx, nbd_server->tlscreds, nbd_server->tlsauthz,
                    nbd_blockdev_client_closed);
 }
 
@@ -89,6 +101,7 @@ static void nbd_server_free(NBDServerData *server)
         object_unref(OBJECT(server->tlscreds));
     }
     g_free(server->tlsauthz);
+    g_free(server->ctxs);
 
     g_free(server);
 }
@@ -125,8 +138,10 @@ static QCryptoTLSCreds *nbd_get_tls_creds(const char *id, Error **errp)
 
 void nbd_server_start(SocketAddress *addr, const char *tls_creds,
                       const char *tls_authz, uint32_t max_connections,
-                      Error **errp)
+                      strList *iothreads, Error **errp)
 {
+    strList *it;
+
     if (nbd_server) {
         error_setg(errp, "NBD server already running");
         return;
@@ -134,6 +149,20 @@ void nbd_server_start(SocketAddress *addr, const char *tls_creds,
 
     nbd_server = g_new0(NBDServerData, 1);
     nbd_server->max_connections = max_connections;
+
+    for (it = iothreads; it; it = it->next) {
+        IOThread *iothread = iothread_by_id(it->value);
+
+        if (!iothread) {
+            error_setg(errp, "No IOThread with id '%s'", it->value);
+            goto error;
+        }
+        nbd_server->ctxs = g_renew(AioContext *, nbd_server->ctxs,
+                                   nbd_server->n_ctxs + 1);
+        nbd_server->ctxs[nbd_server->n_ctxs++] =
+            iothread_get_aio_context(iothread);
+    }
+
     nbd_server->listener = qio_net_listener_new();
 
     qio_net_listener_set_name(nbd_server->listener,
@@ -169,18 +198,20 @@ void nbd_server_start(SocketAddress *addr, const char *tls_creds,
 void nbd_server_start_options(NbdServerOptions *arg, Error **errp)
 {
     nbd_server_start(arg->addr, arg->tls_creds, arg->tls_authz,
-                     arg->max_connections, errp);
+                     arg->max_connections, arg->iothreads, errp);
 }
 
 void qmp_nbd_server_start(SocketAddressLegacy *addr,
                           const char *tls_creds,
                           const char *tls_authz,
                           bool has_max_connections, uint32_t max_connections,
+                          strList *iothreads,
                           Error **errp)
 {
     SocketAddress *addr_flat = socket_address_flatten(addr);
 
-    nbd_server_start(addr_flat, tls_creds, tls_authz, max_connections, errp);
+    nbd_server_start(addr_flat, tls_creds, tls_authz, max_connections,
+                     iothreads, errp);
     qapi_free_SocketAddress(addr_flat);
 }
 
@@ -48,10 +48,12 @@ static int mux_chr_write(Chardev *chr, const uint8_t *buf, int len)
     if (!d->timestamps) {
         ret = qemu_chr_fe_write(&d->chr, buf, len);
     } else {
-        int i;
-
         ret = 0;
-        for (i = 0; i < len; i++) {
+        while (ret < len) {
+            const uint8_t *nl = memchr(buf + ret, '\n', len - ret);
+            int linelen = nl ? nl - (buf + ret) + 1 : len - ret;
+            int written;
+
             if (d->linestart) {
                 char buf1[64];
                 int64_t ti;
@@ -75,8 +77,13 @@ static int mux_chr_write(Chardev *chr, const uint8_t *buf, int len)
                                       (uint8_t *)buf1, strlen(buf1));
                 d->linestart = 0;
             }
-            ret += qemu_chr_fe_write(&d->chr, buf + i, 1);
-            if (buf[i] == '\n') {
+            /* send everything up to and including the newline at once */
+            written = qemu_chr_fe_write(&d->chr, buf + ret, linelen);
+            if (written <= 0) {
+                break;
+            }
+            ret += written;
+            if (nl && written == linelen) {
                 d->linestart = 1;
             }
         }
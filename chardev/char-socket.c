@@ -27,6 +27,7 @@
 #include "io/channel-socket.h"
 #include "io/channel-websock.h"
 #include "qemu/error-report.h"
+#include "qemu/host-utils.h"
 #include "qemu/module.h"
 #include "qemu/option.h"
 #include "qapi/error.h"
@@ -36,6 +37,7 @@
 
 #include "chardev/char-io.h"
 #include "chardev/char-socket.h"
+#include "trace.h"
 
 static gboolean socket_reconnect_timeout(gpointer opaque);
 static void tcp_chr_telnet_init(Chardev *chr);
@@ -103,15 +105,163 @@ static void tcp_chr_accept(QIONetListener *listener,
 static int tcp_chr_read_poll(void *opaque);
 static void tcp_chr_disconnect_locked(Chardev *chr);
 
+static bool tcp_chr_wbuf_empty(const SocketChardev *s)
+{
+    return s->wbuf_head == s->wbuf_tail;
+}
+
+/*
+ * Send as much of the write buffer as the socket accepts right now.
+ * Called with chr_write_lock held.
+ */
+static void tcp_chr_wbuf_flush(Chardev *chr)
+{
+    SocketChardev *s = SOCKET_CHARDEV(chr);
+    size_t tail = s->wbuf_tail & (s->wbuf_size - 1);
+    size_t len = s->wbuf_head - s->wbuf_tail;
+    struct iovec iov[2];
+    unsigned int niov = 1;
+    ssize_t ret;
+
+    iov[0].iov_base = s->wbuf + tail;
+    iov[0].iov_len = MIN(len, s->wbuf_size - tail);
+    if (iov[0].iov_len < len) {
+        iov[1].iov_base = s->wbuf;
+        iov[1].iov_len = len - iov[0].iov_len;
+        niov++;
+    }
+
+    ret = qio_channel_writev(s->ioc, iov, niov, NULL);
+    if (ret > 0) {
+        s->wbuf_tail += ret;
+        s->tx_bytes += ret;
+        trace_chr_socket_flush(chr->label, ret,
+                               s->wbuf_head - s->wbuf_tail, s->tx_bytes);
+    } else if (ret != QIO_CHANNEL_ERR_BLOCK) {
+        tcp_chr_disconnect_locked(chr);
+    }
+}
+
+static void remove_write_source(SocketChardev *s)
+{
+    if (s->write_source != NULL) {
+        g_source_destroy(s->write_source);
+        g_source_unref(s->write_source);
+        s->write_source = NULL;
+    }
+}
+
+static gboolean tcp_chr_write_source_func(QIOChannel *chan,
+                                          GIOCondition cond,
+                                          void *opaque)
+{
+    Chardev *chr = CHARDEV(opaque);
+    SocketChardev *s = SOCKET_CHARDEV(opaque);
+    bool done;
+
+    qemu_mutex_lock(&chr->chr_write_lock);
+    if (s->state == TCP_CHARDEV_STATE_CONNECTED && !tcp_chr_wbuf_empty(s)) {
+        tcp_chr_wbuf_flush(chr);
+    }
+    /* flushing may have hit an error and torn down the connection */
+    done = !s->ioc || tcp_chr_wbuf_empty(s);
+    if (done && s->write_source) {
+        g_source_unref(s->write_source);
+        s->write_source = NULL;
+    }
+    qemu_mutex_unlock(&chr->chr_write_lock);
+
+    return done ? G_SOURCE_REMOVE : G_SOURCE_CONTINUE;
+}
+
+/* Called with chr_write_lock held.  */
+static int tcp_chr_write_buffered(Chardev *chr, const uint8_t *buf, int len)
+{
+    SocketChardev *s = SOCKET_CHARDEV(chr);
+    size_t done = 0;
+    size_t avail, chunk, first, pos;
+
+    if (tcp_chr_wbuf_empty(s)) {
+        /*
+         * Fast path: nothing queued yet, so hand the data straight to
+         * the socket and only buffer whatever it does not accept.
+         */
+        struct iovec iov = { .iov_base = (void *)buf, .iov_len = len };
+        ssize_t ret = qio_channel_writev(s->ioc, &iov, 1, NULL);
+
+        if (ret == QIO_CHANNEL_ERR_BLOCK) {
+            ret = 0;
+        } else if (ret < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        s->tx_bytes += ret;
+        done = ret;
+        if (done == len) {
+            return len;
+        }
+    }
+
+    avail = s->wbuf_size - (s->wbuf_head - s->wbuf_tail);
+    chunk = MIN(len - done, avail);
+    pos = s->wbuf_head & (s->wbuf_size - 1);
+    first = MIN(chunk, s->wbuf_size - pos);
+    memcpy(s->wbuf + pos, buf + done, first);
+    memcpy(s->wbuf, buf + done + first, chunk - first);
+    s->wbuf_head += chunk;
+    done += chunk;
+    trace_chr_socket_queue(chr->label, chunk, s->wbuf_head - s->wbuf_tail);
+
+    if (!tcp_chr_wbuf_empty(s) && !s->write_source) {
+        s->write_source = qio_channel_add_watch_source(
+            s->ioc, G_IO_OUT, tcp_chr_write_source_func,
+            chr, NULL, chr->gcontext);
+    }
+
+    if (done == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+    return done;
+}
+
 /* Called with chr_write_lock held.  */
 static int tcp_chr_write(Chardev *chr, const uint8_t *buf, int len)
 {
     SocketChardev *s = SOCKET_CHARDEV(chr);
 
     if (s->state == TCP_CHARDEV_STATE_CONNECTED) {
-        int ret =  io_channel_send_full(s->ioc, buf, len,
-                                        s->write_msgfds,
-                                        s->write_msgfds_num);
+        int ret;
+
+        if (s->wbuf && !s->write_msgfds_num) {
+            ret = tcp_chr_write_buffered(chr, buf, len);
+            if (ret < 0 && errno != EAGAIN) {
+                if (tcp_chr_read_poll(chr) <= 0) {
+                    tcp_chr_disconnect_locked(chr);
+                }
+            }
+            return ret;
+        }
+
+        /*
+         * Passed fds must keep their position in the byte stream, so
+         * anything still queued in the write buffer has to go first.
+         */
+        if (s->wbuf && !tcp_chr_wbuf_empty(s)) {
+            tcp_chr_wbuf_flush(chr);
+            if (s->state != TCP_CHARDEV_STATE_CONNECTED) {
+                errno = EIO;
+                return -1;
+            }
+            if (!tcp_chr_wbuf_empty(s)) {
+                errno = EAGAIN;
+                return -1;
+            }
+        }
+
+        ret = io_channel_send_full(s->ioc, buf, len,
+                                   s->write_msgfds,
+                                   s->write_msgfds_num);
 
         /* free the written msgfds in any cases
          * other than ret < 0 && errno == EAGAIN
@@ -368,6 +518,8 @@ static void tcp_chr_free_connection(Chardev *chr)
     }
 
     remove_hup_source(s);
+    remove_write_source(s);
+    s->wbuf_head = s->wbuf_tail = 0;
 
     tcp_set_msgfds(chr, NULL, 0);
     remove_fd_in_watch(chr);
@@ -1086,6 +1238,7 @@ static void char_socket_finalize(Object *obj)
 
     tcp_chr_free_connection(chr);
     tcp_chr_reconn_timer_cancel(s);
+    g_free(s->wbuf);
     qapi_free_SocketAddress(s->addr);
     tcp_chr_telnet_destroy(s);
     g_free(s->telnet_init);
@@ -1364,6 +1517,10 @@ static void qmp_chardev_open_socket(Chardev *chr,
     s->is_tn3270 = is_tn3270;
     s->is_websock = is_websock;
     s->do_nodelay = do_nodelay;
+    if (sock->has_write_buffer && sock->write_buffer) {
+        s->wbuf_size = pow2ceil(sock->write_buffer);
+        s->wbuf = g_malloc(s->wbuf_size);
+    }
     if (sock->tls_creds) {
         Object *creds;
         creds = object_resolve_path_component(
@@ -1494,6 +1651,8 @@ static void qemu_chr_parse_socket(QemuOpts *opts, ChardevBackend *backend,
     sock->wait = qemu_opt_get_bool(opts, "wait", true);
     sock->has_reconnect = qemu_opt_find(opts, "reconnect");
     sock->reconnect = qemu_opt_get_number(opts, "reconnect", 0);
+    sock->has_write_buffer = qemu_opt_find(opts, "write-buffer");
+    sock->write_buffer = qemu_opt_get_size(opts, "write-buffer", 0);
     sock->tls_creds = g_strdup(qemu_opt_get(opts, "tls-creds"));
     sock->tls_authz = g_strdup(qemu_opt_get(opts, "tls-authz"));
 
@@ -859,6 +859,9 @@ QemuOptsList qemu_chardev_opts = {
         },{
             .name = "reconnect",
             .type = QEMU_OPT_NUMBER,
+        },{
+            .name = "write-buffer",
+            .type = QEMU_OPT_SIZE,
         },{
             .name = "telnet",
             .type = QEMU_OPT_BOOL,
@@ -21,6 +21,7 @@
 #include "qemu/osdep.h"
 #include "qapi/error.h"
 #include "qemu/bswap.h"
+#include "qemu/thread.h"
 
 #include "block-luks.h"
 #include "block-luks-priv.h"
@@ -860,31 +861,33 @@ cleanup:
 }
 
 /*
- * Given a key slot, and user password, this will attempt to unlock
- * the master encryption key from the key slot.
+ * Given the pre-read key material of a key slot, this runs the
+ * CPU-bound part of unlocking it: derive the candidate key from the
+ * user password, decrypt and join the split master key and check the
+ * result against the master key digest.  @splitkey is decrypted in
+ * place.
+ *
+ * This reads no mutable state from @block, so several slots may be
+ * tried concurrently from different threads.
  *
  * Returns:
- *    0 if the key slot is disabled, or key could not be decrypted
- *      with the provided password
- *    1 if the key slot is enabled, and key decrypted successfully
- *      with the provided password
- *   -1 if a fatal error occurred loading the key
+ *    0 if the key could not be decrypted with the provided password
+ *    1 if the key was decrypted successfully with the provided
+ *      password
+ *   -1 if a fatal error occurred
  */
 static int
-qcrypto_block_luks_load_key(QCryptoBlock *block,
-                            size_t slot_idx,
-                            const char *password,
-                            uint8_t *masterkey,
-                            QCryptoBlockReadFunc readfunc,
-                            void *opaque,
-                            Error **errp)
+qcrypto_block_luks_try_key(QCryptoBlock *block,
+                           size_t slot_idx,
+                           const char *password,
+                           uint8_t *splitkey,
+                           size_t splitkeylen,
+                           uint8_t *masterkey,
+                           Error **errp)
 {
     QCryptoBlockLUKS *luks = block->opaque;
     const QCryptoBlockLUKSKeySlot *slot;
-    g_autofree uint8_t *splitkey = NULL;
-    size_t splitkeylen;
     g_autofree uint8_t *possiblekey = NULL;
-    int rv;
     g_autoptr(QCryptoCipher) cipher = NULL;
     uint8_t keydigest[QCRYPTO_BLOCK_LUKS_DIGEST_LEN];
     g_autoptr(QCryptoIVGen) ivgen = NULL;
@@ -892,12 +895,7 @@ qcrypto_block_luks_load_key(QCryptoBlock *block,
 
     assert(slot_idx < QCRYPTO_BLOCK_LUKS_NUM_KEY_SLOTS);
     slot = &luks->header.key_slots[slot_idx];
-    if (slot->active != QCRYPTO_BLOCK_LUKS_KEY_SLOT_ENABLED) {
-        return 0;
-    }
 
-    splitkeylen = luks->header.master_key_len * slot->stripes;
-    splitkey = g_new0(uint8_t, splitkeylen);
     possiblekey = g_new0(uint8_t, luks->header.master_key_len);
 
     /*
@@ -916,22 +914,6 @@ qcrypto_block_luks_load_key(QCryptoBlock *block,
         return -1;
     }
 
-    /*
-     * We need to read the master key material from the
-     * LUKS key material header. What we're reading is
-     * not the raw master key, but rather the data after
-     * it has been passed through AFSplit and the result
-     * then encrypted.
-     */
-    rv = readfunc(block,
-                  slot->key_offset_sector * QCRYPTO_BLOCK_LUKS_SECTOR_SIZE,
-                  splitkey, splitkeylen,
-                  opaque,
-                  errp);
-    if (rv < 0) {
-        return -1;
-    }
-
 
     /* Setup the cipher/ivgen that we'll use to try to decrypt
      * the split master key material */
@@ -1021,11 +1003,96 @@ qcrypto_block_luks_load_key(QCryptoBlock *block,
     return 0;
 }
 
+/*
+ * Given a key slot, and user password, this will attempt to unlock
+ * the master encryption key from the key slot.
+ *
+ * Returns:
+ *    0 if the key slot is disabled, or key could not be decrypted
+ *      with the provided password
+ *    1 if the key slot is enabled, and key decrypted successfully
+ *      with the provided password
+ *   -1 if a fatal error occurred loading the key
+ */
+static int
+qcrypto_block_luks_load_key(QCryptoBlock *block,
+                            size_t slot_idx,
+                            const char *password,
+                            uint8_t *masterkey,
+                            QCryptoBlockReadFunc readfunc,
+                            void *opaque,
+                            Error **errp)
+{
+    QCryptoBlockLUKS *luks = block->opaque;
+    const QCryptoBlockLUKSKeySlot *slot;
+    g_autofree uint8_t *splitkey = NULL;
+    size_t splitkeylen;
+    int rv;
+
+    assert(slot_idx < QCRYPTO_BLOCK_LUKS_NUM_KEY_SLOTS);
+    slot = &luks->header.key_slots[slot_idx];
+    if (slot->active != QCRYPTO_BLOCK_LUKS_KEY_SLOT_ENABLED) {
+        return 0;
+    }
+
+    /*
+     * We need to read the master key material from the
+     * LUKS key material header. What we're reading is
+     * not the raw master key, but rather the data after
+     * it has been passed through AFSplit and the result
+     * then encrypted.
+     */
+    splitkeylen = luks->header.master_key_len * slot->stripes;
+    splitkey = g_new0(uint8_t, splitkeylen);
+
+    rv = readfunc(block,
+                  slot->key_offset_sector * QCRYPTO_BLOCK_LUKS_SECTOR_SIZE,
+                  splitkey, splitkeylen,
+                  opaque,
+                  errp);
+    if (rv < 0) {
+        return -1;
+    }
+
+    return qcrypto_block_luks_try_key(block, slot_idx, password,
+                                      splitkey, splitkeylen,
+                                      masterkey, errp);
+}
+
+typedef struct QCryptoBlockLUKSKeyJob QCryptoBlockLUKSKeyJob;
+struct QCryptoBlockLUKSKeyJob {
+    QCryptoBlock *block;
+    size_t slot_idx;
+    const char *password;
+    uint8_t *splitkey;
+    size_t splitkeylen;
+    uint8_t *masterkey;
+    QemuThread thread;
+    int rv;
+    Error *err;
+};
+
+static void *qcrypto_block_luks_try_key_thread(void *opaque)
+{
+    QCryptoBlockLUKSKeyJob *job = opaque;
+
+    job->rv = qcrypto_block_luks_try_key(job->block, job->slot_idx,
+                                         job->password,
+                                         job->splitkey, job->splitkeylen,
+                                         job->masterkey, &job->err);
+    return NULL;
+}
 
 /*
- * Given a user password, this will iterate over all key
- * slots and try to unlock each active key slot using the
- * password until it successfully obtains a master key.
+ * Given a user password, this will try to unlock each active key
+ * slot using the password until it successfully obtains a master
+ * key.
+ *
+ * The key material of all active slots is read up front and the
+ * expensive key derivation then runs for all slots concurrently, so
+ * unlocking a volume with several key slots costs one PBKDF2 wall
+ * clock time instead of one per slot.  The outcome is decided in
+ * slot order, as if the slots had been tried one after another.
  *
  * Returns 0 if a key was loaded, -1 if no keys could be loaded
  */
@@ -1037,28 +1104,80 @@ qcrypto_block_luks_find_key(QCryptoBlock *block,
                             void *opaque,
                             Error **errp)
 {
-    size_t i;
-    int rv;
+    ERRP_GUARD();
+    QCryptoBlockLUKS *luks = block->opaque;
+    QCryptoBlockLUKSKeyJob jobs[QCRYPTO_BLOCK_LUKS_NUM_KEY_SLOTS];
+    size_t i, njobs = 0;
+    int ret = -1;
 
     for (i = 0; i < QCRYPTO_BLOCK_LUKS_NUM_KEY_SLOTS; i++) {
-        rv = qcrypto_block_luks_load_key(block,
-                                         i,
-                                         password,
-                                         masterkey,
-                                         readfunc,
-                                         opaque,
-                                         errp);
-        if (rv < 0) {
-            goto error;
+        const QCryptoBlockLUKSKeySlot *slot = &luks->header.key_slots[i];
+        QCryptoBlockLUKSKeyJob *job;
+
+        if (slot->active != QCRYPTO_BLOCK_LUKS_KEY_SLOT_ENABLED) {
+            continue;
         }
-        if (rv == 1) {
-            return 0;
+
+        job = &jobs[njobs++];
+        *job = (QCryptoBlockLUKSKeyJob) {
+            .block = block,
+            .slot_idx = i,
+            .password = password,
+            .splitkeylen = luks->header.master_key_len * slot->stripes,
+        };
+        job->splitkey = g_new0(uint8_t, job->splitkeylen);
+        job->masterkey = g_new0(uint8_t, luks->header.master_key_len);
+
+        if (readfunc(block,
+                     slot->key_offset_sector * QCRYPTO_BLOCK_LUKS_SECTOR_SIZE,
+                     job->splitkey, job->splitkeylen,
+                     opaque,
+                     errp) < 0) {
+            njobs--;
+            g_free(job->splitkey);
+            g_free(job->masterkey);
+            goto cleanup;
         }
     }
 
-    error_setg(errp, "Invalid password, cannot unlock any keyslot");
- error:
-    return -1;
+    if (njobs == 1) {
+        qcrypto_block_luks_try_key_thread(&jobs[0]);
+    } else {
+        for (i = 0; i < njobs; i++) {
+            qemu_thread_create(&jobs[i].thread, "luks-keyslot",
+                               qcrypto_block_luks_try_key_thread, &jobs[i],
+                               QEMU_THREAD_JOINABLE);
+        }
+        for (i = 0; i < njobs; i++) {
+            qemu_thread_join(&jobs[i].thread);
+        }
+    }
+
+    for (i = 0; i < njobs; i++) {
+        if (jobs[i].rv == 1) {
+            memcpy(masterkey, jobs[i].masterkey,
+                   luks->header.master_key_len);
+            ret = 0;
+            break;
+        }
+        if (jobs[i].rv < 0) {
+            error_propagate(errp, jobs[i].err);
+            jobs[i].err = NULL;
+            break;
+        }
+    }
+
+    if (ret < 0 && !*errp) {
+        error_setg(errp, "Invalid password, cannot unlock any keyslot");
+    }
+
+ cleanup:
+    for (i = 0; i < njobs; i++) {
+        error_free(jobs[i].err);
+        g_free(jobs[i].splitkey);
+        g_free(jobs[i].masterkey);
+    }
+    return ret;
 }
 
 /*
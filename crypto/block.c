@@ -373,6 +373,15 @@ static int do_qcrypto_block_cipher_encdec(QCryptoCipher *cipher,
     assert(QEMU_IS_ALIGNED(offset, sectorsize));
     assert(QEMU_IS_ALIGNED(len, sectorsize));
 
+    /*
+     * Stateless IV generators (plain64 in the default LUKS setup)
+     * need no serialization, so don't pay for a lock/unlock pair on
+     * every sector of a large request.
+     */
+    if (ivgen_mutex && qcrypto_ivgen_is_stateless(ivgen)) {
+        ivgen_mutex = NULL;
+    }
+
     while (len > 0) {
         size_t nbytes;
         if (niv) {
@@ -56,5 +56,6 @@ struct QCryptoIVGenDriver qcrypto_ivgen_plain = {
     .init = qcrypto_ivgen_plain_init,
     .calculate = qcrypto_ivgen_plain_calculate,
     .cleanup = qcrypto_ivgen_plain_cleanup,
+    .stateless = true,
 };
 
@@ -79,6 +79,12 @@ QCryptoIVGenAlgorithm qcrypto_ivgen_get_algorithm(QCryptoIVGen *ivgen)
 }
 
 
+bool qcrypto_ivgen_is_stateless(QCryptoIVGen *ivgen)
+{
+    return ivgen->driver->stateless;
+}
+
+
 QCryptoCipherAlgorithm qcrypto_ivgen_get_cipher(QCryptoIVGen *ivgen)
 {
     return ivgen->cipher;
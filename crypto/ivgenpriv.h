@@ -34,6 +34,12 @@ struct QCryptoIVGenDriver {
                      uint8_t *iv, size_t niv,
                      Error **errp);
     void (*cleanup)(QCryptoIVGen *ivgen);
+
+    /*
+     * Set when calculate() touches no mutable state, so that it
+     * may be called concurrently without serialization
+     */
+    bool stateless;
 };
 
 struct QCryptoIVGen {
@@ -32,6 +32,7 @@
 
 
 #include <gnutls/x509.h>
+#include <gnutls/socket.h>
 
 
 struct QCryptoTLSSession {
@@ -438,6 +439,38 @@ qcrypto_tls_session_set_callbacks(QCryptoTLSSession *session,
 }
 
 
+void
+qcrypto_tls_session_set_transport_fd(QCryptoTLSSession *session,
+                                     int fd)
+{
+    session->writeFunc = NULL;
+    session->readFunc = NULL;
+    session->opaque = NULL;
+
+    /*
+     * Passing NULL restores the library's default push/pull
+     * functions, which operate on the descriptor set below and are
+     * a prerequisite for it to install kernel TLS offload on the
+     * socket after the handshake.
+     */
+    gnutls_transport_set_push_function(session->handle, NULL);
+    gnutls_transport_set_pull_function(session->handle, NULL);
+    gnutls_transport_set_int(session->handle, fd);
+}
+
+
+bool
+qcrypto_tls_session_get_ktls_enabled(QCryptoTLSSession *session)
+{
+#if GNUTLS_VERSION_NUMBER >= 0x030703
+    return gnutls_transport_is_ktls_enabled(session->handle) ==
+        GNUTLS_KTLS_DUPLEX;
+#else
+    return false;
+#endif
+}
+
+
 ssize_t
 qcrypto_tls_session_write(QCryptoTLSSession *session,
                           const char *buf,
@@ -602,6 +635,20 @@ qcrypto_tls_session_set_callbacks(
 }
 
 
+void
+qcrypto_tls_session_set_transport_fd(QCryptoTLSSession *sess G_GNUC_UNUSED,
+                                     int fd G_GNUC_UNUSED)
+{
+}
+
+
+bool
+qcrypto_tls_session_get_ktls_enabled(QCryptoTLSSession *sess G_GNUC_UNUSED)
+{
+    return false;
+}
+
+
 ssize_t
 qcrypto_tls_session_write(QCryptoTLSSession *sess,
                           const char *buf,
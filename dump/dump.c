@@ -1444,6 +1444,35 @@ static void free_data_cache(DataCache *data_cache)
     g_free(data_cache->buf);
 }
 
+/* maximum number of page compression worker threads */
+#define DUMP_NR_COMPRESS_WORKERS_MAX    16
+
+/*
+ * Page compression worker for write_dump_pages(). The main thread hands
+ * each worker one page at a time and collects the results in submission
+ * order, so the resulting vmcore is identical to a single-threaded dump.
+ */
+typedef struct DumpCompressWorker {
+    DumpState *s;
+    QemuThread thread;
+    QemuMutex mutex;
+    QemuCond cond;
+    bool busy;          /* page submitted and not collected yet */
+    bool done;          /* worker finished compressing the page */
+    bool quit;
+    /* page to compress */
+    uint8_t *in;
+    /* compression result */
+    bool is_zero;
+    uint32_t flags;     /* DUMP_DH_COMPRESSED_* or 0 for plaintext */
+    size_t size_out;    /* size of the data at @out */
+    size_t len_buf_out; /* allocated size of @out */
+    uint8_t *out;
+#ifdef CONFIG_LZO
+    lzo_bytep wrkmem;
+#endif
+} DumpCompressWorker;
+
 static size_t get_len_buf_out(size_t page_size, uint32_t flag_compress)
 {
     switch (flag_compress) {
@@ -1466,21 +1495,201 @@ static size_t get_len_buf_out(size_t page_size, uint32_t flag_compress)
     return 0;
 }
 
+static void dump_compress_page(DumpCompressWorker *w)
+{
+    DumpState *s = w->s;
+    size_t page_size = s->dump_info.page_size;
+    size_t size_out;
+
+    w->is_zero = buffer_is_zero(w->in, page_size);
+    if (w->is_zero) {
+        return;
+    }
+
+    /*
+     * only one compression format will be used here, for s->flag_compress
+     * is set. But when compression fails to work, we fall back to save in
+     * plaintext.
+     */
+    size_out = w->len_buf_out;
+    if ((s->flag_compress & DUMP_DH_COMPRESSED_ZLIB) &&
+            (compress2(w->out, (uLongf *)&size_out, w->in,
+                       page_size, Z_BEST_SPEED) == Z_OK) &&
+            (size_out < page_size)) {
+        w->flags = DUMP_DH_COMPRESSED_ZLIB;
+        w->size_out = size_out;
+#ifdef CONFIG_LZO
+    } else if ((s->flag_compress & DUMP_DH_COMPRESSED_LZO) &&
+            (lzo1x_1_compress(w->in, page_size, w->out,
+            (lzo_uint *)&size_out, w->wrkmem) == LZO_E_OK) &&
+            (size_out < page_size)) {
+        w->flags = DUMP_DH_COMPRESSED_LZO;
+        w->size_out = size_out;
+#endif
+#ifdef CONFIG_SNAPPY
+    } else if ((s->flag_compress & DUMP_DH_COMPRESSED_SNAPPY) &&
+            (snappy_compress((char *)w->in, page_size,
+            (char *)w->out, &size_out) == SNAPPY_OK) &&
+            (size_out < page_size)) {
+        w->flags = DUMP_DH_COMPRESSED_SNAPPY;
+        w->size_out = size_out;
+#endif
+    } else {
+        /*
+         * fall back to save in plaintext, size_out should be
+         * assigned the target's page size
+         */
+        w->flags = 0;
+        w->size_out = page_size;
+        memcpy(w->out, w->in, page_size);
+    }
+}
+
+static void *dump_compress_worker_thread(void *opaque)
+{
+    DumpCompressWorker *w = opaque;
+
+    qemu_mutex_lock(&w->mutex);
+    while (true) {
+        while (!w->quit && !(w->busy && !w->done)) {
+            qemu_cond_wait(&w->cond, &w->mutex);
+        }
+        if (w->quit) {
+            break;
+        }
+        qemu_mutex_unlock(&w->mutex);
+
+        dump_compress_page(w);
+
+        qemu_mutex_lock(&w->mutex);
+        w->done = true;
+        qemu_cond_signal(&w->cond);
+    }
+    qemu_mutex_unlock(&w->mutex);
+
+    return NULL;
+}
+
+/*
+ * Wait for the worker's page, then write its descriptor and data to the
+ * caches. Must be called in page submission order to keep the vmcore layout
+ * sequential.
+ */
+static int dump_compress_collect(DumpCompressWorker *w,
+                                 DataCache *page_desc, DataCache *page_data,
+                                 const PageDescriptor *pd_zero,
+                                 off_t *offset_data, Error **errp)
+{
+    DumpState *s = w->s;
+    PageDescriptor pd;
+    int ret;
+
+    qemu_mutex_lock(&w->mutex);
+    while (!w->done) {
+        qemu_cond_wait(&w->cond, &w->mutex);
+    }
+    w->busy = false;
+    w->done = false;
+    qemu_mutex_unlock(&w->mutex);
+
+    if (w->is_zero) {
+        /* zero pages all share the page data written up front */
+        ret = write_cache(page_desc, pd_zero, sizeof(PageDescriptor), false);
+        if (ret < 0) {
+            error_setg(errp, "dump: failed to write page desc");
+            return -1;
+        }
+    } else {
+        ret = write_cache(page_data, w->out, w->size_out, false);
+        if (ret < 0) {
+            error_setg(errp, "dump: failed to write page data");
+            return -1;
+        }
+
+        pd.flags = cpu_to_dump32(s, w->flags);
+        pd.size = cpu_to_dump32(s, w->size_out);
+        pd.page_flags = cpu_to_dump64(s, 0);
+        pd.offset = cpu_to_dump64(s, *offset_data);
+        *offset_data += w->size_out;
+
+        ret = write_cache(page_desc, &pd, sizeof(PageDescriptor), false);
+        if (ret < 0) {
+            error_setg(errp, "dump: failed to write page desc");
+            return -1;
+        }
+    }
+    s->written_size += s->dump_info.page_size;
+
+    return 0;
+}
+
+static DumpCompressWorker *dump_compress_workers_setup(DumpState *s,
+                                                       size_t len_buf_out,
+                                                       int nr_workers)
+{
+    DumpCompressWorker *workers = g_new0(DumpCompressWorker, nr_workers);
+    int i;
+
+    for (i = 0; i < nr_workers; i++) {
+        DumpCompressWorker *w = &workers[i];
+
+        w->s = s;
+        w->in = g_malloc(s->dump_info.page_size);
+        w->out = g_malloc(len_buf_out);
+        w->len_buf_out = len_buf_out;
+#ifdef CONFIG_LZO
+        w->wrkmem = g_malloc(LZO1X_1_MEM_COMPRESS);
+#endif
+        qemu_mutex_init(&w->mutex);
+        qemu_cond_init(&w->cond);
+        qemu_thread_create(&w->thread, "dump_compress",
+                           dump_compress_worker_thread, w,
+                           QEMU_THREAD_JOINABLE);
+    }
+
+    return workers;
+}
+
+static void dump_compress_workers_cleanup(DumpCompressWorker *workers,
+                                          int nr_workers)
+{
+    int i;
+
+    for (i = 0; i < nr_workers; i++) {
+        qemu_mutex_lock(&workers[i].mutex);
+        workers[i].quit = true;
+        qemu_cond_signal(&workers[i].cond);
+        qemu_mutex_unlock(&workers[i].mutex);
+    }
+    for (i = 0; i < nr_workers; i++) {
+        DumpCompressWorker *w = &workers[i];
+
+        qemu_thread_join(&w->thread);
+        qemu_mutex_destroy(&w->mutex);
+        qemu_cond_destroy(&w->cond);
+        g_free(w->in);
+        g_free(w->out);
+#ifdef CONFIG_LZO
+        g_free(w->wrkmem);
+#endif
+    }
+    g_free(workers);
+}
+
 static void write_dump_pages(DumpState *s, Error **errp)
 {
     int ret = 0;
     DataCache page_desc, page_data;
-    size_t len_buf_out, size_out;
-#ifdef CONFIG_LZO
-    lzo_bytep wrkmem = NULL;
-#endif
-    uint8_t *buf_out = NULL;
+    size_t len_buf_out;
     off_t offset_desc, offset_data;
-    PageDescriptor pd, pd_zero;
+    PageDescriptor pd_zero;
     uint8_t *buf;
     GuestPhysBlock *block_iter = NULL;
     uint64_t pfn_iter;
     g_autofree uint8_t *page = NULL;
+    DumpCompressWorker *workers;
+    uint64_t submitted = 0;
+    int i, nr_workers;
 
     /* get offset of page_desc and page_data in dump file */
     offset_desc = s->offset_page;
@@ -1493,11 +1702,8 @@ static void write_dump_pages(DumpState *s, Error **errp)
     len_buf_out = get_len_buf_out(s->dump_info.page_size, s->flag_compress);
     assert(len_buf_out != 0);
 
-#ifdef CONFIG_LZO
-    wrkmem = g_malloc(LZO1X_1_MEM_COMPRESS);
-#endif
-
-    buf_out = g_malloc(len_buf_out);
+    nr_workers = MIN(g_get_num_processors(), DUMP_NR_COMPRESS_WORKERS_MAX);
+    workers = dump_compress_workers_setup(s, len_buf_out, nr_workers);
 
     /*
      * init zero page's page_desc and page_data, because every zero page
@@ -1520,99 +1726,37 @@ static void write_dump_pages(DumpState *s, Error **errp)
 
     /*
      * dump memory to vmcore page by page. zero page will all be resided in the
-     * first page of page section
+     * first page of page section. Pages are compressed by the worker threads
+     * and collected in submission order, so the layout of the vmcore does not
+     * depend on the number of workers.
      */
     for (buf = page; get_next_page(&block_iter, &pfn_iter, &buf, s); buf = page) {
-        /* check zero page */
-        if (buffer_is_zero(buf, s->dump_info.page_size)) {
-            ret = write_cache(&page_desc, &pd_zero, sizeof(PageDescriptor),
-                              false);
-            if (ret < 0) {
-                error_setg(errp, "dump: failed to write page desc");
-                goto out;
-            }
-        } else {
-            /*
-             * not zero page, then:
-             * 1. compress the page
-             * 2. write the compressed page into the cache of page_data
-             * 3. get page desc of the compressed page and write it into the
-             *    cache of page_desc
-             *
-             * only one compression format will be used here, for
-             * s->flag_compress is set. But when compression fails to work,
-             * we fall back to save in plaintext.
-             */
-             size_out = len_buf_out;
-             if ((s->flag_compress & DUMP_DH_COMPRESSED_ZLIB) &&
-                    (compress2(buf_out, (uLongf *)&size_out, buf,
-                               s->dump_info.page_size, Z_BEST_SPEED) == Z_OK) &&
-                    (size_out < s->dump_info.page_size)) {
-                pd.flags = cpu_to_dump32(s, DUMP_DH_COMPRESSED_ZLIB);
-                pd.size  = cpu_to_dump32(s, size_out);
-
-                ret = write_cache(&page_data, buf_out, size_out, false);
-                if (ret < 0) {
-                    error_setg(errp, "dump: failed to write page data");
-                    goto out;
-                }
-#ifdef CONFIG_LZO
-            } else if ((s->flag_compress & DUMP_DH_COMPRESSED_LZO) &&
-                    (lzo1x_1_compress(buf, s->dump_info.page_size, buf_out,
-                    (lzo_uint *)&size_out, wrkmem) == LZO_E_OK) &&
-                    (size_out < s->dump_info.page_size)) {
-                pd.flags = cpu_to_dump32(s, DUMP_DH_COMPRESSED_LZO);
-                pd.size  = cpu_to_dump32(s, size_out);
-
-                ret = write_cache(&page_data, buf_out, size_out, false);
-                if (ret < 0) {
-                    error_setg(errp, "dump: failed to write page data");
-                    goto out;
-                }
-#endif
-#ifdef CONFIG_SNAPPY
-            } else if ((s->flag_compress & DUMP_DH_COMPRESSED_SNAPPY) &&
-                    (snappy_compress((char *)buf, s->dump_info.page_size,
-                    (char *)buf_out, &size_out) == SNAPPY_OK) &&
-                    (size_out < s->dump_info.page_size)) {
-                pd.flags = cpu_to_dump32(s, DUMP_DH_COMPRESSED_SNAPPY);
-                pd.size  = cpu_to_dump32(s, size_out);
-
-                ret = write_cache(&page_data, buf_out, size_out, false);
-                if (ret < 0) {
-                    error_setg(errp, "dump: failed to write page data");
-                    goto out;
-                }
-#endif
-            } else {
-                /*
-                 * fall back to save in plaintext, size_out should be
-                 * assigned the target's page size
-                 */
-                pd.flags = cpu_to_dump32(s, 0);
-                size_out = s->dump_info.page_size;
-                pd.size = cpu_to_dump32(s, size_out);
-
-                ret = write_cache(&page_data, buf,
-                                  s->dump_info.page_size, false);
-                if (ret < 0) {
-                    error_setg(errp, "dump: failed to write page data");
-                    goto out;
-                }
-            }
+        DumpCompressWorker *w = &workers[submitted % nr_workers];
 
-            /* get and write page desc here */
-            pd.page_flags = cpu_to_dump64(s, 0);
-            pd.offset = cpu_to_dump64(s, offset_data);
-            offset_data += size_out;
+        if (w->busy &&
+            dump_compress_collect(w, &page_desc, &page_data, &pd_zero,
+                                  &offset_data, errp) < 0) {
+            goto out;
+        }
 
-            ret = write_cache(&page_desc, &pd, sizeof(PageDescriptor), false);
-            if (ret < 0) {
-                error_setg(errp, "dump: failed to write page desc");
-                goto out;
-            }
+        memcpy(w->in, buf, s->dump_info.page_size);
+        qemu_mutex_lock(&w->mutex);
+        w->busy = true;
+        w->done = false;
+        qemu_cond_signal(&w->cond);
+        qemu_mutex_unlock(&w->mutex);
+        submitted++;
+    }
+
+    /* collect the pages that are still being compressed, oldest first */
+    for (i = 0; i < nr_workers; i++) {
+        DumpCompressWorker *w = &workers[(submitted + i) % nr_workers];
+
+        if (w->busy &&
+            dump_compress_collect(w, &page_desc, &page_data, &pd_zero,
+                                  &offset_data, errp) < 0) {
+            goto out;
         }
-        s->written_size += s->dump_info.page_size;
     }
 
     ret = write_cache(&page_desc, NULL, 0, true);
@@ -1627,14 +1771,9 @@ static void write_dump_pages(DumpState *s, Error **errp)
     }
 
 out:
+    dump_compress_workers_cleanup(workers, nr_workers);
     free_data_cache(&page_desc);
     free_data_cache(&page_data);
-
-#ifdef CONFIG_LZO
-    g_free(wrkmem);
-#endif
-
-    g_free(buf_out);
 }
 
 static void create_kdump_vmcore(DumpState *s, Error **errp)
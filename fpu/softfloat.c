@@ -2990,10 +2990,28 @@ float16 float16_round_to_int(float16 a, float_status *s)
     return float16_round_pack_canonical(&p, s);
 }
 
+/*
+ * Hardfloat is usable for round-to-int and float-to-int conversions when
+ * the preconditions of can_use_fpu hold, the inputs need no flushing,
+ * and (for conversions) the rounded value is representable in the
+ * destination type.  Within those bounds the only exception that can be
+ * raised is inexact, which per can_use_fpu is already set.  NaNs fail
+ * the range comparisons and take the soft path, as do values that might
+ * overflow, which must raise invalid.
+ */
+
 float32 float32_round_to_int(float32 a, float_status *s)
 {
     FloatParts64 p;
 
+    if (can_use_fpu(s) && !s->flush_inputs_to_zero &&
+        likely(float32_is_zero_or_normal(a))) {
+        union_float32 ua = { .s = a };
+
+        ua.h = rintf(ua.h);
+        return ua.s;
+    }
+
     float32_unpack_canonical(&p, a, s);
     parts_round_to_int(&p, s->float_rounding_mode, 0, s, &float32_params);
     return float32_round_pack_canonical(&p, s);
@@ -3003,6 +3021,14 @@ float64 float64_round_to_int(float64 a, float_status *s)
 {
     FloatParts64 p;
 
+    if (can_use_fpu(s) && !s->flush_inputs_to_zero &&
+        likely(float64_is_zero_or_normal(a))) {
+        union_float64 ua = { .s = a };
+
+        ua.h = rint(ua.h);
+        return ua.s;
+    }
+
     float64_unpack_canonical(&p, a, s);
     parts_round_to_int(&p, s->float_rounding_mode, 0, s, &float64_params);
     return float64_round_pack_canonical(&p, s);
@@ -3290,11 +3316,28 @@ int16_t float32_to_int16(float32 a, float_status *s)
 
 int32_t float32_to_int32(float32 a, float_status *s)
 {
+    if (can_use_fpu(s) && !s->flush_inputs_to_zero) {
+        union_float32 ua = { .s = a };
+        float r = rintf(ua.h);
+
+        /* NaNs and values that might overflow fail the comparison. */
+        if (r >= -0x1p31f && r < 0x1p31f) {
+            return r;
+        }
+    }
     return float32_to_int32_scalbn(a, s->float_rounding_mode, 0, s);
 }
 
 int64_t float32_to_int64(float32 a, float_status *s)
 {
+    if (can_use_fpu(s) && !s->flush_inputs_to_zero) {
+        union_float32 ua = { .s = a };
+        float r = rintf(ua.h);
+
+        if (r >= -0x1p63f && r < 0x1p63f) {
+            return r;
+        }
+    }
     return float32_to_int64_scalbn(a, s->float_rounding_mode, 0, s);
 }
 
@@ -3305,11 +3348,27 @@ int16_t float64_to_int16(float64 a, float_status *s)
 
 int32_t float64_to_int32(float64 a, float_status *s)
 {
+    if (can_use_fpu(s) && !s->flush_inputs_to_zero) {
+        union_float64 ua = { .s = a };
+        double r = rint(ua.h);
+
+        if (r >= -0x1p31 && r < 0x1p31) {
+            return r;
+        }
+    }
     return float64_to_int32_scalbn(a, s->float_rounding_mode, 0, s);
 }
 
 int64_t float64_to_int64(float64 a, float_status *s)
 {
+    if (can_use_fpu(s) && !s->flush_inputs_to_zero) {
+        union_float64 ua = { .s = a };
+        double r = rint(ua.h);
+
+        if (r >= -0x1p63 && r < 0x1p63) {
+            return r;
+        }
+    }
     return float64_to_int64_scalbn(a, s->float_rounding_mode, 0, s);
 }
 
@@ -3360,11 +3419,27 @@ int16_t float32_to_int16_round_to_zero(float32 a, float_status *s)
 
 int32_t float32_to_int32_round_to_zero(float32 a, float_status *s)
 {
+    if (can_use_fpu(s) && !s->flush_inputs_to_zero) {
+        union_float32 ua = { .s = a };
+        float r = truncf(ua.h);
+
+        if (r >= -0x1p31f && r < 0x1p31f) {
+            return r;
+        }
+    }
     return float32_to_int32_scalbn(a, float_round_to_zero, 0, s);
 }
 
 int64_t float32_to_int64_round_to_zero(float32 a, float_status *s)
 {
+    if (can_use_fpu(s) && !s->flush_inputs_to_zero) {
+        union_float32 ua = { .s = a };
+        float r = truncf(ua.h);
+
+        if (r >= -0x1p63f && r < 0x1p63f) {
+            return r;
+        }
+    }
     return float32_to_int64_scalbn(a, float_round_to_zero, 0, s);
 }
 
@@ -3375,11 +3450,27 @@ int16_t float64_to_int16_round_to_zero(float64 a, float_status *s)
 
 int32_t float64_to_int32_round_to_zero(float64 a, float_status *s)
 {
+    if (can_use_fpu(s) && !s->flush_inputs_to_zero) {
+        union_float64 ua = { .s = a };
+        double r = trunc(ua.h);
+
+        if (r >= -0x1p31 && r < 0x1p31) {
+            return r;
+        }
+    }
     return float64_to_int32_scalbn(a, float_round_to_zero, 0, s);
 }
 
 int64_t float64_to_int64_round_to_zero(float64 a, float_status *s)
 {
+    if (can_use_fpu(s) && !s->flush_inputs_to_zero) {
+        union_float64 ua = { .s = a };
+        double r = trunc(ua.h);
+
+        if (r >= -0x1p63 && r < 0x1p63) {
+            return r;
+        }
+    }
     return float64_to_int64_scalbn(a, float_round_to_zero, 0, s);
 }
 
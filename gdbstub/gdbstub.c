@@ -1310,6 +1310,44 @@ static void handle_read_mem(GArray *params, void *user_ctx)
     gdb_put_strbuf();
 }
 
+static void handle_read_mem_binary(GArray *params, void *user_ctx)
+{
+    if (params->len != 2) {
+        gdb_put_packet("E22");
+        return;
+    }
+
+    /* An 'x' packet with a zero length is a probe for support */
+    if (!get_param(params, 1)->val_ull) {
+        gdb_put_packet("OK");
+        return;
+    }
+
+    /* Worst case, gdb_memtox() escaping doubles the required space */
+    if (get_param(params, 1)->val_ull > (MAX_PACKET_LENGTH - 1) / 2) {
+        gdb_put_packet("E22");
+        return;
+    }
+
+    g_byte_array_set_size(gdbserver_state.mem_buf,
+                          get_param(params, 1)->val_ull);
+
+    if (gdb_target_memory_rw_debug(gdbserver_state.g_cpu,
+                                   get_param(params, 0)->val_ull,
+                                   gdbserver_state.mem_buf->data,
+                                   gdbserver_state.mem_buf->len, false)) {
+        gdb_put_packet("E14");
+        return;
+    }
+
+    g_string_assign(gdbserver_state.str_buf, "b");
+    gdb_memtox(gdbserver_state.str_buf,
+               (const char *)gdbserver_state.mem_buf->data,
+               gdbserver_state.mem_buf->len);
+    gdb_put_packet_binary(gdbserver_state.str_buf->str,
+                          gdbserver_state.str_buf->len, true);
+}
+
 static void handle_write_all_regs(GArray *params, void *user_ctx)
 {
     int reg_id;
@@ -1681,7 +1719,8 @@ static void handle_query_supported(GArray *params, void *user_ctx)
 #endif
     }
 
-    g_string_append(gdbserver_state.str_buf, ";vContSupported+;multiprocess+");
+    g_string_append(gdbserver_state.str_buf,
+                    ";vContSupported+;multiprocess+;binary-upload+");
     gdb_put_strbuf();
 }
 
@@ -2087,6 +2126,17 @@ static int gdb_handle_packet(const char *line_buf)
             cmd_parser = &write_mem_cmd_desc;
         }
         break;
+    case 'x':
+        {
+            static const GdbCmdParseEntry read_mem_binary_cmd_desc = {
+                .handler = handle_read_mem_binary,
+                .cmd = "x",
+                .cmd_startswith = 1,
+                .schema = "L,L0"
+            };
+            cmd_parser = &read_mem_binary_cmd_desc;
+        }
+        break;
     case 'p':
         {
             static const GdbCmdParseEntry get_reg_cmd_desc = {
@@ -769,6 +769,20 @@ SRST
     Dump all the ramblocks of the system.
 ERST
 
+    {
+        .name       = "bql",
+        .args_type  = "",
+        .params     = "",
+        .help       = "Display BQL hold/wait profiling information",
+        .cmd_info_hrt = qmp_x_query_bql,
+    },
+
+SRST
+  ``info bql``
+    Dump the per-caller BQL hold/wait profile and the collapsed stacks of
+    long holds collected while profiling was enabled with ``bql-profile on``.
+ERST
+
     {
         .name       = "hotpluggable-cpus",
         .args_type  = "",
@@ -899,7 +913,7 @@ ERST
         .name       = "stats",
         .args_type  = "target:s,names:s?,provider:s?",
         .params     = "target [names] [provider]",
-        .help       = "show statistics for the given target (vm or vcpu); optionally filter by"
+        .help       = "show statistics for the given target (vm, vcpu, cryptodev or virtio); optionally filter by"
                       "name (comma-separated list, or * for all) and provider",
         .cmd        = hmp_info_stats,
     },
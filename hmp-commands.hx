@@ -639,6 +639,24 @@ SRST
   whether profiling is on or off.
 ERST
 
+    {
+        .name       = "bql-profile",
+        .args_type  = "op:s?,threshold:l?",
+        .params     = "[on [threshold-ns]|off|reset]",
+        .help       = "enable, disable or reset BQL hold/wait profiling. "
+                      "Holds of at least threshold-ns nanoseconds have their "
+                      "stack captured (default 1ms). "
+                      "With no arguments, prints whether profiling is on or off.",
+        .cmd        = hmp_bql_profile,
+    },
+
+SRST
+``bql-profile [on [threshold-ns]|off|reset]``
+  Enable, disable or reset BQL hold/wait profiling.  Holds of at least
+  *threshold-ns* nanoseconds have their stack captured for the ``info bql``
+  report.  With no arguments, prints whether profiling is on or off.
+ERST
+
     {
         .name       = "system_reset",
         .args_type  = "",
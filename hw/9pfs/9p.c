@@ -1584,6 +1584,9 @@ static void coroutine_fn v9fs_getattr(void *opaque)
     uint64_t request_mask;
     V9fsStatDotl v9stat_dotl;
     V9fsPDU *pdu = opaque;
+    uint64_t gen = 0;
+    int gen_err = 0;
+    bool st_gen;
 
     retval = pdu_unmarshal(pdu, offset, "dq", &fid, &request_mask);
     if (retval < 0) {
@@ -1599,8 +1602,14 @@ static void coroutine_fn v9fs_getattr(void *opaque)
     /*
      * Currently we only support BASIC fields in stat, so there is no
      * need to look at request_mask.
+     *
+     * The inode generation number is fetched in the same worker round
+     * trip as the stat itself, if requested and supported by the
+     * underlying fs.
      */
-    retval = v9fs_co_lstat(pdu, &fidp->path, &stbuf);
+    st_gen = (request_mask & P9_STATS_GEN) && pdu->s->ctx.exops.get_st_gen;
+    retval = v9fs_co_lstat_st_gen(pdu, &fidp->path, st_gen, &stbuf,
+                                  &gen, &gen_err);
     if (retval < 0) {
         goto out;
     }
@@ -1609,16 +1618,16 @@ static void coroutine_fn v9fs_getattr(void *opaque)
         goto out;
     }
 
-    /*  fill st_gen if requested and supported by underlying fs */
     if (request_mask & P9_STATS_GEN) {
-        retval = v9fs_co_st_gen(pdu, &fidp->path, stbuf.st_mode, &v9stat_dotl);
-        switch (retval) {
+        switch (gen_err) {
         case 0:
             /* we have valid st_gen: update result mask */
+            v9stat_dotl.st_gen = gen;
             v9stat_dotl.st_result_mask |= P9_STATS_GEN;
             break;
         case -EINTR:
             /* request cancelled, e.g. by Tflush */
+            retval = -EINTR;
             goto out;
         default:
             /* failed to get st_gen: not fatal, ignore */
@@ -1639,19 +1648,6 @@ out_nofid:
     pdu_complete(pdu, retval);
 }
 
-/* Attribute flags */
-#define P9_ATTR_MODE       (1 << 0)
-#define P9_ATTR_UID        (1 << 1)
-#define P9_ATTR_GID        (1 << 2)
-#define P9_ATTR_SIZE       (1 << 3)
-#define P9_ATTR_ATIME      (1 << 4)
-#define P9_ATTR_MTIME      (1 << 5)
-#define P9_ATTR_CTIME      (1 << 6)
-#define P9_ATTR_ATIME_SET  (1 << 7)
-#define P9_ATTR_MTIME_SET  (1 << 8)
-
-#define P9_ATTR_MASK    127
-
 static void coroutine_fn v9fs_setattr(void *opaque)
 {
     int err = 0;
@@ -1675,63 +1671,9 @@ static void coroutine_fn v9fs_setattr(void *opaque)
         err = -EINVAL;
         goto out_nofid;
     }
-    if (v9iattr.valid & P9_ATTR_MODE) {
-        err = v9fs_co_chmod(pdu, &fidp->path, v9iattr.mode);
-        if (err < 0) {
-            goto out;
-        }
-    }
-    if (v9iattr.valid & (P9_ATTR_ATIME | P9_ATTR_MTIME)) {
-        struct timespec times[2];
-        if (v9iattr.valid & P9_ATTR_ATIME) {
-            if (v9iattr.valid & P9_ATTR_ATIME_SET) {
-                times[0].tv_sec = v9iattr.atime_sec;
-                times[0].tv_nsec = v9iattr.atime_nsec;
-            } else {
-                times[0].tv_nsec = UTIME_NOW;
-            }
-        } else {
-            times[0].tv_nsec = UTIME_OMIT;
-        }
-        if (v9iattr.valid & P9_ATTR_MTIME) {
-            if (v9iattr.valid & P9_ATTR_MTIME_SET) {
-                times[1].tv_sec = v9iattr.mtime_sec;
-                times[1].tv_nsec = v9iattr.mtime_nsec;
-            } else {
-                times[1].tv_nsec = UTIME_NOW;
-            }
-        } else {
-            times[1].tv_nsec = UTIME_OMIT;
-        }
-        err = v9fs_co_utimensat(pdu, &fidp->path, times);
-        if (err < 0) {
-            goto out;
-        }
-    }
-    /*
-     * If the only valid entry in iattr is ctime we can call
-     * chown(-1,-1) to update the ctime of the file
-     */
-    if ((v9iattr.valid & (P9_ATTR_UID | P9_ATTR_GID)) ||
-        ((v9iattr.valid & P9_ATTR_CTIME)
-         && !((v9iattr.valid & P9_ATTR_MASK) & ~P9_ATTR_CTIME))) {
-        if (!(v9iattr.valid & P9_ATTR_UID)) {
-            v9iattr.uid = -1;
-        }
-        if (!(v9iattr.valid & P9_ATTR_GID)) {
-            v9iattr.gid = -1;
-        }
-        err = v9fs_co_chown(pdu, &fidp->path, v9iattr.uid,
-                            v9iattr.gid);
-        if (err < 0) {
-            goto out;
-        }
-    }
-    if (v9iattr.valid & (P9_ATTR_SIZE)) {
-        err = v9fs_co_truncate(pdu, &fidp->path, v9iattr.size);
-        if (err < 0) {
-            goto out;
-        }
+    err = v9fs_co_setattr(pdu, &fidp->path, &v9iattr);
+    if (err < 0) {
+        goto out;
     }
     err = offset;
     trace_v9fs_setattr_return(pdu->tag, pdu->id);
@@ -2210,6 +2152,12 @@ out_nofid:
  *
  * The resulting QEMUIOVector has heap-allocated iovecs and must be cleaned up
  * with qemu_iovec_destroy().
+ *
+ * Note that the iovecs point straight into the transport's request
+ * buffers (for virtio, the mapped guest pages of the virtqueue
+ * element), so Tread/Twrite payloads go to preadv()/pwritev() without
+ * an intermediate copy.  Only the xattr paths, which serve data from
+ * an in-memory value, marshal through v9fs_pack().
  */
 static void v9fs_init_qiov_from_pdu(QEMUIOVector *qiov, V9fsPDU *pdu,
                                     size_t skip, size_t size,
@@ -184,6 +184,19 @@ typedef struct V9fsConf
 #define P9_XATTR_CREATE 1
 #define P9_XATTR_REPLACE 2
 
+/* 9p2000.L Tsetattr attribute flags */
+#define P9_ATTR_MODE       (1 << 0)
+#define P9_ATTR_UID        (1 << 1)
+#define P9_ATTR_GID        (1 << 2)
+#define P9_ATTR_SIZE       (1 << 3)
+#define P9_ATTR_ATIME      (1 << 4)
+#define P9_ATTR_MTIME      (1 << 5)
+#define P9_ATTR_CTIME      (1 << 6)
+#define P9_ATTR_ATIME_SET  (1 << 7)
+#define P9_ATTR_MTIME_SET  (1 << 8)
+
+#define P9_ATTR_MASK    127
+
 typedef struct V9fsXattr
 {
     uint64_t copied_len;
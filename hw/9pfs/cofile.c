@@ -66,6 +66,43 @@ int coroutine_fn v9fs_co_lstat(V9fsPDU *pdu, V9fsPath *path, struct stat *stbuf)
     return err;
 }
 
+/*
+ * Combined lstat and inode generation fetch for Tgetattr, so that a
+ * request asking for P9_STATS_GEN makes one worker round trip instead
+ * of two.  The generation number is only fetched when @st_gen is true
+ * (the caller must have checked that the fs driver supports it), and
+ * its outcome is reported separately in @st_gen_err because a failure
+ * there is not fatal to the getattr itself.
+ */
+int coroutine_fn v9fs_co_lstat_st_gen(V9fsPDU *pdu, V9fsPath *path,
+                                      bool st_gen, struct stat *stbuf,
+                                      uint64_t *gen, int *st_gen_err)
+{
+    int err;
+    V9fsState *s = pdu->s;
+
+    if (v9fs_request_cancelled(pdu)) {
+        return -EINTR;
+    }
+    *st_gen_err = 0;
+    v9fs_path_read_lock(s);
+    v9fs_co_run_in_worker(
+        {
+            err = s->ops->lstat(&s->ctx, path, stbuf);
+            if (err < 0) {
+                err = -errno;
+            } else if (st_gen) {
+                *st_gen_err = s->ctx.exops.get_st_gen(&s->ctx, path,
+                                                      stbuf->st_mode, gen);
+                if (*st_gen_err < 0) {
+                    *st_gen_err = -errno;
+                }
+            }
+        });
+    v9fs_path_unlock(s);
+    return err;
+}
+
 int coroutine_fn v9fs_co_fstat(V9fsPDU *pdu, V9fsFidState *fidp,
                                struct stat *stbuf)
 {
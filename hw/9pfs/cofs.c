@@ -164,6 +164,90 @@ int coroutine_fn v9fs_co_chown(V9fsPDU *pdu, V9fsPath *path, uid_t uid,
     return err;
 }
 
+/*
+ * Apply a Tsetattr request to @path.  The requested attribute updates
+ * are performed back to back in a single worker round trip, instead
+ * of paying a thread hop for every individual change.
+ */
+int coroutine_fn v9fs_co_setattr(V9fsPDU *pdu, V9fsPath *path,
+                                 V9fsIattr *iattr)
+{
+    int err = 0;
+    FsCred cred;
+    struct timespec times[2];
+    V9fsState *s = pdu->s;
+
+    if (v9fs_request_cancelled(pdu)) {
+        return -EINTR;
+    }
+    cred_init(&cred);
+    cred.fc_mode = iattr->mode;
+    if (iattr->valid & P9_ATTR_UID) {
+        cred.fc_uid = iattr->uid;
+    }
+    if (iattr->valid & P9_ATTR_GID) {
+        cred.fc_gid = iattr->gid;
+    }
+    if (iattr->valid & P9_ATTR_ATIME) {
+        if (iattr->valid & P9_ATTR_ATIME_SET) {
+            times[0].tv_sec = iattr->atime_sec;
+            times[0].tv_nsec = iattr->atime_nsec;
+        } else {
+            times[0].tv_nsec = UTIME_NOW;
+        }
+    } else {
+        times[0].tv_nsec = UTIME_OMIT;
+    }
+    if (iattr->valid & P9_ATTR_MTIME) {
+        if (iattr->valid & P9_ATTR_MTIME_SET) {
+            times[1].tv_sec = iattr->mtime_sec;
+            times[1].tv_nsec = iattr->mtime_nsec;
+        } else {
+            times[1].tv_nsec = UTIME_NOW;
+        }
+    } else {
+        times[1].tv_nsec = UTIME_OMIT;
+    }
+    v9fs_path_read_lock(s);
+    v9fs_co_run_in_worker(
+        {
+            if (iattr->valid & P9_ATTR_MODE) {
+                err = s->ops->chmod(&s->ctx, path, &cred);
+                if (err < 0) {
+                    err = -errno;
+                }
+            }
+            if (!err &&
+                (iattr->valid & (P9_ATTR_ATIME | P9_ATTR_MTIME))) {
+                err = s->ops->utimensat(&s->ctx, path, times);
+                if (err < 0) {
+                    err = -errno;
+                }
+            }
+            /*
+             * If the only valid entry in iattr is ctime we can call
+             * chown(-1,-1) to update the ctime of the file
+             */
+            if (!err &&
+                ((iattr->valid & (P9_ATTR_UID | P9_ATTR_GID)) ||
+                 ((iattr->valid & P9_ATTR_CTIME) &&
+                  !((iattr->valid & P9_ATTR_MASK) & ~P9_ATTR_CTIME)))) {
+                err = s->ops->chown(&s->ctx, path, &cred);
+                if (err < 0) {
+                    err = -errno;
+                }
+            }
+            if (!err && (iattr->valid & P9_ATTR_SIZE)) {
+                err = s->ops->truncate(&s->ctx, path, iattr->size);
+                if (err < 0) {
+                    err = -errno;
+                }
+            }
+        });
+    v9fs_path_unlock(s);
+    return err;
+}
+
 int coroutine_fn v9fs_co_truncate(V9fsPDU *pdu, V9fsPath *path, off_t size)
 {
     int err;
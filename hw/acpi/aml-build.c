@@ -445,13 +445,29 @@ build_append_named_dword(GArray *array, const char *name_format, ...)
 
 static GPtrArray *alloc_list;
 
+/*
+ * Nodes recycled from the previous build, with their buffers kept at
+ * their grown size.  A dense DSDT allocates thousands of nodes and the
+ * same tables are rebuilt on every reset, so reusing them avoids
+ * re-growing all the arrays from one byte each time.
+ */
+#define AML_NODE_CACHE_MAX 4096
+static GPtrArray *node_cache;
+
 static Aml *aml_alloc(void)
 {
-    Aml *var = g_new0(typeof(*var), 1);
+    Aml *var;
 
+    if (node_cache && node_cache->len) {
+        var = g_ptr_array_remove_index_fast(node_cache, node_cache->len - 1);
+        g_array_set_size(var->buf, 0);
+        var->op = 0;
+    } else {
+        var = g_new0(typeof(*var), 1);
+        var->buf = build_alloc_array();
+    }
     g_ptr_array_add(alloc_list, var);
     var->block_flags = AML_NO_OPCODE;
-    var->buf = build_alloc_array();
     return var;
 }
 
@@ -476,6 +492,11 @@ static Aml *aml_bundle(uint8_t op, AmlBlockFlags flags)
 static void aml_free(gpointer data, gpointer user_data)
 {
     Aml *var = data;
+
+    if (node_cache->len < AML_NODE_CACHE_MAX) {
+        g_ptr_array_add(node_cache, var);
+        return;
+    }
     build_free_array(var->buf);
     g_free(var);
 }
@@ -484,6 +505,9 @@ Aml *init_aml_allocator(void)
 {
     assert(!alloc_list);
     alloc_list = g_ptr_array_new();
+    if (!node_cache) {
+        node_cache = g_ptr_array_new();
+    }
     return aml_alloc();
 }
 
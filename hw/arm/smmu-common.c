@@ -24,6 +24,8 @@
 #include "qapi/error.h"
 #include "qemu/jhash.h"
 #include "qemu/module.h"
+#include "qemu/stats64.h"
+#include "sysemu/stats.h"
 
 #include "qemu/error-report.h"
 #include "hw/arm/smmu-common.h"
@@ -66,6 +68,10 @@ SMMUIOTLBKey smmu_get_iotlb_key(uint16_t asid, uint16_t vmid, uint64_t iova,
     return key;
 }
 
+/* IOTLB efficiency counters, exposed through query-stats */
+static Stat64 smmu_iotlb_hit_count;
+static Stat64 smmu_iotlb_miss_count;
+
 SMMUTLBEntry *smmu_iotlb_lookup(SMMUState *bs, SMMUTransCfg *cfg,
                                 SMMUTransTableInfo *tt, hwaddr iova)
 {
@@ -91,12 +97,14 @@ SMMUTLBEntry *smmu_iotlb_lookup(SMMUState *bs, SMMUTransCfg *cfg,
 
     if (entry) {
         cfg->iotlb_hits++;
+        stat64_add(&smmu_iotlb_hit_count, 1);
         trace_smmu_iotlb_lookup_hit(cfg->asid, cfg->s2cfg.vmid, iova,
                                     cfg->iotlb_hits, cfg->iotlb_misses,
                                     100 * cfg->iotlb_hits /
                                     (cfg->iotlb_hits + cfg->iotlb_misses));
     } else {
         cfg->iotlb_misses++;
+        stat64_add(&smmu_iotlb_miss_count, 1);
         trace_smmu_iotlb_lookup_miss(cfg->asid, cfg->s2cfg.vmid, iova,
                                      cfg->iotlb_hits, cfg->iotlb_misses,
                                      100 * cfg->iotlb_hits /
@@ -659,8 +667,62 @@ void smmu_inv_notifiers_all(SMMUState *s)
     }
 }
 
+static void smmu_stats_add(StatsList **stats_list, const char *name,
+                           uint64_t value, strList *names)
+{
+    Stats *stats;
+
+    if (!apply_str_list_filter(name, names)) {
+        return;
+    }
+
+    stats = g_new0(Stats, 1);
+    stats->name = g_strdup(name);
+    stats->value = g_new0(StatsValue, 1);
+    stats->value->type = QTYPE_QNUM;
+    stats->value->u.scalar = value;
+
+    QAPI_LIST_PREPEND(*stats_list, stats);
+}
+
+static void smmu_stats_cb(StatsResultList **result, StatsTarget target,
+                          strList *names, strList *targets, Error **errp)
+{
+    StatsList *stats_list = NULL;
+
+    if (target != STATS_TARGET_VM) {
+        return;
+    }
+
+    smmu_stats_add(&stats_list, "iotlb-hits",
+                   stat64_get(&smmu_iotlb_hit_count), names);
+    smmu_stats_add(&stats_list, "iotlb-misses",
+                   stat64_get(&smmu_iotlb_miss_count), names);
+
+    add_stats_entry(result, STATS_PROVIDER_IOMMU, NULL, stats_list);
+}
+
+static void smmu_schemas_cb(StatsSchemaList **result, Error **errp)
+{
+    static const char *const names[] = { "iotlb-hits", "iotlb-misses" };
+    StatsSchemaValueList *stats_list = NULL;
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(names); i++) {
+        StatsSchemaValue *schema = g_new0(StatsSchemaValue, 1);
+
+        schema->name = g_strdup(names[i]);
+        schema->type = STATS_TYPE_CUMULATIVE;
+        QAPI_LIST_PREPEND(stats_list, schema);
+    }
+
+    add_stats_schema(result, STATS_PROVIDER_IOMMU, STATS_TARGET_VM,
+                     stats_list);
+}
+
 static void smmu_base_realize(DeviceState *dev, Error **errp)
 {
+    static bool stats_registered;
     SMMUState *s = ARM_SMMU(dev);
     SMMUBaseClass *sbc = ARM_SMMU_GET_CLASS(dev);
     Error *local_err = NULL;
@@ -680,6 +742,12 @@ static void smmu_base_realize(DeviceState *dev, Error **errp)
     } else {
         error_setg(errp, "SMMU is not attached to any PCI bus!");
     }
+
+    if (!stats_registered) {
+        add_stats_callbacks(STATS_PROVIDER_IOMMU, smmu_stats_cb,
+                            smmu_schemas_cb);
+        stats_registered = true;
+    }
 }
 
 static void smmu_base_reset_hold(Object *obj)
@@ -14,6 +14,7 @@
 #include "qemu/osdep.h"
 #include "qemu/defer-call.h"
 #include "qapi/error.h"
+#include "qapi/qapi-visit-virtio.h"
 #include "qemu/iov.h"
 #include "qemu/module.h"
 #include "qemu/error-report.h"
@@ -223,16 +224,6 @@ out:
 
 #endif
 
-static VirtIOBlockReq *virtio_blk_get_request(VirtIOBlock *s, VirtQueue *vq)
-{
-    VirtIOBlockReq *req = virtqueue_pop(vq, sizeof(VirtIOBlockReq));
-
-    if (req) {
-        virtio_blk_init_request(s, vq, req);
-    }
-    return req;
-}
-
 static int virtio_blk_handle_scsi_req(VirtIOBlockReq *req)
 {
     int status = VIRTIO_BLK_S_OK;
@@ -1110,9 +1101,11 @@ static int virtio_blk_handle_request(VirtIOBlockReq *req, MultiReqBuffer *mrb)
 
 void virtio_blk_handle_vq(VirtIOBlock *s, VirtQueue *vq)
 {
-    VirtIOBlockReq *req;
+    VirtQueueElement *elems[32];
     MultiReqBuffer mrb = {};
     bool suppress_notifications = virtio_queue_get_notification(vq);
+    bool fatal = false;
+    unsigned int n, i;
 
     defer_call_begin();
 
@@ -1121,18 +1114,25 @@ void virtio_blk_handle_vq(VirtIOBlock *s, VirtQueue *vq)
             virtio_queue_set_notification(vq, 0);
         }
 
-        while ((req = virtio_blk_get_request(s, vq))) {
-            if (virtio_blk_handle_request(req, &mrb)) {
-                virtqueue_detach_element(req->vq, &req->elem, 0);
-                virtio_blk_free_request(req);
-                break;
+        do {
+            n = virtqueue_pop_batch(vq, sizeof(VirtIOBlockReq), elems,
+                                    ARRAY_SIZE(elems));
+            for (i = 0; i < n; i++) {
+                VirtIOBlockReq *req = (VirtIOBlockReq *)elems[i];
+
+                virtio_blk_init_request(s, vq, req);
+                if (fatal || virtio_blk_handle_request(req, &mrb)) {
+                    virtqueue_detach_element(req->vq, &req->elem, 0);
+                    virtio_blk_free_request(req);
+                    fatal = true;
+                }
             }
-        }
+        } while (n == ARRAY_SIZE(elems) && !fatal);
 
         if (suppress_notifications) {
             virtio_queue_set_notification(vq, 1);
         }
-    } while (!virtio_queue_empty(vq));
+    } while (!fatal && !virtio_queue_empty(vq));
 
     if (mrb.num_reqs) {
         virtio_blk_submit_multireq(s, &mrb);
@@ -2106,6 +2106,80 @@ static void virtio_blk_device_unrealize(DeviceState *dev)
     virtio_cleanup(vdev);
 }
 
+static void virtio_blk_get_iothread_vq_mapping(Object *obj, Visitor *v,
+                                               const char *name, void *opaque,
+                                               Error **errp)
+{
+    VirtIOBlock *s = VIRTIO_BLK(obj);
+
+    visit_type_IOThreadVirtQueueMappingList(v, name,
+                                            &s->conf.iothread_vq_mapping_list,
+                                            errp);
+}
+
+/*
+ * Replace the iothread-vq-mapping of a running device, so skewed queue
+ * load can be rebalanced across the configured IOThreads without a
+ * device reset.  The ioeventfd machinery is stopped, the new mapping
+ * applied, and the ioeventfds restarted on the new AioContexts.
+ *
+ * Context: BQL held
+ */
+static void virtio_blk_set_iothread_vq_mapping(Object *obj, Visitor *v,
+                                               const char *name, void *opaque,
+                                               Error **errp)
+{
+    VirtIOBlock *s = VIRTIO_BLK(obj);
+    VirtIODevice *vdev = VIRTIO_DEVICE(obj);
+    IOThreadVirtQueueMappingList *list = NULL;
+    IOThreadVirtQueueMappingList *node;
+    g_autofree AioContext **vq_aio_context = NULL;
+
+    if (!visit_type_IOThreadVirtQueueMappingList(v, name, &list, errp)) {
+        return;
+    }
+
+    if (!DEVICE(obj)->realized) {
+        error_setg(errp, "Use the iothread-vq-mapping property before "
+                   "the device is realized");
+        goto out;
+    }
+
+    if (!s->conf.iothread_vq_mapping_list) {
+        error_setg(errp, "Device was not configured with "
+                   "iothread-vq-mapping");
+        goto out;
+    }
+
+    vq_aio_context = g_new(AioContext *, s->conf.num_queues);
+    if (!apply_iothread_vq_mapping(list, vq_aio_context, s->conf.num_queues,
+                                   errp)) {
+        goto out;
+    }
+
+    virtio_blk_stop_ioeventfd(vdev);
+
+    /* Release the references taken for the old mapping */
+    for (node = s->conf.iothread_vq_mapping_list; node; node = node->next) {
+        IOThread *iothread = iothread_by_id(node->value->iothread);
+        object_unref(OBJECT(iothread));
+    }
+    qapi_free_IOThreadVirtQueueMappingList(s->conf.iothread_vq_mapping_list);
+    s->conf.iothread_vq_mapping_list = list;
+    list = NULL;
+
+    memcpy(s->vq_aio_context, vq_aio_context,
+           s->conf.num_queues * sizeof(AioContext *));
+
+    if (virtio_blk_start_ioeventfd(vdev)) {
+        error_setg(errp, "Failed to restart ioeventfd with the new mapping");
+    }
+    return;
+
+out:
+    qapi_free_IOThreadVirtQueueMappingList(list);
+}
+
 static void virtio_blk_instance_init(Object *obj)
 {
     VirtIOBlock *s = VIRTIO_BLK(obj);
@@ -2113,6 +2187,12 @@ static void virtio_blk_instance_init(Object *obj)
     device_add_bootindex_property(obj, &s->conf.conf.bootindex,
                                   "bootindex", "/disk@0,0",
                                   DEVICE(obj));
+
+    object_property_add(obj, "x-iothread-vq-mapping",
+                        "IOThreadVirtQueueMappingList",
+                        virtio_blk_get_iothread_vq_mapping,
+                        virtio_blk_set_iothread_vq_mapping,
+                        NULL, NULL);
 }
 
 static const VMStateDescription vmstate_virtio_blk = {
@@ -180,26 +180,57 @@ static void do_flush_queued_data(VirtIOSerialPort *port, VirtQueue *vq,
             port->iov_offset = 0;
         }
 
-        for (i = port->iov_idx; i < port->elem->out_num; i++) {
-            size_t buf_size;
+        /*
+         * Hand multi-buffer elements to the backend in one go: large
+         * guest writes (e.g. guest-agent file transfers) arrive as
+         * many page-sized buffers, and delivering them one at a time
+         * pays the backend's per-write overhead for every page.
+         */
+        if (port->elem->out_num > 1 &&
+            port->iov_idx == 0 && port->iov_offset == 0) {
+            size_t size = iov_size(port->elem->out_sg, port->elem->out_num);
+            g_autofree uint8_t *buf = g_malloc(size);
             ssize_t ret;
 
-            buf_size = port->elem->out_sg[i].iov_len - port->iov_offset;
-            ret = vsc->have_data(port,
-                                  port->elem->out_sg[i].iov_base
-                                  + port->iov_offset,
-                                  buf_size);
+            iov_to_buf(port->elem->out_sg, port->elem->out_num, 0, buf, size);
+            ret = vsc->have_data(port, buf, size);
             if (!port->elem) { /* bail if we got disconnected */
                 return;
             }
             if (port->throttled) {
-                port->iov_idx = i;
-                if (ret > 0) {
-                    port->iov_offset += ret;
+                /* Turn the consumed byte count back into a resume position */
+                size_t off = ret > 0 ? ret : 0;
+
+                for (i = 0; i < port->elem->out_num &&
+                            off >= port->elem->out_sg[i].iov_len; i++) {
+                    off -= port->elem->out_sg[i].iov_len;
                 }
+                port->iov_idx = i;
+                port->iov_offset = off;
                 break;
             }
-            port->iov_offset = 0;
+        } else {
+            for (i = port->iov_idx; i < port->elem->out_num; i++) {
+                size_t buf_size;
+                ssize_t ret;
+
+                buf_size = port->elem->out_sg[i].iov_len - port->iov_offset;
+                ret = vsc->have_data(port,
+                                      port->elem->out_sg[i].iov_base
+                                      + port->iov_offset,
+                                      buf_size);
+                if (!port->elem) { /* bail if we got disconnected */
+                    return;
+                }
+                if (port->throttled) {
+                    port->iov_idx = i;
+                    if (ret > 0) {
+                        port->iov_offset += ret;
+                    }
+                    break;
+                }
+                port->iov_offset = 0;
+            }
         }
         if (port->throttled) {
             break;
@@ -987,7 +987,7 @@ static QTAILQ_HEAD(, Rom) roms = QTAILQ_HEAD_INITIALIZER(roms);
 
 /*
  * rom->data can be heap-allocated or memory-mapped (e.g. when added with
- * rom_add_elf_program())
+ * rom_add_file() or rom_add_elf_program())
  */
 static void rom_free_data(Rom *rom)
 {
@@ -1075,7 +1075,6 @@ ssize_t rom_add_file(const char *file, const char *fw_dir,
 {
     MachineClass *mc = MACHINE_GET_CLASS(qdev_get_machine());
     Rom *rom;
-    ssize_t rc;
     int fd = -1;
     char devpath[100];
 
@@ -1114,13 +1113,24 @@ ssize_t rom_add_file(const char *file, const char *fw_dir,
     }
 
     rom->datasize = rom->romsize;
-    rom->data     = g_malloc0(rom->datasize);
-    lseek(fd, 0, SEEK_SET);
-    rc = read(fd, rom->data, rom->datasize);
-    if (rc != rom->datasize) {
-        fprintf(stderr, "rom: file %-20s: read error: rc=%zd (expected %zd)\n",
-                rom->name, rc, rom->datasize);
-        goto err;
+    if (rom->datasize) {
+        GError *gerr = NULL;
+
+        /*
+         * Map the file instead of reading it into a heap copy. The mapping
+         * is private and writable, so users patching the data through
+         * rom_ptr() modify only their in-memory copy, and pages are
+         * faulted in on demand when the data is actually consumed (e.g. by
+         * fw_cfg DMA), which keeps large blobs off the guest startup path.
+         */
+        rom->mapped_file = g_mapped_file_new_from_fd(fd, true, &gerr);
+        if (!rom->mapped_file) {
+            fprintf(stderr, "rom: file %-20s: map error: %s\n",
+                    rom->name, gerr->message);
+            g_error_free(gerr);
+            goto err;
+        }
+        rom->data = (uint8_t *)g_mapped_file_get_contents(rom->mapped_file);
     }
     close(fd);
     rom_insert(rom);
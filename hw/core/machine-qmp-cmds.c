@@ -8,6 +8,9 @@
  */
 
 #include "qemu/osdep.h"
+#include "exec/cpu-common.h"
+#include "exec/ramblock.h"
+#include "exec/ramlist.h"
 #include "hw/acpi/vmgenid.h"
 #include "hw/boards.h"
 #include "hw/intc/intc.h"
@@ -19,6 +22,8 @@
 #include "qapi/qmp/qobject.h"
 #include "qapi/qobject-input-visitor.h"
 #include "qapi/type-helpers.h"
+#include "qemu/rcu.h"
+#include "qemu/units.h"
 #include "qemu/uuid.h"
 #include "qom/qom-qobject.h"
 #include "sysemu/hostmem.h"
@@ -291,6 +296,165 @@ MemoryInfo *qmp_query_memory_size_summary(Error **errp)
     return mem_info;
 }
 
+#ifdef CONFIG_LINUX
+
+/* Parse "Key:   123 kB" style smaps fields into bytes */
+static bool smaps_field(const char *line, const char *key, uint64_t *val)
+{
+    size_t keylen = strlen(key);
+
+    if (strncmp(line, key, keylen) != 0 || line[keylen] != ':') {
+        return false;
+    }
+    *val = g_ascii_strtoull(line + keylen + 1, NULL, 10) * KiB;
+    return true;
+}
+
+/*
+ * Accumulate the smaps counters of every mapping overlapping
+ * [start, end).  A RAM block usually is a single mapping, but madvise
+ * calls (ballooning, THP hints) can split it into several.
+ */
+static void ram_block_sum_smaps(const char *smaps, uint64_t start,
+                                uint64_t end,
+                                RamBlockFragmentationInfo *info)
+{
+    g_auto(GStrv) lines = g_strsplit(smaps, "\n", -1);
+    bool in_range = false;
+    uint64_t val;
+    int i;
+
+    for (i = 0; lines[i]; i++) {
+        const char *line = lines[i];
+        char *dash;
+        uint64_t vma_start, vma_end;
+
+        /* Mapping header lines look like "55e2...-55e3... rw-p ..." */
+        vma_start = g_ascii_strtoull(line, &dash, 16);
+        if (dash != line && *dash == '-') {
+            vma_end = g_ascii_strtoull(dash + 1, NULL, 16);
+            in_range = vma_start < end && vma_end > start;
+            continue;
+        }
+        if (!in_range) {
+            continue;
+        }
+        if (smaps_field(line, "Rss", &val)) {
+            info->rss += val;
+        } else if (smaps_field(line, "Swap", &val)) {
+            info->swap += val;
+        } else if (smaps_field(line, "AnonHugePages", &val)) {
+            info->anon_huge += val;
+        } else if (smaps_field(line, "Shared_Hugetlb", &val) ||
+                   smaps_field(line, "Private_Hugetlb", &val)) {
+            info->hugetlb += val;
+        }
+    }
+}
+
+/*
+ * Accumulate the per-node residency ("N<node>=<pages>") of every
+ * numa_maps line within [start, end), scaled by the line's kernel page
+ * size.
+ */
+static RamBlockNumaNodeList *ram_block_sum_numa_maps(const char *numa_maps,
+                                                     uint64_t start,
+                                                     uint64_t end)
+{
+    RamBlockNumaNodeList *head = NULL, **tail = &head;
+    g_auto(GStrv) lines = g_strsplit(numa_maps, "\n", -1);
+    g_autofree uint64_t *nodes = g_new0(uint64_t, MAX_NODES);
+    int i;
+
+    for (i = 0; lines[i]; i++) {
+        const char *line = lines[i];
+        char *endp;
+        uint64_t vma_start, pagesize = qemu_real_host_page_size();
+        const char *tok;
+
+        vma_start = g_ascii_strtoull(line, &endp, 16);
+        if (endp == line || vma_start < start || vma_start >= end) {
+            continue;
+        }
+
+        tok = strstr(line, "kernelpagesize_kB=");
+        if (tok) {
+            pagesize = g_ascii_strtoull(tok + strlen("kernelpagesize_kB="),
+                                        NULL, 10) * KiB;
+        }
+
+        for (tok = strchr(line, ' '); tok; tok = strchr(tok + 1, ' ')) {
+            unsigned long node, pages;
+
+            if (tok[1] != 'N' || !g_ascii_isdigit(tok[2])) {
+                continue;
+            }
+            node = strtoul(tok + 2, &endp, 10);
+            if (*endp != '=' || node >= MAX_NODES) {
+                continue;
+            }
+            pages = strtoul(endp + 1, NULL, 10);
+            nodes[node] += pages * pagesize;
+        }
+    }
+
+    for (i = 0; i < MAX_NODES; i++) {
+        RamBlockNumaNode *node;
+
+        if (!nodes[i]) {
+            continue;
+        }
+        node = g_new0(RamBlockNumaNode, 1);
+        node->node = i;
+        node->size = nodes[i];
+        QAPI_LIST_APPEND(tail, node);
+    }
+    return head;
+}
+
+RamBlockFragmentationInfoList *qmp_query_memory_fragmentation(Error **errp)
+{
+    RamBlockFragmentationInfoList *head = NULL, **tail = &head;
+    g_autofree char *smaps = NULL;
+    g_autofree char *numa_maps = NULL;
+    RAMBlock *block;
+
+    if (!g_file_get_contents("/proc/self/smaps", &smaps, NULL, NULL)) {
+        error_setg(errp, "cannot read /proc/self/smaps");
+        return NULL;
+    }
+    /* numa_maps is absent on kernels without NUMA support */
+    g_file_get_contents("/proc/self/numa_maps", &numa_maps, NULL, NULL);
+
+    RCU_READ_LOCK_GUARD();
+    RAMBLOCK_FOREACH(block) {
+        RamBlockFragmentationInfo *info;
+        uint64_t start, end;
+
+        if (!block->host) {
+            continue;
+        }
+
+        info = g_new0(RamBlockFragmentationInfo, 1);
+        info->name = g_strdup(qemu_ram_get_idstr(block));
+        info->page_size = qemu_ram_pagesize(block);
+        info->used_length = block->used_length;
+        info->max_length = block->max_length;
+
+        start = (uintptr_t)block->host;
+        end = start + block->max_length;
+        ram_block_sum_smaps(smaps, start, end, info);
+        if (numa_maps) {
+            info->host_nodes = ram_block_sum_numa_maps(numa_maps, start, end);
+        }
+
+        QAPI_LIST_APPEND(tail, info);
+    }
+    return head;
+}
+
+#endif /* CONFIG_LINUX */
+
 static int qmp_x_query_rdma_foreach(Object *obj, void *opaque)
 {
     RdmaProvider *rdma;
@@ -440,6 +440,20 @@ static void machine_set_mem_merge(Object *obj, bool value, Error **errp)
     ms->mem_merge = value;
 }
 
+static bool machine_get_mem_merge_advisor(Object *obj, Error **errp)
+{
+    MachineState *ms = MACHINE(obj);
+
+    return ms->mem_merge_advisor;
+}
+
+static void machine_set_mem_merge_advisor(Object *obj, bool value, Error **errp)
+{
+    MachineState *ms = MACHINE(obj);
+
+    ms->mem_merge_advisor = value;
+}
+
 static bool machine_get_usb(Object *obj, Error **errp)
 {
     MachineState *ms = MACHINE(obj);
@@ -1041,6 +1055,12 @@ static void machine_class_init(ObjectClass *oc, void *data)
     object_class_property_set_description(oc, "mem-merge",
         "Enable/disable memory merge support");
 
+    object_class_property_add_bool(oc, "mem-merge-advisor",
+        machine_get_mem_merge_advisor, machine_set_mem_merge_advisor);
+    object_class_property_set_description(oc, "mem-merge-advisor",
+        "Advise merging selectively from a background duplicate scan "
+        "instead of marking all guest RAM mergeable");
+
     object_class_property_add_bool(oc, "usb",
         machine_get_usb, machine_set_usb);
     object_class_property_set_description(oc, "usb",
@@ -1198,6 +1218,11 @@ bool machine_mem_merge(MachineState *machine)
     return machine->mem_merge;
 }
 
+bool machine_mem_merge_advisor(MachineState *machine)
+{
+    return machine->mem_merge_advisor;
+}
+
 static char *cpu_slot_to_string(const CPUArchId *cpu)
 {
     GString *s = g_string_new(NULL);
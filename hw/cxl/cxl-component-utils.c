@@ -88,6 +88,14 @@ static uint64_t cxl_cache_mem_read_reg(void *opaque, hwaddr offset,
     }
 }
 
+uint64_t cxl_decoders_generation = 1;
+
+/* Callers hold the BQL, as do the readers in cxl-host.c */
+void cxl_decoders_changed(void)
+{
+    cxl_decoders_generation++;
+}
+
 static void dumb_hdm_handler(CXLComponentState *cxl_cstate, hwaddr offset,
                              uint32_t value)
 {
@@ -111,9 +119,11 @@ static void dumb_hdm_handler(CXLComponentState *cxl_cstate, hwaddr offset,
     if (should_commit) {
         value = FIELD_DP32(value, CXL_HDM_DECODER0_CTRL, ERR, 0);
         value = FIELD_DP32(value, CXL_HDM_DECODER0_CTRL, COMMITTED, 1);
+        cxl_decoders_changed();
     } else if (should_uncommit) {
         value = FIELD_DP32(value, CXL_HDM_DECODER0_CTRL, ERR, 0);
         value = FIELD_DP32(value, CXL_HDM_DECODER0_CTRL, COMMITTED, 0);
+        cxl_decoders_changed();
     }
     stl_le_p((uint8_t *)cache_mem + offset, value);
 }
@@ -65,6 +65,9 @@ static void cxl_fixed_memory_window_config(CXLState *cxl_state,
         fw->targets[i] = g_strdup(target->value);
     }
 
+    /* Stale from the start, filled on first access */
+    fw->decode_cache = g_new0(CXLDecodeCacheEntry, CXL_DECODE_CACHE_SIZE);
+
     cxl_state->fixed_windows = g_list_append(cxl_state->fixed_windows,
                                              g_steal_pointer(&fw));
 
@@ -152,7 +155,7 @@ static bool cxl_hdm_find_target(uint32_t *cache_mem, hwaddr addr,
     return found;
 }
 
-static PCIDevice *cxl_cfmws_find_device(CXLFixedWindow *fw, hwaddr addr)
+static PCIDevice *cxl_cfmws_walk_device(CXLFixedWindow *fw, hwaddr addr)
 {
     CXLComponentState *hb_cstate, *usp_cstate;
     PCIHostState *hb;
@@ -243,6 +246,32 @@ static PCIDevice *cxl_cfmws_find_device(CXLFixedWindow *fw, hwaddr addr)
     return d;
 }
 
+static PCIDevice *cxl_cfmws_find_device(CXLFixedWindow *fw, hwaddr addr)
+{
+    hwaddr tag = addr & ~(hwaddr)(CXL_DECODE_CACHE_LINE - 1);
+    CXLDecodeCacheEntry *ent;
+    PCIDevice *d;
+
+    if (unlikely(fw->decode_cache_gen != cxl_decoders_generation)) {
+        memset(fw->decode_cache, 0,
+               CXL_DECODE_CACHE_SIZE * sizeof(*fw->decode_cache));
+        fw->decode_cache_gen = cxl_decoders_generation;
+    }
+
+    ent = &fw->decode_cache[(tag / CXL_DECODE_CACHE_LINE)
+                            % CXL_DECODE_CACHE_SIZE];
+    if (likely(ent->dev && ent->tag == tag)) {
+        return ent->dev;
+    }
+
+    d = cxl_cfmws_walk_device(fw, addr);
+    if (d) {
+        ent->tag = tag;
+        ent->dev = d;
+    }
+    return d;
+}
+
 static MemTxResult cxl_read_cfmws(void *opaque, hwaddr addr, uint64_t *data,
                                   unsigned size, MemTxAttrs attrs)
 {
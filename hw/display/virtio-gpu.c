@@ -526,6 +526,7 @@ static void virtio_gpu_resource_flush(VirtIOGPU *g,
     }
 
     if (res->blob) {
+        qemu_rect_init(&flush_rect, rf.r.x, rf.r.y, rf.r.width, rf.r.height);
         for (i = 0; i < g->parent_obj.conf.max_outputs; i++) {
             scanout = &g->parent_obj.scanout[i];
             if (scanout->resource_id == res->resource_id &&
@@ -533,11 +534,19 @@ static void virtio_gpu_resource_flush(VirtIOGPU *g,
                 rf.r.x + rf.r.width >= scanout->x &&
                 rf.r.y < scanout->y + scanout->height &&
                 rf.r.y + rf.r.height >= scanout->y) {
+                QemuRect rect;
+
                 within_bounds = true;
 
                 if (console_has_gl(scanout->con)) {
-                    dpy_gl_update(scanout->con, 0, 0, scanout->width,
-                                  scanout->height);
+                    /* only flag the damaged part of the scanout */
+                    qemu_rect_init(&rect, scanout->x, scanout->y,
+                                   scanout->width, scanout->height);
+                    if (qemu_rect_intersect(&flush_rect, &rect, &rect)) {
+                        qemu_rect_translate(&rect, -scanout->x, -scanout->y);
+                        dpy_gl_update(scanout->con, rect.x, rect.y,
+                                      rect.width, rect.height);
+                    }
                     update_submitted = true;
                 }
             }
@@ -2749,11 +2749,17 @@ void acpi_build(AcpiBuildTables *tables, MachineState *machine)
 static void acpi_ram_update(MemoryRegion *mr, GArray *data)
 {
     uint32_t size = acpi_data_len(data);
+    void *ram;
 
     /* Make sure RAM size is correct - in case it got changed e.g. by migration */
     memory_region_ram_resize(mr, size, &error_abort);
 
-    memcpy(memory_region_get_ram_ptr(mr), data->data, size);
+    ram = memory_region_get_ram_ptr(mr);
+    if (memcmp(ram, data->data, size) == 0) {
+        /* the common case: a reboot did not change the tables */
+        return;
+    }
+    memcpy(ram, data->data, size);
     memory_region_set_dirty(mr, 0, size);
 }
 
@@ -32,8 +32,10 @@
 #include "hw/i386/apic-msidef.h"
 #include "hw/i386/x86-iommu.h"
 #include "hw/pci-host/q35.h"
+#include "qemu/stats64.h"
 #include "sysemu/kvm.h"
 #include "sysemu/dma.h"
+#include "sysemu/stats.h"
 #include "sysemu/sysemu.h"
 #include "hw/i386/apic_internal.h"
 #include "kvm/kvm_i386.h"
@@ -327,6 +329,10 @@ static uint64_t vtd_get_iotlb_gfn(hwaddr addr, uint32_t level)
     return (addr & vtd_slpt_level_page_mask(level)) >> VTD_PAGE_SHIFT_4K;
 }
 
+/* IOTLB efficiency counters, exposed through query-stats */
+static Stat64 vtd_iotlb_hits;
+static Stat64 vtd_iotlb_misses;
+
 /* Must be called with IOMMU lock held */
 static VTDIOTLBEntry *vtd_lookup_iotlb(IntelIOMMUState *s, uint16_t source_id,
                                        uint32_t pasid, hwaddr addr)
@@ -347,6 +353,7 @@ static VTDIOTLBEntry *vtd_lookup_iotlb(IntelIOMMUState *s, uint16_t source_id,
     }
 
 out:
+    stat64_add(entry ? &vtd_iotlb_hits : &vtd_iotlb_misses, 1);
     return entry;
 }
 
@@ -4178,8 +4185,67 @@ static Notifier vtd_machine_done_notify = {
     .notify = vtd_machine_done_hook,
 };
 
+static StatsList *vtd_stats_add(const char *name, uint64_t val,
+                                strList *names, StatsList *stats_list)
+{
+    Stats *stats;
+
+    if (!apply_str_list_filter(name, names)) {
+        return stats_list;
+    }
+
+    stats = g_new0(Stats, 1);
+    stats->name = g_strdup(name);
+    stats->value = g_new0(StatsValue, 1);
+    stats->value->type = QTYPE_QNUM;
+    stats->value->u.scalar = val;
+
+    QAPI_LIST_PREPEND(stats_list, stats);
+    return stats_list;
+}
+
+static void vtd_stats_cb(StatsResultList **result, StatsTarget target,
+                         strList *names, strList *targets, Error **errp)
+{
+    StatsList *stats_list = NULL;
+
+    if (target != STATS_TARGET_VM) {
+        return;
+    }
+
+    stats_list = vtd_stats_add("iotlb-hits", stat64_get(&vtd_iotlb_hits),
+                               names, stats_list);
+    stats_list = vtd_stats_add("iotlb-misses", stat64_get(&vtd_iotlb_misses),
+                               names, stats_list);
+
+    if (stats_list) {
+        add_stats_entry(result, STATS_PROVIDER_IOMMU, NULL, stats_list);
+    }
+}
+
+static void vtd_schemas_cb(StatsSchemaList **result, Error **errp)
+{
+    StatsSchemaValueList *stats_list = NULL;
+    StatsSchemaValueList *entry;
+    static const char *const names[] = { "iotlb-hits", "iotlb-misses" };
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(names); i++) {
+        entry = g_new0(StatsSchemaValueList, 1);
+        entry->value = g_new0(StatsSchemaValue, 1);
+        entry->value->name = g_strdup(names[i]);
+        entry->value->type = STATS_TYPE_CUMULATIVE;
+        entry->next = stats_list;
+        stats_list = entry;
+    }
+
+    add_stats_schema(result, STATS_PROVIDER_IOMMU, STATS_TARGET_VM,
+                     stats_list);
+}
+
 static void vtd_realize(DeviceState *dev, Error **errp)
 {
+    static bool stats_registered;
     MachineState *ms = MACHINE(qdev_get_machine());
     PCMachineState *pcms = PC_MACHINE(ms);
     X86MachineState *x86ms = X86_MACHINE(ms);
@@ -4231,6 +4297,12 @@ static void vtd_realize(DeviceState *dev, Error **errp)
     /* Pseudo address space under root PCI bus. */
     x86ms->ioapic_as = vtd_host_dma_iommu(bus, s, Q35_PSEUDO_DEVFN_IOAPIC);
     qemu_add_machine_init_done_notifier(&vtd_machine_done_notify);
+
+    if (!stats_registered) {
+        add_stats_callbacks(STATS_PROVIDER_IOMMU, vtd_stats_cb,
+                            vtd_schemas_cb);
+        stats_registered = true;
+    }
 }
 
 static void vtd_class_init(ObjectClass *klass, void *data)
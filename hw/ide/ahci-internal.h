@@ -320,6 +320,10 @@ struct AHCIDevice {
     int32_t busy_slot;
     bool init_d2h_sent;
     AHCICmdHdr *cur_cmd;
+    /* Copy of the PRDT for the command in flight, fetched once per command */
+    AHCI_SG *prdt_cache;
+    AHCICmdHdr *prdt_cache_cmd;
+    uint16_t prdt_cache_len;
     NCQTransferState ncq_tfs[AHCI_MAX_CMDS];
     MemReentrancyGuard mem_reentrancy_guard;
 };
@@ -45,6 +45,7 @@
 static void check_cmd(AHCIState *s, int port);
 static void handle_cmd(AHCIState *s, int port, uint8_t slot);
 static void ahci_reset_port(AHCIState *s, int port);
+static void ahci_prdt_cache_invalidate(AHCIDevice *ad);
 static bool ahci_write_fis_d2h(AHCIDevice *ad, bool d2h_fis_i);
 static void ahci_clear_cmd_issue(AHCIDevice *ad, uint8_t slot);
 static void ahci_init_d2h(AHCIDevice *ad);
@@ -672,6 +673,7 @@ static void ahci_reset_port(AHCIState *s, int port)
     pr->cmd_issue = 0;
     d->busy_slot = -1;
     d->init_d2h_sent = false;
+    ahci_prdt_cache_invalidate(d);
 
     ide_state = &s->dev[port].port.ifs[0];
     if (!ide_state->blk) {
@@ -933,18 +935,69 @@ static int prdt_tbl_entry_size(const AHCI_SG *tbl)
  * building the sglist from the PRDT as soon as we hit @limit bytes,
  * which is <= INT32_MAX/2GiB.
  */
-static int ahci_populate_sglist(AHCIDevice *ad, QEMUSGList *sglist,
-                                AHCICmdHdr *cmd, int64_t limit, uint64_t offset)
+static void ahci_prdt_cache_invalidate(AHCIDevice *ad)
+{
+    g_free(ad->prdt_cache);
+    ad->prdt_cache = NULL;
+    ad->prdt_cache_cmd = NULL;
+    ad->prdt_cache_len = 0;
+}
+
+/*
+ * Fetch the PRDT for @cmd, reusing the cached copy when the same command
+ * asks again.  Multi-chunk DMA and PIO transfers rebuild their sglist for
+ * every chunk of the transfer, but the guest must not modify the PRDT while
+ * the command is outstanding (AHCI 1.3.1, section 5.3.7), so mapping and
+ * copying it once per command is sufficient and saves one dma_memory_map
+ * round trip per chunk.  The cache is dropped at command completion.
+ */
+static const AHCI_SG *ahci_prdt_fetch(AHCIDevice *ad, AHCICmdHdr *cmd,
+                                      uint16_t prdtl)
 {
-    uint16_t opts = le16_to_cpu(cmd->opts);
-    uint16_t prdtl = le16_to_cpu(cmd->prdtl);
     uint64_t cfis_addr = le64_to_cpu(cmd->tbl_addr);
     uint64_t prdt_addr = cfis_addr + 0x80;
     dma_addr_t prdt_len = (prdtl * sizeof(AHCI_SG));
     dma_addr_t real_prdt_len = prdt_len;
     uint8_t *prdt;
+
+    if (ad->prdt_cache_cmd == cmd && ad->prdt_cache_len == prdtl) {
+        return ad->prdt_cache;
+    }
+
+    ahci_prdt_cache_invalidate(ad);
+
+    /* map PRDT */
+    if (!(prdt = dma_memory_map(ad->hba->as, prdt_addr, &prdt_len,
+                                DMA_DIRECTION_TO_DEVICE,
+                                MEMTXATTRS_UNSPECIFIED))){
+        trace_ahci_populate_sglist_no_map(ad->hba, ad->port_no);
+        return NULL;
+    }
+
+    if (prdt_len < real_prdt_len) {
+        trace_ahci_populate_sglist_short_map(ad->hba, ad->port_no);
+        dma_memory_unmap(ad->hba->as, prdt, prdt_len,
+                         DMA_DIRECTION_TO_DEVICE, prdt_len);
+        return NULL;
+    }
+
+    ad->prdt_cache = g_memdup2(prdt, prdt_len);
+    ad->prdt_cache_cmd = cmd;
+    ad->prdt_cache_len = prdtl;
+
+    dma_memory_unmap(ad->hba->as, prdt, prdt_len,
+                     DMA_DIRECTION_TO_DEVICE, prdt_len);
+
+    return ad->prdt_cache;
+}
+
+static int ahci_populate_sglist(AHCIDevice *ad, QEMUSGList *sglist,
+                                AHCICmdHdr *cmd, int64_t limit, uint64_t offset)
+{
+    uint16_t opts = le16_to_cpu(cmd->opts);
+    uint16_t prdtl = le16_to_cpu(cmd->prdtl);
+    const AHCI_SG *tbl;
     int i;
-    int r = 0;
     uint64_t sum = 0;
     int off_idx = -1;
     int64_t off_pos = -1;
@@ -959,57 +1012,40 @@ static int ahci_populate_sglist(AHCIDevice *ad, QEMUSGList *sglist,
         return -1;
     }
 
-    /* map PRDT */
-    if (!(prdt = dma_memory_map(ad->hba->as, prdt_addr, &prdt_len,
-                                DMA_DIRECTION_TO_DEVICE,
-                                MEMTXATTRS_UNSPECIFIED))){
-        trace_ahci_populate_sglist_no_map(ad->hba, ad->port_no);
+    tbl = ahci_prdt_fetch(ad, cmd, prdtl);
+    if (!tbl) {
         return -1;
     }
 
-    if (prdt_len < real_prdt_len) {
-        trace_ahci_populate_sglist_short_map(ad->hba, ad->port_no);
-        r = -1;
-        goto out;
-    }
-
     /* Get entries in the PRDT, init a qemu sglist accordingly */
-    if (prdtl > 0) {
-        AHCI_SG *tbl = (AHCI_SG *)prdt;
-        sum = 0;
-        for (i = 0; i < prdtl; i++) {
-            tbl_entry_size = prdt_tbl_entry_size(&tbl[i]);
-            if (offset < (sum + tbl_entry_size)) {
-                off_idx = i;
-                off_pos = offset - sum;
-                break;
-            }
-            sum += tbl_entry_size;
-        }
-        if ((off_idx == -1) || (off_pos < 0) || (off_pos > tbl_entry_size)) {
-            trace_ahci_populate_sglist_bad_offset(ad->hba, ad->port_no,
-                                                  off_idx, off_pos);
-            r = -1;
-            goto out;
+    for (i = 0; i < prdtl; i++) {
+        tbl_entry_size = prdt_tbl_entry_size(&tbl[i]);
+        if (offset < (sum + tbl_entry_size)) {
+            off_idx = i;
+            off_pos = offset - sum;
+            break;
         }
+        sum += tbl_entry_size;
+    }
+    if ((off_idx == -1) || (off_pos < 0) || (off_pos > tbl_entry_size)) {
+        trace_ahci_populate_sglist_bad_offset(ad->hba, ad->port_no,
+                                              off_idx, off_pos);
+        return -1;
+    }
 
-        qemu_sglist_init(sglist, qbus->parent, (prdtl - off_idx),
-                         ad->hba->as);
-        qemu_sglist_add(sglist, le64_to_cpu(tbl[off_idx].addr) + off_pos,
-                        MIN(prdt_tbl_entry_size(&tbl[off_idx]) - off_pos,
-                            limit));
+    qemu_sglist_init(sglist, qbus->parent, (prdtl - off_idx),
+                     ad->hba->as);
+    qemu_sglist_add(sglist, le64_to_cpu(tbl[off_idx].addr) + off_pos,
+                    MIN(prdt_tbl_entry_size(&tbl[off_idx]) - off_pos,
+                        limit));
 
-        for (i = off_idx + 1; i < prdtl && sglist->size < limit; i++) {
-            qemu_sglist_add(sglist, le64_to_cpu(tbl[i].addr),
-                            MIN(prdt_tbl_entry_size(&tbl[i]),
-                                limit - sglist->size));
-        }
+    for (i = off_idx + 1; i < prdtl && sglist->size < limit; i++) {
+        qemu_sglist_add(sglist, le64_to_cpu(tbl[i].addr),
+                        MIN(prdt_tbl_entry_size(&tbl[i]),
+                            limit - sglist->size));
     }
 
-out:
-    dma_memory_unmap(ad->hba->as, prdt, prdt_len,
-                     DMA_DIRECTION_TO_DEVICE, prdt_len);
-    return r;
+    return 0;
 }
 
 static void ncq_err(NCQTransferState *ncq_tfs)
@@ -1019,6 +1055,7 @@ static void ncq_err(NCQTransferState *ncq_tfs)
     ide_state->error = ABRT_ERR;
     ide_state->status = READY_STAT | ERR_STAT;
     qemu_sglist_destroy(&ncq_tfs->sglist);
+    ahci_prdt_cache_invalidate(ncq_tfs->drive);
     ncq_tfs->used = 0;
 }
 
@@ -1039,6 +1076,7 @@ static void ncq_finish(NCQTransferState *ncq_tfs)
     block_acct_done(blk_get_stats(ncq_tfs->drive->port.ifs[0].blk),
                     &ncq_tfs->acct);
     qemu_sglist_destroy(&ncq_tfs->sglist);
+    ahci_prdt_cache_invalidate(ncq_tfs->drive);
     ncq_tfs->used = 0;
 }
 
@@ -1359,6 +1397,8 @@ static void handle_cmd(AHCIState *s, int port, uint8_t slot)
     cmd = get_cmd_header(s, port, slot);
     /* remember current slot handle for later */
     s->dev[port].cur_cmd = cmd;
+    /* a new command may reuse the header of a completed one */
+    ahci_prdt_cache_invalidate(&s->dev[port]);
 
     /* The device we are working for */
     ide_state = &s->dev[port].port.ifs[0];
@@ -1568,6 +1608,8 @@ static void ahci_cmd_done(const IDEDMA *dma)
 
     trace_ahci_cmd_done(ad->hba, ad->port_no);
 
+    ahci_prdt_cache_invalidate(ad);
+
     /* no longer busy */
     if (ad->busy_slot != -1) {
         ahci_clear_cmd_issue(ad, ad->busy_slot);
@@ -1650,6 +1692,7 @@ void ahci_uninit(AHCIState *s)
         for (j = 0; j < 2; j++) {
             ide_exit(&ad->port.ifs[j]);
         }
+        ahci_prdt_cache_invalidate(ad);
         object_unparent(OBJECT(&ad->port));
     }
 
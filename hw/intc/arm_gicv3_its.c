@@ -1274,6 +1274,16 @@ static void process_cmdq(GICv3ITSState *s)
         return;
     }
 
+    /*
+     * Defer the per-redistributor LPI recalculation until the whole
+     * queue has been drained, so that a storm of INT commands costs a
+     * single pending table rescan per redistributor rather than one
+     * per interrupt.
+     */
+    for (i = 0; i < s->gicv3->num_cpu; i++) {
+        gicv3_redist_lpi_batch_begin(&s->gicv3->cpu[i]);
+    }
+
     while (wr_offset != rd_offset) {
         ItsCmdResult result = CMD_CONTINUE_OK;
         void *hostmem;
@@ -1315,10 +1325,15 @@ static void process_cmdq(GICv3ITSState *s)
             /*
              * Current implementation makes a blocking synchronous call
              * for every command issued earlier, hence the internal state
-             * is already consistent by the time SYNC command is executed.
-             * Hence no further processing is required for SYNC command.
+             * is already consistent by the time SYNC command is executed,
+             * except for the LPI recalculation we deferred above: flush
+             * that now so the effects of earlier commands are visible.
              */
             trace_gicv3_its_cmd_sync();
+            for (i = 0; i < s->gicv3->num_cpu; i++) {
+                gicv3_redist_lpi_batch_end(&s->gicv3->cpu[i]);
+                gicv3_redist_lpi_batch_begin(&s->gicv3->cpu[i]);
+            }
             break;
         case GITS_CMD_VSYNC:
             /*
@@ -1330,6 +1345,10 @@ static void process_cmdq(GICv3ITSState *s)
                 break;
             }
             trace_gicv3_its_cmd_vsync();
+            for (i = 0; i < s->gicv3->num_cpu; i++) {
+                gicv3_redist_lpi_batch_end(&s->gicv3->cpu[i]);
+                gicv3_redist_lpi_batch_begin(&s->gicv3->cpu[i]);
+            }
             break;
         case GITS_CMD_MAPD:
             result = process_mapd(s, cmdpkt);
@@ -1405,6 +1424,10 @@ static void process_cmdq(GICv3ITSState *s)
             break;
         }
     }
+
+    for (i = 0; i < s->gicv3->num_cpu; i++) {
+        gicv3_redist_lpi_batch_end(&s->gicv3->cpu[i]);
+    }
 }
 
 /*
@@ -840,10 +840,33 @@ void gicv3_redist_update_lpi_only(GICv3CPUState *cs)
 
 void gicv3_redist_update_lpi(GICv3CPUState *cs)
 {
+    if (cs->lpi_batch_active) {
+        /* Defer the rescan to gicv3_redist_lpi_batch_end() */
+        cs->lpi_batch_rescan = true;
+        return;
+    }
     gicv3_redist_update_lpi_only(cs);
     gicv3_redist_update(cs);
 }
 
+void gicv3_redist_lpi_batch_begin(GICv3CPUState *cs)
+{
+    cs->lpi_batch_active = true;
+}
+
+void gicv3_redist_lpi_batch_end(GICv3CPUState *cs)
+{
+    cs->lpi_batch_active = false;
+    if (cs->lpi_batch_rescan) {
+        cs->lpi_batch_rescan = false;
+        cs->lpi_batch_update = false;
+        gicv3_redist_update_lpi(cs);
+    } else if (cs->lpi_batch_update) {
+        cs->lpi_batch_update = false;
+        gicv3_redist_update(cs);
+    }
+}
+
 void gicv3_redist_lpi_pending(GICv3CPUState *cs, int irq, int level)
 {
     /*
@@ -864,7 +887,12 @@ void gicv3_redist_lpi_pending(GICv3CPUState *cs, int irq, int level)
      */
     if (level) {
         gicv3_redist_check_lpi_priority(cs, irq);
-        gicv3_redist_update(cs);
+        if (cs->lpi_batch_active) {
+            /* hpplpi is up to date; defer the cpuif update */
+            cs->lpi_batch_update = true;
+        } else {
+            gicv3_redist_update(cs);
+        }
     } else {
         if (irq == cs->hpplpi.irq) {
             gicv3_redist_update_lpi(cs);
@@ -645,6 +645,28 @@ void gicv3_redist_update_lpi(GICv3CPUState *cs);
  * an incoming migration has loaded new state.
  */
 void gicv3_redist_update_lpi_only(GICv3CPUState *cs);
+/**
+ * gicv3_redist_lpi_batch_begin:
+ * @cs: GICv3CPUState
+ *
+ * Start deferring LPI pending table rescans and cpuif updates for this
+ * redistributor. The pending table in guest memory is still updated for
+ * every LPI, but the (much more expensive) recalculation of the highest
+ * priority pending interrupt is postponed until the matching call to
+ * gicv3_redist_lpi_batch_end(). Used by the ITS while it drains its
+ * command queue, so that a burst of INT commands costs one rescan per
+ * redistributor rather than one per interrupt.
+ */
+void gicv3_redist_lpi_batch_begin(GICv3CPUState *cs);
+/**
+ * gicv3_redist_lpi_batch_end:
+ * @cs: GICv3CPUState
+ *
+ * Stop deferring LPI recalculation for this redistributor and perform
+ * whatever recalculation was deferred since the matching call to
+ * gicv3_redist_lpi_batch_begin().
+ */
+void gicv3_redist_lpi_batch_end(GICv3CPUState *cs);
 /**
  * gicv3_redist_inv_lpi:
  * @cs: GICv3CPUState
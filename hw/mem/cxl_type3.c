@@ -743,6 +743,8 @@ static void ct3_exit(PCIDevice *pci_dev)
     pcie_aer_exit(pci_dev);
     cxl_doe_cdat_release(cxl_cstate);
     g_free(regs->special_ops);
+    /* Drop any window decode cache entries pointing at this device */
+    cxl_decoders_changed();
     if (ct3d->hostpmem) {
         address_space_destroy(&ct3d->hostpmem_as);
     }
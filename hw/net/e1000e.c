@@ -403,9 +403,12 @@ static void e1000e_write_config(PCIDevice *pci_dev, uint32_t address,
 
     pci_default_write_config(pci_dev, address, val, len);
 
-    if (range_covers_byte(address, len, PCI_COMMAND) &&
-        (pci_dev->config[PCI_COMMAND] & PCI_COMMAND_MASTER)) {
-        e1000e_start_recv(&s->core);
+    if (range_covers_byte(address, len, PCI_COMMAND)) {
+        /* the bus master address space may have changed under the caches */
+        e1000e_core_rx_desc_caches_drop(&s->core);
+        if (pci_dev->config[PCI_COMMAND] & PCI_COMMAND_MASTER) {
+            e1000e_start_recv(&s->core);
+        }
     }
 }
 
@@ -885,6 +885,95 @@ typedef struct E1000E_RxRing_st {
     const E1000ERingInfo *i;
 } E1000E_RxRing;
 
+static void
+e1000e_rx_desc_cache_drop(E1000ECore *core, int idx)
+{
+    if (core->rx_desc_cache[idx].valid) {
+        address_space_cache_destroy(&core->rx_desc_cache[idx].cache);
+        core->rx_desc_cache[idx].valid = false;
+    }
+}
+
+void
+e1000e_core_rx_desc_caches_drop(E1000ECore *core)
+{
+    int i;
+
+    for (i = 0; i < E1000E_NUM_QUEUES; i++) {
+        e1000e_rx_desc_cache_drop(core, i);
+    }
+}
+
+/*
+ * Map the RX descriptor ring once and reuse the mapping for every
+ * descriptor access instead of paying for a full address space
+ * translation per pci_dma_read()/pci_dma_write(), the way virtio caches
+ * its vrings.  A change of the ring geometry is caught here by the
+ * base/len comparison; changes of the bus master address space drop the
+ * caches explicitly.  Returns NULL if the ring cannot be mapped in one
+ * piece, in which case the caller falls back to uncached DMA.
+ */
+static MemoryRegionCache *
+e1000e_rx_ring_desc_cache(E1000ECore *core, const E1000ERingInfo *r)
+{
+    struct E1000ERxDescCache *c = &core->rx_desc_cache[r->idx];
+    uint64_t base = e1000e_ring_base(core, r);
+    uint32_t len = core->mac[r->dlen];
+
+    if (c->valid && c->base == base && c->len == len) {
+        return &c->cache;
+    }
+
+    e1000e_rx_desc_cache_drop(core, r->idx);
+
+    if (!len) {
+        return NULL;
+    }
+
+    if (address_space_cache_init(&c->cache,
+                                 pci_get_address_space(core->owner),
+                                 base, len, true) != len) {
+        address_space_cache_destroy(&c->cache);
+        return NULL;
+    }
+
+    c->base = base;
+    c->len = len;
+    c->valid = true;
+
+    return &c->cache;
+}
+
+static void
+e1000e_rx_desc_dma_read(E1000ECore *core, const E1000ERingInfo *r,
+                        dma_addr_t addr, void *buf, dma_addr_t len)
+{
+    MemoryRegionCache *cache = e1000e_rx_ring_desc_cache(core, r);
+
+    if (cache) {
+        address_space_read_cached(cache, addr - e1000e_ring_base(core, r),
+                                  buf, len);
+    } else {
+        pci_dma_read(core->owner, addr, buf, len);
+    }
+}
+
+static void
+e1000e_rx_desc_dma_write(E1000ECore *core, const E1000ERingInfo *r,
+                         dma_addr_t addr, const void *buf, dma_addr_t len)
+{
+    MemoryRegionCache *cache = e1000e_rx_ring_desc_cache(core, r);
+
+    if (cache) {
+        hwaddr offset = addr - e1000e_ring_base(core, r);
+
+        address_space_write_cached(cache, offset, buf, len);
+        address_space_cache_invalidate(cache, offset, len);
+    } else {
+        pci_dma_write(core->owner, addr, buf, len);
+    }
+}
+
 static inline void
 e1000e_rx_ring_init(E1000ECore *core, E1000E_RxRing *rxr, int idx)
 {
@@ -1323,22 +1412,22 @@ struct NetRxPkt *pkt, const E1000E_RSSInfo *rss_info,
 }
 
 static inline void
-e1000e_pci_dma_write_rx_desc(E1000ECore *core, dma_addr_t addr,
-                             union e1000_rx_desc_union *desc, dma_addr_t len)
+e1000e_pci_dma_write_rx_desc(E1000ECore *core, const E1000ERingInfo *rxi,
+                             dma_addr_t addr, union e1000_rx_desc_union *desc,
+                             dma_addr_t len)
 {
-    PCIDevice *dev = core->owner;
-
     if (e1000e_rx_use_legacy_descriptor(core)) {
         struct e1000_rx_desc *d = &desc->legacy;
         size_t offset = offsetof(struct e1000_rx_desc, status);
         uint8_t status = d->status;
 
         d->status &= ~E1000_RXD_STAT_DD;
-        pci_dma_write(dev, addr, desc, len);
+        e1000e_rx_desc_dma_write(core, rxi, addr, desc, len);
 
         if (status & E1000_RXD_STAT_DD) {
             d->status = status;
-            pci_dma_write(dev, addr + offset, &status, sizeof(status));
+            e1000e_rx_desc_dma_write(core, rxi, addr + offset,
+                                     &status, sizeof(status));
         }
     } else {
         if (core->mac[RCTL] & E1000_RCTL_DTYP_PS) {
@@ -1348,11 +1437,12 @@ e1000e_pci_dma_write_rx_desc(E1000ECore *core, dma_addr_t addr,
             uint32_t status = d->wb.middle.status_error;
 
             d->wb.middle.status_error &= ~E1000_RXD_STAT_DD;
-            pci_dma_write(dev, addr, desc, len);
+            e1000e_rx_desc_dma_write(core, rxi, addr, desc, len);
 
             if (status & E1000_RXD_STAT_DD) {
                 d->wb.middle.status_error = status;
-                pci_dma_write(dev, addr + offset, &status, sizeof(status));
+                e1000e_rx_desc_dma_write(core, rxi, addr + offset,
+                                         &status, sizeof(status));
             }
         } else {
             union e1000_rx_desc_extended *d = &desc->extended;
@@ -1361,11 +1451,12 @@ e1000e_pci_dma_write_rx_desc(E1000ECore *core, dma_addr_t addr,
             uint32_t status = d->wb.upper.status_error;
 
             d->wb.upper.status_error &= ~E1000_RXD_STAT_DD;
-            pci_dma_write(dev, addr, desc, len);
+            e1000e_rx_desc_dma_write(core, rxi, addr, desc, len);
 
             if (status & E1000_RXD_STAT_DD) {
                 d->wb.upper.status_error = status;
-                pci_dma_write(dev, addr + offset, &status, sizeof(status));
+                e1000e_rx_desc_dma_write(core, rxi, addr + offset,
+                                         &status, sizeof(status));
             }
         }
     }
@@ -1485,7 +1576,6 @@ e1000e_write_packet_to_guest(E1000ECore *core, struct NetRxPkt *pkt,
                              const E1000E_RxRing *rxr,
                              const E1000E_RSSInfo *rss_info)
 {
-    PCIDevice *d = core->owner;
     dma_addr_t base;
     union e1000_rx_desc_union desc;
     size_t desc_size;
@@ -1519,7 +1609,7 @@ e1000e_write_packet_to_guest(E1000ECore *core, struct NetRxPkt *pkt,
 
         base = e1000e_ring_head_descr(core, rxi);
 
-        pci_dma_read(d, base, &desc, core->rx_desc_len);
+        e1000e_rx_desc_dma_read(core, rxi, base, &desc, core->rx_desc_len);
 
         trace_e1000e_rx_descr(rxi->idx, base, core->rx_desc_len);
 
@@ -1599,7 +1689,8 @@ e1000e_write_packet_to_guest(E1000ECore *core, struct NetRxPkt *pkt,
 
         e1000e_write_rx_descr(core, &desc, is_last ? core->rx_pkt : NULL,
                            rss_info, do_ps ? ps_hdr_len : 0, &bastate.written);
-        e1000e_pci_dma_write_rx_desc(core, base, &desc, core->rx_desc_len);
+        e1000e_pci_dma_write_rx_desc(core, rxi, base, &desc,
+                                     core->rx_desc_len);
 
         e1000e_ring_advance(core, rxi,
                             core->rx_desc_len / E1000_MIN_RX_DESC_LEN);
@@ -3354,6 +3445,8 @@ e1000e_core_pci_uninit(E1000ECore *core)
 
     e1000e_intrmgr_pci_unint(core);
 
+    e1000e_core_rx_desc_caches_drop(core);
+
     for (i = 0; i < E1000E_NUM_QUEUES; i++) {
         net_tx_pkt_uninit(core->tx[i].tx_pkt);
     }
@@ -3458,6 +3551,8 @@ static void e1000e_reset(E1000ECore *core, bool sw)
 
     e1000e_intrmgr_reset(core);
 
+    e1000e_core_rx_desc_caches_drop(core);
+
     memset(core->phy, 0, sizeof core->phy);
     memcpy(core->phy, e1000e_phy_reg_init, sizeof e1000e_phy_reg_init);
 
@@ -81,6 +81,14 @@ struct E1000Core {
 
     struct NetRxPkt *rx_pkt;
 
+    /* Cached mappings of the RX descriptor rings */
+    struct E1000ERxDescCache {
+        MemoryRegionCache cache;
+        uint64_t base;
+        uint32_t len;
+        bool valid;
+    } rx_desc_cache[E1000E_NUM_QUEUES];
+
     bool has_vnet;
     int max_queue_num;
 
@@ -139,6 +147,9 @@ e1000e_core_set_link_status(E1000ECore *core);
 void
 e1000e_core_pci_uninit(E1000ECore *core);
 
+void
+e1000e_core_rx_desc_caches_drop(E1000ECore *core);
+
 bool
 e1000e_can_receive(E1000ECore *core);
 
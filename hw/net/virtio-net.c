@@ -599,6 +599,31 @@ static void virtio_net_queue_enable(VirtIODevice *vdev, uint32_t queue_index)
     }
 }
 
+static unsigned virtio_net_mac_filter_bit(const uint8_t *mac)
+{
+    return (mac[0] ^ mac[1] ^ mac[2] ^ mac[3] ^ mac[4] ^ mac[5]) & 63;
+}
+
+static uint64_t virtio_net_mac_filter(const uint8_t *macs, int from, int to)
+{
+    uint64_t filter = 0;
+    int i;
+
+    for (i = from; i < to; i++) {
+        filter |= 1ULL << virtio_net_mac_filter_bit(&macs[i * ETH_ALEN]);
+    }
+    return filter;
+}
+
+static void virtio_net_rebuild_mac_filter(VirtIONet *n)
+{
+    n->mac_table.uni_filter = virtio_net_mac_filter(n->mac_table.macs, 0,
+                                                    n->mac_table.first_multi);
+    n->mac_table.multi_filter = virtio_net_mac_filter(n->mac_table.macs,
+                                                      n->mac_table.first_multi,
+                                                      n->mac_table.in_use);
+}
+
 static void virtio_net_reset(VirtIODevice *vdev)
 {
     VirtIONet *n = VIRTIO_NET(vdev);
@@ -623,6 +648,7 @@ static void virtio_net_reset(VirtIODevice *vdev)
     n->mac_table.multi_overflow = 0;
     n->mac_table.uni_overflow = 0;
     memset(n->mac_table.macs, 0, MAC_TABLE_ENTRIES * ETH_ALEN);
+    virtio_net_rebuild_mac_filter(n);
     memcpy(&n->mac[0], &n->nic->conf->macaddr, sizeof(n->mac));
     qemu_format_nic_info_str(qemu_get_queue(n->nic), n->mac);
     memset(n->vlans, 0, MAX_VLAN >> 3);
@@ -1215,6 +1241,7 @@ static int virtio_net_handle_mac(VirtIONet *n, uint8_t cmd,
     n->mac_table.uni_overflow = uni_overflow;
     n->mac_table.multi_overflow = multi_overflow;
     memcpy(n->mac_table.macs, macs, MAC_TABLE_ENTRIES * ETH_ALEN);
+    virtio_net_rebuild_mac_filter(n);
     g_free(macs);
     rxfilter_notify(nc);
 
@@ -1272,6 +1299,14 @@ static int virtio_net_handle_announce(VirtIONet *n, uint8_t cmd,
 
 static void virtio_net_detach_epbf_rss(VirtIONet *n);
 
+static void virtio_net_build_rss_table(VirtIONet *n)
+{
+    if (!n->rss_data.toeplitz_table) {
+        n->rss_data.toeplitz_table = g_new(net_toeplitz_table, 1);
+    }
+    net_toeplitz_table_init(n->rss_data.toeplitz_table, n->rss_data.key);
+}
+
 static void virtio_net_disable_rss(VirtIONet *n)
 {
     if (n->rss_data.enabled) {
@@ -1495,6 +1530,7 @@ static uint16_t virtio_net_handle_rss(VirtIONet *n,
         err_value = (uint32_t)s;
         goto error;
     }
+    virtio_net_build_rss_table(n);
     n->rss_data.enabled = true;
 
     if (!n->rss_data.populate_hash) {
@@ -1785,9 +1821,12 @@ static int receive_filter(VirtIONet *n, const uint8_t *buf, int size)
             return 1;
         }
 
-        for (i = n->mac_table.first_multi; i < n->mac_table.in_use; i++) {
-            if (!memcmp(ptr, &n->mac_table.macs[i * ETH_ALEN], ETH_ALEN)) {
-                return 1;
+        if (n->mac_table.multi_filter &
+            (1ULL << virtio_net_mac_filter_bit(ptr))) {
+            for (i = n->mac_table.first_multi; i < n->mac_table.in_use; i++) {
+                if (!memcmp(ptr, &n->mac_table.macs[i * ETH_ALEN], ETH_ALEN)) {
+                    return 1;
+                }
             }
         }
     } else { // unicast
@@ -1799,9 +1838,12 @@ static int receive_filter(VirtIONet *n, const uint8_t *buf, int size)
             return 1;
         }
 
-        for (i = 0; i < n->mac_table.first_multi; i++) {
-            if (!memcmp(ptr, &n->mac_table.macs[i * ETH_ALEN], ETH_ALEN)) {
-                return 1;
+        if (n->mac_table.uni_filter &
+            (1ULL << virtio_net_mac_filter_bit(ptr))) {
+            for (i = 0; i < n->mac_table.first_multi; i++) {
+                if (!memcmp(ptr, &n->mac_table.macs[i * ETH_ALEN], ETH_ALEN)) {
+                    return 1;
+                }
             }
         }
     }
@@ -1914,7 +1956,8 @@ static int virtio_net_process_rss(NetClientState *nc, const uint8_t *buf,
         return n->rss_data.redirect ? n->rss_data.default_queue : -1;
     }
 
-    hash = net_rx_pkt_calc_rss_hash(pkt, net_hash_type, n->rss_data.key);
+    hash = net_rx_pkt_calc_rss_hash_table(pkt, net_hash_type,
+                                          n->rss_data.toeplitz_table);
 
     if (n->rss_data.populate_hash) {
         virtio_set_packet_hash(buf, reports[net_hash_type], hash);
@@ -3099,6 +3142,7 @@ static int virtio_net_post_load_device(void *opaque, int version_id)
         }
     }
     n->mac_table.first_multi = i;
+    virtio_net_rebuild_mac_filter(n);
 
     /* nc.link_down can't be migrated, so infer link_down according
      * to link status bit in n->status */
@@ -3121,6 +3165,7 @@ static int virtio_net_post_load_device(void *opaque, int version_id)
     }
 
     if (n->rss_data.enabled) {
+        virtio_net_build_rss_table(n);
         n->rss_data.enabled_software_rss = n->rss_data.populate_hash;
         if (!n->rss_data.populate_hash) {
             if (!virtio_net_attach_epbf_rss(n)) {
@@ -3856,6 +3901,7 @@ static void virtio_net_device_unrealize(DeviceState *dev)
     qemu_del_nic(n->nic);
     virtio_net_rsc_cleanup(n);
     g_free(n->rss_data.indirections_table);
+    g_free(n->rss_data.toeplitz_table);
     net_rx_pkt_uninit(n->rx_pkt);
     virtio_cleanup(vdev);
 }
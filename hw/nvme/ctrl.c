@@ -40,6 +40,7 @@
  *              sriov_vi_flexible=<N[optional]> \
  *              sriov_max_vi_per_vf=<N[optional]> \
  *              sriov_max_vq_per_vf=<N[optional]> \
+ *              iothread=<iothread_id[optional]>, \
  *              subsys=<subsys_id>
  *      -device nvme-ns,drive=<drive_id>,bus=<bus_name>,nsid=<nsid>,\
  *              zoned=<true|false[optional]>, \
@@ -85,6 +86,14 @@
  *   Identify Controller data structure in CMIC (Controller Multi-path I/O and
  *   Namespace Sharing Capabilities).
  *
+ * - `iothread`
+ *   Specifying this parameter moves processing of the I/O submission and
+ *   completion queues (including the doorbell ioeventfds, see `ioeventfd`)
+ *   to the given iothread instead of the QEMU main loop. The admin queue
+ *   pair is always processed in the main loop. This parameter cannot be
+ *   combined with `subsys` since namespaces could then be shared with
+ *   controllers that process their queues in other threads.
+ *
  * - `aerl`
  *   The Asynchronous Event Request Limit (AERL). Indicates the maximum number
  *   of concurrently outstanding Asynchronous Event Request commands support
@@ -198,9 +207,11 @@
 #include "qemu/range.h"
 #include "qapi/error.h"
 #include "qapi/visitor.h"
+#include "block/aio-wait.h"
 #include "sysemu/sysemu.h"
 #include "sysemu/block-backend.h"
 #include "sysemu/hostmem.h"
+#include "sysemu/iothread.h"
 #include "hw/pci/msix.h"
 #include "hw/pci/pcie_sriov.h"
 #include "migration/vmstate.h"
@@ -254,6 +265,8 @@ static const uint32_t nvme_feature_cap[NVME_FID_MAX] = {
     [NVME_ERROR_RECOVERY]           = NVME_FEAT_CAP_CHANGE | NVME_FEAT_CAP_NS,
     [NVME_VOLATILE_WRITE_CACHE]     = NVME_FEAT_CAP_CHANGE,
     [NVME_NUMBER_OF_QUEUES]         = NVME_FEAT_CAP_CHANGE,
+    [NVME_INTERRUPT_COALESCING]     = NVME_FEAT_CAP_CHANGE,
+    [NVME_INTERRUPT_VECTOR_CONF]    = NVME_FEAT_CAP_CHANGE,
     [NVME_ASYNCHRONOUS_EVENT_CONF]  = NVME_FEAT_CAP_CHANGE,
     [NVME_TIMESTAMP]                = NVME_FEAT_CAP_CHANGE,
     [NVME_HOST_BEHAVIOR_SUPPORT]    = NVME_FEAT_CAP_CHANGE,
@@ -693,6 +706,99 @@ static void nvme_irq_deassert(NvmeCtrl *n, NvmeCQueue *cq)
     }
 }
 
+/*
+ * Interrupt coalescing (Interrupt Coalescing and Interrupt Vector
+ * Configuration features): defer the MSI-X notification while at most
+ * THR + 1 completions are outstanding, bounded by the aggregation time.
+ * The admin completion queue and pin-based interrupts are never coalesced.
+ * Aggregation is tracked per completion queue rather than per vector; the
+ * two are equivalent for the usual one vector per queue setup.
+ *
+ * Returns true if the notification was deferred.
+ */
+static bool nvme_cq_coalesce_irq(NvmeCtrl *n, NvmeCQueue *cq)
+{
+    uint8_t thr = NVME_INTC_THR(n->features.intc);
+    uint8_t aggr_time = NVME_INTC_TIME(n->features.intc);
+    uint32_t outstanding;
+
+    if (!thr || !aggr_time || !cq->cqid || !msix_enabled(PCI_DEVICE(n))) {
+        return false;
+    }
+
+    if (test_bit(cq->vector, n->features.intvc_nocoalescing)) {
+        return false;
+    }
+
+    /* thr is zero based; aggregate while the threshold is not exceeded */
+    outstanding = (cq->tail - cq->head + cq->size) % cq->size;
+    if (outstanding > thr) {
+        return false;
+    }
+
+    if (!timer_pending(cq->coal_timer)) {
+        timer_mod(cq->coal_timer, qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL) +
+                                  (int64_t)aggr_time * 100 * SCALE_US);
+    }
+
+    return true;
+}
+
+static void nvme_cq_coalesce_timer(void *opaque)
+{
+    NvmeCQueue *cq = opaque;
+
+    if (cq->tail != cq->head) {
+        nvme_irq_assert(cq->ctrl, cq);
+    }
+}
+
+/*
+ * Interrupt state (bar.intms, irq_status and cq_pending) is protected by the
+ * BQL; completion queues that are processed in an iothread defer interrupt
+ * updates to the main loop by scheduling cq->irq_bh.
+ */
+static void nvme_cq_update_irq(NvmeCtrl *n, NvmeCQueue *cq)
+{
+    if (cq->tail != cq->head) {
+        if (cq->irq_enabled && !cq->irq_pending) {
+            cq->irq_pending = true;
+            n->cq_pending++;
+        }
+
+        if (cq->irq_enabled && nvme_cq_coalesce_irq(n, cq)) {
+            return;
+        }
+
+        timer_del(cq->coal_timer);
+        nvme_irq_assert(n, cq);
+    } else {
+        if (cq->irq_enabled && cq->irq_pending) {
+            cq->irq_pending = false;
+            n->cq_pending--;
+        }
+
+        timer_del(cq->coal_timer);
+        nvme_irq_deassert(n, cq);
+    }
+}
+
+static void nvme_cq_irq_bh(void *opaque)
+{
+    NvmeCQueue *cq = opaque;
+
+    nvme_cq_update_irq(cq->ctrl, cq);
+}
+
+static void nvme_cq_kick_irq(NvmeCQueue *cq)
+{
+    if (qemu_get_current_aio_context() == qemu_get_aio_context()) {
+        nvme_cq_update_irq(cq->ctrl, cq);
+    } else {
+        qemu_bh_schedule(cq->irq_bh);
+    }
+}
+
 static void nvme_req_clear(NvmeRequest *req)
 {
     req->ns = NULL;
@@ -1487,7 +1593,6 @@ static void nvme_post_cqes(void *opaque)
     NvmeCQueue *cq = opaque;
     NvmeCtrl *n = cq->ctrl;
     NvmeRequest *req, *next;
-    bool pending = cq->head != cq->tail;
     int ret;
 
     QTAILQ_FOREACH_SAFE(req, &cq->req_list, entry, next) {
@@ -1521,13 +1626,8 @@ static void nvme_post_cqes(void *opaque)
         nvme_sg_unmap(&req->sg);
         QTAILQ_INSERT_TAIL(&sq->req_list, req, entry);
     }
-    if (cq->tail != cq->head) {
-        if (cq->irq_enabled && !pending) {
-            n->cq_pending++;
-        }
 
-        nvme_irq_assert(n, cq);
-    }
+    nvme_cq_kick_irq(cq);
 }
 
 static void nvme_enqueue_req_completion(NvmeCQueue *cq, NvmeRequest *req)
@@ -4486,10 +4586,15 @@ static uint16_t nvme_io_cmd(NvmeCtrl *n, NvmeRequest *req)
     return NVME_INVALID_OPCODE | NVME_DNR;
 }
 
+static AioContext *nvme_queue_aio_context(NvmeCtrl *n, uint16_t qid)
+{
+    /* the admin queue pair is always processed in the main loop */
+    return qid && n->iothread ? n->ctx : qemu_get_aio_context();
+}
+
 static void nvme_cq_notifier(EventNotifier *e)
 {
     NvmeCQueue *cq = container_of(e, NvmeCQueue, notifier);
-    NvmeCtrl *n = cq->ctrl;
 
     if (!event_notifier_test_and_clear(e)) {
         return;
@@ -4498,11 +4603,7 @@ static void nvme_cq_notifier(EventNotifier *e)
     nvme_update_cq_head(cq);
 
     if (cq->tail == cq->head) {
-        if (cq->irq_enabled) {
-            n->cq_pending--;
-        }
-
-        nvme_irq_deassert(n, cq);
+        nvme_cq_kick_irq(cq);
     }
 
     qemu_bh_schedule(cq->bh);
@@ -4519,7 +4620,12 @@ static int nvme_init_cq_ioeventfd(NvmeCQueue *cq)
         return ret;
     }
 
-    event_notifier_set_handler(&cq->notifier, nvme_cq_notifier);
+    if (n->iothread) {
+        aio_set_event_notifier(n->ctx, &cq->notifier, nvme_cq_notifier,
+                               NULL, NULL);
+    } else {
+        event_notifier_set_handler(&cq->notifier, nvme_cq_notifier);
+    }
     memory_region_add_eventfd(&n->iomem,
                               0x1000 + offset, 4, false, 0, &cq->notifier);
 
@@ -4548,13 +4654,27 @@ static int nvme_init_sq_ioeventfd(NvmeSQueue *sq)
         return ret;
     }
 
-    event_notifier_set_handler(&sq->notifier, nvme_sq_notifier);
+    if (n->iothread) {
+        aio_set_event_notifier(n->ctx, &sq->notifier, nvme_sq_notifier,
+                               NULL, NULL);
+    } else {
+        event_notifier_set_handler(&sq->notifier, nvme_sq_notifier);
+    }
     memory_region_add_eventfd(&n->iomem,
                               0x1000 + offset, 4, false, 0, &sq->notifier);
 
     return 0;
 }
 
+/*
+ * Empty BH; running it with aio_wait_bh_oneshot() guarantees that any queue
+ * handler that was in flight in the iothread when the queue was torn down
+ * has returned.
+ */
+static void nvme_queue_quiesced_bh(void *opaque)
+{
+}
+
 static void nvme_free_sq(NvmeSQueue *sq, NvmeCtrl *n)
 {
     uint16_t offset = sq->sqid << 3;
@@ -4564,19 +4684,46 @@ static void nvme_free_sq(NvmeSQueue *sq, NvmeCtrl *n)
     if (sq->ioeventfd_enabled) {
         memory_region_del_eventfd(&n->iomem,
                                   0x1000 + offset, 4, false, 0, &sq->notifier);
-        event_notifier_set_handler(&sq->notifier, NULL);
+        if (n->iothread) {
+            aio_set_event_notifier(n->ctx, &sq->notifier, NULL, NULL, NULL);
+        } else {
+            event_notifier_set_handler(&sq->notifier, NULL);
+        }
         event_notifier_cleanup(&sq->notifier);
     }
+    if (n->iothread && sq->sqid) {
+        aio_wait_bh_oneshot(n->ctx, nvme_queue_quiesced_bh, NULL);
+    }
     g_free(sq->io_req);
     if (sq->sqid) {
         g_free(sq);
     }
 }
 
+/*
+ * Flush residual completions for @sq and reclaim its requests from the
+ * completion queue.  Runs in the AioContext that processes the queue pair.
+ */
+static void nvme_del_sq_bh(void *opaque)
+{
+    NvmeSQueue *sq = opaque;
+    NvmeCtrl *n = sq->ctrl;
+    NvmeCQueue *cq = n->cq[sq->cqid];
+    NvmeRequest *r, *next;
+
+    nvme_post_cqes(cq);
+    QTAILQ_FOREACH_SAFE(r, &cq->req_list, entry, next) {
+        if (r->sq == sq) {
+            QTAILQ_REMOVE(&cq->req_list, r, entry);
+            QTAILQ_INSERT_TAIL(&sq->req_list, r, entry);
+        }
+    }
+}
+
 static uint16_t nvme_del_sq(NvmeCtrl *n, NvmeRequest *req)
 {
     NvmeDeleteQ *c = (NvmeDeleteQ *)&req->cmd;
-    NvmeRequest *r, *next;
+    NvmeRequest *r;
     NvmeSQueue *sq;
     NvmeCQueue *cq;
     uint16_t qid = le16_to_cpu(c->qid);
@@ -4601,12 +4748,10 @@ static uint16_t nvme_del_sq(NvmeCtrl *n, NvmeRequest *req)
         cq = n->cq[sq->cqid];
         QTAILQ_REMOVE(&cq->sq_list, sq, entry);
 
-        nvme_post_cqes(cq);
-        QTAILQ_FOREACH_SAFE(r, &cq->req_list, entry, next) {
-            if (r->sq == sq) {
-                QTAILQ_REMOVE(&cq->req_list, r, entry);
-                QTAILQ_INSERT_TAIL(&sq->req_list, r, entry);
-            }
+        if (n->iothread) {
+            aio_wait_bh_oneshot(n->ctx, nvme_del_sq_bh, sq);
+        } else {
+            nvme_del_sq_bh(sq);
         }
     }
 
@@ -4635,8 +4780,9 @@ static void nvme_init_sq(NvmeSQueue *sq, NvmeCtrl *n, uint64_t dma_addr,
         QTAILQ_INSERT_TAIL(&(sq->req_list), &sq->io_req[i], entry);
     }
 
-    sq->bh = qemu_bh_new_guarded(nvme_process_sq, sq,
-                                 &DEVICE(sq->ctrl)->mem_reentrancy_guard);
+    sq->bh = aio_bh_new_guarded(nvme_queue_aio_context(n, sqid),
+                                nvme_process_sq, sq,
+                                &DEVICE(sq->ctrl)->mem_reentrancy_guard);
 
     if (n->dbbuf_enabled) {
         sq->db_addr = n->dbbuf_dbs + (sqid << 3);
@@ -5216,12 +5362,25 @@ static void nvme_free_cq(NvmeCQueue *cq, NvmeCtrl *n)
 
     n->cq[cq->cqid] = NULL;
     qemu_bh_delete(cq->bh);
+    qemu_bh_delete(cq->irq_bh);
+    timer_free(cq->coal_timer);
+    if (cq->irq_pending) {
+        cq->irq_pending = false;
+        n->cq_pending--;
+    }
     if (cq->ioeventfd_enabled) {
         memory_region_del_eventfd(&n->iomem,
                                   0x1000 + offset, 4, false, 0, &cq->notifier);
-        event_notifier_set_handler(&cq->notifier, NULL);
+        if (n->iothread) {
+            aio_set_event_notifier(n->ctx, &cq->notifier, NULL, NULL, NULL);
+        } else {
+            event_notifier_set_handler(&cq->notifier, NULL);
+        }
         event_notifier_cleanup(&cq->notifier);
     }
+    if (n->iothread && cq->cqid) {
+        aio_wait_bh_oneshot(n->ctx, nvme_queue_quiesced_bh, NULL);
+    }
     if (msix_enabled(pci)) {
         msix_vector_unuse(pci, cq->vector);
     }
@@ -5247,7 +5406,8 @@ static uint16_t nvme_del_cq(NvmeCtrl *n, NvmeRequest *req)
         return NVME_INVALID_QUEUE_DEL;
     }
 
-    if (cq->irq_enabled && cq->tail != cq->head) {
+    if (cq->irq_enabled && cq->irq_pending) {
+        cq->irq_pending = false;
         n->cq_pending--;
     }
 
@@ -5272,6 +5432,7 @@ static void nvme_init_cq(NvmeCQueue *cq, NvmeCtrl *n, uint64_t dma_addr,
     cq->dma_addr = dma_addr;
     cq->phase = 1;
     cq->irq_enabled = irq_enabled;
+    cq->irq_pending = false;
     cq->vector = vector;
     cq->head = cq->tail = 0;
     QTAILQ_INIT(&cq->req_list);
@@ -5287,8 +5448,13 @@ static void nvme_init_cq(NvmeCQueue *cq, NvmeCtrl *n, uint64_t dma_addr,
         }
     }
     n->cq[cqid] = cq;
-    cq->bh = qemu_bh_new_guarded(nvme_post_cqes, cq,
-                                 &DEVICE(cq->ctrl)->mem_reentrancy_guard);
+    cq->bh = aio_bh_new_guarded(nvme_queue_aio_context(n, cqid),
+                                nvme_post_cqes, cq,
+                                &DEVICE(cq->ctrl)->mem_reentrancy_guard);
+    cq->irq_bh = qemu_bh_new_guarded(nvme_cq_irq_bh, cq,
+                                     &DEVICE(cq->ctrl)->mem_reentrancy_guard);
+    cq->coal_timer = timer_new_ns(QEMU_CLOCK_VIRTUAL, nvme_cq_coalesce_timer,
+                                  cq);
 }
 
 static uint16_t nvme_create_cq(NvmeCtrl *n, NvmeRequest *req)
@@ -5990,6 +6156,21 @@ static uint16_t nvme_get_feature(NvmeCtrl *n, NvmeRequest *req)
         }
         trace_pci_nvme_getfeat_vwcache(result ? "enabled" : "disabled");
         goto out;
+    case NVME_INTERRUPT_COALESCING:
+        result = n->features.intc;
+        goto out;
+    case NVME_INTERRUPT_VECTOR_CONF:
+        iv = dw11 & 0xffff;
+        if (iv >= n->conf_ioqpairs + 1) {
+            return NVME_INVALID_FIELD | NVME_DNR;
+        }
+
+        result = iv;
+        if (iv == n->admin_cq.vector ||
+            test_bit(iv, n->features.intvc_nocoalescing)) {
+            result |= NVME_INTVC_NOCOALESCING;
+        }
+        goto out;
     case NVME_ASYNCHRONOUS_EVENT_CONF:
         result = n->features.async_config;
         goto out;
@@ -6153,6 +6334,7 @@ static uint16_t nvme_set_feature(NvmeCtrl *n, NvmeRequest *req)
     uint8_t fid = NVME_GETSETFEAT_FID(dw10);
     uint8_t save = NVME_SETFEAT_SAVE(dw10);
     uint16_t status;
+    uint16_t iv;
     int i;
 
     trace_pci_nvme_setfeat(nvme_cid(req), nsid, fid, save, dw11);
@@ -6269,6 +6451,21 @@ static uint16_t nvme_set_feature(NvmeCtrl *n, NvmeRequest *req)
         req->cqe.result = cpu_to_le32((n->conf_ioqpairs - 1) |
                                       ((n->conf_ioqpairs - 1) << 16));
         break;
+    case NVME_INTERRUPT_COALESCING:
+        n->features.intc = dw11 & 0xffff;
+        break;
+    case NVME_INTERRUPT_VECTOR_CONF:
+        iv = dw11 & 0xffff;
+        if (iv >= n->conf_ioqpairs + 1) {
+            return NVME_INVALID_FIELD | NVME_DNR;
+        }
+
+        if (dw11 & NVME_INTVC_NOCOALESCING) {
+            set_bit(iv, n->features.intvc_nocoalescing);
+        } else {
+            clear_bit(iv, n->features.intvc_nocoalescing);
+        }
+        break;
     case NVME_ASYNCHRONOUS_EVENT_CONF:
         n->features.async_config = dw11;
         break;
@@ -7114,6 +7311,17 @@ static void nvme_ctrl_reset(NvmeCtrl *n, NvmeResetType rst)
         }
     }
 
+    if (n->iothread) {
+        for (i = 1; i <= NVME_MAX_NAMESPACES; i++) {
+            ns = nvme_ns(n, i);
+            if (!ns) {
+                continue;
+            }
+
+            blk_set_aio_context(ns->blkconf.blk, qemu_get_aio_context(), NULL);
+        }
+    }
+
     while (!QTAILQ_EMPTY(&n->aer_queue)) {
         NvmeAsyncEvent *event = QTAILQ_FIRST(&n->aer_queue);
         QTAILQ_REMOVE(&n->aer_queue, event, entry);
@@ -7155,6 +7363,9 @@ static void nvme_ctrl_reset(NvmeCtrl *n, NvmeResetType rst)
     n->dbbuf_dbs = 0;
     n->dbbuf_eis = 0;
     n->dbbuf_enabled = false;
+
+    n->features.intc = 0;
+    bitmap_zero(n->features.intvc_nocoalescing, PCI_MSIX_FLAGS_QSIZE + 1);
 }
 
 static void nvme_ctrl_shutdown(NvmeCtrl *n)
@@ -7249,6 +7460,29 @@ static int nvme_start_ctrl(NvmeCtrl *n)
         return -1;
     }
 
+    if (n->iothread) {
+        NvmeNamespace *ns;
+        Error *local_err = NULL;
+        int i;
+
+        for (i = 1; i <= NVME_MAX_NAMESPACES; i++) {
+            ns = nvme_ns(n, i);
+            if (!ns) {
+                continue;
+            }
+
+            /*
+             * Home the backends in the iothread; dma_blk_read() and
+             * dma_blk_write() must be submitted from the context that the
+             * BlockBackend is bound to.
+             */
+            if (blk_set_aio_context(ns->blkconf.blk, n->ctx, &local_err) < 0) {
+                error_report_err(local_err);
+                return -1;
+            }
+        }
+    }
+
     n->page_bits = page_bits;
     n->page_size = page_size;
     n->max_prp_ents = n->page_size / sizeof(uint64_t);
@@ -7647,7 +7881,8 @@ static void nvme_process_db(NvmeCtrl *n, hwaddr addr, int val)
         }
 
         if (cq->tail == cq->head) {
-            if (cq->irq_enabled) {
+            if (cq->irq_enabled && cq->irq_pending) {
+                cq->irq_pending = false;
                 n->cq_pending--;
             }
 
@@ -7786,6 +8021,13 @@ static bool nvme_check_params(NvmeCtrl *n, Error **errp)
         return false;
     }
 
+    if (n->iothread && n->subsys) {
+        error_setg(errp, "iothread is not supported in combination with a "
+                   "subsystem; namespaces could be shared with controllers "
+                   "that process their queues in other threads");
+        return false;
+    }
+
     if (params->max_ioqpairs < 1 ||
         params->max_ioqpairs > NVME_MAX_IOQPAIRS) {
         error_setg(errp, "max_ioqpairs must be between 1 and %d",
@@ -7918,6 +8160,9 @@ static void nvme_init_state(NvmeCtrl *n)
     uint8_t max_vfs;
     int i;
 
+    n->ctx = n->iothread ? iothread_get_aio_context(n->iothread)
+                         : qemu_get_aio_context();
+
     if (pci_is_vf(pci)) {
         sctrl = nvme_sctrl(n);
         max_vfs = 0;
@@ -8326,6 +8571,11 @@ void nvme_attach_ns(NvmeCtrl *n, NvmeNamespace *ns)
     n->namespaces[nsid] = ns;
     ns->attached++;
 
+    /* the namespace may be attached while the controller is running */
+    if (n->iothread && NVME_CC_EN(ldl_le_p(&n->bar.cc))) {
+        blk_set_aio_context(ns->blkconf.blk, n->ctx, NULL);
+    }
+
     n->dmrsl = MIN_NON_ZERO(n->dmrsl,
                             BDRV_REQUEST_MAX_BYTES / nvme_l2b(ns, 1));
 }
@@ -8425,6 +8675,8 @@ static Property nvme_props[] = {
                      HostMemoryBackend *),
     DEFINE_PROP_LINK("subsys", NvmeCtrl, subsys, TYPE_NVME_SUBSYS,
                      NvmeSubsystem *),
+    DEFINE_PROP_LINK("iothread", NvmeCtrl, iothread, TYPE_IOTHREAD,
+                     IOThread *),
     DEFINE_PROP_STRING("serial", NvmeCtrl, params.serial),
     DEFINE_PROP_UINT32("cmb_size_mb", NvmeCtrl, params.cmb_size_mb, 0),
     DEFINE_PROP_UINT32("num_queues", NvmeCtrl, params.num_queues, 0),
@@ -21,6 +21,7 @@
 #include "qemu/uuid.h"
 #include "hw/pci/pci_device.h"
 #include "hw/block/block.h"
+#include "sysemu/iothread.h"
 
 #include "block/nvme.h"
 
@@ -498,6 +499,7 @@ typedef struct NvmeCQueue {
     uint8_t     phase;
     uint16_t    cqid;
     uint16_t    irq_enabled;
+    bool        irq_pending;
     uint32_t    head;
     uint32_t    tail;
     uint32_t    vector;
@@ -506,6 +508,8 @@ typedef struct NvmeCQueue {
     uint64_t    db_addr;
     uint64_t    ei_addr;
     QEMUBH      *bh;
+    QEMUBH      *irq_bh;
+    QEMUTimer   *coal_timer;
     EventNotifier notifier;
     bool        ioeventfd_enabled;
     QTAILQ_HEAD(, NvmeSQueue) sq_list;
@@ -547,6 +551,9 @@ typedef struct NvmeCtrl {
     NvmeParams   params;
     NvmeBus      bus;
 
+    IOThread     *iothread;
+    AioContext   *ctx;
+
     uint16_t    cntlid;
     bool        qs_created;
     uint32_t    page_size;
@@ -608,6 +615,8 @@ typedef struct NvmeCtrl {
         };
 
         uint32_t                async_config;
+        uint32_t                intc;
+        DECLARE_BITMAP(intvc_nocoalescing, PCI_MSIX_FLAGS_QSIZE + 1);
         NvmeHostBehaviorSupport hbs;
     } features;
 
@@ -61,6 +61,8 @@ static void q35_host_realize(DeviceState *dev, Error **errp)
     /* register q35 0xcf8 port as coalesced pio */
     memory_region_set_flush_coalesced(&pci->data_mem);
     memory_region_add_coalescing(&pci->conf_mem, 0, 4);
+    /* Data port accesses flush, so only the last address write matters */
+    memory_region_set_coalesced_write_merging(&pci->conf_mem);
 
     pci->bus = pci_root_bus_new(DEVICE(s), "pcie.0",
                                 s->mch.pci_address_space,
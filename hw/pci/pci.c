@@ -2232,6 +2232,31 @@ static uint8_t pci_find_capability_list(PCIDevice *pdev, uint8_t cap_id,
     return next;
 }
 
+/*
+ * Rebuild the capability offset index.  Walk order matches
+ * pci_find_capability_list(), so for duplicate capability IDs the cache
+ * holds the same offset a list walk would return.
+ */
+static void pci_cap_cache_rebuild(PCIDevice *pdev)
+{
+    uint8_t next;
+
+    memset(pdev->cap_cache, 0, sizeof(pdev->cap_cache));
+
+    if (!(pdev->config[PCI_STATUS] & PCI_STATUS_CAP_LIST)) {
+        return;
+    }
+
+    for (next = pdev->config[PCI_CAPABILITY_LIST]; next;
+         next = pdev->config[next + PCI_CAP_LIST_NEXT]) {
+        uint8_t cap_id = pdev->config[next + PCI_CAP_LIST_ID];
+
+        if (cap_id <= PCI_CAP_ID_MAX && !pdev->cap_cache[cap_id]) {
+            pdev->cap_cache[cap_id] = next;
+        }
+    }
+}
+
 static uint8_t pci_find_capability_at_offset(PCIDevice *pdev, uint8_t offset)
 {
     uint8_t next, prev, found = 0;
@@ -2463,6 +2488,9 @@ int pci_add_capability(PCIDevice *pdev, uint8_t cap_id,
     memset(pdev->wmask + offset, 0, size);
     /* Check capability by default */
     memset(pdev->cmask + offset, 0xFF, size);
+
+    pci_cap_cache_rebuild(pdev);
+
     return offset;
 }
 
@@ -2482,10 +2510,26 @@ void pci_del_capability(PCIDevice *pdev, uint8_t cap_id, uint8_t size)
 
     if (!pdev->config[PCI_CAPABILITY_LIST])
         pdev->config[PCI_STATUS] &= ~PCI_STATUS_CAP_LIST;
+
+    pci_cap_cache_rebuild(pdev);
 }
 
 uint8_t pci_find_capability(PCIDevice *pdev, uint8_t cap_id)
 {
+    uint8_t offset;
+
+    if (cap_id <= PCI_CAP_ID_MAX) {
+        offset = pdev->cap_cache[cap_id];
+        /*
+         * Devices that splice their capability chain by hand (e.g. for
+         * passthrough) bypass pci_add_capability(), so trust the cache
+         * only if the indexed offset still holds the capability.
+         */
+        if (offset && pdev->config[offset + PCI_CAP_LIST_ID] == cap_id) {
+            return offset;
+        }
+    }
+
     return pci_find_capability_list(pdev, cap_id, NULL);
 }
 
@@ -1003,8 +1003,50 @@ out:
     return next;
 }
 
+/*
+ * Rebuild the extended capability offset index.  Walk order matches
+ * pcie_find_capability_list(), so for duplicate capability IDs the
+ * cache holds the same offset a list walk would return.
+ */
+static void pcie_ext_cap_cache_rebuild(PCIDevice *dev)
+{
+    uint32_t header = pci_get_long(dev->config + PCI_CONFIG_SPACE_SIZE);
+    uint16_t next;
+
+    memset(dev->ext_cap_cache, 0, sizeof(dev->ext_cap_cache));
+
+    if (!header) {
+        return;
+    }
+
+    for (next = PCI_CONFIG_SPACE_SIZE; next; next = PCI_EXT_CAP_NEXT(header)) {
+        uint16_t cap_id;
+
+        header = pci_get_long(dev->config + next);
+        cap_id = PCI_EXT_CAP_ID(header);
+        if (cap_id <= PCI_EXT_CAP_ID_MAX && !dev->ext_cap_cache[cap_id]) {
+            dev->ext_cap_cache[cap_id] = next;
+        }
+    }
+}
+
 uint16_t pcie_find_capability(PCIDevice *dev, uint16_t cap_id)
 {
+    uint16_t offset;
+
+    if (cap_id <= PCI_EXT_CAP_ID_MAX) {
+        offset = dev->ext_cap_cache[cap_id];
+        /*
+         * Devices that splice their capability chain by hand (e.g. for
+         * passthrough) bypass pcie_add_capability(), so trust the cache
+         * only if the indexed offset still holds the capability.
+         */
+        if (offset &&
+            PCI_EXT_CAP_ID(pci_get_long(dev->config + offset)) == cap_id) {
+            return offset;
+        }
+    }
+
     return pcie_find_capability_list(dev, cap_id, NULL);
 }
 
@@ -1050,6 +1092,8 @@ void pcie_add_capability(PCIDevice *dev,
     memset(dev->w1cmask + offset, 0, size);
     /* Check capability by default */
     memset(dev->cmask + offset, 0xFF, size);
+
+    pcie_ext_cap_cache_rebuild(dev);
 }
 
 /*
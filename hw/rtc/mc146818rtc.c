@@ -935,6 +935,8 @@ static void rtc_realizefn(DeviceState *dev, Error **errp)
                           s, "rtc-index", 1);
     memory_region_add_subregion(&s->io, 0, &s->coalesced_io);
     memory_region_add_coalescing(&s->coalesced_io, 0, 1);
+    /* Data port accesses flush, so only the last index write matters */
+    memory_region_set_coalesced_write_merging(&s->coalesced_io);
 
     qdev_set_legacy_instance_id(dev, s->io_base, 3);
 
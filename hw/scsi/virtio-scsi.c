@@ -831,13 +831,62 @@ static void virtio_scsi_handle_cmd_req_submit(VirtIOSCSI *s, VirtIOSCSIReq *req)
     scsi_req_unref(sreq);
 }
 
+typedef QTAILQ_HEAD(, VirtIOSCSIReq) VirtIOSCSIReqList;
+
+static int virtio_scsi_cmd_req_cmp(const void *opaque_a, const void *opaque_b)
+{
+    VirtIOSCSIReq *a = *(VirtIOSCSIReq * const *)opaque_a;
+    VirtIOSCSIReq *b = *(VirtIOSCSIReq * const *)opaque_b;
+
+    if (a->sreq->dev != b->sreq->dev) {
+        return a->sreq->dev < b->sreq->dev ? -1 : 1;
+    }
+
+    if (a->sreq->cmd.lba != b->sreq->cmd.lba) {
+        return a->sreq->cmd.lba < b->sreq->cmd.lba ? -1 : 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Reorder the batch by (device, LBA) so that sequential guest I/O that
+ * arrives interleaved within a single virtqueue poll reaches the block
+ * layer in offset order, where adjacent requests can be merged.  SIMPLE
+ * task attribute commands carry no ordering guarantee, so they may be
+ * reordered freely; leave the batch untouched if it contains anything
+ * else.
+ */
+static void virtio_scsi_sort_cmd_reqs(VirtIOSCSIReqList *reqs, int nreqs)
+{
+    g_autofree VirtIOSCSIReq **elems = g_new(VirtIOSCSIReq *, nreqs);
+    VirtIOSCSIReq *req;
+    int i = 0;
+
+    QTAILQ_FOREACH(req, reqs, next) {
+        if (req->req.cmd.task_attr != VIRTIO_SCSI_S_SIMPLE) {
+            return;
+        }
+
+        elems[i++] = req;
+    }
+
+    qsort(elems, nreqs, sizeof(*elems), virtio_scsi_cmd_req_cmp);
+
+    QTAILQ_INIT(reqs);
+    for (i = 0; i < nreqs; i++) {
+        QTAILQ_INSERT_TAIL(reqs, elems[i], next);
+    }
+}
+
 static void virtio_scsi_handle_cmd_vq(VirtIOSCSI *s, VirtQueue *vq)
 {
     VirtIOSCSIReq *req, *next;
     int ret = 0;
+    int nreqs = 0;
     bool suppress_notifications = virtio_queue_get_notification(vq);
 
-    QTAILQ_HEAD(, VirtIOSCSIReq) reqs = QTAILQ_HEAD_INITIALIZER(reqs);
+    VirtIOSCSIReqList reqs = QTAILQ_HEAD_INITIALIZER(reqs);
 
     do {
         if (suppress_notifications) {
@@ -848,6 +897,7 @@ static void virtio_scsi_handle_cmd_vq(VirtIOSCSI *s, VirtQueue *vq)
             ret = virtio_scsi_handle_cmd_req_prepare(s, req);
             if (!ret) {
                 QTAILQ_INSERT_TAIL(&reqs, req, next);
+                nreqs++;
             } else if (ret == -EINVAL) {
                 /* The device is broken and shouldn't process any request */
                 while (!QTAILQ_EMPTY(&reqs)) {
@@ -858,6 +908,7 @@ static void virtio_scsi_handle_cmd_vq(VirtIOSCSI *s, VirtQueue *vq)
                     virtqueue_detach_element(req->vq, &req->elem, 0);
                     virtio_scsi_free_req(req);
                 }
+                nreqs = 0;
             }
         }
 
@@ -866,6 +917,10 @@ static void virtio_scsi_handle_cmd_vq(VirtIOSCSI *s, VirtQueue *vq)
         }
     } while (ret != -EINVAL && !virtio_queue_empty(vq));
 
+    if (nreqs > 1) {
+        virtio_scsi_sort_cmd_reqs(&reqs, nreqs);
+    }
+
     QTAILQ_FOREACH_SAFE(req, &reqs, next, next) {
         virtio_scsi_handle_cmd_req_submit(s, req);
     }
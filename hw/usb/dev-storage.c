@@ -10,6 +10,7 @@
 #include "qemu/osdep.h"
 #include "qapi/error.h"
 #include "qemu/error-report.h"
+#include "qemu/units.h"
 #include "qemu/module.h"
 #include "qemu/option.h"
 #include "qemu/config-file.h"
@@ -27,6 +28,9 @@
 #define MassStorageReset  0xff
 #define GetMaxLun         0xfe
 
+/* Room for two scsi-disk sized chunks of read-ahead data.  */
+#define USB_MSD_INBUF_SIZE  (256 * KiB)
+
 struct usb_msd_cbw {
     uint32_t sig;
     uint32_t tag;
@@ -208,20 +212,48 @@ static void usb_msd_fatal_error(MSDState *s)
     s->needs_reset = true;
 }
 
+static uint32_t usb_msd_inbuf_avail(MSDState *s)
+{
+    return s->inbuf_len - s->inbuf_off;
+}
+
 static void usb_msd_copy_data(MSDState *s, USBPacket *p)
 {
     uint32_t len;
+
+    /* Drain read-ahead data first, it precedes the live SCSI chunk.  */
+    len = MIN(p->iov.size - p->actual_length, usb_msd_inbuf_avail(s));
+    if (len) {
+        usb_packet_copy(p, s->inbuf + s->inbuf_off, len);
+        s->inbuf_off += len;
+        if (s->inbuf_off == s->inbuf_len) {
+            s->inbuf_off = s->inbuf_len = 0;
+        }
+        if (len > s->data_len) {
+            len = s->data_len;
+        }
+        s->data_len -= len;
+    }
+
     len = p->iov.size - p->actual_length;
     if (len > s->scsi_len)
         len = s->scsi_len;
-    usb_packet_copy(p, scsi_req_get_buf(s->req) + s->scsi_off, len);
-    s->scsi_len -= len;
-    s->scsi_off += len;
-    if (len > s->data_len) {
-        len = s->data_len;
+    if (len) {
+        usb_packet_copy(p, scsi_req_get_buf(s->req) + s->scsi_off, len);
+        s->scsi_len -= len;
+        s->scsi_off += len;
+        if (len > s->data_len) {
+            len = s->data_len;
+        }
+        s->data_len -= len;
     }
-    s->data_len -= len;
-    if (s->scsi_len == 0 || s->data_len == 0) {
+
+    if (usb_msd_inbuf_avail(s)) {
+        return;
+    }
+    if (s->req && !s->req_continued &&
+        (s->scsi_len == 0 || s->data_len == 0)) {
+        s->req_continued = true;
         scsi_req_continue(s->req);
     }
 }
@@ -249,6 +281,7 @@ void usb_msd_transfer_data(SCSIRequest *req, uint32_t len)
         return;
     }
 
+    s->req_continued = false;
     s->scsi_len = len;
     s->scsi_off = 0;
     if (p) {
@@ -259,18 +292,37 @@ void usb_msd_transfer_data(SCSIRequest *req, uint32_t len)
             usb_msd_packet_complete(s);
         }
     }
+
+    /*
+     * Read-ahead: stash whatever the guest has not consumed yet and
+     * request the next chunk right away, so the block layer works on it
+     * while the guest drains the bulk pipe.
+     */
+    if (s->mode == USB_MSDM_DATAIN && s->req && !s->req_continued &&
+        s->inbuf && s->scsi_len &&
+        s->scsi_len <= s->inbuf_size - s->inbuf_len) {
+        memcpy(s->inbuf + s->inbuf_len,
+               scsi_req_get_buf(s->req) + s->scsi_off, s->scsi_len);
+        s->inbuf_len += s->scsi_len;
+        s->scsi_len = 0;
+        s->req_continued = true;
+        scsi_req_continue(s->req);
+    }
 }
 
 void usb_msd_command_complete(SCSIRequest *req, size_t resid)
 {
     MSDState *s = DO_UPCAST(MSDState, dev.qdev, req->bus->qbus.parent);
     USBPacket *p = s->packet;
+    uint32_t inbuf_avail = usb_msd_inbuf_avail(s);
 
     trace_usb_msd_cmd_complete(req->status, req->tag);
 
     s->csw.sig = cpu_to_le32(0x53425355);
     s->csw.tag = cpu_to_le32(req->tag);
-    s->csw.residue = cpu_to_le32(s->data_len);
+    /* read-ahead data still in flight to the guest is not residue */
+    s->csw.residue = cpu_to_le32(s->data_len > inbuf_avail ?
+                                 s->data_len - inbuf_avail : 0);
     s->csw.status = req->status != 0;
 
     if (s->packet) {
@@ -318,6 +370,7 @@ void usb_msd_request_cancelled(SCSIRequest *req)
         scsi_req_unref(s->req);
         s->req = NULL;
         s->scsi_len = 0;
+        s->inbuf_len = s->inbuf_off = 0;
     }
 }
 
@@ -338,6 +391,7 @@ void usb_msd_handle_reset(USBDevice *dev)
 
     memset(&s->csw, 0, sizeof(s->csw));
     s->mode = USB_MSDM_CBW;
+    s->inbuf_len = s->inbuf_off = 0;
 
     s->needs_reset = false;
 }
@@ -361,6 +415,7 @@ static void usb_msd_handle_control(USBDevice *dev, USBPacket *p,
     case ClassInterfaceOutRequest | MassStorageReset:
         /* Reset state ready for the next CBW.  */
         s->mode = USB_MSDM_CBW;
+        s->inbuf_len = s->inbuf_off = 0;
         break;
     case ClassInterfaceRequest | GetMaxLun:
         maxlun = 0;
@@ -438,6 +493,10 @@ static void usb_msd_handle_data(USBDevice *dev, USBPacket *p)
                 s->mode = USB_MSDM_CSW;
             } else if (cbw.flags & 0x80) {
                 s->mode = USB_MSDM_DATAIN;
+                if (!s->inbuf) {
+                    s->inbuf = g_malloc(USB_MSD_INBUF_SIZE);
+                    s->inbuf_size = USB_MSD_INBUF_SIZE;
+                }
             } else {
                 s->mode = USB_MSDM_DATAOUT;
             }
@@ -445,6 +504,8 @@ static void usb_msd_handle_data(USBDevice *dev, USBPacket *p)
                                      cbw.cmd_len, s->data_len);
             assert(le32_to_cpu(s->csw.residue) == 0);
             s->scsi_len = 0;
+            s->inbuf_len = s->inbuf_off = 0;
+            s->req_continued = false;
             s->req = scsi_req_new(scsi_dev, tag, cbw.lun, cbw.cmd, cbw.cmd_len, NULL);
             if (s->commandlog) {
                 scsi_req_print(s->req);
@@ -522,9 +583,14 @@ static void usb_msd_handle_data(USBDevice *dev, USBPacket *p)
 
         case USB_MSDM_DATAIN:
             trace_usb_msd_data_in(p->iov.size, s->data_len, s->scsi_len);
-            if (s->scsi_len) {
+            if (s->scsi_len || usb_msd_inbuf_avail(s)) {
                 usb_msd_copy_data(s, p);
             }
+            if (!s->req && s->data_len == 0 && !usb_msd_inbuf_avail(s)) {
+                /* the command completed ahead of the guest draining the
+                   read-ahead buffer; it is empty now */
+                s->mode = USB_MSDM_CSW;
+            }
             if (le32_to_cpu(s->csw.residue)) {
                 len = p->iov.size - p->actual_length;
                 if (len) {
@@ -568,6 +634,27 @@ void *usb_msd_load_request(QEMUFile *f, SCSIRequest *req)
     return NULL;
 }
 
+static bool usb_msd_inbuf_needed(void *opaque)
+{
+    MSDState *s = opaque;
+
+    return usb_msd_inbuf_avail(s) != 0;
+}
+
+static const VMStateDescription vmstate_usb_msd_inbuf = {
+    .name = "usb-storage/inbuf",
+    .version_id = 1,
+    .minimum_version_id = 1,
+    .needed = usb_msd_inbuf_needed,
+    .fields = (const VMStateField[]) {
+        VMSTATE_UINT32(inbuf_size, MSDState),
+        VMSTATE_UINT32(inbuf_len, MSDState),
+        VMSTATE_UINT32(inbuf_off, MSDState),
+        VMSTATE_VBUFFER_ALLOC_UINT32(inbuf, MSDState, 1, NULL, inbuf_size),
+        VMSTATE_END_OF_LIST()
+    }
+};
+
 static const VMStateDescription vmstate_usb_msd = {
     .name = "usb-storage",
     .version_id = 1,
@@ -583,6 +670,10 @@ static const VMStateDescription vmstate_usb_msd = {
         VMSTATE_UINT32(csw.residue, MSDState),
         VMSTATE_UINT8(csw.status, MSDState),
         VMSTATE_END_OF_LIST()
+    },
+    .subsections = (const VMStateDescription * const []) {
+        &vmstate_usb_msd_inbuf,
+        NULL
     }
 };
 
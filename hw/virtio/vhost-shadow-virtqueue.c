@@ -34,6 +34,7 @@ bool vhost_svq_valid_features(uint64_t features, Error **errp)
         switch (b) {
         case VIRTIO_F_ANY_LAYOUT:
         case VIRTIO_RING_F_EVENT_IDX:
+        case VIRTIO_F_RING_PACKED:
             continue;
 
         case VIRTIO_F_ACCESS_PLATFORM:
@@ -217,6 +218,73 @@ static bool vhost_svq_add_split(VhostShadowVirtqueue *svq,
     return true;
 }
 
+static bool vhost_svq_add_packed(VhostShadowVirtqueue *svq,
+                                 const struct iovec *out_sg, size_t out_num,
+                                 const struct iovec *in_sg, size_t in_num,
+                                 unsigned *head)
+{
+    struct vring_packed_desc *descs = svq->vring_packed.desc;
+    uint16_t head_idx = svq->shadow_avail_idx;
+    uint16_t head_flags = 0;
+    uint16_t id, i;
+    unsigned n;
+    bool ok;
+    g_autofree hwaddr *sgs = g_new(hwaddr, out_num + in_num);
+
+    /* We need some descriptors here */
+    if (unlikely(!out_num && !in_num)) {
+        qemu_log_mask(LOG_GUEST_ERROR,
+                      "Guest provided element with no descriptors");
+        return false;
+    }
+
+    ok = vhost_svq_translate_addr(svq, sgs, out_sg, out_num) &&
+         vhost_svq_translate_addr(svq, sgs + out_num, in_sg, in_num);
+    if (unlikely(!ok)) {
+        return false;
+    }
+
+    id = svq->free_head;
+    i = head_idx;
+    for (n = 0; n < out_num + in_num; n++) {
+        const struct iovec *sg = n < out_num ? &out_sg[n]
+                                             : &in_sg[n - out_num];
+        uint16_t flags = cpu_to_le16(
+            (n < out_num ? 0 : VRING_DESC_F_WRITE) |
+            (n + 1 == out_num + in_num ? 0 : VRING_DESC_F_NEXT) |
+            (svq->avail_wrap_counter ? BIT(VRING_PACKED_DESC_F_AVAIL)
+                                     : BIT(VRING_PACKED_DESC_F_USED)));
+
+        descs[i].addr = cpu_to_le64(sgs[n]);
+        descs[i].len = cpu_to_le32(sg->iov_len);
+        descs[i].id = cpu_to_le16(id);
+        if (i == head_idx) {
+            /* Deferred until the rest of the chain is written */
+            head_flags = flags;
+        } else {
+            descs[i].flags = flags;
+        }
+
+        if (++i >= svq->vring.num) {
+            i = 0;
+            svq->avail_wrap_counter = !svq->avail_wrap_counter;
+        }
+    }
+
+    svq->shadow_avail_idx = i;
+    svq->free_head = le16_to_cpu(svq->desc_next[id]);
+
+    /*
+     * The chain becomes visible to the device when the head descriptor's
+     * avail flag is written, so it must be the last store.
+     */
+    smp_wmb();
+    descs[head_idx].flags = head_flags;
+
+    *head = id;
+    return true;
+}
+
 static void vhost_svq_kick(VhostShadowVirtqueue *svq)
 {
     bool needs_kick;
@@ -227,7 +295,16 @@ static void vhost_svq_kick(VhostShadowVirtqueue *svq)
      */
     smp_mb();
 
-    if (virtio_vdev_has_feature(svq->vdev, VIRTIO_RING_F_EVENT_IDX)) {
+    if (svq->is_packed) {
+        uint16_t flags = le16_to_cpu(*(volatile uint16_t *)
+                                     &svq->vring_packed.device->flags);
+        /*
+         * VRING_PACKED_EVENT_FLAG_DESC would allow skipping some
+         * notifications, but always sending one is also correct and the
+         * device only uses it when EVENT_IDX is negotiated.
+         */
+        needs_kick = flags != VRING_PACKED_EVENT_FLAG_DISABLE;
+    } else if (virtio_vdev_has_feature(svq->vdev, VIRTIO_RING_F_EVENT_IDX)) {
         uint16_t avail_event = *(uint16_t *)(&svq->vring.used->ring[svq->vring.num]);
         needs_kick = vring_need_event(avail_event, svq->shadow_avail_idx, svq->shadow_avail_idx - 1);
     } else {
@@ -258,7 +335,13 @@ int vhost_svq_add(VhostShadowVirtqueue *svq, const struct iovec *out_sg,
         return -ENOSPC;
     }
 
-    ok = vhost_svq_add_split(svq, out_sg, out_num, in_sg, in_num, &qemu_head);
+    if (svq->is_packed) {
+        ok = vhost_svq_add_packed(svq, out_sg, out_num, in_sg, in_num,
+                                  &qemu_head);
+    } else {
+        ok = vhost_svq_add_split(svq, out_sg, out_num, in_sg, in_num,
+                                 &qemu_head);
+    }
     if (unlikely(!ok)) {
         return -EINVAL;
     }
@@ -358,7 +441,7 @@ static void vhost_handle_guest_kick_notifier(EventNotifier *n)
     vhost_handle_guest_kick(svq);
 }
 
-static bool vhost_svq_more_used(VhostShadowVirtqueue *svq)
+static bool vhost_svq_more_used_split(VhostShadowVirtqueue *svq)
 {
     uint16_t *used_idx = &svq->vring.used->idx;
     if (svq->last_used_idx != svq->shadow_used_idx) {
@@ -370,6 +453,22 @@ static bool vhost_svq_more_used(VhostShadowVirtqueue *svq)
     return svq->last_used_idx != svq->shadow_used_idx;
 }
 
+static bool vhost_svq_more_used_packed(VhostShadowVirtqueue *svq)
+{
+    uint16_t flags = le16_to_cpu(*(volatile uint16_t *)
+                            &svq->vring_packed.desc[svq->last_used_idx].flags);
+    bool avail = flags & BIT(VRING_PACKED_DESC_F_AVAIL);
+    bool used = flags & BIT(VRING_PACKED_DESC_F_USED);
+
+    return avail == used && used == svq->used_wrap_counter;
+}
+
+static bool vhost_svq_more_used(VhostShadowVirtqueue *svq)
+{
+    return svq->is_packed ? vhost_svq_more_used_packed(svq)
+                          : vhost_svq_more_used_split(svq);
+}
+
 /**
  * Enable vhost device calls after disable them.
  *
@@ -381,7 +480,10 @@ static bool vhost_svq_more_used(VhostShadowVirtqueue *svq)
  */
 static bool vhost_svq_enable_notification(VhostShadowVirtqueue *svq)
 {
-    if (virtio_vdev_has_feature(svq->vdev, VIRTIO_RING_F_EVENT_IDX)) {
+    if (svq->is_packed) {
+        svq->vring_packed.driver->flags =
+            cpu_to_le16(VRING_PACKED_EVENT_FLAG_ENABLE);
+    } else if (virtio_vdev_has_feature(svq->vdev, VIRTIO_RING_F_EVENT_IDX)) {
         uint16_t *used_event = (uint16_t *)&svq->vring.avail->ring[svq->vring.num];
         *used_event = svq->shadow_used_idx;
     } else {
@@ -395,6 +497,12 @@ static bool vhost_svq_enable_notification(VhostShadowVirtqueue *svq)
 
 static void vhost_svq_disable_notification(VhostShadowVirtqueue *svq)
 {
+    if (svq->is_packed) {
+        svq->vring_packed.driver->flags =
+            cpu_to_le16(VRING_PACKED_EVENT_FLAG_DISABLE);
+        return;
+    }
+
     /*
      * No need to disable notification in the event idx case, since used event
      * index is already an index too far away.
@@ -414,14 +522,14 @@ static uint16_t vhost_svq_last_desc_of_chain(const VhostShadowVirtqueue *svq,
     return i;
 }
 
-static VirtQueueElement *vhost_svq_get_buf(VhostShadowVirtqueue *svq,
-                                           uint32_t *len)
+static VirtQueueElement *vhost_svq_get_buf_split(VhostShadowVirtqueue *svq,
+                                                 uint32_t *len)
 {
     const vring_used_t *used = svq->vring.used;
     vring_used_elem_t used_elem;
     uint16_t last_used, last_used_chain, num;
 
-    if (!vhost_svq_more_used(svq)) {
+    if (!vhost_svq_more_used_split(svq)) {
         return NULL;
     }
 
@@ -456,6 +564,65 @@ static VirtQueueElement *vhost_svq_get_buf(VhostShadowVirtqueue *svq,
     return g_steal_pointer(&svq->desc_state[used_elem.id].elem);
 }
 
+/* Advance the device ring position of a packed SVQ by num slots */
+static void vhost_svq_used_advance_packed(VhostShadowVirtqueue *svq,
+                                          uint16_t num)
+{
+    svq->last_used_idx += num;
+    if (svq->last_used_idx >= svq->vring.num) {
+        svq->last_used_idx -= svq->vring.num;
+        svq->used_wrap_counter = !svq->used_wrap_counter;
+    }
+}
+
+static VirtQueueElement *vhost_svq_get_buf_packed(VhostShadowVirtqueue *svq,
+                                                  uint32_t *len)
+{
+    const struct vring_packed_desc *descs = svq->vring_packed.desc;
+    uint16_t id, num;
+
+    if (!vhost_svq_more_used_packed(svq)) {
+        return NULL;
+    }
+
+    /* Only get used elements after they have been exposed by dev */
+    smp_rmb();
+    id = le16_to_cpu(descs[svq->last_used_idx].id);
+    *len = le32_to_cpu(descs[svq->last_used_idx].len);
+
+    if (unlikely(id >= svq->vring.num ||
+                 !svq->desc_state[id].ndescs)) {
+        qemu_log_mask(LOG_GUEST_ERROR,
+            "Device %s says index %u is used, but it was not available",
+            svq->vdev->name, id);
+        /* Skip the bogus used entry so the SVQ does not spin on it */
+        vhost_svq_used_advance_packed(svq, 1);
+        return NULL;
+    }
+
+    /*
+     * The device may use chains out of order: the ring position advances
+     * over the length of the chain identified by id, which may differ from
+     * the one exposed at this slot.
+     */
+    num = svq->desc_state[id].ndescs;
+    svq->desc_state[id].ndescs = 0;
+    vhost_svq_used_advance_packed(svq, num);
+
+    svq->desc_next[id] = cpu_to_le16(svq->free_head);
+    svq->free_head = id;
+    svq->num_free += num;
+
+    return g_steal_pointer(&svq->desc_state[id].elem);
+}
+
+static VirtQueueElement *vhost_svq_get_buf(VhostShadowVirtqueue *svq,
+                                           uint32_t *len)
+{
+    return svq->is_packed ? vhost_svq_get_buf_packed(svq, len)
+                          : vhost_svq_get_buf_split(svq, len);
+}
+
 /**
  * Push an element to SVQ, returning it to the guest.
  */
@@ -602,17 +769,31 @@ void vhost_svq_get_vring_addr(const VhostShadowVirtqueue *svq,
 
 size_t vhost_svq_driver_area_size(const VhostShadowVirtqueue *svq)
 {
-    size_t desc_size = sizeof(vring_desc_t) * svq->vring.num;
-    size_t avail_size = offsetof(vring_avail_t, ring[svq->vring.num]) +
+    size_t desc_size, avail_size;
+
+    if (svq->is_packed) {
+        desc_size = sizeof(struct vring_packed_desc) * svq->vring.num;
+        avail_size = sizeof(struct vring_packed_desc_event);
+    } else {
+        desc_size = sizeof(vring_desc_t) * svq->vring.num;
+        avail_size = offsetof(vring_avail_t, ring[svq->vring.num]) +
                                                               sizeof(uint16_t);
+    }
 
     return ROUND_UP(desc_size + avail_size, qemu_real_host_page_size());
 }
 
 size_t vhost_svq_device_area_size(const VhostShadowVirtqueue *svq)
 {
-    size_t used_size = offsetof(vring_used_t, ring[svq->vring.num]) +
+    size_t used_size;
+
+    if (svq->is_packed) {
+        used_size = sizeof(struct vring_packed_desc_event);
+    } else {
+        used_size = offsetof(vring_used_t, ring[svq->vring.num]) +
                                                               sizeof(uint16_t);
+    }
+
     return ROUND_UP(used_size, qemu_real_host_page_size());
 }
 
@@ -668,16 +849,32 @@ void vhost_svq_start(VhostShadowVirtqueue *svq, VirtIODevice *vdev,
     svq->vq = vq;
     svq->iova_tree = iova_tree;
 
+    svq->is_packed = virtio_vdev_has_feature(vdev, VIRTIO_F_RING_PACKED);
     svq->vring.num = virtio_queue_get_num(vdev, virtio_get_queue_index(vq));
     svq->num_free = svq->vring.num;
     svq->vring.desc = mmap(NULL, vhost_svq_driver_area_size(svq),
                            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
                            -1, 0);
-    desc_size = sizeof(vring_desc_t) * svq->vring.num;
-    svq->vring.avail = (void *)((char *)svq->vring.desc + desc_size);
     svq->vring.used = mmap(NULL, vhost_svq_device_area_size(svq),
                            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
                            -1, 0);
+    if (svq->is_packed) {
+        desc_size = sizeof(struct vring_packed_desc) * svq->vring.num;
+        svq->vring_packed.desc = (void *)svq->vring.desc;
+        svq->vring_packed.driver = (void *)((char *)svq->vring.desc +
+                                            desc_size);
+        svq->vring_packed.device = (void *)svq->vring.used;
+        /*
+         * vhost_vring_addr reuses the split fields for the packed descriptor
+         * ring and the event suppression areas, so keep them as aliases.
+         */
+        svq->vring.avail = (void *)svq->vring_packed.driver;
+        svq->avail_wrap_counter = true;
+        svq->used_wrap_counter = true;
+    } else {
+        desc_size = sizeof(vring_desc_t) * svq->vring.num;
+        svq->vring.avail = (void *)((char *)svq->vring.desc + desc_size);
+    }
     svq->desc_state = g_new0(SVQDescState, svq->vring.num);
     svq->desc_next = g_new0(uint16_t, svq->vring.num);
     for (unsigned i = 0; i < svq->vring.num - 1; i++) {
@@ -51,6 +51,18 @@ typedef struct VhostShadowVirtqueue {
     /* Shadow vring */
     struct vring vring;
 
+    /* Shadow packed vring, used instead of vring.desc/avail/used if packed */
+    struct {
+        /* Packed descriptor ring */
+        struct vring_packed_desc *desc;
+
+        /* Driver event suppression area */
+        struct vring_packed_desc_event *driver;
+
+        /* Device event suppression area */
+        struct vring_packed_desc_event *device;
+    } vring_packed;
+
     /* Shadow kick notifier, sent to vhost */
     EventNotifier hdev_kick;
     /* Shadow call notifier, sent to vhost */
@@ -110,6 +122,15 @@ typedef struct VhostShadowVirtqueue {
 
     /* Size of SVQ vring free descriptors */
     uint16_t num_free;
+
+    /* True if the device negotiated VIRTIO_F_RING_PACKED */
+    bool is_packed;
+
+    /* Driver ring wrap counter, only used if is_packed */
+    bool avail_wrap_counter;
+
+    /* Device ring wrap counter, only used if is_packed */
+    bool used_wrap_counter;
 } VhostShadowVirtqueue;
 
 bool vhost_svq_valid_features(uint64_t features, Error **errp);
@@ -264,6 +264,17 @@ struct vhost_user {
     /* Our current regions */
     int num_shadow_regions;
     struct vhost_memory_region shadow_regions[VHOST_USER_MAX_RAM_SLOTS];
+
+    /*
+     * Copy of the last SET_MEM_TABLE payload the backend accepted,
+     * used to skip retransmissions that would make the backend tear
+     * down and remap every region for no change.  Only meaningful for
+     * the lifetime of the backend connection; a reconnected backend
+     * starts from a fresh vhost_user.
+     */
+    bool last_mem_table_valid;
+    VhostUserMemory last_mem_table;
+    int last_mem_table_fds[VHOST_MEMORY_BASELINE_NREGIONS];
 };
 
 struct scrub_regions {
@@ -1043,14 +1054,34 @@ static int vhost_user_set_mem_table(struct vhost_dev *dev,
             return ret;
         }
 
+        /*
+         * The table is resent on every device start.  If neither the
+         * layout nor the backing fds changed, the backend already has
+         * exactly these mappings and the message can be elided.
+         */
+        if (u->last_mem_table_valid &&
+            memcmp(&msg.payload.memory, &u->last_mem_table,
+                   sizeof(msg.payload.memory)) == 0 &&
+            memcmp(fds, u->last_mem_table_fds, fd_num * sizeof(fds[0])) == 0) {
+            return 0;
+        }
+        u->last_mem_table_valid = false;
+
         ret = vhost_user_write(dev, &msg, fds, fd_num);
         if (ret < 0) {
             return ret;
         }
 
         if (reply_supported) {
-            return process_message_reply(dev, &msg);
+            ret = process_message_reply(dev, &msg);
+            if (ret < 0) {
+                return ret;
+            }
         }
+
+        u->last_mem_table = msg.payload.memory;
+        memcpy(u->last_mem_table_fds, fds, fd_num * sizeof(fds[0]));
+        u->last_mem_table_valid = true;
     }
 
     return 0;
@@ -1483,11 +1514,15 @@ static int vhost_user_get_max_memslots(struct vhost_dev *dev,
 
 static int vhost_user_reset_device(struct vhost_dev *dev)
 {
+    struct vhost_user *u = dev->opaque;
     VhostUserMsg msg = {
         .hdr.flags = VHOST_USER_VERSION,
         .hdr.request = VHOST_USER_RESET_DEVICE,
     };
 
+    /* A reset backend drops its mappings */
+    u->last_mem_table_valid = false;
+
     /*
      * Historically, reset was not implemented so only reset devices
      * that are expecting it.
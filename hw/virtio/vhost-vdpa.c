@@ -1225,6 +1225,14 @@ static bool vhost_vdpa_svq_setup(struct vhost_dev *dev,
     };
     int r;
 
+    if (virtio_vdev_has_feature(dev->vdev, VIRTIO_F_RING_PACKED)) {
+        /*
+         * The packed vring base carries the wrap counters in bits 15 and
+         * 31, and the SVQ vring starts with both of them set.
+         */
+        s.num = (1u << 31) | (1 << 15);
+    }
+
     r = vhost_vdpa_set_dev_vring_base(dev, &s);
     if (unlikely(r)) {
         error_setg_errno(errp, -r, "Cannot set vring base");
@@ -14,6 +14,8 @@
  */
 
 #include "qemu/osdep.h"
+#include "qemu/cutils.h"
+#include "qemu/host-utils.h"
 #include "qemu/iov.h"
 #include "qemu/module.h"
 #include "qemu/timer.h"
@@ -75,9 +77,97 @@ static bool virtio_balloon_inhibited(void)
             migration_in_bg_snapshot();
 }
 
+#define HPAGE_PMD_SIZE_PATH "/sys/kernel/mm/transparent_hugepage/hpage_pmd_size"
+
+/* Probed host THP size, or 0 when the host does not expose it */
+static size_t balloon_thp_size(void)
+{
+    static size_t thp_size;
+    static bool probed;
+    gchar *content = NULL;
+    const char *endptr;
+    uint64_t tmp;
+
+    if (probed) {
+        return thp_size;
+    }
+
+    if (g_file_get_contents(HPAGE_PMD_SIZE_PATH, &content, NULL, NULL) &&
+        !qemu_strtou64(content, &endptr, 0, &tmp) &&
+        (!endptr || *endptr == '\n') &&
+        tmp && is_power_of_2(tmp)) {
+        thp_size = tmp;
+    }
+    g_free(content);
+    probed = true;
+    return thp_size;
+}
+
+/*
+ * Keep khugepaged away from host THP regions the guest is discarding
+ * piecemeal, and invite it back once pages are returned.  Without the
+ * inflate-side hint, the 4k discards below split a transparent hugepage
+ * and khugepaged may immediately rebuild it around the hole, undoing
+ * the ballooning.  Consecutive pages of the same region only issue one
+ * madvise call.
+ */
+static void balloon_thp_hint(VirtIOBalloon *balloon, void *addr, size_t size,
+                             bool inflate)
+{
+    size_t thp_size = balloon_thp_size();
+    void *base, *last;
+
+    if (!thp_size) {
+        return;
+    }
+
+    base = (void *)((uintptr_t)addr & ~(thp_size - 1));
+    last = (void *)(((uintptr_t)addr + size - 1) & ~(thp_size - 1));
+    if (base == last && balloon->thp_hint_base == base &&
+        balloon->thp_hint_nohuge == inflate) {
+        return;
+    }
+    balloon->thp_hint_base = last;
+    balloon->thp_hint_nohuge = inflate;
+
+    /* Best effort, like the discard and deflate hints */
+    qemu_madvise(base, (uintptr_t)last - (uintptr_t)base + thp_size,
+                 inflate ? QEMU_MADV_NOHUGEPAGE : QEMU_MADV_HUGEPAGE);
+}
+
+/*
+ * Guests post inflate PFNs in batches that are very often contiguous,
+ * ascending or descending; merge them so that ballooning memory out
+ * issues one discard per contiguous run instead of one syscall per
+ * 4k page.  A range never outlives the virtqueue element it was
+ * collected from, so the RAMBlock stays valid under the BQL.
+ */
+typedef struct BalloonDiscardRange {
+    RAMBlock *rb;
+    ram_addr_t offset;
+    void *host;
+    size_t size;        /* 0 when no range is pending */
+} BalloonDiscardRange;
+
+static void balloon_discard_range_flush(VirtIOBalloon *balloon,
+                                        BalloonDiscardRange *range)
+{
+    if (!range->size) {
+        return;
+    }
+
+    balloon_thp_hint(balloon, range->host, range->size, true);
+    ram_block_discard_range(range->rb, range->offset, range->size);
+    /* We ignore errors from ram_block_discard_range(), because it
+     * has already reported them, and failing to discard a balloon
+     * page is not fatal */
+    range->size = 0;
+}
+
 static void balloon_inflate_page(VirtIOBalloon *balloon,
                                  MemoryRegion *mr, hwaddr mr_offset,
-                                 PartiallyBalloonedPage *pbp)
+                                 PartiallyBalloonedPage *pbp,
+                                 BalloonDiscardRange *range)
 {
     void *addr = memory_region_get_ram_ptr(mr) + mr_offset;
     ram_addr_t rb_offset, rb_aligned_offset, base_gpa;
@@ -91,12 +181,25 @@ static void balloon_inflate_page(VirtIOBalloon *balloon,
     rb_page_size = qemu_ram_pagesize(rb);
 
     if (rb_page_size == BALLOON_PAGE_SIZE) {
-        /* Easy case */
+        /* Easy case: extend the pending range when adjacent */
 
-        ram_block_discard_range(rb, rb_offset, rb_page_size);
-        /* We ignore errors from ram_block_discard_range(), because it
-         * has already reported them, and failing to discard a balloon
-         * page is not fatal */
+        if (range->size && rb == range->rb) {
+            if (rb_offset == range->offset + range->size) {
+                range->size += rb_page_size;
+                return;
+            }
+            if (rb_offset + rb_page_size == range->offset) {
+                range->offset = rb_offset;
+                range->host = addr;
+                range->size += rb_page_size;
+                return;
+            }
+        }
+        balloon_discard_range_flush(balloon, range);
+        range->rb = rb;
+        range->offset = rb_offset;
+        range->host = addr;
+        range->size = rb_page_size;
         return;
     }
 
@@ -157,6 +260,11 @@ static void balloon_deflate_page(VirtIOBalloon *balloon,
 
     host_addr = (void *)((uintptr_t)addr & ~(rb_page_size - 1));
 
+    if (rb_page_size == BALLOON_PAGE_SIZE) {
+        /* Make the region eligible for collapse by khugepaged again */
+        balloon_thp_hint(balloon, addr, BALLOON_PAGE_SIZE, false);
+    }
+
     /* When a page is deflated, we hint the whole host page it lives
      * on, since we can't do anything smaller */
     ret = qemu_madvise(host_addr, rb_page_size, QEMU_MADV_WILLNEED);
@@ -392,6 +500,7 @@ static void virtio_balloon_handle_output(VirtIODevice *vdev, VirtQueue *vq)
 
     for (;;) {
         PartiallyBalloonedPage pbp = {};
+        BalloonDiscardRange range = {};
         size_t offset = 0;
         uint32_t pfn;
 
@@ -426,7 +535,8 @@ static void virtio_balloon_handle_output(VirtIODevice *vdev, VirtQueue *vq)
             if (!virtio_balloon_inhibited()) {
                 if (vq == s->ivq) {
                     balloon_inflate_page(s, section.mr,
-                                         section.offset_within_region, &pbp);
+                                         section.offset_within_region,
+                                         &pbp, &range);
                 } else if (vq == s->dvq) {
                     balloon_deflate_page(s, section.mr, section.offset_within_region);
                 } else {
@@ -436,6 +546,7 @@ static void virtio_balloon_handle_output(VirtIODevice *vdev, VirtQueue *vq)
             memory_region_unref(section.mr);
         }
 
+        balloon_discard_range_flush(s, &range);
         virtqueue_push(vq, elem, 0);
         virtio_notify(vdev, vq);
         g_free(elem);
@@ -249,6 +249,14 @@ void hmp_virtio_queue_status(Monitor *mon, const QDict *qdict)
         monitor_printf(mon, "  shadow_avail_idx:     %d\n",
                        s->shadow_avail_idx);
     }
+    if (s->has_notifications) {
+        monitor_printf(mon, "  notifications:        %"PRId64"\n",
+                       s->notifications);
+    }
+    if (s->has_polled) {
+        monitor_printf(mon, "  polled:               %"PRId64"\n",
+                       s->polled);
+    }
     monitor_printf(mon, "  VRing:\n");
     monitor_printf(mon, "    num:          %"PRId32"\n", s->vring_num);
     monitor_printf(mon, "    num_default:  %"PRId32"\n",
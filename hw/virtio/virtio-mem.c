@@ -13,6 +13,7 @@
 #include "qemu/osdep.h"
 #include "qemu/iov.h"
 #include "qemu/cutils.h"
+#include "qemu/madvise.h"
 #include "qemu/error-report.h"
 #include "qemu/units.h"
 #include "sysemu/numa.h"
@@ -576,6 +577,149 @@ static void virtio_mem_deactivate_unplugged_memslots(VirtIOMEM *vmem,
     memory_region_transaction_commit();
 }
 
+/*
+ * Background preparation of blocks the guest is expected to plug next:
+ * populate (and thereby zero) host pages up to requested-size plus
+ * prealloc-ahead, so that plug requests and the guest's first touch
+ * don't pay the fault-and-zero cost on the guest's critical path.
+ * Populated-but-unplugged blocks consume host memory until they are
+ * either plugged or fall outside the goal after a requested-size
+ * shrink; that is the trade-off the knob opts into.
+ */
+#define VIRTIO_MEM_PREPARE_CHUNK_SIZE (128 * MiB)
+
+static void *virtio_mem_prepare_thread_fn(void *opaque)
+{
+    VirtIOMEM *vmem = opaque;
+    void *area = memory_region_get_ram_ptr(&vmem->memdev->mr);
+    int fd = memory_region_get_fd(&vmem->memdev->mr);
+
+    qemu_mutex_lock(&vmem->prepare_lock);
+    while (!vmem->prepare_exit) {
+        uint64_t start, chunk;
+        Error *local_err = NULL;
+
+        if (vmem->prepare_offset >= vmem->prepare_goal) {
+            qemu_cond_wait(&vmem->prepare_cond, &vmem->prepare_lock);
+            continue;
+        }
+
+        /*
+         * Never touch plugged blocks: they are populated by definition
+         * and the guest may be writing to them concurrently.  The
+         * bitmap is read without the BQL, so we can lose a race
+         * against a concurrent (un)plug; that is harmless only
+         * because preparation uses MADV_POPULATE_WRITE (enforced at
+         * realize time), which populates pages without modifying
+         * their contents.
+         */
+        start = vmem->prepare_offset;
+        while (start < vmem->prepare_goal &&
+               virtio_mem_is_range_plugged(vmem, vmem->addr + start,
+                                           vmem->block_size)) {
+            start += vmem->block_size;
+        }
+        vmem->prepare_offset = start;
+        if (start >= vmem->prepare_goal) {
+            continue;
+        }
+        chunk = vmem->block_size;
+        while (chunk < MIN(vmem->prepare_goal - start,
+                           MAX(vmem->block_size,
+                               VIRTIO_MEM_PREPARE_CHUNK_SIZE)) &&
+               !virtio_mem_is_range_plugged(vmem, vmem->addr + start + chunk,
+                                            vmem->block_size)) {
+            chunk += vmem->block_size;
+        }
+        qemu_mutex_unlock(&vmem->prepare_lock);
+
+        if (!qemu_prealloc_mem(fd, area + start, chunk, 1, NULL, false,
+                               &local_err)) {
+            static bool warned;
+
+            if (!warned) {
+                warn_report_err(local_err);
+                warned = true;
+            } else {
+                error_free(local_err);
+            }
+            qemu_mutex_lock(&vmem->prepare_lock);
+            /* Stop trying until the next kick. */
+            vmem->prepare_goal = MIN(vmem->prepare_goal, start);
+            continue;
+        }
+
+        qemu_mutex_lock(&vmem->prepare_lock);
+        /* An unplug may have discarded part of the chunk again. */
+        if (vmem->prepare_offset >= start) {
+            vmem->prepare_offset = start + chunk;
+        }
+    }
+    qemu_mutex_unlock(&vmem->prepare_lock);
+    return NULL;
+}
+
+/* Recompute the goal after requested-size changed and wake the worker. */
+static void virtio_mem_prepare_kick(VirtIOMEM *vmem)
+{
+    const uint64_t region_size = memory_region_size(&vmem->memdev->mr);
+
+    if (!vmem->prepare_running) {
+        return;
+    }
+
+    qemu_mutex_lock(&vmem->prepare_lock);
+    vmem->prepare_goal = MIN(region_size,
+                             vmem->requested_size + vmem->prealloc_ahead);
+    qemu_cond_signal(&vmem->prepare_cond);
+    qemu_mutex_unlock(&vmem->prepare_lock);
+}
+
+/* After discarding [offset, offset + size), re-prepare from offset. */
+static void virtio_mem_prepare_discarded(VirtIOMEM *vmem, uint64_t offset)
+{
+    if (!vmem->prepare_running) {
+        return;
+    }
+
+    qemu_mutex_lock(&vmem->prepare_lock);
+    if (offset < vmem->prepare_offset) {
+        vmem->prepare_offset = offset;
+        qemu_cond_signal(&vmem->prepare_cond);
+    }
+    qemu_mutex_unlock(&vmem->prepare_lock);
+}
+
+static void virtio_mem_prepare_start(VirtIOMEM *vmem)
+{
+    qemu_mutex_init(&vmem->prepare_lock);
+    qemu_cond_init(&vmem->prepare_cond);
+    vmem->prepare_offset = 0;
+    vmem->prepare_goal = 0;
+    vmem->prepare_exit = false;
+    vmem->prepare_running = true;
+    qemu_thread_create(&vmem->prepare_thread, "virtio-mem-prep",
+                       virtio_mem_prepare_thread_fn, vmem,
+                       QEMU_THREAD_JOINABLE);
+    virtio_mem_prepare_kick(vmem);
+}
+
+static void virtio_mem_prepare_stop(VirtIOMEM *vmem)
+{
+    if (!vmem->prepare_running) {
+        return;
+    }
+
+    qemu_mutex_lock(&vmem->prepare_lock);
+    vmem->prepare_exit = true;
+    qemu_cond_signal(&vmem->prepare_cond);
+    qemu_mutex_unlock(&vmem->prepare_lock);
+    qemu_thread_join(&vmem->prepare_thread);
+    qemu_cond_destroy(&vmem->prepare_cond);
+    qemu_mutex_destroy(&vmem->prepare_lock);
+    vmem->prepare_running = false;
+}
+
 static int virtio_mem_set_block_state(VirtIOMEM *vmem, uint64_t start_gpa,
                                       uint64_t size, bool plug)
 {
@@ -591,6 +735,7 @@ static int virtio_mem_set_block_state(VirtIOMEM *vmem, uint64_t start_gpa,
         if (ram_block_discard_range(rb, offset, size)) {
             return -EBUSY;
         }
+        virtio_mem_prepare_discarded(vmem, offset);
         virtio_mem_notify_unplug(vmem, offset, size);
         virtio_mem_set_range_unplugged(vmem, start_gpa, size);
         /* Deactivate completely unplugged memslots after updating the state. */
@@ -741,6 +886,7 @@ static int virtio_mem_unplug_all(VirtIOMEM *vmem)
         if (ram_block_discard_range(rb, 0, qemu_ram_get_used_length(rb))) {
             return -EBUSY;
         }
+        virtio_mem_prepare_discarded(vmem, 0);
         virtio_mem_notify_unplug_all(vmem);
 
         bitmap_clear(vmem->bitmap, 0, vmem->bitmap_size);
@@ -1052,6 +1198,11 @@ static void virtio_mem_device_realize(DeviceState *dev, Error **errp)
                    ")", VIRTIO_MEM_REQUESTED_SIZE_PROP,
                    VIRTIO_MEM_BLOCK_SIZE_PROP, vmem->block_size);
         return;
+    } else if (!QEMU_IS_ALIGNED(vmem->prealloc_ahead, vmem->block_size)) {
+        error_setg(errp, "'%s' property has to be multiples of '%s' (0x%" PRIx64
+                   ")", VIRTIO_MEM_PREALLOC_AHEAD_PROP,
+                   VIRTIO_MEM_BLOCK_SIZE_PROP, vmem->block_size);
+        return;
     } else if (!QEMU_IS_ALIGNED(vmem->addr, vmem->block_size)) {
         error_setg(errp, "'%s' property has to be multiples of '%s' (0x%" PRIx64
                    ")", VIRTIO_MEM_ADDR_PROP, VIRTIO_MEM_BLOCK_SIZE_PROP,
@@ -1065,6 +1216,20 @@ static void virtio_mem_device_realize(DeviceState *dev, Error **errp)
         return;
     }
 
+    if (vmem->prealloc_ahead &&
+        qemu_madvise(memory_region_get_ram_ptr(&vmem->memdev->mr), page_size,
+                     QEMU_MADV_POPULATE_WRITE)) {
+        /*
+         * The preparation thread may race with guest (un)plug, which is
+         * only safe with MADV_POPULATE_WRITE: it populates pages
+         * without modifying their contents.  Refuse to fall back to
+         * writing to each page.
+         */
+        error_setg(errp, "'%s' requires MADV_POPULATE_WRITE support",
+                   VIRTIO_MEM_PREALLOC_AHEAD_PROP);
+        return;
+    }
+
     if (ram_block_coordinated_discard_require(true)) {
         error_setg(errp, "Discarding RAM is disabled");
         return;
@@ -1131,6 +1296,10 @@ static void virtio_mem_device_realize(DeviceState *dev, Error **errp)
      */
     memory_region_set_ram_discard_manager(&vmem->memdev->mr,
                                           RAM_DISCARD_MANAGER(vmem));
+
+    if (vmem->prealloc_ahead) {
+        virtio_mem_prepare_start(vmem);
+    }
 }
 
 static void virtio_mem_device_unrealize(DeviceState *dev)
@@ -1138,6 +1307,8 @@ static void virtio_mem_device_unrealize(DeviceState *dev)
     VirtIODevice *vdev = VIRTIO_DEVICE(dev);
     VirtIOMEM *vmem = VIRTIO_MEM(dev);
 
+    virtio_mem_prepare_stop(vmem);
+
     /*
      * The unplug handler unmapped the memory region, it cannot be
      * found via an address space anymore. Unset ourselves.
@@ -1592,6 +1763,7 @@ static void virtio_mem_set_requested_size(Object *obj, Visitor *v,
         if (value != vmem->requested_size) {
             virtio_mem_resize_usable_region(vmem, value, false);
             vmem->requested_size = value;
+            virtio_mem_prepare_kick(vmem);
         }
         /*
          * Trigger a config update so the guest gets notified. We trigger
@@ -1686,6 +1858,8 @@ static Property virtio_mem_properties[] = {
     DEFINE_PROP_UINT64(VIRTIO_MEM_ADDR_PROP, VirtIOMEM, addr, 0),
     DEFINE_PROP_UINT32(VIRTIO_MEM_NODE_PROP, VirtIOMEM, node, 0),
     DEFINE_PROP_BOOL(VIRTIO_MEM_PREALLOC_PROP, VirtIOMEM, prealloc, false),
+    DEFINE_PROP_SIZE(VIRTIO_MEM_PREALLOC_AHEAD_PROP, VirtIOMEM,
+                     prealloc_ahead, 0),
     DEFINE_PROP_LINK(VIRTIO_MEM_MEMDEV_PROP, VirtIOMEM, memdev,
                      TYPE_MEMORY_BACKEND, HostMemoryBackend *),
 #if defined(VIRTIO_MEM_HAS_LEGACY_GUESTS)
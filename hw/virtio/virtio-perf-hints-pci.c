@@ -0,0 +1,74 @@
+/*
+ * Virtio performance hints PCI Bindings
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2.
+ * See the COPYING file in the top-level directory.
+ */
+
+#include "qemu/osdep.h"
+
+#include "hw/virtio/virtio-pci.h"
+#include "hw/virtio/virtio-perf-hints.h"
+#include "hw/qdev-properties.h"
+#include "qapi/error.h"
+#include "qemu/module.h"
+#include "qom/object.h"
+
+typedef struct VirtIOPerfHintsPCI VirtIOPerfHintsPCI;
+
+/*
+ * virtio-perf-hints-pci: This extends VirtioPCIProxy.
+ */
+#define TYPE_VIRTIO_PERF_HINTS_PCI "virtio-perf-hints-pci-base"
+DECLARE_INSTANCE_CHECKER(VirtIOPerfHintsPCI, VIRTIO_PERF_HINTS_PCI,
+                         TYPE_VIRTIO_PERF_HINTS_PCI)
+
+struct VirtIOPerfHintsPCI {
+    VirtIOPCIProxy parent_obj;
+    VirtIOPerfHints vdev;
+};
+
+static void virtio_perf_hints_pci_realize(VirtIOPCIProxy *vpci_dev,
+                                          Error **errp)
+{
+    VirtIOPerfHintsPCI *hints = VIRTIO_PERF_HINTS_PCI(vpci_dev);
+    DeviceState *vdev = DEVICE(&hints->vdev);
+
+    virtio_pci_force_virtio_1(vpci_dev);
+    qdev_realize(vdev, BUS(&vpci_dev->bus), errp);
+}
+
+static void virtio_perf_hints_pci_class_init(ObjectClass *klass, void *data)
+{
+    DeviceClass *dc = DEVICE_CLASS(klass);
+    VirtioPCIClass *k = VIRTIO_PCI_CLASS(klass);
+    PCIDeviceClass *pcidev_k = PCI_DEVICE_CLASS(klass);
+
+    k->realize = virtio_perf_hints_pci_realize;
+    set_bit(DEVICE_CATEGORY_MISC, dc->categories);
+    pcidev_k->revision = VIRTIO_PCI_ABI_VERSION;
+    pcidev_k->class_id = PCI_CLASS_OTHERS;
+}
+
+static void virtio_perf_hints_pci_initfn(Object *obj)
+{
+    VirtIOPerfHintsPCI *dev = VIRTIO_PERF_HINTS_PCI(obj);
+
+    virtio_instance_init_common(obj, &dev->vdev, sizeof(dev->vdev),
+                                TYPE_VIRTIO_PERF_HINTS);
+}
+
+static const VirtioPCIDeviceTypeInfo virtio_perf_hints_pci_info = {
+    .base_name     = TYPE_VIRTIO_PERF_HINTS_PCI,
+    .generic_name  = "virtio-perf-hints-pci",
+    .instance_size = sizeof(VirtIOPerfHintsPCI),
+    .instance_init = virtio_perf_hints_pci_initfn,
+    .class_init    = virtio_perf_hints_pci_class_init,
+};
+
+static void virtio_perf_hints_pci_register(void)
+{
+    virtio_pci_types_register(&virtio_perf_hints_pci_info);
+}
+
+type_init(virtio_perf_hints_pci_register)
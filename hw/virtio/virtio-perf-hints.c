@@ -0,0 +1,232 @@
+/*
+ * Virtio performance hints device
+ *
+ * The guest posts a request on the hint queue when it enters or
+ * leaves a latency-critical phase.  While at least one section is
+ * open the policy engine raises iothread adaptive polling to
+ * poll-boost-ns with growth/shrink disabled and, unless pause-jobs is
+ * off, pauses the background jobs that were running when the section
+ * opened.  Closing the last section restores every iothread's
+ * configured poll parameters and resumes exactly the jobs that were
+ * paused.  Static tuning has to pick one point on the CPU/latency
+ * curve; this lets the guest move along it at phase granularity.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2.
+ * See the COPYING file in the top-level directory.
+ */
+
+#include "qemu/osdep.h"
+#include "qapi/error.h"
+#include "qemu/iov.h"
+#include "qemu/job.h"
+#include "qemu/main-loop.h"
+#include "hw/qdev-properties.h"
+#include "hw/virtio/virtio-perf-hints.h"
+#include "sysemu/iothread.h"
+#include "trace.h"
+
+static int virtio_perf_hints_boost_one(Object *obj, void *opaque)
+{
+    VirtIOPerfHints *hints = opaque;
+    IOThread *iothread = (IOThread *)object_dynamic_cast(obj, TYPE_IOTHREAD);
+
+    if (iothread) {
+        aio_context_set_poll_params(iothread_get_aio_context(iothread),
+                                    hints->poll_boost_ns, 0, 0, &error_abort);
+    }
+    return 0;
+}
+
+static int virtio_perf_hints_restore_one(Object *obj, void *opaque)
+{
+    IOThread *iothread = (IOThread *)object_dynamic_cast(obj, TYPE_IOTHREAD);
+
+    if (iothread) {
+        aio_context_set_poll_params(iothread_get_aio_context(iothread),
+                                    iothread->poll_max_ns,
+                                    iothread->poll_grow,
+                                    iothread->poll_shrink,
+                                    &error_abort);
+    }
+    return 0;
+}
+
+static void virtio_perf_hints_pause_jobs(VirtIOPerfHints *hints)
+{
+    Job *job;
+
+    WITH_JOB_LOCK_GUARD() {
+        for (job = job_next_locked(NULL); job; job = job_next_locked(job)) {
+            job_ref_locked(job);
+            job_pause_locked(job);
+            g_ptr_array_add(hints->paused_jobs, job);
+        }
+    }
+}
+
+/*
+ * Only the jobs recorded at pause time are resumed; jobs created
+ * while the section was open were never paused and keep running.
+ */
+static void virtio_perf_hints_resume_jobs(VirtIOPerfHints *hints)
+{
+    unsigned i;
+
+    WITH_JOB_LOCK_GUARD() {
+        for (i = 0; i < hints->paused_jobs->len; i++) {
+            Job *job = g_ptr_array_index(hints->paused_jobs, i);
+
+            job_resume_locked(job);
+            job_unref_locked(job);
+        }
+    }
+    g_ptr_array_set_size(hints->paused_jobs, 0);
+}
+
+static void virtio_perf_hints_apply(VirtIOPerfHints *hints, bool critical)
+{
+    Object *container = object_get_objects_root();
+
+    trace_virtio_perf_hints_apply(critical);
+    if (critical) {
+        object_child_foreach(container, virtio_perf_hints_boost_one, hints);
+        if (hints->pause_jobs) {
+            virtio_perf_hints_pause_jobs(hints);
+        }
+    } else {
+        object_child_foreach(container, virtio_perf_hints_restore_one, NULL);
+        virtio_perf_hints_resume_jobs(hints);
+    }
+}
+
+static uint32_t virtio_perf_hints_request(VirtIOPerfHints *hints,
+                                          uint32_t type)
+{
+    switch (type) {
+    case VIRTIO_PERF_HINTS_LATENCY_ENTER:
+        if (hints->critical_depth++ == 0) {
+            virtio_perf_hints_apply(hints, true);
+        }
+        return 0;
+    case VIRTIO_PERF_HINTS_LATENCY_EXIT:
+        if (hints->critical_depth == 0) {
+            return 1;
+        }
+        if (--hints->critical_depth == 0) {
+            virtio_perf_hints_apply(hints, false);
+        }
+        return 0;
+    default:
+        return 1;
+    }
+}
+
+static void virtio_perf_hints_handle(VirtIODevice *vdev, VirtQueue *vq)
+{
+    VirtIOPerfHints *hints = VIRTIO_PERF_HINTS(vdev);
+    VirtQueueElement *elem;
+    struct virtio_perf_hints_req req;
+    struct virtio_perf_hints_resp resp;
+
+    while ((elem = virtqueue_pop(vq, sizeof(VirtQueueElement)))) {
+        size_t len = iov_to_buf(elem->out_sg, elem->out_num, 0,
+                                &req, sizeof(req));
+
+        if (len != sizeof(req) || elem->in_num < 1) {
+            virtio_error(vdev, "virtio-perf-hints request not proper");
+            virtqueue_detach_element(vq, elem, 0);
+            g_free(elem);
+            return;
+        }
+
+        /* Device is modern-only, so the wire format is little endian */
+        resp.ret =
+            cpu_to_le32(virtio_perf_hints_request(hints,
+                                                  le32_to_cpu(req.type)));
+        len = iov_from_buf(elem->in_sg, elem->in_num, 0,
+                           &resp, sizeof(resp));
+        virtqueue_push(vq, elem, len);
+        g_free(elem);
+    }
+    virtio_notify(vdev, vq);
+}
+
+static uint64_t virtio_perf_hints_get_features(VirtIODevice *vdev,
+                                               uint64_t features,
+                                               Error **errp)
+{
+    return features;
+}
+
+static void virtio_perf_hints_reset(VirtIODevice *vdev)
+{
+    VirtIOPerfHints *hints = VIRTIO_PERF_HINTS(vdev);
+
+    /* Drop whatever the guest left open, restoring the static tuning */
+    if (hints->critical_depth > 0) {
+        hints->critical_depth = 0;
+        virtio_perf_hints_apply(hints, false);
+    }
+}
+
+static void virtio_perf_hints_realize(DeviceState *dev, Error **errp)
+{
+    VirtIODevice *vdev = VIRTIO_DEVICE(dev);
+    VirtIOPerfHints *hints = VIRTIO_PERF_HINTS(dev);
+
+    virtio_init(vdev, VIRTIO_ID_PERF_HINTS, 0);
+    hints->hint_vq = virtio_add_queue(vdev, 64, virtio_perf_hints_handle);
+    hints->paused_jobs = g_ptr_array_new();
+}
+
+static void virtio_perf_hints_unrealize(DeviceState *dev)
+{
+    VirtIODevice *vdev = VIRTIO_DEVICE(dev);
+    VirtIOPerfHints *hints = VIRTIO_PERF_HINTS(dev);
+
+    virtio_perf_hints_reset(vdev);
+    g_ptr_array_free(hints->paused_jobs, true);
+    virtio_delete_queue(hints->hint_vq);
+    virtio_cleanup(vdev);
+}
+
+static const VMStateDescription vmstate_virtio_perf_hints = {
+    .name = "virtio-perf-hints",
+    .unmigratable = 1,
+};
+
+static Property virtio_perf_hints_properties[] = {
+    DEFINE_PROP_UINT64("poll-boost-ns", VirtIOPerfHints, poll_boost_ns,
+                       64 * 1000),
+    DEFINE_PROP_BOOL("pause-jobs", VirtIOPerfHints, pause_jobs, true),
+    DEFINE_PROP_END_OF_LIST(),
+};
+
+static void virtio_perf_hints_class_init(ObjectClass *klass, void *data)
+{
+    DeviceClass *dc = DEVICE_CLASS(klass);
+    VirtioDeviceClass *vdc = VIRTIO_DEVICE_CLASS(klass);
+
+    device_class_set_props(dc, virtio_perf_hints_properties);
+    dc->vmsd = &vmstate_virtio_perf_hints;
+    set_bit(DEVICE_CATEGORY_MISC, dc->categories);
+
+    vdc->realize = virtio_perf_hints_realize;
+    vdc->unrealize = virtio_perf_hints_unrealize;
+    vdc->get_features = virtio_perf_hints_get_features;
+    vdc->reset = virtio_perf_hints_reset;
+}
+
+static const TypeInfo virtio_perf_hints_info = {
+    .name          = TYPE_VIRTIO_PERF_HINTS,
+    .parent        = TYPE_VIRTIO_DEVICE,
+    .class_init    = virtio_perf_hints_class_init,
+    .instance_size = sizeof(VirtIOPerfHints),
+};
+
+static void virtio_register_types(void)
+{
+    type_register_static(&virtio_perf_hints_info);
+}
+
+type_init(virtio_register_types)
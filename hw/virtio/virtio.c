@@ -31,6 +31,7 @@
 #include "hw/virtio/virtio-access.h"
 #include "sysemu/dma.h"
 #include "sysemu/runstate.h"
+#include "sysemu/stats.h"
 #include "virtio-qmp.h"
 
 #include "standard-headers/linux/virtio_ids.h"
@@ -141,6 +142,21 @@ struct VirtQueue
     /* Notification enabled? */
     bool notification;
 
+    /* Guest kicks delivered through the host notifier or device MMIO */
+    uint64_t notifications;
+
+    /* Used buffer notifications (interrupts) delivered to the guest */
+    uint64_t guest_notifications;
+
+    /* Work found by AioContext polling, without a guest kick */
+    uint64_t polled;
+
+    /* Value of @polled when the current polling section started */
+    uint64_t polled_at_poll_begin;
+
+    /* Consecutive polling sections that found no work */
+    unsigned int poll_misses;
+
     uint16_t queue_index;
 
     unsigned int inuse;
@@ -1503,7 +1519,8 @@ static void *virtqueue_alloc_element(size_t sz, unsigned out_num, unsigned in_nu
     return elem;
 }
 
-static void *virtqueue_split_pop(VirtQueue *vq, size_t sz)
+static void *virtqueue_split_pop(VirtQueue *vq, size_t sz,
+                                 bool update_avail_event)
 {
     unsigned int i, head, max;
     VRingMemoryRegionCaches *caches;
@@ -1542,7 +1559,8 @@ static void *virtqueue_split_pop(VirtQueue *vq, size_t sz)
         goto done;
     }
 
-    if (virtio_vdev_has_feature(vdev, VIRTIO_RING_F_EVENT_IDX)) {
+    if (update_avail_event &&
+        virtio_vdev_has_feature(vdev, VIRTIO_RING_F_EVENT_IDX)) {
         vring_set_avail_event(vq, vq->last_avail_idx);
     }
 
@@ -1788,8 +1806,53 @@ void *virtqueue_pop(VirtQueue *vq, size_t sz)
     if (virtio_vdev_has_feature(vq->vdev, VIRTIO_F_RING_PACKED)) {
         return virtqueue_packed_pop(vq, sz);
     } else {
-        return virtqueue_split_pop(vq, sz);
+        return virtqueue_split_pop(vq, sz, true);
+    }
+}
+
+unsigned int virtqueue_pop_batch(VirtQueue *vq, size_t sz,
+                                 VirtQueueElement **elems, unsigned int n)
+{
+    VirtIODevice *vdev = vq->vdev;
+    unsigned int count = 0;
+
+    if (virtio_device_disabled(vdev)) {
+        return 0;
+    }
+
+    RCU_READ_LOCK_GUARD();
+
+    if (virtio_vdev_has_feature(vdev, VIRTIO_F_RING_PACKED)) {
+        while (count < n) {
+            VirtQueueElement *elem = virtqueue_packed_pop(vq, sz);
+
+            if (!elem) {
+                break;
+            }
+            elems[count++] = elem;
+        }
+        return count;
+    }
+
+    while (count < n) {
+        VirtQueueElement *elem = virtqueue_split_pop(vq, sz, false);
+
+        if (!elem) {
+            break;
+        }
+        elems[count++] = elem;
     }
+
+    /*
+     * The avail event only needs to say where the harvest stopped, so
+     * publish it once for the whole batch instead of once per element.
+     * A stale value in the meantime only means an extra guest kick.
+     */
+    if (count && virtio_vdev_has_feature(vdev, VIRTIO_RING_F_EVENT_IDX)) {
+        vring_set_avail_event(vq, vq->last_avail_idx);
+    }
+
+    return count;
 }
 
 static unsigned int virtqueue_packed_drop_all(VirtQueue *vq)
@@ -2093,6 +2156,10 @@ static void __virtio_queue_reset(VirtIODevice *vdev, uint32_t i)
     vdev->vq[i].signalled_used = 0;
     vdev->vq[i].signalled_used_valid = false;
     vdev->vq[i].notification = true;
+    vdev->vq[i].notifications = 0;
+    vdev->vq[i].polled = 0;
+    vdev->vq[i].polled_at_poll_begin = 0;
+    vdev->vq[i].poll_misses = 0;
     vdev->vq[i].vring.num = vdev->vq[i].vring.num_default;
     vdev->vq[i].inuse = 0;
     virtio_virtqueue_reset_region_cache(&vdev->vq[i]);
@@ -2293,6 +2360,7 @@ void virtio_queue_notify(VirtIODevice *vdev, int n)
     if (vq->host_notifier_enabled) {
         event_notifier_set(&vq->host_notifier);
     } else if (vq->handle_output) {
+        vq->notifications++;
         vq->handle_output(vdev, vq);
 
         if (unlikely(vdev->start_on_kick)) {
@@ -2473,6 +2541,7 @@ void virtio_notify_irqfd(VirtIODevice *vdev, VirtQueue *vq)
     }
 
     trace_virtio_notify_irqfd(vdev, vq);
+    vq->guest_notifications++;
 
     /*
      * virtio spec 1.0 says ISR bit 0 should be ignored with MSI, but
@@ -2508,6 +2577,7 @@ void virtio_notify(VirtIODevice *vdev, VirtQueue *vq)
     }
 
     trace_virtio_notify(vdev, vq);
+    vq->guest_notifications++;
     virtio_irq(vq);
 }
 
@@ -3532,11 +3602,25 @@ EventNotifier *virtio_queue_get_guest_notifier(VirtQueue *vq)
     return &vq->guest_notifier;
 }
 
+/* Polling sections without work before suppression is given up */
+#define VIRTIO_QUEUE_POLL_MISS_LIMIT 8
+
 static void virtio_queue_host_notifier_aio_poll_begin(EventNotifier *n)
 {
     VirtQueue *vq = container_of(n, VirtQueue, host_notifier);
 
-    virtio_queue_set_notification(vq, 0);
+    vq->polled_at_poll_begin = vq->polled;
+
+    /*
+     * Only suppress guest notifications while polling keeps finding
+     * work.  A queue that has gone quiet gets its work through the
+     * host notifier anyway, and leaving notifications enabled spares
+     * the suppression flag flipping in guest memory on every section.
+     * The first successful poll re-arms suppression below.
+     */
+    if (vq->poll_misses < VIRTIO_QUEUE_POLL_MISS_LIMIT) {
+        virtio_queue_set_notification(vq, 0);
+    }
 }
 
 static bool virtio_queue_host_notifier_aio_poll(void *opaque)
@@ -3551,6 +3635,7 @@ static void virtio_queue_host_notifier_aio_poll_ready(EventNotifier *n)
 {
     VirtQueue *vq = container_of(n, VirtQueue, host_notifier);
 
+    vq->polled++;
     virtio_queue_notify_vq(vq);
 }
 
@@ -3558,6 +3643,12 @@ static void virtio_queue_host_notifier_aio_poll_end(EventNotifier *n)
 {
     VirtQueue *vq = container_of(n, VirtQueue, host_notifier);
 
+    if (vq->polled != vq->polled_at_poll_begin) {
+        vq->poll_misses = 0;
+    } else if (vq->poll_misses < VIRTIO_QUEUE_POLL_MISS_LIMIT) {
+        vq->poll_misses++;
+    }
+
     /* Caller polls once more after this to catch requests that race with us */
     virtio_queue_set_notification(vq, 1);
 }
@@ -3637,6 +3728,7 @@ void virtio_queue_host_notifier_read(EventNotifier *n)
 {
     VirtQueue *vq = container_of(n, VirtQueue, host_notifier);
     if (event_notifier_test_and_clear(n)) {
+        vq->notifications++;
         virtio_queue_notify_vq(vq);
     }
 }
@@ -3904,6 +3996,151 @@ void virtio_device_release_ioeventfd(VirtIODevice *vdev)
     virtio_bus_release_ioeventfd(vbus);
 }
 
+typedef struct VirtioStatsArgs {
+    StatsResultList **result;
+    strList *names;
+    strList *targets;
+} VirtioStatsArgs;
+
+static StatsList *virtio_stats_add(StatsList *stats_list, strList *names,
+                                   const char *name, uint64_t val)
+{
+    Stats *stats;
+
+    if (!apply_str_list_filter(name, names)) {
+        return stats_list;
+    }
+
+    stats = g_new0(Stats, 1);
+    stats->name = g_strdup(name);
+    stats->value = g_new0(StatsValue, 1);
+    stats->value->type = QTYPE_QNUM;
+    stats->value->u.scalar = val;
+
+    QAPI_LIST_PREPEND(stats_list, stats);
+    return stats_list;
+}
+
+static int virtio_device_stats_query(Object *obj, void *opaque)
+{
+    VirtioStatsArgs *args = opaque;
+    Object *dev = object_dynamic_cast(obj, TYPE_VIRTIO_DEVICE);
+    VirtIODevice *vdev;
+    StatsList *stats_list = NULL;
+    g_autofree char *path = NULL;
+    int i;
+
+    if (!dev || !DEVICE(dev)->realized) {
+        return 0;
+    }
+
+    vdev = VIRTIO_DEVICE(dev);
+    path = object_get_canonical_path(dev);
+    if (!apply_str_list_filter(path, args->targets)) {
+        return 0;
+    }
+
+    for (i = 0; i < VIRTIO_QUEUE_MAX; i++) {
+        VirtQueue *vq = &vdev->vq[i];
+        g_autofree char *kicks_name = NULL;
+        g_autofree char *interrupts_name = NULL;
+        g_autofree char *polled_name = NULL;
+        g_autofree char *inuse_name = NULL;
+
+        if (!virtio_queue_get_num(vdev, i)) {
+            continue;
+        }
+
+        kicks_name = g_strdup_printf("vq%d-kicks", i);
+        interrupts_name = g_strdup_printf("vq%d-interrupts", i);
+        polled_name = g_strdup_printf("vq%d-polled", i);
+        inuse_name = g_strdup_printf("vq%d-inuse", i);
+
+        stats_list = virtio_stats_add(stats_list, args->names, kicks_name,
+                                      vq->notifications);
+        stats_list = virtio_stats_add(stats_list, args->names, interrupts_name,
+                                      vq->guest_notifications);
+        stats_list = virtio_stats_add(stats_list, args->names, polled_name,
+                                      vq->polled);
+        stats_list = virtio_stats_add(stats_list, args->names, inuse_name,
+                                      vq->inuse);
+    }
+
+    add_stats_entry(args->result, STATS_PROVIDER_VIRTIO, path, stats_list);
+    return 0;
+}
+
+static void virtio_stats_cb(StatsResultList **result, StatsTarget target,
+                            strList *names, strList *targets, Error **errp)
+{
+    VirtioStatsArgs args;
+
+    if (target != STATS_TARGET_VIRTIO) {
+        return;
+    }
+
+    args.result = result;
+    args.names = names;
+    args.targets = targets;
+    object_child_foreach_recursive(object_get_root(),
+                                   virtio_device_stats_query, &args);
+}
+
+static StatsSchemaValueList *virtio_schemas_add(StatsSchemaValueList *list,
+                                                const char *name,
+                                                StatsType type)
+{
+    StatsSchemaValueList *schema_entry = g_new0(StatsSchemaValueList, 1);
+
+    schema_entry->value = g_new0(StatsSchemaValue, 1);
+    schema_entry->value->type = type;
+    schema_entry->value->name = g_strdup(name);
+    schema_entry->next = list;
+
+    return schema_entry;
+}
+
+static int virtio_device_max_queues(Object *obj, void *opaque)
+{
+    int *max_queues = opaque;
+    Object *dev = object_dynamic_cast(obj, TYPE_VIRTIO_DEVICE);
+
+    if (dev && DEVICE(dev)->realized) {
+        *max_queues = MAX(*max_queues,
+                          virtio_get_num_queues(VIRTIO_DEVICE(dev)));
+    }
+    return 0;
+}
+
+static void virtio_schemas_cb(StatsSchemaList **result, Error **errp)
+{
+    StatsSchemaValueList *stats_list = NULL;
+    int i, max_queues = 0;
+
+    /* the set of statistic names depends on the widest device */
+    object_child_foreach_recursive(object_get_root(),
+                                   virtio_device_max_queues, &max_queues);
+
+    for (i = 0; i < max_queues; i++) {
+        g_autofree char *kicks_name = g_strdup_printf("vq%d-kicks", i);
+        g_autofree char *interrupts_name = g_strdup_printf("vq%d-interrupts", i);
+        g_autofree char *polled_name = g_strdup_printf("vq%d-polled", i);
+        g_autofree char *inuse_name = g_strdup_printf("vq%d-inuse", i);
+
+        stats_list = virtio_schemas_add(stats_list, kicks_name,
+                                        STATS_TYPE_CUMULATIVE);
+        stats_list = virtio_schemas_add(stats_list, interrupts_name,
+                                        STATS_TYPE_CUMULATIVE);
+        stats_list = virtio_schemas_add(stats_list, polled_name,
+                                        STATS_TYPE_CUMULATIVE);
+        stats_list = virtio_schemas_add(stats_list, inuse_name,
+                                        STATS_TYPE_INSTANT);
+    }
+
+    add_stats_schema(result, STATS_PROVIDER_VIRTIO, STATS_TARGET_VIRTIO,
+                     stats_list);
+}
+
 static void virtio_device_class_init(ObjectClass *klass, void *data)
 {
     /* Set the default value here. */
@@ -3918,6 +4155,10 @@ static void virtio_device_class_init(ObjectClass *klass, void *data)
     vdc->stop_ioeventfd = virtio_device_stop_ioeventfd_impl;
 
     vdc->legacy_features |= VIRTIO_LEGACY_FEATURES;
+
+    /* The base class is initialized once, register the provider here.  */
+    add_stats_callbacks(STATS_PROVIDER_VIRTIO, virtio_stats_cb,
+                        virtio_schemas_cb);
 }
 
 bool virtio_device_ioeventfd_enabled(VirtIODevice *vdev)
@@ -3982,6 +4223,10 @@ VirtQueueStatus *qmp_x_query_virtio_queue_status(const char *path,
         status->has_last_avail_idx = true;
         status->last_avail_idx = vdev->vq[queue].last_avail_idx;
         status->shadow_avail_idx = vdev->vq[queue].shadow_avail_idx;
+        status->has_notifications = true;
+        status->notifications = vdev->vq[queue].notifications;
+        status->has_polled = true;
+        status->polled = vdev->vq[queue].polled;
     }
 
     return status;
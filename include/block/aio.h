@@ -108,7 +108,20 @@ typedef struct {
 } FDMonOps;
 
 /*
- * Each aio_bh_poll() call carves off a slice of the BH list, so that newly
+ * Bottom half priority classes.  Within each aio_bh_poll() call the classes
+ * are dispatched in priority order, and the background class is additionally
+ * subject to a per-call dispatch budget so that bulk work cannot delay
+ * latency-critical callbacks by more than one event loop iteration.
+ */
+typedef enum {
+    QEMU_BH_PRIORITY_CRITICAL,   /* latency-critical, e.g. guest notifies */
+    QEMU_BH_PRIORITY_NORMAL,     /* the default for all bottom halves */
+    QEMU_BH_PRIORITY_BACKGROUND, /* bulk work, budgeted per aio_bh_poll() */
+    QEMU_BH_PRIORITY__MAX,
+} QEMUBHPriority;
+
+/*
+ * Each aio_bh_poll() call carves off a slice of the BH lists, so that newly
  * scheduled BHs are not processed until the next aio_bh_poll() call.  All
  * active aio_bh_poll() calls chain their slices together in a list, so that
  * nested aio_bh_poll() calls process all scheduled bottom halves.
@@ -116,7 +129,7 @@ typedef struct {
 typedef QSLIST_HEAD(, QEMUBH) BHList;
 typedef struct BHListSlice BHListSlice;
 struct BHListSlice {
-    BHList bh_list;
+    BHList bh_list[QEMU_BH_PRIORITY__MAX];
     QSIMPLEQ_ENTRY(BHListSlice) next;
 };
 
@@ -177,8 +190,8 @@ struct AioContext {
      */
     QemuLockCnt list_lock;
 
-    /* Bottom Halves pending aio_bh_poll() processing */
-    BHList bh_list;
+    /* Bottom Halves pending aio_bh_poll() processing, per priority class */
+    BHList bh_list[QEMU_BH_PRIORITY__MAX];
 
     /* Chained BH list slices for each nested aio_bh_poll() call */
     QSIMPLEQ_HEAD(, BHListSlice) bh_slice_list;
@@ -227,8 +240,7 @@ struct AioContext {
     /* Number of AioHandlers without .io_poll() */
     int poll_disable_cnt;
 
-    /* Polling mode parameters */
-    int64_t poll_ns;        /* current polling time in nanoseconds */
+    /* Polling mode parameters; the current polling time is per-AioHandler */
     int64_t poll_max_ns;    /* maximum polling time in nanoseconds */
     int64_t poll_grow;      /* polling time growth factor */
     int64_t poll_shrink;    /* polling time shrink factor */
@@ -391,6 +403,18 @@ int aio_bh_poll(AioContext *ctx);
  */
 void qemu_bh_schedule(QEMUBH *bh);
 
+/**
+ * qemu_bh_set_priority: Assign a bottom half to a priority class.
+ *
+ * Bottom halves default to QEMU_BH_PRIORITY_NORMAL.  The priority must be
+ * set before the bottom half is scheduled for the first time; it cannot be
+ * changed while the bottom half is pending.
+ *
+ * @bh: The bottom half whose priority is set.
+ * @priority: The priority class.
+ */
+void qemu_bh_set_priority(QEMUBH *bh, QEMUBHPriority priority);
+
 /**
  * qemu_bh_cancel: Cancel execution of a bottom half.
  *
@@ -127,9 +127,15 @@ typedef struct BlockZoneDescriptor {
 
 /*
  * Track write pointers of a zone in bytes.
+ *
+ * A zone's write pointer is protected by the lock shard its zone
+ * index maps to, so writers and appenders working on different zones
+ * run in parallel instead of queueing on one device-wide mutex.
  */
+#define BLK_ZONE_WPS_SHARDS 64
+
 typedef struct BlockZoneWps {
-    CoMutex colock;
+    CoMutex colock[BLK_ZONE_WPS_SHARDS];
     uint64_t wp[];
 } BlockZoneWps;
 
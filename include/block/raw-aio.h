@@ -71,8 +71,23 @@ void luring_cleanup(LuringState *s);
 /* luring_co_submit: submit I/O requests in the thread's current AioContext. */
 int coroutine_fn luring_co_submit(BlockDriverState *bs, int fd, uint64_t offset,
                                   QEMUIOVector *qiov, int type);
+
+/*
+ * luring_co_pdiscard: punch a hole asynchronously in the thread's current
+ * AioContext.  Returns -ENOTSUP when the host cannot punch holes through
+ * io_uring; the caller should fall back to the thread pool then.
+ */
+int coroutine_fn luring_co_pdiscard(BlockDriverState *bs, int fd,
+                                    uint64_t offset, uint64_t bytes);
 void luring_detach_aio_context(LuringState *s, AioContext *old_context);
 void luring_attach_aio_context(LuringState *s, AioContext *new_context);
+
+/*
+ * luring_fd_unregister: drop @fd from all rings' registered file tables.
+ * Must be called before closing an fd that was submitted via
+ * luring_co_submit(), or the kernel's table reference keeps it open.
+ */
+void luring_fd_unregister(int fd);
 #endif
 
 #ifdef _WIN32
@@ -64,6 +64,18 @@ struct SocketChardev {
     size_t write_msgfds_num;
     bool registered_yank;
 
+    /*
+     * Optional outgoing buffer, enabled with the write-buffer option.
+     * head and tail are free-running offsets into a power-of-two sized
+     * ring and are only updated under chr_write_lock.
+     */
+    uint8_t *wbuf;
+    size_t wbuf_size;
+    size_t wbuf_head;
+    size_t wbuf_tail;
+    GSource *write_source;
+    uint64_t tx_bytes;
+
     SocketAddress *addr;
     bool is_listen;
     bool is_telnet;
@@ -170,6 +170,19 @@ int qcrypto_ivgen_calculate(QCryptoIVGen *ivgen,
 QCryptoIVGenAlgorithm qcrypto_ivgen_get_algorithm(QCryptoIVGen *ivgen);
 
 
+/**
+ * qcrypto_ivgen_is_stateless:
+ * @ivgen: the IV generator object
+ *
+ * Report whether qcrypto_ivgen_calculate() touches any mutable
+ * state in @ivgen. Stateless generators (plain, plain64) may be
+ * called concurrently from multiple threads without serialization.
+ *
+ * Returns: true if IV calculation needs no serialization
+ */
+bool qcrypto_ivgen_is_stateless(QCryptoIVGen *ivgen);
+
+
 /**
  * qcrypto_ivgen_get_cipher:
  * @ivgen: the IV generator object
@@ -207,6 +207,41 @@ void qcrypto_tls_session_set_callbacks(QCryptoTLSSession *sess,
                                        QCryptoTLSSessionReadFunc readFunc,
                                        void *opaque);
 
+/**
+ * qcrypto_tls_session_set_transport_fd:
+ * @sess: the TLS session object
+ * @fd: the file descriptor of the data channel
+ *
+ * Hand the socket file descriptor for the underlying data
+ * channel straight to the TLS library, replacing any callbacks
+ * previously registered with qcrypto_tls_session_set_callbacks().
+ * This allows the library to install kernel TLS offload on the
+ * socket once the handshake completes, where the platform and
+ * negotiated cipher support it, so that record encryption happens
+ * in sendmsg()/recvmsg() rather than in userspace. If offload is
+ * unavailable the session transparently falls back to performing
+ * the record layer in userspace, reading and writing @fd directly.
+ *
+ * Only use this when the data channel really is a plain socket
+ * file descriptor; channels needing any other framing must keep
+ * using the callbacks.
+ */
+void qcrypto_tls_session_set_transport_fd(QCryptoTLSSession *sess,
+                                          int fd);
+
+/**
+ * qcrypto_tls_session_get_ktls_enabled:
+ * @sess: the TLS session object
+ *
+ * Check whether kernel TLS offload was installed for both
+ * directions of the session. Only valid to call once
+ * qcrypto_tls_session_get_handshake_status() returns
+ * QCRYPTO_TLS_HANDSHAKE_COMPLETE.
+ *
+ * Returns: true if the kernel performs the record layer
+ */
+bool qcrypto_tls_session_get_ktls_enabled(QCryptoTLSSession *sess);
+
 /**
  * qcrypto_tls_session_write:
  * @sess: the TLS session object
@@ -1,6 +1,8 @@
 #ifndef QEMU_DISAS_H
 #define QEMU_DISAS_H
 
+#include "qemu/thread.h"
+
 /* Disassemble this for me please... (debugging). */
 void disas(FILE *out, const void *code, size_t size);
 void target_disas(FILE *out, CPUState *cpu, uint64_t code, size_t size);
@@ -27,6 +29,12 @@ struct syminfo {
       struct elf64_sym *elf64;
     } disas_symtab;
     const char *disas_strtab;
+    /*
+     * Set once disas_symtab has been sorted.  The system-mode ELF
+     * loader sorts large symbol tables on a worker thread instead of
+     * delaying startup; its lookup function waits on this event.
+     */
+    QemuEvent symtab_ready;
     struct syminfo *next;
 };
 
@@ -222,6 +222,23 @@ void tlb_flush_range_by_mmuidx_all_cpus_synced(CPUState *cpu,
                                                uint16_t idxmap,
                                                unsigned bits);
 
+/**
+ * tlb_flush_page_list_by_mmuidx_all_cpus_synced:
+ * @cpu: Originating CPU of the flush
+ * @pages: virtual addresses of the pages to be flushed
+ * @num_pages: number of entries in @pages
+ * @idxmap: bitmap of mmu indexes to flush
+ *
+ * For each mmuidx in @idxmap, flush all of @pages on all CPUs, like
+ * tlb_flush_page_by_mmuidx_all_cpus_synced(), but batched: the pages
+ * are sorted and coalesced into runs, and each CPU receives a single
+ * work item covering the whole list rather than one per page.
+ */
+void tlb_flush_page_list_by_mmuidx_all_cpus_synced(CPUState *cpu,
+                                                   const vaddr *pages,
+                                                   size_t num_pages,
+                                                   uint16_t idxmap);
+
 /**
  * tlb_set_page_full:
  * @cpu: CPU context
@@ -365,6 +382,13 @@ static inline void tlb_flush_range_by_mmuidx_all_cpus_synced(CPUState *cpu,
                                                              unsigned bits)
 {
 }
+static inline void
+tlb_flush_page_list_by_mmuidx_all_cpus_synced(CPUState *cpu,
+                                              const vaddr *pages,
+                                              size_t num_pages,
+                                              uint16_t idxmap)
+{
+}
 #endif
 /**
  * probe_access:
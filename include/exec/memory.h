@@ -26,6 +26,7 @@
 #include "qemu/int128.h"
 #include "qemu/range.h"
 #include "qemu/notify.h"
+#include "qemu/thread.h"
 #include "qom/object.h"
 #include "qemu/rcu.h"
 
@@ -795,6 +796,8 @@ struct MemoryRegion {
     bool nonvolatile;
     bool rom_device;
     bool flush_coalesced_mmio;
+    bool coalesced_write_merge;
+    bool lockless_read;
     bool unmergeable;
     uint8_t dirty_log_mask;
     bool is_iommu;
@@ -1106,6 +1109,13 @@ struct MemoryListener {
     QTAILQ_ENTRY(MemoryListener) link_as;
 };
 
+typedef struct AddressSpaceMapClient {
+    QEMUBH *bh;
+    QLIST_ENTRY(AddressSpaceMapClient) link;
+} AddressSpaceMapClient;
+
+#define DEFAULT_MAX_BOUNCE_BUFFER_SIZE (4096)
+
 /**
  * struct AddressSpace: describes a mapping of addresses to #MemoryRegion objects
  */
@@ -1123,6 +1133,16 @@ struct AddressSpace {
     struct MemoryRegionIoeventfd *ioeventfds;
     QTAILQ_HEAD(, MemoryListener) listeners;
     QTAILQ_ENTRY(AddressSpace) address_spaces_link;
+
+    /*
+     * Maximum DMA bounce buffer size used for indirect memory map requests.
+     */
+    size_t max_bounce_buffer_size;
+    /* Total size of bounce buffers currently allocated, atomically accessed */
+    size_t bounce_buffer_size;
+    /* List of callbacks to invoke when buffers free up */
+    QemuMutex map_client_list_lock;
+    QLIST_HEAD(, AddressSpaceMapClient) map_client_list;
 };
 
 typedef struct AddressSpaceDispatch AddressSpaceDispatch;
@@ -2256,6 +2276,50 @@ void memory_region_set_flush_coalesced(MemoryRegion *mr);
  */
 void memory_region_clear_flush_coalesced(MemoryRegion *mr);
 
+/**
+ * memory_region_set_coalesced_write_merging: Allow merging of buffered
+ *                                            writes to the same address.
+ *
+ * Declare that back-to-back coalesced writes to the same offset of the
+ * region may be merged when the coalescing buffer is flushed, so that
+ * only the last value is delivered to the write callback.  Only
+ * suitable for posted registers whose intermediate values have no side
+ * effects, such as index or address latches whose companion data port
+ * is not coalesced; the region must already have MMIO coalescing
+ * enabled via memory_region_set_coalescing() or
+ * memory_region_add_coalescing().
+ *
+ * @mr: the memory region to be updated.
+ */
+void memory_region_set_coalesced_write_merging(MemoryRegion *mr);
+
+/**
+ * memory_region_get_coalesced_write_merging: Query coalesced write merging.
+ *
+ * Returns true if back-to-back coalesced writes to the same offset of
+ * the region may be merged on flush.
+ *
+ * @mr: the memory region being queried.
+ */
+bool memory_region_get_coalesced_write_merging(MemoryRegion *mr);
+
+/**
+ * memory_region_enable_lockless_read: Allow reads without the BQL.
+ *
+ * Declare that reading the region has no side effects and needs no
+ * serialization, so that guest reads may dispatch to the region's read
+ * callback without taking the big QEMU lock.  Suitable for devices
+ * whose read handlers only sample device state that is updated
+ * atomically, such as status or doorbell registers polled by the
+ * guest.  The device must tolerate concurrent read callbacks from
+ * multiple vCPU threads, and must not rely on the reentrancy guard or
+ * on coalesced MMIO flushing for the region.  Writes to the region
+ * still take the BQL.
+ *
+ * @mr: the memory region to be updated.
+ */
+void memory_region_enable_lockless_read(MemoryRegion *mr);
+
 /**
  * memory_region_add_eventfd: Request an eventfd to be triggered when a word
  *                            is written to a location.
@@ -2926,8 +2990,8 @@ bool address_space_access_valid(AddressSpace *as, hwaddr addr, hwaddr len,
  * May return %NULL and set *@plen to zero(0), if resources needed to perform
  * the mapping are exhausted.
  * Use only for reads OR writes - not for read-modify-write operations.
- * Use cpu_register_map_client() to know when retrying the map operation is
- * likely to succeed.
+ * Use address_space_register_map_client() to know when retrying the map
+ * operation is likely to succeed.
  *
  * @as: #AddressSpace to be accessed
  * @addr: address within that address space
@@ -2952,6 +3016,28 @@ void *address_space_map(AddressSpace *as, hwaddr addr,
 void address_space_unmap(AddressSpace *as, void *buffer, hwaddr len,
                          bool is_write, hwaddr access_len);
 
+/*
+ * address_space_register_map_client: Register a callback to invoke when
+ * resources for address_space_map() are available again.
+ *
+ * address_space_map may fail when there are not enough resources available,
+ * such as when bounce buffer memory would exceed the limit. The callback can
+ * be used to retry the map operation when resources become available again.
+ *
+ * @as: #AddressSpace to be accessed
+ * @bh: callback to invoke when address_space_map() retry is appropriate
+ */
+void address_space_register_map_client(AddressSpace *as, QEMUBH *bh);
+
+/*
+ * address_space_unregister_map_client: Unregister a callback that has
+ * previously been registered and not fired yet.
+ *
+ * @as: #AddressSpace to be accessed
+ * @bh: callback to unregister
+ */
+void address_space_unregister_map_client(AddressSpace *as, QEMUBH *bh);
+
 
 /* Internal functions, part of the implementation of address_space_read.  */
 MemTxResult address_space_read_full(AddressSpace *as, hwaddr addr,
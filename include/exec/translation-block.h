@@ -9,9 +9,7 @@
 
 #include "qemu/thread.h"
 #include "exec/cpu-common.h"
-#ifdef CONFIG_USER_ONLY
 #include "qemu/interval-tree.h"
-#endif
 
 /*
  * Page tracking code uses ram addresses in system mode, and virtual
@@ -77,6 +75,8 @@ struct TranslationBlock {
 #define CF_PARALLEL      0x00008000 /* Generate code for a parallel context */
 #define CF_NOIRQ         0x00010000 /* Generate an uninterruptible TB */
 #define CF_PCREL         0x00020000 /* Opcodes in TB are PC-relative */
+#define CF_TIER1         0x00040000 /* Cheap first-tier TB; recompile if hot */
+#define CF_SPEC          0x00080000 /* Entry specialized on a guarded constant */
 #define CF_CLUSTER_MASK  0xff000000 /* Top 8 bits are cluster ID */
 #define CF_CLUSTER_SHIFT 24
 
@@ -88,20 +88,37 @@ struct TranslationBlock {
     uint16_t size;
     uint16_t icount;
 
+    /* for CF_TIER1, number of executions observed via tb_lookup */
+    uint32_t exec_count;
+
+    /*
+     * The global (TCG temp index) that the optimizer proved to hold a
+     * constant at each goto_tb exit, or -1.  Lets the two-tier engine
+     * chain to a successor specialized on that constant.
+     */
+    int16_t exit_spec_reg[2];
+    uint64_t exit_spec_val[2];
+
     struct tb_tc tc;
 
     /*
      * Track tb_page_addr_t intervals that intersect this TB.
      * For user-only, the virtual addresses are always contiguous,
-     * and we use a unified interval tree.  For system, we use a
-     * linked list headed in each PageDesc.  Within the list, the lsb
-     * of the previous pointer tells the index of page_next[], and the
-     * list is protected by the PageDesc lock(s).
+     * and we use a unified interval tree.  For system, each PageDesc
+     * keys the TBs intersecting its page by their byte range on that
+     * page in an interval tree, so a write invalidates only truly
+     * overlapping TBs.  A TB owns one node per page; each node
+     * carries a back pointer since the member index cannot be
+     * recovered from the node alone.  The trees are protected by the
+     * PageDesc lock(s).
      */
 #ifdef CONFIG_USER_ONLY
     IntervalTreeNode itree;
 #else
-    uintptr_t page_next[2];
+    struct PageTBNode {
+        IntervalTreeNode itree;
+        struct TranslationBlock *tb;
+    } page_node[2];
     tb_page_addr_t page_addr[2];
 #endif
 
@@ -195,8 +195,13 @@ struct CPUClass {
  */
 #define NB_MMU_MODES 16
 
-/* Use a fully associative victim tlb of 8 entries. */
-#define CPU_VTLB_SIZE 8
+/*
+ * Use a fully associative victim tlb.  The size starts at 8 entries
+ * and adapts between the bounds below, based on the ratio of victim
+ * hits to full page table walks observed in the resize time window.
+ */
+#define CPU_VTLB_MIN_SIZE 8
+#define CPU_VTLB_MAX_SIZE 64
 
 /*
  * The full TLB entry, which is not accessed by generated TCG code,
@@ -281,10 +286,24 @@ typedef struct CPUTLBDesc {
     size_t n_used_entries;
     /* The next index to use in the tlb victim table.  */
     size_t vindex;
+    /* The current number of entries in the tlb victim table.  */
+    size_t vsize;
     /* The tlb victim table, in two parts.  */
-    CPUTLBEntry vtable[CPU_VTLB_SIZE];
-    CPUTLBEntryFull vfulltlb[CPU_VTLB_SIZE];
+    CPUTLBEntry *vtable;
+    CPUTLBEntryFull *vfulltlb;
     CPUTLBEntryFull *fulltlb;
+    /*
+     * Statistics.  These are not lock protected, but are read and
+     * written atomically, as for the counts in CPUTLBCommon.
+     * vtlb_hits counts misses on the fast tlb that were absorbed by
+     * the victim table; walk_count counts refills via tlb_set_page_full,
+     * i.e. misses that required a full page table walk.
+     */
+    size_t vtlb_hits;
+    size_t walk_count;
+    /* values of the above at the beginning of the time window */
+    size_t window_vtlb_hits;
+    size_t window_walk_count;
 } CPUTLBDesc;
 
 /*
@@ -26,6 +26,22 @@
 
 typedef struct PXBCXLDev PXBCXLDev;
 
+/*
+ * Direct-mapped cache of HDM decode results for one fixed memory
+ * window, so that most accesses translate with a single lookup
+ * instead of re-walking the host bridge and switch decoders.  Every
+ * interleave granularity is at least 256 bytes, so one entry per
+ * 256-byte aligned HPA is always uniform.  Entries are dropped
+ * wholesale when cxl_decoders_generation moves on.
+ */
+#define CXL_DECODE_CACHE_LINE 256
+#define CXL_DECODE_CACHE_SIZE 512
+
+typedef struct CXLDecodeCacheEntry {
+    hwaddr tag;
+    PCIDevice *dev;     /* NULL when the entry is unused */
+} CXLDecodeCacheEntry;
+
 typedef struct CXLFixedWindow {
     uint64_t size;
     char **targets;
@@ -36,6 +52,8 @@ typedef struct CXLFixedWindow {
     /* Todo: XOR based interleaving */
     MemoryRegion mr;
     hwaddr base;
+    CXLDecodeCacheEntry *decode_cache;
+    uint64_t decode_cache_gen;
 } CXLFixedWindow;
 
 typedef struct CXLState {
@@ -270,6 +270,13 @@ uint8_t cxl_interleave_granularity_enc(uint64_t gran, Error **errp);
 
 hwaddr cxl_decode_ig(int ig);
 
+/*
+ * Bumped whenever host bridge or switch decode state may have changed;
+ * cached HDM translations tagged with an older generation are stale.
+ */
+extern uint64_t cxl_decoders_generation;
+void cxl_decoders_changed(void);
+
 CXLComponentState *cxl_get_hb_cstate(PCIHostState *hb);
 bool cxl_get_hb_passthrough(PCIHostState *hb);
 
@@ -86,6 +86,9 @@ static const char *glue(lookup_symbol, SZ)(struct syminfo *s,
     struct elf_sym *syms = glue(s->disas_symtab.elf, SZ);
     struct elf_sym *sym;
 
+    /* The table is sorted on a worker thread; see load_symbols.  */
+    qemu_event_wait(&s->symtab_ready);
+
     sym = bsearch(&orig_addr, syms, s->disas_num_syms, sizeof(*syms),
                   glue(symfind, SZ));
     if (sym != NULL) {
@@ -104,6 +107,24 @@ static int glue(symcmp, SZ)(const void *s0, const void *s1)
         : ((sym0->st_value > sym1->st_value) ? 1 : 0);
 }
 
+static void *glue(sort_symtab, SZ)(void *opaque)
+{
+    struct syminfo *s = opaque;
+    struct elf_sym *syms = glue(s->disas_symtab.elf, SZ);
+    int nsyms = s->disas_num_syms;
+    int i;
+
+    qsort(syms, nsyms, sizeof(*syms), glue(symcmp, SZ));
+    for (i = 0; i < nsyms - 1; i++) {
+        if (syms[i].st_size == 0) {
+            syms[i].st_size = syms[i + 1].st_value - syms[i].st_value;
+        }
+    }
+
+    qemu_event_set(&s->symtab_ready);
+    return NULL;
+}
+
 static void glue(load_symbols, SZ)(struct elfhdr *ehdr, int fd, int must_swab,
                                    int clear_lsb, symbol_fn_t sym_cb)
 {
@@ -112,6 +133,7 @@ static void glue(load_symbols, SZ)(struct elfhdr *ehdr, int fd, int must_swab,
     g_autofree struct elf_sym *syms = NULL;
     g_autofree char *str = NULL;
     struct syminfo *s;
+    QemuThread sorter;
     int nsyms, i;
 
     shdr_table = load_at(fd, ehdr->e_shoff,
@@ -181,12 +203,6 @@ static void glue(load_symbols, SZ)(struct elfhdr *ehdr, int fd, int must_swab,
     }
 
     syms = g_realloc(syms, nsyms * sizeof(*syms));
-    qsort(syms, nsyms, sizeof(*syms), glue(symcmp, SZ));
-    for (i = 0; i < nsyms - 1; i++) {
-        if (syms[i].st_size == 0) {
-            syms[i].st_size = syms[i + 1].st_value - syms[i].st_value;
-        }
-    }
 
     /* Commit */
     s = g_malloc0(sizeof(*s));
@@ -194,6 +210,17 @@ static void glue(load_symbols, SZ)(struct elfhdr *ehdr, int fd, int must_swab,
     glue(s->disas_symtab.elf, SZ) = g_steal_pointer(&syms);
     s->disas_num_syms = nsyms;
     s->disas_strtab = g_steal_pointer(&str);
+    qemu_event_init(&s->symtab_ready, false);
+
+    /*
+     * Sorting the symbol table of a large debug kernel can take a
+     * noticeable fraction of startup, and most runs never look up a
+     * symbol at all.  Push the sort to a worker thread; consumers
+     * wait on symtab_ready, which is cheap once it has been set.
+     */
+    qemu_thread_create(&sorter, "symtab-sort", glue(sort_symtab, SZ),
+                       s, QEMU_THREAD_DETACHED);
+
     s->next = syminfos;
     syminfos = s;
 }
@@ -219,6 +219,17 @@ struct GICv3CPUState {
     /* Cached information recalculated from vLPI tables in guest memory */
     PendingIrq hppvlpi;
 
+    /*
+     * While the ITS drains its command queue the expensive LPI pending
+     * table rescans and cpuif updates are deferred and performed once
+     * per redistributor when the drain completes. These flags are only
+     * set within a single command queue drain (under the BQL), so they
+     * don't need to be migrated.
+     */
+    bool lpi_batch_active;
+    bool lpi_batch_rescan;
+    bool lpi_batch_update;
+
     /* This is temporary working state, to avoid a malloc in gicv3_update() */
     bool seenbetter;
 };
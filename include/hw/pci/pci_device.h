@@ -104,6 +104,13 @@ struct PCIDevice {
     /* Capability bits */
     uint32_t cap_present;
 
+    /*
+     * Capability offset indexes, rebuilt whenever a capability is added
+     * or removed, so that lookups do not walk the lists in config space.
+     */
+    uint8_t cap_cache[PCI_CAP_ID_MAX + 1];
+    uint16_t ext_cap_cache[PCI_EXT_CAP_ID_MAX + 1];
+
     /* Offset of MSI-X capability in config space */
     uint8_t msix_cap;
 
@@ -32,6 +32,16 @@ struct MSDState {
     uint32_t data_len;
     struct usb_msd_csw csw;
     SCSIRequest *req;
+    bool req_continued;
+    /*
+     * Read-ahead buffer for the data-in stage.  SCSI chunks are stashed
+     * here so that the next block read can be issued while the guest is
+     * still draining the previous chunk over the bulk endpoint.
+     */
+    uint8_t *inbuf;
+    uint32_t inbuf_size;
+    uint32_t inbuf_len;
+    uint32_t inbuf_off;
     SCSIBus bus;
     /* For async completion.  */
     USBPacket *packet;
@@ -71,6 +71,10 @@ struct VirtIOBalloon {
 
     bool qemu_4_0_config_size;
     uint32_t poison_val;
+
+    /* Last host THP region given a hugepage hint, to batch madvise calls */
+    void *thp_hint_base;
+    bool thp_hint_nohuge;
 };
 
 #endif
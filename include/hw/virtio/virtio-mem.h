@@ -16,6 +16,7 @@
 #include "standard-headers/linux/virtio_mem.h"
 #include "hw/virtio/virtio.h"
 #include "qapi/qapi-types-misc.h"
+#include "qemu/thread.h"
 #include "sysemu/hostmem.h"
 #include "qom/object.h"
 
@@ -33,6 +34,7 @@ OBJECT_DECLARE_TYPE(VirtIOMEM, VirtIOMEMClass,
 #define VIRTIO_MEM_UNPLUGGED_INACCESSIBLE_PROP "unplugged-inaccessible"
 #define VIRTIO_MEM_EARLY_MIGRATION_PROP "x-early-migration"
 #define VIRTIO_MEM_PREALLOC_PROP "prealloc"
+#define VIRTIO_MEM_PREALLOC_AHEAD_PROP "prealloc-ahead"
 #define VIRTIO_MEM_DYNAMIC_MEMSLOTS_PROP "dynamic-memslots"
 
 struct VirtIOMEM {
@@ -97,6 +99,23 @@ struct VirtIOMEM {
     /* whether to prealloc memory when plugging new blocks */
     bool prealloc;
 
+    /*
+     * How much memory beyond requested-size to keep populated in the
+     * background, so plug requests flip blocks whose pages are already
+     * faulted in and zeroed.  0 disables background preparation.
+     */
+    uint64_t prealloc_ahead;
+
+    /* Background preparation state, protected by prepare_lock. */
+    QemuThread prepare_thread;
+    QemuMutex prepare_lock;
+    QemuCond prepare_cond;
+    uint64_t prepare_offset;    /* everything below this is populated
+                                 * or plugged (guest-owned) */
+    uint64_t prepare_goal;      /* populate up to this offset */
+    bool prepare_running;
+    bool prepare_exit;
+
     /*
      * Whether we migrate properties that are immutable while migration is
      * active early, before state of other devices and especially, before
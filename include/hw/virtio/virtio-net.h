@@ -146,6 +146,8 @@ typedef struct VirtioNetRssData {
     bool    populate_hash;
     uint32_t hash_types;
     uint8_t key[VIRTIO_NET_RSS_MAX_KEY_SIZE];
+    /* Toeplitz lookup table derived from the key, for software RSS */
+    struct net_toeplitz_table *toeplitz_table;
     uint16_t indirections_len;
     uint16_t *indirections_table;
     uint16_t default_queue;
@@ -197,6 +199,14 @@ struct VirtIONet {
         uint8_t multi_overflow;
         uint8_t uni_overflow;
         uint8_t *macs;
+        /*
+         * 64-bit membership prefilters over the unicast and multicast
+         * halves of macs[], rebuilt whenever the table changes; a
+         * clear bit proves a destination is absent without walking
+         * the table.  Not migrated, recomputed on load.
+         */
+        uint64_t uni_filter;
+        uint64_t multi_filter;
     } mac_table;
     uint32_t *vlans;
     virtio_net_conf net_conf;
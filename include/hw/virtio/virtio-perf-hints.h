@@ -0,0 +1,55 @@
+/*
+ * Virtio performance hints device
+ *
+ * A paravirt channel through which the guest signals latency-critical
+ * phases, so the host can temporarily trade CPU for latency: boost
+ * iothread adaptive polling and pause background block jobs while a
+ * critical section is open, and fall back to the configured tuning
+ * when it closes.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2.
+ * See the COPYING file in the top-level directory.
+ */
+
+#ifndef HW_VIRTIO_PERF_HINTS_H
+#define HW_VIRTIO_PERF_HINTS_H
+
+#include "hw/virtio/virtio.h"
+#include "qom/object.h"
+
+#define TYPE_VIRTIO_PERF_HINTS "virtio-perf-hints-device"
+OBJECT_DECLARE_SIMPLE_TYPE(VirtIOPerfHints, VIRTIO_PERF_HINTS)
+
+/* Experimental device ID; not yet reserved in the virtio spec */
+#define VIRTIO_ID_PERF_HINTS 42
+
+/* Guest request types */
+#define VIRTIO_PERF_HINTS_LATENCY_ENTER 1
+#define VIRTIO_PERF_HINTS_LATENCY_EXIT  2
+
+struct virtio_perf_hints_req {
+    uint32_t type;
+    uint32_t reserved;
+};
+
+struct virtio_perf_hints_resp {
+    uint32_t ret;
+};
+
+struct VirtIOPerfHints {
+    VirtIODevice parent_obj;
+
+    VirtQueue *hint_vq;
+
+    /* Policy knobs */
+    uint64_t poll_boost_ns;
+    bool pause_jobs;
+
+    /* Number of guest latency-critical sections currently open */
+    unsigned critical_depth;
+
+    /* Jobs paused by the policy, referenced until resumed */
+    GPtrArray *paused_jobs;
+};
+
+#endif
@@ -60,6 +60,15 @@ struct QIOChannelWebsock {
     Buffer rawinput;
     size_t payload_remain;
     size_t pong_remain;
+    /*
+     * Location of the trailing data frame in encoutput, if its
+     * header has not yet hit the wire, so that further writes can
+     * extend it in place rather than emit a new frame. An end
+     * offset of zero means no frame is open for extension.
+     */
+    size_t coalesce_header;
+    size_t coalesce_end;
+    size_t coalesce_size;
     QIOChannelWebsockMask mask;
     guint io_tag;
     Error *io_err;
@@ -22,6 +22,7 @@
 #define QIO_DNS_RESOLVER_H
 
 #include "qapi/qapi-types-sockets.h"
+#include "qemu/thread.h"
 #include "qom/object.h"
 #include "io/task.h"
 
@@ -131,6 +132,15 @@ OBJECT_DECLARE_SIMPLE_TYPE(QIODNSResolver,
  */
 struct QIODNSResolver {
     Object parent;
+
+    /*
+     * Successful lookups are cached for a short TTL so that
+     * reconnect loops do not query a slow or flaky DNS server
+     * on every attempt. Lookups may run from worker threads,
+     * hence the lock.
+     */
+    QemuMutex lock;
+    GHashTable *cache;
 };
 
 
@@ -17,6 +17,7 @@
 #include "qemu/notify.h"
 #include "qapi/qapi-types-migration.h"
 #include "qapi/qapi-types-net.h"
+#include "qapi/qapi-types-run-state.h"
 #include "migration/client-options.h"
 
 /* migration/ram.c */
@@ -117,4 +118,14 @@ bool migration_in_bg_snapshot(void);
 /* migration/block-dirty-bitmap.c */
 void dirty_bitmap_mig_init(void);
 
+/* migration/reset-snapshot.c */
+
+/*
+ * Restore the state captured by x-reset-snapshot-save instead of
+ * resetting the machine.  Returns false when no snapshot is armed or
+ * @reason is not a whole-machine reboot, in which case the caller must
+ * perform a full reset.
+ */
+bool reset_snapshot_load(ShutdownCause reason);
+
 #endif
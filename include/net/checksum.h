@@ -50,6 +50,31 @@ net_raw_checksum(uint8_t *data, int length)
     return net_checksum_finish(net_checksum_add(length, data));
 }
 
+/**
+ * net_checksum_fixup32: incrementally update a checksum for a field change
+ *
+ * Recompute a TCP/UDP/IP checksum after a 32-bit field covered by it has
+ * been rewritten, without re-reading the rest of the data (RFC 1624,
+ * equation 3).
+ *
+ * @csum: current checksum, host order
+ * @old_val: previous value of the changed field, host order
+ * @new_val: new value of the changed field, host order
+ *
+ * Returns the updated checksum in host order.
+ */
+static inline uint16_t
+net_checksum_fixup32(uint16_t csum, uint32_t old_val, uint32_t new_val)
+{
+    uint32_t sum = (uint16_t)~csum;
+
+    sum += (uint16_t)~(old_val >> 16);
+    sum += (uint16_t)~(old_val & 0xffff);
+    sum += new_val >> 16;
+    sum += new_val & 0xffff;
+    return net_checksum_finish(sum);
+}
+
 /**
  * net_checksum_add_iov: scatter-gather vector checksumming
  *
@@ -108,4 +133,37 @@ void net_toeplitz_add(uint32_t *result,
     *result = accumulator;
 }
 
+/*
+ * Table-driven Toeplitz hashing.  The contribution of every possible
+ * input byte at every input position is precomputed from the key once,
+ * turning the per-packet bit loop into one table lookup per input byte.
+ * Worth it when many packets are hashed with the same key.
+ */
+#define NET_TOEPLITZ_KEY_LENGTH 40
+#define NET_TOEPLITZ_MAX_INPUT  (NET_TOEPLITZ_KEY_LENGTH - 4)
+
+typedef struct net_toeplitz_table {
+    uint32_t column[NET_TOEPLITZ_MAX_INPUT][256];
+} net_toeplitz_table;
+
+void net_toeplitz_table_init(net_toeplitz_table *table,
+                             const uint8_t *key);
+
+static inline
+uint32_t net_toeplitz_table_hash(const net_toeplitz_table *table,
+                                 const uint8_t *input,
+                                 uint32_t len)
+{
+    uint32_t hash = 0;
+    uint32_t byte;
+
+    assert(len <= NET_TOEPLITZ_MAX_INPUT);
+
+    for (byte = 0; byte < len; byte++) {
+        hash ^= table->column[byte][input[byte]];
+    }
+
+    return hash;
+}
+
 #endif /* QEMU_NET_CHECKSUM_H */
@@ -59,6 +59,12 @@ struct NetFilterState {
     bool on;
     char *position;
     bool insert_before_flag;
+    /*
+     * Cached copy of the class receive_iov hook, resolved once at
+     * completion; packet delivery dispatches through this instead of
+     * doing a QOM class lookup per packet per filter.
+     */
+    FilterReceiveIOV *receive_iov;
     QTAILQ_ENTRY(NetFilterState) next;
 };
 
@@ -43,6 +43,7 @@ typedef struct NICConf {
 /* Net clients */
 
 typedef void (NetPoll)(NetClientState *, bool enable);
+typedef void (NetQueueFlushed)(NetClientState *);
 typedef bool (NetCanReceive)(NetClientState *);
 typedef int (NetStart)(NetClientState *);
 typedef int (NetLoad)(NetClientState *);
@@ -84,6 +85,8 @@ typedef struct NetClientInfo {
     LinkStatusChanged *link_status_changed;
     QueryRxFilter *query_rx_filter;
     NetPoll *poll;
+    /* Called on the peer when this client's incoming queue drains */
+    NetQueueFlushed *queue_flushed;
     HasUfo *has_ufo;
     HasUso *has_uso;
     HasVnetHdr *has_vnet_hdr;
@@ -0,0 +1,88 @@
+/*
+ * Shared compression service
+ *
+ * A single place for one-shot buffer compression so that subsystems
+ * which offload compression to worker threads (migration, qcow2) share
+ * codecs instead of each wrapping zlib and zstd themselves, and so that
+ * hardware compression engines (e.g. Intel IAA/QAT) can be plugged in
+ * once and accelerate every consumer.  Backends register a priority;
+ * the highest-priority backend supporting the requested format wins,
+ * with the built-in software backend as the fallback.
+ *
+ * The batch entry points exist for hardware backends, which amortize
+ * submission cost by pushing all descriptors to the engine before
+ * waiting for completions; the software backend simply loops.  All
+ * calls are synchronous - consumers already run them on worker threads.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or
+ * (at your option) any later version.
+ */
+
+#ifndef QEMU_COMPRESS_H
+#define QEMU_COMPRESS_H
+
+#include "qemu/queue.h"
+
+typedef enum QemuCompressFormat {
+    QEMU_COMPRESS_FMT_ZLIB, /* deflate; window_bits selects the framing */
+    QEMU_COMPRESS_FMT_ZSTD,
+} QemuCompressFormat;
+
+/*
+ * One compression or decompression descriptor.  @level 0 means the
+ * codec default.  @window_bits applies to zlib only: 0 means the zlib
+ * default (15, zlib framing); negative values select raw deflate, as
+ * used by qcow2.
+ */
+typedef struct QemuCompressReq {
+    const void *src;
+    size_t src_size;
+    void *dst;
+    size_t dst_size;
+    int level;
+    int window_bits;
+    /*
+     * Compression: compressed size, -ENOMEM if @dst is too small, or
+     * -EIO.  Decompression: bytes produced (decoding stops once @dst
+     * is full, even if @src is only partially consumed), or -EIO.
+     * Either direction: -ENOTSUP if the format is not compiled in.
+     */
+    ssize_t result;
+} QemuCompressReq;
+
+typedef struct QemuCompressBackend QemuCompressBackend;
+struct QemuCompressBackend {
+    const char *name;
+    /* Higher priority wins; the software fallback registers with 0. */
+    int priority;
+    bool (*supports)(QemuCompressFormat fmt);
+    void (*compress)(QemuCompressFormat fmt, QemuCompressReq *reqs,
+                     size_t nreqs);
+    void (*decompress)(QemuCompressFormat fmt, QemuCompressReq *reqs,
+                       size_t nreqs);
+    QTAILQ_ENTRY(QemuCompressBackend) next;
+};
+
+/*
+ * Register a backend.  Must happen during startup, before any data
+ * path calls into the service; lookups take no lock.
+ */
+void qemu_compress_backend_register(QemuCompressBackend *backend);
+
+/* True if @fmt would be handled by a hardware backend. */
+bool qemu_compress_accelerated(QemuCompressFormat fmt);
+
+void qemu_compress_batch(QemuCompressFormat fmt, QemuCompressReq *reqs,
+                         size_t nreqs);
+void qemu_decompress_batch(QemuCompressFormat fmt, QemuCompressReq *reqs,
+                           size_t nreqs);
+
+/* Single-buffer convenience wrappers; see QemuCompressReq for returns. */
+ssize_t qemu_compress_one(QemuCompressFormat fmt, int level, int window_bits,
+                          void *dst, size_t dst_size,
+                          const void *src, size_t src_size);
+ssize_t qemu_decompress_one(QemuCompressFormat fmt, int window_bits,
+                            void *dst, size_t dst_size,
+                            const void *src, size_t src_size);
+
+#endif /* QEMU_COMPRESS_H */
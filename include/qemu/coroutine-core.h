@@ -139,6 +139,24 @@ bool qemu_coroutine_entered(Coroutine *co);
  */
 void qemu_co_mutex_init(CoMutex *mutex);
 
+/**
+ * Initialises a CoMutex and enables contention profiling for it.  Statistics
+ * of all mutexes registered under the same name are aggregated and reported
+ * by the "coroutine" query-stats provider.  @name must be a string literal
+ * or otherwise outlive the process.
+ */
+void qemu_co_mutex_init_profiled(CoMutex *mutex, const char *name);
+
+/**
+ * Invoke @fn for each registered CoMutex profile, passing the name, the
+ * number of acquisitions, the number of contended acquisitions, and the
+ * cumulative wait and hold times in nanoseconds.
+ */
+typedef void CoMutexProfileFunc(const char *name, uint64_t acquisitions,
+                                uint64_t contentions, uint64_t wait_ns,
+                                uint64_t hold_ns, void *opaque);
+void qemu_co_mutex_profile_foreach(CoMutexProfileFunc *fn, void *opaque);
+
 /**
  * Locks the mutex. If the lock cannot be taken immediately, control is
  * transferred to the caller of the current coroutine.
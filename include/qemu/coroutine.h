@@ -66,6 +66,14 @@ struct CoMutex {
     unsigned handoff, sequence;
 
     Coroutine *holder;
+
+    /* Contention profile shared by all mutexes registered under the same
+     * name, or NULL when the mutex was initialized with
+     * qemu_co_mutex_init().  hold_start_ns is only valid while a profiled
+     * mutex is held.
+     */
+    struct CoMutexProfile *profile;
+    int64_t hold_start_ns;
 };
 
 /**
@@ -281,6 +289,16 @@ void qemu_coroutine_inc_pool_size(unsigned int additional_pool_size);
  */
 void qemu_coroutine_dec_pool_size(unsigned int additional_pool_size);
 
+/**
+ * Retrieve coroutine pool statistics
+ *
+ * @allocations: total number of coroutines created from scratch
+ * @pool_hits: total number of coroutines recycled from the pool
+ * @pool_size: current number of unused coroutines in the global pool
+ */
+void qemu_coroutine_pool_stats(uint64_t *allocations, uint64_t *pool_hits,
+                               uint64_t *pool_size);
+
 #include "qemu/lockable.h"
 
 /**
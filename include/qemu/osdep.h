@@ -688,7 +688,7 @@ typedef struct ThreadContext ThreadContext;
  * @sz: the size of the area to preallocate
  * @max_threads: maximum number of threads to use
  * @tc: prealloc context threads pointer, NULL if not in use
- * @async: request asynchronous preallocation, requires @tc
+ * @async: request asynchronous preallocation
  * @errp: returns an error if this function fails
  *
  * Preallocate memory (populate/prefault page tables writable) for the virtual
@@ -0,0 +1,114 @@
+/*
+ * Unified hot-path counter registry
+ *
+ * Modules register named counters and log2 histograms once at startup
+ * and update them from hot paths without taking locks: every counter
+ * is sharded across cache lines by thread, and the shards are only
+ * summed when a snapshot is taken.  The QMP query-profile command
+ * returns a filtered snapshot of everything registered here, and
+ * profile-reset zeroes it, so new instrumentation gets a management
+ * surface without growing a bespoke command.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or
+ * (at your option) any later version.
+ */
+
+#ifndef QEMU_PROFILE_H
+#define QEMU_PROFILE_H
+
+#include "qemu/queue.h"
+#include "qemu/stats64.h"
+
+#define PROFILE_COUNTER_SHARDS 16
+#define PROFILE_HISTOGRAM_BUCKETS 64
+
+typedef struct ProfileCounterShard {
+    Stat64 value;
+} QEMU_ALIGNED(64) ProfileCounterShard;
+
+typedef struct ProfileCounter {
+    const char *name;
+    QTAILQ_ENTRY(ProfileCounter) next;
+    ProfileCounterShard shards[PROFILE_COUNTER_SHARDS];
+} ProfileCounter;
+
+typedef struct ProfileHistogramShard {
+    Stat64 buckets[PROFILE_HISTOGRAM_BUCKETS];
+} QEMU_ALIGNED(64) ProfileHistogramShard;
+
+/*
+ * Log2 histogram: bucket N counts recorded values whose floor(log2)
+ * is N, with zero counted in bucket 0.
+ */
+typedef struct ProfileHistogram {
+    const char *name;
+    QTAILQ_ENTRY(ProfileHistogram) next;
+    ProfileHistogramShard shards[PROFILE_COUNTER_SHARDS];
+} ProfileHistogram;
+
+/*
+ * profile_counter_register:
+ * @counter: zero-initialized counter, usually static storage
+ * @name: snapshot name, not copied; must out-live the counter
+ *
+ * Add @counter to the registry.  Call once per counter, from module
+ * or instance initialization, not from hot paths.
+ */
+void profile_counter_register(ProfileCounter *counter, const char *name);
+
+/*
+ * profile_counter_unregister:
+ * @counter: a registered counter
+ *
+ * Remove @counter from the registry, e.g. when the instance it counts
+ * for goes away.  The caller must ensure no thread still updates it.
+ */
+void profile_counter_unregister(ProfileCounter *counter);
+
+/*
+ * profile_histogram_register:
+ *
+ * Counterpart of profile_counter_register() for histograms.
+ */
+void profile_histogram_register(ProfileHistogram *histogram,
+                                const char *name);
+
+/* Assign and return the calling thread's shard index. */
+unsigned profile_shard_index_slow(void);
+
+extern __thread unsigned profile_thread_shard; /* shard index + 1, 0 unset */
+
+static inline unsigned profile_shard_index(void)
+{
+    return profile_thread_shard ? profile_thread_shard - 1
+                                : profile_shard_index_slow();
+}
+
+static inline void profile_counter_add(ProfileCounter *counter,
+                                       uint64_t delta)
+{
+    stat64_add(&counter->shards[profile_shard_index()].value, delta);
+}
+
+static inline void profile_counter_inc(ProfileCounter *counter)
+{
+    profile_counter_add(counter, 1);
+}
+
+void profile_histogram_record(ProfileHistogram *histogram, uint64_t value);
+
+/* Aggregation, for snapshots: sums all shards. */
+uint64_t profile_counter_get(ProfileCounter *counter);
+uint64_t profile_histogram_bucket(ProfileHistogram *histogram,
+                                  unsigned bucket);
+
+void profile_counter_reset(ProfileCounter *counter);
+void profile_histogram_reset(ProfileHistogram *histogram);
+
+typedef void ProfileCounterIter(ProfileCounter *counter, void *opaque);
+typedef void ProfileHistogramIter(ProfileHistogram *histogram, void *opaque);
+
+void profile_counter_foreach(ProfileCounterIter *fn, void *opaque);
+void profile_histogram_foreach(ProfileHistogramIter *fn, void *opaque);
+
+#endif /* QEMU_PROFILE_H */
@@ -15,8 +15,11 @@ typedef bool (*qht_cmp_func_t)(const void *a, const void *b);
 
 struct qht {
     struct qht_map *map;
+    /* old map, drained incrementally after an automatic resize */
+    struct qht_map *prev;
     qht_cmp_func_t cmp;
-    QemuMutex lock; /* serializes setters of ht->map */
+    QemuMutex lock; /* serializes setters of ht->map, ht->prev, migrate_next */
+    size_t migrate_next; /* next head bucket of ht->prev to migrate */
     unsigned int mode;
 };
 
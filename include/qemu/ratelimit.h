@@ -17,64 +17,64 @@
 #include "qemu/lockable.h"
 #include "qemu/timer.h"
 
+/*
+ * Token bucket.  Tokens are data units, accrued at @speed units per
+ * second with nanosecond resolution and capped at @burst.  The balance
+ * may go negative when a request overshoots the budget; the debt is
+ * paid off by the returned delay, so throughput converges on @speed
+ * without the sawtooth a fixed accounting slice produces.
+ */
 typedef struct {
     QemuMutex lock;
-    int64_t slice_start_time;
-    int64_t slice_end_time;
-    uint64_t slice_quota;
-    uint64_t slice_ns;
-    uint64_t dispatched;
+    int64_t last_time;
+    double tokens;
+    double burst;
+    double speed;
 } RateLimit;
 
 /** Calculate and return delay for next request in ns
  *
  * Record that we sent @n data units (where @n matches the scale chosen
- * during ratelimit_set_speed). If we may send more data units
- * in the current time slice, return 0 (i.e. no delay). Otherwise
- * return the amount of time (in ns) until the start of the next time
- * slice that will permit sending the next chunk of data.
+ * during ratelimit_set_speed). If the bucket still holds tokens,
+ * return 0 (i.e. no delay). Otherwise return the amount of time (in
+ * ns) until enough tokens have accrued to pay for the data already
+ * sent.
  *
- * Recording sent data units even after exceeding the quota is
- * permitted; the time slice will be extended accordingly.
+ * Recording sent data units even after exceeding the budget is
+ * permitted; the token balance simply goes further negative.
  */
 static inline int64_t ratelimit_calculate_delay(RateLimit *limit, uint64_t n)
 {
     int64_t now = qemu_clock_get_ns(QEMU_CLOCK_REALTIME);
-    double delay_slices;
 
     QEMU_LOCK_GUARD(&limit->lock);
-    if (!limit->slice_quota) {
+    if (!limit->speed) {
         /* Throttling disabled.  */
         return 0;
     }
-    assert(limit->slice_ns);
 
-    if (limit->slice_end_time < now) {
-        /* Previous, possibly extended, time slice finished; reset the
-         * accounting. */
-        limit->slice_start_time = now;
-        limit->slice_end_time = now + limit->slice_ns;
-        limit->dispatched = 0;
-    }
+    limit->tokens += (now - limit->last_time) * limit->speed / NANOSECONDS_PER_SECOND;
+    limit->tokens = MIN(limit->tokens, limit->burst);
+    limit->last_time = now;
 
-    limit->dispatched += n;
-    if (limit->dispatched < limit->slice_quota) {
-        /* We may send further data within the current time slice, no
-         * need to delay the next request. */
+    limit->tokens -= n;
+    if (limit->tokens >= 0) {
+        /* We may send further data right away, no need to delay the
+         * next request. */
         return 0;
     }
 
-    /* Quota exceeded. Wait based on the excess amount and then start a new
-     * slice. */
-    delay_slices = (double)limit->dispatched / limit->slice_quota;
-    limit->slice_end_time = limit->slice_start_time +
-        (uint64_t)(delay_slices * limit->slice_ns);
-    return limit->slice_end_time - now;
+    /* In debt.  Wait until the accrual rate pays it off.  */
+    return (int64_t)(-limit->tokens / limit->speed * NANOSECONDS_PER_SECOND) + 1;
 }
 
 static inline void ratelimit_init(RateLimit *limit)
 {
     qemu_mutex_init(&limit->lock);
+    limit->last_time = qemu_clock_get_ns(QEMU_CLOCK_REALTIME);
+    limit->tokens = 0;
+    limit->burst = 0;
+    limit->speed = 0;
 }
 
 static inline void ratelimit_destroy(RateLimit *limit)
@@ -82,15 +82,21 @@ static inline void ratelimit_destroy(RateLimit *limit)
     qemu_mutex_destroy(&limit->lock);
 }
 
+/** Set the limit to @speed data units per second, with a burst
+ * allowance covering @burst_ns worth of data at that rate. */
 static inline void ratelimit_set_speed(RateLimit *limit, uint64_t speed,
-                                       uint64_t slice_ns)
+                                       uint64_t burst_ns)
 {
     QEMU_LOCK_GUARD(&limit->lock);
-    limit->slice_ns = slice_ns;
+    limit->speed = speed;
     if (speed == 0) {
-        limit->slice_quota = 0;
+        limit->tokens = 0;
+        limit->burst = 0;
     } else {
-        limit->slice_quota = MAX(((double)speed * slice_ns) / 1000000000ULL, 1);
+        limit->burst = MAX((double)speed * burst_ns / NANOSECONDS_PER_SECOND, 1);
+        /* A newly configured limit starts with a full bucket. */
+        limit->tokens = limit->burst;
+        limit->last_time = qemu_clock_get_ns(QEMU_CLOCK_REALTIME);
     }
 }
 
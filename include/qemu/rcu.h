@@ -195,4 +195,14 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(RCUReadAuto, rcu_read_auto_unlock)
 void rcu_add_force_rcu_notifier(Notifier *n);
 void rcu_remove_force_rcu_notifier(Notifier *n);
 
+/**
+ * rcu_call_stats: query the state of the call_rcu() queue
+ * @pending: number of callbacks awaiting a grace period
+ * @forced_notifies: number of force-RCU notifications sent because the
+ *                   queue depth crossed the forcing threshold
+ *
+ * Feeds the "rcu" provider of the QMP query-stats command.
+ */
+void rcu_call_stats(uint64_t *pending, uint64_t *forced_notifies);
+
 #endif /* QEMU_RCU_H */
@@ -136,6 +136,13 @@ struct ObjectClass
     ObjectUnparent *unparent;
 
     GHashTable *properties;
+    /*
+     * Flattened view of @properties including all parent classes,
+     * built lazily on the first lookup and rebuilt whenever a class
+     * property has been added anywhere in the hierarchy since.
+     */
+    GHashTable *flat_properties;
+    unsigned flat_properties_gen;
 };
 
 /**
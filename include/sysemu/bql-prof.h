@@ -0,0 +1,38 @@
+/*
+ * BQL hold/wait profiling
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+
+#ifndef SYSEMU_BQL_PROF_H
+#define SYSEMU_BQL_PROF_H
+
+/* Read with qatomic_read() before calling the hooks below */
+extern bool bql_prof_enabled;
+
+/**
+ * bql_prof_acquire: account a BQL acquisition
+ * @file: source file of the lock call site
+ * @line: source line of the lock call site
+ * @wait_ns: time spent waiting for the lock, in nanoseconds
+ *
+ * Called by the new lock holder, i.e. with the BQL held.
+ */
+void bql_prof_acquire(const char *file, int line, int64_t wait_ns);
+
+/**
+ * bql_prof_release: account the end of the current BQL hold
+ *
+ * Called with the BQL still held, right before it is released.  Holds
+ * longer than the configured threshold have their stack captured for
+ * the "long holds" report.
+ */
+void bql_prof_release(void);
+
+bool bql_prof_is_enabled(void);
+void bql_prof_enable(int64_t threshold_ns);
+void bql_prof_disable(void);
+void bql_prof_reset(void);
+
+#endif
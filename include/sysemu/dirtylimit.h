@@ -15,6 +15,7 @@
 #define DIRTYLIMIT_CALC_TIME_MS         1000    /* 1000ms */
 
 int64_t vcpu_dirty_rate_get(int cpu_index);
+bool vcpu_dirty_rate_stat_running(void);
 void vcpu_dirty_rate_stat_start(void);
 void vcpu_dirty_rate_stat_stop(void);
 void vcpu_dirty_rate_stat_initialize(void);
@@ -63,6 +63,8 @@ enum KVMDirtyRingReaperState {
 struct KVMDirtyRingReaper {
     /* The reaper thread */
     QemuThread reaper_thr;
+    /* Posted to cut the periodic sleep short when a ring is filling up */
+    QemuSemaphore reaper_sem;
     volatile uint64_t reaper_iteration; /* iteration number of reaper thr */
     volatile enum KVMDirtyRingReaperState reaper_state; /* reap thr state */
 };
@@ -0,0 +1,22 @@
+/*
+ * Targeted KSM advice from a background duplicate scan
+ *
+ * Copyright (c) 2026 the QEMU developers
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or
+ * (at your option) any later version.
+ */
+
+#ifndef SYSEMU_RAM_DEDUP_H
+#define SYSEMU_RAM_DEDUP_H
+
+/*
+ * Start the dedup advisor: a low-priority thread that scans guest RAM
+ * for stable duplicate page candidates and marks only those ranges
+ * MADV_MERGEABLE, instead of blanket-marking all guest RAM the way
+ * mem-merge=on does.  Idempotent; enabled with the machine property
+ * mem-merge-advisor=on.
+ */
+void ram_dedup_start(void);
+
+#endif /* SYSEMU_RAM_DEDUP_H */
@@ -55,4 +55,12 @@ void tcg_register_thread(void);
  */
 void tcg_prologue_init(void);
 
+/**
+ * tcg_numa_regions: when true, each code generation region is bound
+ * to the NUMA node of the thread that allocates it, so that generated
+ * code is fetched from node-local memory.  Only effective when QEMU
+ * is built with libnuma support; set before TCG threads register.
+ */
+extern bool tcg_numa_regions;
+
 #endif
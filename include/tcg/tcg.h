@@ -502,6 +502,18 @@ struct TCGContext {
     tcg_insn_unit *code_buf;      /* pointer for start of tb */
     tcg_insn_unit *code_ptr;      /* pointer for running end of tb */
 
+    /*
+     * Cross-TB constant specialization (two-tier-tb): the entry
+     * assumption to guard, set by the caller of tb_gen_code and
+     * consumed by translator_loop, and the global that the optimizer
+     * proved constant at each goto_tb exit of the current TB.
+     * A global temp index, or -1 for none.
+     */
+    int tb_entry_spec_reg;
+    uint64_t tb_entry_spec_val;
+    int tb_exit_spec_reg[2];
+    uint64_t tb_exit_spec_val[2];
+
 #ifdef CONFIG_DEBUG_TCG
     int goto_tb_issue_mask;
     const TCGOpcode *vecop_list;
@@ -519,6 +531,18 @@ struct TCGContext {
     /* Threshold to flush the translated code buffer.  */
     void *code_gen_highwater;
 
+    /*
+     * Translation cost counters, aggregated across contexts by
+     * tcg_dump_stats().  Each context is written only by its owning
+     * vCPU thread; updates are published with qatomic_set() so the
+     * monitor cannot observe torn 64-bit values.
+     */
+    uint64_t stat_tb_count;
+    uint64_t stat_guest_bytes;
+    uint64_t stat_host_bytes;
+    uint64_t stat_opt_ns;
+    uint64_t stat_gen_ns;
+
     /* Track which vCPU triggers events */
     CPUState *cpu;                      /* *_trans */
 
@@ -526,6 +550,21 @@ struct TCGContext {
 #ifdef TCG_TARGET_NEED_LDST_LABELS
     QSIMPLEQ_HEAD(, TCGLabelQemuLdst) ldst_labels;
 #endif
+#ifdef TCG_TARGET_NEED_PEEPHOLE
+    /*
+     * Emission-time peephole state.  A candidate is only acted upon
+     * while it is still adjacent to code_ptr.
+     */
+    struct {
+        tcg_insn_unit *ldst_prev; /* slot of a pairable load/store */
+        uint32_t ldst_insn;
+        int ldst_rt, ldst_rn;
+        intptr_t ldst_ofs;
+        tcg_insn_unit *cset_end;  /* end of a setcond emission */
+        int cset_rd;
+        int cset_cond;
+    } peep;
+#endif
 #ifdef TCG_TARGET_NEED_POOL_LABELS
     struct TCGLabelPoolData *pool_labels;
 #endif
@@ -794,6 +833,8 @@ void tcg_func_start(TCGContext *s);
 
 int tcg_gen_code(TCGContext *s, TranslationBlock *tb, uint64_t pc_start);
 
+void tcg_dump_stats(GString *buf);
+
 void tb_target_set_jmp_target(const TranslationBlock *, int,
                               uintptr_t, uintptr_t);
 
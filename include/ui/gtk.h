@@ -21,6 +21,7 @@
 #include "ui/clipboard.h"
 #include "ui/console.h"
 #include "ui/kbd-state.h"
+#include "ui/rect.h"
 #if defined(CONFIG_OPENGL)
 #include "ui/egl-helpers.h"
 #include "ui/egl-context.h"
@@ -48,6 +49,8 @@ typedef struct VirtualGfxConsole {
     EGLContext ectx;
     EGLSurface esurface;
     int glupdates;
+    /* Bounding box of the surface updates since the last texture upload */
+    QemuRect gldamage;
     int x, y, w, h;
     egl_fb guest_fb;
     egl_fb win_fb;
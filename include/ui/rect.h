@@ -29,6 +29,30 @@ static inline void qemu_rect_translate(QemuRect *rect,
     rect->y += dy;
 }
 
+static inline bool qemu_rect_is_empty(const QemuRect *rect)
+{
+    return rect->width == 0 || rect->height == 0;
+}
+
+static inline void qemu_rect_union(QemuRect *a, const QemuRect *b)
+{
+    int16_t x1, y1;
+
+    if (qemu_rect_is_empty(b)) {
+        return;
+    }
+    if (qemu_rect_is_empty(a)) {
+        *a = *b;
+        return;
+    }
+
+    x1 = MIN(a->x, b->x);
+    y1 = MIN(a->y, b->y);
+    qemu_rect_init(a, x1, y1,
+                   MAX(a->x + a->width, b->x + b->width) - x1,
+                   MAX(a->y + a->height, b->y + b->height) - y1);
+}
+
 static inline bool qemu_rect_intersect(const QemuRect *a, const QemuRect *b,
                                        QemuRect *res)
 {
@@ -24,6 +24,7 @@
 #include "io/channel-socket.h"
 #include "io/channel-util.h"
 #include "io/channel-watch.h"
+#include "io/dns-resolver.h"
 #include "trace.h"
 #include "qapi/clone-visitor.h"
 #ifdef CONFIG_LINUX
@@ -145,6 +146,52 @@ qio_channel_socket_new_fd(int fd,
 }
 
 
+/*
+ * Resolve @addr through the DNS resolver (and its lookup cache),
+ * then try to connect each returned address in turn. This keeps
+ * reconnect loops from querying a slow DNS server on every attempt.
+ */
+static int qio_channel_socket_connect_resolved(SocketAddress *addr,
+                                               Error **errp)
+{
+    QIODNSResolver *resolver = qio_dns_resolver_get_instance();
+    SocketAddress **addrs = NULL;
+    size_t naddrs = 0;
+    Error *err = NULL;
+    int fd = -1;
+    size_t i;
+
+    if (qio_dns_resolver_lookup_sync(resolver, addr, &naddrs,
+                                     &addrs, errp) < 0) {
+        return -1;
+    }
+
+    for (i = 0; i < naddrs; i++) {
+        error_free(err);
+        err = NULL;
+        if (addr->u.inet.has_keep_alive) {
+            addrs[i]->u.inet.has_keep_alive = true;
+            addrs[i]->u.inet.keep_alive = addr->u.inet.keep_alive;
+        }
+        fd = socket_connect(addrs[i], &err);
+        if (fd >= 0) {
+            break;
+        }
+    }
+
+    for (i = 0; i < naddrs; i++) {
+        qapi_free_SocketAddress(addrs[i]);
+    }
+    g_free(addrs);
+
+    if (fd < 0) {
+        error_propagate(errp, err);
+    } else {
+        error_free(err);
+    }
+    return fd;
+}
+
 int qio_channel_socket_connect_sync(QIOChannelSocket *ioc,
                                     SocketAddress *addr,
                                     Error **errp)
@@ -152,7 +199,12 @@ int qio_channel_socket_connect_sync(QIOChannelSocket *ioc,
     int fd;
 
     trace_qio_channel_socket_connect_sync(ioc, addr);
-    fd = socket_connect(addr, errp);
+    if (addr->type == SOCKET_ADDRESS_TYPE_INET &&
+        addr->u.inet.host && addr->u.inet.host[0]) {
+        fd = qio_channel_socket_connect_resolved(addr, errp);
+    } else {
+        fd = socket_connect(addr, errp);
+    }
     if (fd < 0) {
         trace_qio_channel_socket_connect_fail(ioc);
         return -1;
@@ -22,6 +22,7 @@
 #include "qapi/error.h"
 #include "qemu/module.h"
 #include "io/channel-tls.h"
+#include "io/channel-socket.h"
 #include "trace.h"
 #include "qemu/atomic.h"
 
@@ -63,6 +64,27 @@ static ssize_t qio_channel_tls_read_handler(char *buf,
 }
 
 
+static void qio_channel_tls_set_transport(QIOChannelTLS *tioc)
+{
+#ifdef __linux__
+    QIOChannelSocket *sioc = (QIOChannelSocket *)
+        object_dynamic_cast(OBJECT(tioc->master), TYPE_QIO_CHANNEL_SOCKET);
+
+    /*
+     * When the master channel is a plain socket, hand its file
+     * descriptor straight to gnutls instead of bouncing records
+     * through the read/write handlers. This lets gnutls install
+     * kernel TLS keys on the socket after the handshake when the
+     * kernel and negotiated cipher allow it, moving record
+     * encryption into sendmsg()/recvmsg() and enabling NIC offload.
+     * Channels with extra framing (e.g. websock) keep the handlers.
+     */
+    if (sioc && sioc->fd >= 0) {
+        qcrypto_tls_session_set_transport_fd(tioc->session, sioc->fd);
+    }
+#endif
+}
+
 QIOChannelTLS *
 qio_channel_tls_new_server(QIOChannel *master,
                            QCryptoTLSCreds *creds,
@@ -94,6 +116,7 @@ qio_channel_tls_new_server(QIOChannel *master,
         qio_channel_tls_write_handler,
         qio_channel_tls_read_handler,
         ioc);
+    qio_channel_tls_set_transport(ioc);
 
     trace_qio_channel_tls_new_server(ioc, master, creds, aclname);
     return ioc;
@@ -136,6 +159,7 @@ qio_channel_tls_new_client(QIOChannel *master,
         qio_channel_tls_write_handler,
         qio_channel_tls_read_handler,
         tioc);
+    qio_channel_tls_set_transport(tioc);
 
     trace_qio_channel_tls_new_client(tioc, master, creds, hostname);
     return tioc;
@@ -172,6 +196,8 @@ static void qio_channel_tls_handshake_task(QIOChannelTLS *ioc,
     status = qcrypto_tls_session_get_handshake_status(ioc->session);
     if (status == QCRYPTO_TLS_HANDSHAKE_COMPLETE) {
         trace_qio_channel_tls_handshake_complete(ioc);
+        trace_qio_channel_tls_ktls(
+            ioc, qcrypto_tls_session_get_ktls_enabled(ioc->session));
         if (qcrypto_tls_session_check_credentials(ioc->session,
                                                   &err) < 0) {
             trace_qio_channel_tls_credentials_deny(ioc);
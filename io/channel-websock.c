@@ -614,6 +614,8 @@ static void qio_channel_websock_encode(QIOChannelWebsock *ioc,
                                        size_t size)
 {
     size_t header_size;
+    size_t payload_size = size;
+    size_t frame_start;
     size_t i;
     union {
         char buf[QIO_CHANNEL_WEBSOCK_HEADER_LEN_64_BIT];
@@ -639,6 +641,7 @@ static void qio_channel_websock_encode(QIOChannelWebsock *ioc,
     header_size -= QIO_CHANNEL_WEBSOCK_HEADER_LEN_MASK;
 
     trace_qio_channel_websock_encode(ioc, opcode, header_size, size);
+    frame_start = ioc->encoutput.offset;
     buffer_reserve(&ioc->encoutput, header_size + size);
     buffer_append(&ioc->encoutput, header.buf, header_size);
     for (i = 0; i < niov && size != 0; i++) {
@@ -649,6 +652,74 @@ static void qio_channel_websock_encode(QIOChannelWebsock *ioc,
         buffer_append(&ioc->encoutput, iov[i].iov_base, want);
         size -= want;
     }
+
+    if (opcode == QIO_CHANNEL_WEBSOCK_OPCODE_BINARY_FRAME) {
+        /* The frame may be extended in place by later writes */
+        ioc->coalesce_header = frame_start;
+        ioc->coalesce_size = payload_size;
+        ioc->coalesce_end = ioc->encoutput.offset;
+    } else {
+        /* A control frame now trails the last data frame */
+        ioc->coalesce_end = 0;
+    }
+}
+
+
+/*
+ * Try to append @size bytes from @iov to the data frame at the tail of
+ * encoutput, patching its payload length, rather than paying a fresh
+ * frame header for every write. Only possible while the frame is still
+ * the last one queued, none of its header has hit the wire yet, and
+ * the enlarged payload still fits the header's length encoding.
+ */
+static gboolean qio_channel_websock_extend_frame(QIOChannelWebsock *ioc,
+                                                 const struct iovec *iov,
+                                                 size_t niov,
+                                                 size_t size)
+{
+    QIOChannelWebsockHeader *header;
+    size_t newsize = ioc->coalesce_size + size;
+    size_t i;
+
+    if (ioc->coalesce_end == 0 ||
+        ioc->coalesce_end != ioc->encoutput.offset) {
+        return FALSE;
+    }
+
+    if ((ioc->coalesce_size <
+         QIO_CHANNEL_WEBSOCK_PAYLOAD_LEN_THRESHOLD_7_BIT) !=
+        (newsize < QIO_CHANNEL_WEBSOCK_PAYLOAD_LEN_THRESHOLD_7_BIT) ||
+        (ioc->coalesce_size <
+         QIO_CHANNEL_WEBSOCK_PAYLOAD_LEN_THRESHOLD_16_BIT) !=
+        (newsize < QIO_CHANNEL_WEBSOCK_PAYLOAD_LEN_THRESHOLD_16_BIT)) {
+        return FALSE;
+    }
+
+    buffer_reserve(&ioc->encoutput, size);
+    for (i = 0; i < niov && size != 0; i++) {
+        size_t want = iov[i].iov_len;
+        if (want > size) {
+            want = size;
+        }
+        buffer_append(&ioc->encoutput, iov[i].iov_base, want);
+        size -= want;
+    }
+
+    header = (QIOChannelWebsockHeader *)
+        (ioc->encoutput.buffer + ioc->coalesce_header);
+    if (newsize < QIO_CHANNEL_WEBSOCK_PAYLOAD_LEN_THRESHOLD_7_BIT) {
+        header->b1 = (uint8_t)newsize;
+    } else if (newsize < QIO_CHANNEL_WEBSOCK_PAYLOAD_LEN_THRESHOLD_16_BIT) {
+        header->u.s16.l16 = cpu_to_be16((uint16_t)newsize);
+    } else {
+        header->u.s64.l64 = cpu_to_be64(newsize);
+    }
+
+    trace_qio_channel_websock_extend(ioc, newsize - ioc->coalesce_size,
+                                     newsize);
+    ioc->coalesce_size = newsize;
+    ioc->coalesce_end = ioc->encoutput.offset;
+    return TRUE;
 }
 
 
@@ -793,7 +864,8 @@ static int qio_channel_websock_decode_payload(QIOChannelWebsock *ioc,
 {
     size_t i;
     size_t payload_len = 0;
-    uint32_t *payload32;
+    uint64_t *payload64;
+    uint64_t mask64 = (uint64_t)ioc->mask.u << 32 | ioc->mask.u;
 
     if (ioc->payload_remain) {
         /* If we aren't at the end of the payload, then drop
@@ -817,13 +889,16 @@ static int qio_channel_websock_decode_payload(QIOChannelWebsock *ioc,
         ioc->payload_remain -= payload_len;
 
         /* unmask frame */
-        /* process 1 frame (32 bit op) */
-        payload32 = (uint32_t *)ioc->encinput.buffer;
-        for (i = 0; i < payload_len / 4; i++) {
-            payload32[i] ^= ioc->mask.u;
+        /*
+         * XOR with the mask broadcast into a 64 bit word; the
+         * compiler turns this into SIMD stores where available.
+         */
+        payload64 = (uint64_t *)ioc->encinput.buffer;
+        for (i = 0; i < payload_len / 8; i++) {
+            payload64[i] ^= mask64;
         }
         /* process the remaining bytes (if any) */
-        for (i *= 4; i < payload_len; i++) {
+        for (i *= 8; i < payload_len; i++) {
             ioc->encinput.buffer[i] ^= ioc->mask.c[i % 4];
         }
     }
@@ -998,6 +1073,15 @@ static ssize_t qio_channel_websock_write_wire(QIOChannelWebsock *ioc,
         } else {
             ioc->pong_remain -= ret;
         }
+        if (ioc->coalesce_end) {
+            if ((size_t)ret > ioc->coalesce_header) {
+                /* Part of the open frame's header hit the wire */
+                ioc->coalesce_end = 0;
+            } else {
+                ioc->coalesce_header -= ret;
+                ioc->coalesce_end -= ret;
+            }
+        }
     }
     return done;
 }
@@ -1153,9 +1237,11 @@ static ssize_t qio_channel_websock_writev(QIOChannel *ioc,
     }
 
     if (want) {
-        qio_channel_websock_encode(wioc,
-                                   QIO_CHANNEL_WEBSOCK_OPCODE_BINARY_FRAME,
-                                   iov, niov, want);
+        if (!qio_channel_websock_extend_frame(wioc, iov, niov, want)) {
+            qio_channel_websock_encode(wioc,
+                                       QIO_CHANNEL_WEBSOCK_OPCODE_BINARY_FRAME,
+                                       iov, niov, want);
+        }
     }
 
     /* Even if want == 0, we'll try write_wire in case there's
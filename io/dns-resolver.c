@@ -25,12 +25,121 @@
 #include "qemu/sockets.h"
 #include "qapi/error.h"
 #include "qemu/cutils.h"
+#include "qemu/lockable.h"
 #include "qemu/module.h"
+#include "qemu/profile.h"
+#include "qemu/timer.h"
 
 #ifndef AI_NUMERICSERV
 # define AI_NUMERICSERV 0
 #endif
 
+/* How long a successful lookup may be reused before re-querying DNS */
+#define QIO_DNS_RESOLVER_CACHE_TTL (30 * G_USEC_PER_SEC)
+
+/* Upper bound on distinct addresses kept in the cache */
+#define QIO_DNS_RESOLVER_CACHE_MAX 64
+
+static ProfileCounter qio_dns_resolver_cache_hits;
+static ProfileCounter qio_dns_resolver_cache_misses;
+static ProfileHistogram qio_dns_resolver_lookup_ns;
+
+typedef struct QIODNSResolverCacheEntry {
+    SocketAddress **addrs;
+    size_t naddrs;
+    gint64 expiry;
+} QIODNSResolverCacheEntry;
+
+static void qio_dns_resolver_cache_entry_free(gpointer opaque)
+{
+    QIODNSResolverCacheEntry *entry = opaque;
+    size_t i;
+
+    for (i = 0; i < entry->naddrs; i++) {
+        qapi_free_SocketAddress(entry->addrs[i]);
+    }
+    g_free(entry->addrs);
+    g_free(entry);
+}
+
+static char *qio_dns_resolver_cache_key(InetSocketAddress *iaddr)
+{
+    return g_strdup_printf("%s/%s/%d/%d/%d/%d",
+                           iaddr->host,
+                           iaddr->port ? iaddr->port : "",
+                           iaddr->has_to ? (int)iaddr->to : -1,
+                           iaddr->has_ipv4 ? iaddr->ipv4 : -1,
+                           iaddr->has_ipv6 ? iaddr->ipv6 : -1,
+#ifdef HAVE_IPPROTO_MPTCP
+                           iaddr->has_mptcp ? iaddr->mptcp : -1
+#else
+                           -1
+#endif
+                           );
+}
+
+static bool qio_dns_resolver_cache_lookup(QIODNSResolver *resolver,
+                                          const char *key,
+                                          size_t *naddrs,
+                                          SocketAddress ***addrs)
+{
+    QIODNSResolverCacheEntry *entry;
+    size_t i;
+
+    QEMU_LOCK_GUARD(&resolver->lock);
+    entry = g_hash_table_lookup(resolver->cache, key);
+    if (!entry || entry->expiry < g_get_monotonic_time()) {
+        return false;
+    }
+
+    *naddrs = entry->naddrs;
+    *addrs = g_new0(SocketAddress *, entry->naddrs);
+    for (i = 0; i < entry->naddrs; i++) {
+        (*addrs)[i] = QAPI_CLONE(SocketAddress, entry->addrs[i]);
+    }
+    return true;
+}
+
+static gboolean qio_dns_resolver_cache_expired(gpointer key,
+                                               gpointer value,
+                                               gpointer opaque)
+{
+    QIODNSResolverCacheEntry *entry = value;
+
+    return entry->expiry < *(gint64 *)opaque;
+}
+
+/* Takes ownership of @key; the addresses are copied */
+static void qio_dns_resolver_cache_store(QIODNSResolver *resolver,
+                                         char *key,
+                                         size_t naddrs,
+                                         SocketAddress **addrs)
+{
+    QIODNSResolverCacheEntry *entry;
+    gint64 now = g_get_monotonic_time();
+    size_t i;
+
+    QEMU_LOCK_GUARD(&resolver->lock);
+    if (g_hash_table_size(resolver->cache) >= QIO_DNS_RESOLVER_CACHE_MAX) {
+        g_hash_table_foreach_remove(resolver->cache,
+                                    qio_dns_resolver_cache_expired, &now);
+        if (g_hash_table_size(resolver->cache) >=
+            QIO_DNS_RESOLVER_CACHE_MAX) {
+            g_free(key);
+            return;
+        }
+    }
+
+    entry = g_new0(QIODNSResolverCacheEntry, 1);
+    entry->naddrs = naddrs;
+    entry->addrs = g_new0(SocketAddress *, naddrs);
+    for (i = 0; i < naddrs; i++) {
+        entry->addrs[i] = QAPI_CLONE(SocketAddress, addrs[i]);
+    }
+    entry->expiry = now + QIO_DNS_RESOLVER_CACHE_TTL;
+    g_hash_table_replace(resolver->cache, key, entry);
+}
+
 static QIODNSResolver *instance;
 static GOnce instance_init = G_ONCE_INIT;
 
@@ -57,6 +166,8 @@ static int qio_dns_resolver_lookup_sync_inet(QIODNSResolver *resolver,
     char port[33];
     char uaddr[INET6_ADDRSTRLEN + 1];
     char uport[33];
+    char *key = NULL;
+    int64_t lookup_start;
     int rc;
     Error *err = NULL;
     size_t i;
@@ -87,11 +198,29 @@ static int qio_dns_resolver_lookup_sync_inet(QIODNSResolver *resolver,
         port[0] = '\0';
     }
 
+    /*
+     * Numeric lookups don't touch DNS, so only host name lookups
+     * are worth caching.
+     */
+    if (!(ai.ai_flags & AI_NUMERICHOST)) {
+        key = qio_dns_resolver_cache_key(iaddr);
+        if (qio_dns_resolver_cache_lookup(resolver, key, naddrs, addrs)) {
+            profile_counter_inc(&qio_dns_resolver_cache_hits);
+            g_free(key);
+            return 0;
+        }
+        profile_counter_inc(&qio_dns_resolver_cache_misses);
+    }
+
+    lookup_start = get_clock();
     rc = getaddrinfo(strlen(iaddr->host) ? iaddr->host : NULL,
                      strlen(port) ? port : NULL, &ai, &res);
+    profile_histogram_record(&qio_dns_resolver_lookup_ns,
+                             get_clock() - lookup_start);
     if (rc != 0) {
         error_setg(errp, "address resolution failed for %s:%s: %s",
                    iaddr->host, port, gai_strerror(rc));
+        g_free(key);
         return -1;
     }
 
@@ -131,6 +260,10 @@ static int qio_dns_resolver_lookup_sync_inet(QIODNSResolver *resolver,
         (*addrs)[i] = newaddr;
     }
     freeaddrinfo(res);
+
+    if (key) {
+        qio_dns_resolver_cache_store(resolver, key, *naddrs, *addrs);
+    }
     return 0;
 }
 
@@ -267,10 +400,44 @@ void qio_dns_resolver_lookup_result(QIODNSResolver *resolver,
 }
 
 
+static void qio_dns_resolver_init(Object *obj)
+{
+    QIODNSResolver *resolver = QIO_DNS_RESOLVER(obj);
+
+    qemu_mutex_init(&resolver->lock);
+    resolver->cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                            qio_dns_resolver_cache_entry_free);
+}
+
+
+static void qio_dns_resolver_finalize(Object *obj)
+{
+    QIODNSResolver *resolver = QIO_DNS_RESOLVER(obj);
+
+    g_hash_table_unref(resolver->cache);
+    qemu_mutex_destroy(&resolver->lock);
+}
+
+
+static void qio_dns_resolver_class_init(ObjectClass *klass,
+                                        void *class_data)
+{
+    profile_counter_register(&qio_dns_resolver_cache_hits,
+                             "dns-cache-hits");
+    profile_counter_register(&qio_dns_resolver_cache_misses,
+                             "dns-cache-misses");
+    profile_histogram_register(&qio_dns_resolver_lookup_ns,
+                               "dns-lookup-ns");
+}
+
+
 static const TypeInfo qio_dns_resolver_info = {
     .parent = TYPE_OBJECT,
     .name = TYPE_QIO_DNS_RESOLVER,
     .instance_size = sizeof(QIODNSResolver),
+    .instance_init = qio_dns_resolver_init,
+    .instance_finalize = qio_dns_resolver_finalize,
+    .class_init = qio_dns_resolver_class_init,
 };
 
 
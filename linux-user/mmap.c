@@ -424,6 +424,36 @@ abi_ulong mmap_find_vma(abi_ulong start, abi_ulong size, abi_ulong align)
     prev = 0;
 
     for (;; prev = ptr) {
+        /*
+         * Skip ranges the guest already has mapped: they are backed by
+         * host mappings, so probing them below can only fail.  Stepping
+         * over them via the page table avoids one host mmap/munmap round
+         * trip per existing mapping, which dominates once the guest has
+         * accumulated many thousands of mappings.
+         */
+        if (addr > GUEST_ADDR_MAX || size - 1 > GUEST_ADDR_MAX - addr) {
+            addr = -1;
+        } else {
+            addr = page_find_range_empty(addr, GUEST_ADDR_MAX, size, align);
+        }
+        if (addr == (abi_ulong)-1) {
+            /*
+             * No free guest range above this point; wrap to low memory
+             * once, otherwise the address space is exhausted.
+             */
+            if (wrapped) {
+                return (abi_ulong)-1;
+            }
+            wrapped = 1;
+            addr = (mmap_min_addr > TARGET_PAGE_SIZE
+                    ? TARGET_PAGE_ALIGN(mmap_min_addr)
+                    : TARGET_PAGE_SIZE);
+            addr = page_find_range_empty(addr, GUEST_ADDR_MAX, size, align);
+            if (addr == (abi_ulong)-1) {
+                return (abi_ulong)-1;
+            }
+        }
+
         /*
          * Reserve needed memory area to avoid a race.
          * It should be discarded using:
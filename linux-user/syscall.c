@@ -7755,6 +7755,12 @@ static int do_safe_futex(int *uaddr, int op, int val,
    tricky.  However they're probably useless because guest atomic
    operations won't work either.  */
 #if defined(TARGET_NR_futex) || defined(TARGET_NR_futex_time64)
+/*
+ * Note that g2h() is a constant-offset translation, so every guest futex
+ * word directly aliases the host futex word backing it and each guest
+ * operation maps onto a single host futex syscall: there is no per-call
+ * lookup whose result could usefully be cached.
+ */
 static int do_futex(CPUState *cpu, bool time64, target_ulong uaddr,
                     int op, int val, target_ulong timeout,
                     target_ulong uaddr2, int val3)
@@ -13249,6 +13255,7 @@ static abi_long do_syscall1(CPUArchState *cpu_env, int num, abi_long arg1,
 #endif
     {
         struct target_epoll_event *target_ep;
+        struct epoll_event stack_ep[64];
         struct epoll_event *ep;
         int epfd = arg1;
         int maxevents = arg3;
@@ -13264,10 +13271,18 @@ static abi_long do_syscall1(CPUArchState *cpu_env, int num, abi_long arg1,
             return -TARGET_EFAULT;
         }
 
-        ep = g_try_new(struct epoll_event, maxevents);
-        if (!ep) {
-            unlock_user(target_ep, arg2, 0);
-            return -TARGET_ENOMEM;
+        /*
+         * Event loops call this on every wakeup; don't pay for a heap
+         * allocation each time unless maxevents is unusually large.
+         */
+        if (maxevents <= ARRAY_SIZE(stack_ep)) {
+            ep = stack_ep;
+        } else {
+            ep = g_try_new(struct epoll_event, maxevents);
+            if (!ep) {
+                unlock_user(target_ep, arg2, 0);
+                return -TARGET_ENOMEM;
+            }
         }
 
         switch (num) {
@@ -13312,7 +13327,9 @@ static abi_long do_syscall1(CPUArchState *cpu_env, int num, abi_long arg1,
         } else {
             unlock_user(target_ep, arg2, 0);
         }
-        g_free(ep);
+        if (ep != stack_ep) {
+            g_free(ep);
+        }
         return ret;
     }
 #endif
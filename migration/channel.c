@@ -18,6 +18,7 @@
 #include "trace.h"
 #include "qapi/error.h"
 #include "io/channel-tls.h"
+#include "options.h"
 #include "io/channel-socket.h"
 #include "qemu/yank.h"
 #include "yank_functions.h"
@@ -82,6 +83,12 @@ void migration_channel_connect(MigrationState *s,
         } else {
             QEMUFile *f = qemu_file_new_output(ioc);
 
+            if (migrate_zero_copy_send() &&
+                qio_channel_has_feature(ioc,
+                                        QIO_CHANNEL_FEATURE_WRITE_ZERO_COPY)) {
+                qemu_file_set_zero_copy(f);
+            }
+
             migration_ioc_register_yank(ioc);
 
             qemu_mutex_lock(&s->qemu_file_lock);
@@ -56,6 +56,18 @@ bool file_send_channel_create(gpointer opaque, Error **errp)
     int flags = O_WRONLY;
     bool ret = true;
 
+#ifdef O_DIRECT
+    /*
+     * Only the secondary channels write guest pages, and with
+     * mapped-ram those writes are page-aligned at file offsets derived
+     * from the RAMBlock offsets, so O_DIRECT is safe here.  The main
+     * channel keeps buffered I/O for the unaligned stream metadata.
+     */
+    if (migrate_direct_io()) {
+        flags |= O_DIRECT;
+    }
+#endif
+
     ioc = qio_channel_file_new_path(outgoing_args.fname, flags, 0, errp);
     if (!ioc) {
         ret = false;
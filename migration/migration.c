@@ -1135,6 +1135,9 @@ static void populate_time_info(MigrationInfo *info, MigrationState *s)
     if (migrate_show_downtime(s)) {
         info->has_downtime = true;
         info->downtime = s->downtime;
+        if (s->state == MIGRATION_STATUS_COMPLETED) {
+            info->downtime_breakdown = qemu_savevm_downtime_breakdown();
+        }
     } else {
         info->has_expected_downtime = true;
         info->expected_downtime = s->expected_downtime;
@@ -3258,6 +3261,16 @@ static void migration_iteration_finish(MigrationState *s)
     /* If we enabled cpu throttling for auto-converge, turn it off. */
     cpu_throttle_stop();
 
+    /*
+     * Stop the per-vCPU dirty rate collection if auto-converge started
+     * it; when a vcpu-dirty-limit is in service the stats belong to
+     * dirtylimit_cleanup() instead.
+     */
+    if (vcpu_dirty_rate_stat_running() && !dirtylimit_in_service()) {
+        vcpu_dirty_rate_stat_stop();
+        vcpu_dirty_rate_stat_finalize();
+    }
+
     bql_lock();
     switch (s->state) {
     case MIGRATION_STATUS_COMPLETED:
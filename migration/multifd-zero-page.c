@@ -56,6 +56,37 @@ void multifd_send_zero_page_detect(MultiFDSendParams *p)
         return;
     }
 
+    /*
+     * Batches are filled from a linear bitmap scan, so the offsets very
+     * often form one contiguous run.  Scanning that run as a single
+     * buffer classifies every page at once: the vector loop in
+     * buffer_is_zero() then streams at memory bandwidth instead of
+     * restarting (and re-probing head and tail bytes) once per page.
+     * Mostly-idle guests take this path with fully-zero batches almost
+     * every time.  If any byte is set, fall through to the per-page
+     * scan to find which pages are zero.
+     */
+    if (pages->num > 1) {
+        bool contiguous = true;
+
+        for (i = 1; i < pages->num; i++) {
+            if (pages->offset[i] != pages->offset[0] + (uint64_t)i * p->page_size) {
+                contiguous = false;
+                break;
+            }
+        }
+        if (contiguous &&
+            buffer_is_zero(rb->host + pages->offset[0],
+                           (size_t)pages->num * p->page_size)) {
+            for (i = 0; i < pages->num; i++) {
+                ram_release_page(rb->idstr, pages->offset[i]);
+            }
+            pages->normal_num = 0;
+            return;
+        }
+        i = 0;
+    }
+
     /*
      * Sort the page offset array by moving all normal pages to
      * the left and all zero pages to the right of the array.
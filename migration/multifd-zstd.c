@@ -13,6 +13,7 @@
 #include "qemu/osdep.h"
 #include <zstd.h>
 #include "qemu/rcu.h"
+#include "qemu/timer.h"
 #include "exec/ramblock.h"
 #include "exec/target_page.h"
 #include "qapi/error.h"
@@ -33,8 +34,23 @@ struct zstd_data {
     uint8_t *zbuff;
     /* size of compressed buffer */
     uint32_t zbuff_len;
+    /* current compression level of this channel */
+    int level;
+    /* end the current frame so a new level can take effect */
+    bool restart_frame;
+    /* time spent inside the compressor since the last adjustment */
+    int64_t busy_ns;
+    /* time spent writing or waiting for work since the last adjustment */
+    int64_t idle_ns;
+    /* when the previous packet finished compressing */
+    int64_t last_end_ns;
+    /* packets compressed since the last adjustment */
+    uint32_t packets;
 };
 
+/* Reconsider the per-channel compression level after this many packets */
+#define ZSTD_TUNE_PACKETS 64
+
 /* Multifd zstd compression */
 
 /**
@@ -60,7 +76,8 @@ static int zstd_send_setup(MultiFDSendParams *p, Error **errp)
         return -1;
     }
 
-    res = ZSTD_initCStream(z->zcs, migrate_multifd_zstd_level());
+    z->level = migrate_multifd_zstd_level();
+    res = ZSTD_initCStream(z->zcs, z->level);
     if (ZSTD_isError(res)) {
         ZSTD_freeCStream(z->zcs);
         g_free(z);
@@ -100,6 +117,41 @@ static void zstd_send_cleanup(MultiFDSendParams *p, Error **errp)
     p->compress_data = NULL;
 }
 
+/**
+ * zstd_send_tune: adapt the compression level to the channel
+ *
+ * The send thread alternates between compressing a packet and writing
+ * it out.  When the compressor dominates, it is the bottleneck and a
+ * cheaper level moves more pages per second; when the write side
+ * dominates, the link is saturated and the spare CPU is better spent
+ * on a higher ratio.  Move one level at a time, with hysteresis, to
+ * avoid flip-flopping.
+ *
+ * @p: Params for the channel that we are using
+ */
+static void zstd_send_tune(MultiFDSendParams *p)
+{
+    struct zstd_data *z = p->compress_data;
+    int level = z->level;
+
+    if (z->busy_ns > 2 * z->idle_ns) {
+        level--;
+    } else if (4 * z->busy_ns < z->idle_ns) {
+        level++;
+    }
+    level = CLAMP(level, 1, 20);
+
+    if (level != z->level) {
+        z->level = level;
+        /* The new level can only take effect on a new frame */
+        z->restart_frame = true;
+        trace_multifd_zstd_level(p->id, level);
+    }
+    z->busy_ns = 0;
+    z->idle_ns = 0;
+    z->packets = 0;
+}
+
 /**
  * zstd_send_prepare: prepare date to be able to send
  *
@@ -115,6 +167,7 @@ static int zstd_send_prepare(MultiFDSendParams *p, Error **errp)
 {
     MultiFDPages_t *pages = p->pages;
     struct zstd_data *z = p->compress_data;
+    int64_t start_ns;
     int ret;
     uint32_t i;
 
@@ -122,6 +175,11 @@ static int zstd_send_prepare(MultiFDSendParams *p, Error **errp)
         goto out;
     }
 
+    start_ns = qemu_clock_get_ns(QEMU_CLOCK_REALTIME);
+    if (z->last_end_ns) {
+        z->idle_ns += start_ns - z->last_end_ns;
+    }
+
     z->out.dst = z->zbuff;
     z->out.size = z->zbuff_len;
     z->out.pos = 0;
@@ -130,7 +188,13 @@ static int zstd_send_prepare(MultiFDSendParams *p, Error **errp)
         ZSTD_EndDirective flush = ZSTD_e_continue;
 
         if (i == pages->normal_num - 1) {
-            flush = ZSTD_e_flush;
+            /*
+             * Ending the frame costs the window built up so far, so
+             * only do it when a level change needs to take effect.
+             * The receiving side copes with frame boundaries as long
+             * as they coincide with packet boundaries.
+             */
+            flush = z->restart_frame ? ZSTD_e_end : ZSTD_e_flush;
         }
         z->in.src = p->pages->block->host + pages->offset[i];
         z->in.size = p->page_size;
@@ -159,6 +223,24 @@ static int zstd_send_prepare(MultiFDSendParams *p, Error **errp)
             return -1;
         }
     }
+
+    if (z->restart_frame) {
+        ret = ZSTD_CCtx_setParameter(z->zcs, ZSTD_c_compressionLevel,
+                                     z->level);
+        if (ZSTD_isError(ret)) {
+            error_setg(errp, "multifd %u: setting level %d failed with %s",
+                       p->id, z->level, ZSTD_getErrorName(ret));
+            return -1;
+        }
+        z->restart_frame = false;
+    }
+
+    z->last_end_ns = qemu_clock_get_ns(QEMU_CLOCK_REALTIME);
+    z->busy_ns += z->last_end_ns - start_ns;
+    if (++z->packets >= ZSTD_TUNE_PACKETS) {
+        zstd_send_tune(p);
+    }
+
     p->iov[p->iovs_num].iov_base = z->zbuff;
     p->iov[p->iovs_num].iov_len = z->out.pos;
     p->iovs_num++;
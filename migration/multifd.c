@@ -33,6 +33,11 @@
 #include "io/channel-socket.h"
 #include "yank_functions.h"
 
+#ifdef CONFIG_NUMA
+#include <numa.h>
+#include <numaif.h>
+#endif
+
 /* Multiple fd's */
 
 #define MULTIFD_MAGIC 0x11223344U
@@ -554,6 +559,33 @@ static void multifd_send_kick_main(MultiFDSendParams *p)
     qemu_sem_post(&multifd_send_state->channels_ready);
 }
 
+/*
+ * Return the host NUMA node backing the first page of @pages, or -1 if
+ * it cannot be determined or the host only has one node.  One batch
+ * covers a contiguous guest range, so its pages almost always live on
+ * the same node and the first page is representative.
+ */
+static int multifd_pages_numa_node(MultiFDPages_t *pages)
+{
+#ifdef CONFIG_NUMA
+    void *addr;
+    int node = -1;
+
+    if (numa_available() < 0 || numa_max_node() == 0 ||
+        !pages->num || !pages->block->host) {
+        return -1;
+    }
+
+    addr = pages->block->host + pages->offset[0];
+    if (numa_move_pages(0, 1, &addr, NULL, &node, 0) < 0) {
+        return -1;
+    }
+    return node;
+#else
+    return -1;
+#endif
+}
+
 /*
  * How we use multifd_send_state->pages and channel->pages?
  *
@@ -579,6 +611,8 @@ static bool multifd_send_pages(void)
     static int next_channel;
     MultiFDSendParams *p = NULL; /* make happy gcc */
     MultiFDPages_t *pages = multifd_send_state->pages;
+    int node = multifd_pages_numa_node(pages);
+    int scanned = 0;
 
     if (multifd_send_should_exit()) {
         return false;
@@ -601,11 +635,20 @@ static bool multifd_send_pages(void)
         /*
          * Lockless read to p->pending_job is safe, because only multifd
          * sender thread can clear it.
+         *
+         * Prefer a free channel whose thread runs on the node backing
+         * these pages, so the packet is assembled without cross-node
+         * copies.  Once all channels have been scanned without a node
+         * match, take any free channel rather than stalling the
+         * migration thread.
          */
-        if (qatomic_read(&p->pending_job) == false) {
+        if (qatomic_read(&p->pending_job) == false &&
+            (node < 0 || p->numa_node == node ||
+             scanned >= migrate_multifd_channels())) {
             next_channel = (i + 1) % migrate_multifd_channels();
             break;
         }
+        scanned++;
     }
 
     /*
@@ -910,6 +953,17 @@ static void *multifd_send_thread(void *opaque)
     trace_multifd_send_thread_start(p->id);
     rcu_register_thread();
 
+#ifdef CONFIG_NUMA
+    /*
+     * Keep this thread on its assigned node so that packet assembly
+     * reads guest pages over the local memory controller.  Best effort:
+     * channel selection falls back to any free channel anyway.
+     */
+    if (p->numa_node >= 0) {
+        numa_run_on_node(p->numa_node);
+    }
+#endif
+
     if (use_packets) {
         if (multifd_send_initial_packet(p, &local_err) < 0) {
             ret = -1;
@@ -1187,6 +1241,13 @@ bool multifd_send_setup(void)
         p->name = g_strdup_printf("multifdsend_%d", i);
         p->page_size = qemu_target_page_size();
         p->page_count = page_count;
+        p->numa_node = -1;
+#ifdef CONFIG_NUMA
+        /* Spread the channels across the host nodes backing guest RAM */
+        if (numa_available() >= 0 && numa_max_node() > 0) {
+            p->numa_node = i % (numa_max_node() + 1);
+        }
+#endif
         p->write_flags = 0;
 
         if (!multifd_new_send_channel_create(p, &local_err)) {
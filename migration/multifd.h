@@ -108,6 +108,8 @@ typedef struct {
     uint32_t page_size;
     /* number of pages in a full packet */
     uint32_t page_count;
+    /* host NUMA node this channel's thread is bound to, or -1 */
+    int numa_node;
     /* multifd flags for sending ram */
     int write_flags;
 
@@ -69,6 +69,7 @@ bool migrate_has_block_bitmap_mapping(void);
 
 bool migrate_block_incremental(void);
 uint32_t migrate_checkpoint_delay(void);
+bool migrate_direct_io(void);
 int migrate_compress_level(void);
 int migrate_compress_threads(void);
 int migrate_compress_wait_thread(void);
@@ -23,12 +23,17 @@
 /* the page in cache will not be replaced in two cycles */
 #define CACHED_PAGE_LIFETIME 2
 
+/* evict a page after this many consecutive poor encodings */
+#define CACHED_PAGE_MAX_BAD_ENCODINGS 3
+
 typedef struct CacheItem CacheItem;
 
 struct CacheItem {
     uint64_t it_addr;
     uint64_t it_age;
     uint8_t *it_data;
+    /* consecutive encodings against this page that didn't pay off */
+    uint8_t it_bad_encodings;
 };
 
 struct PageCache {
@@ -82,6 +87,7 @@ PageCache *cache_init(uint64_t new_size, size_t page_size, Error **errp)
         cache->page_cache[i].it_data = NULL;
         cache->page_cache[i].it_age = 0;
         cache->page_cache[i].it_addr = -1;
+        cache->page_cache[i].it_bad_encodings = 0;
     }
 
     return cache;
@@ -169,7 +175,37 @@ int cache_insert(PageCache *cache, uint64_t addr, const uint8_t *pdata,
     memcpy(it->it_data, pdata, cache->page_size);
 
     it->it_age = current_age;
-    it->it_addr = addr;
+    if (it->it_addr != addr) {
+        it->it_addr = addr;
+        it->it_bad_encodings = 0;
+    }
 
     return 0;
 }
+
+void cache_record_encoding(PageCache *cache, uint64_t addr, bool good)
+{
+    CacheItem *it;
+
+    it = cache_get_by_addr(cache, addr);
+
+    if (it->it_addr != addr) {
+        return;
+    }
+
+    if (good) {
+        it->it_bad_encodings = 0;
+    } else if (++it->it_bad_encodings >= CACHED_PAGE_MAX_BAD_ENCODINGS) {
+        /*
+         * The page keeps changing too much between syncs for delta
+         * encoding to pay off.  Drop it so the slot can immediately be
+         * taken by another page (the cache is direct-mapped, so a
+         * churning page otherwise keeps colliding pages out for
+         * CACHED_PAGE_LIFETIME cycles).  The data buffer is kept for
+         * reuse by the next insertion.
+         */
+        it->it_addr = -1;
+        it->it_age = 0;
+        it->it_bad_encodings = 0;
+    }
+}
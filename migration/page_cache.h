@@ -71,4 +71,15 @@ uint8_t *get_cached_data(const PageCache *cache, uint64_t addr);
 int cache_insert(PageCache *cache, uint64_t addr, const uint8_t *pdata,
                  uint64_t current_age);
 
+/**
+ * cache_record_encoding: report how well delta encoding against the
+ * cached copy of a page worked.  Pages that repeatedly encode poorly
+ * are evicted so their slot becomes available to other pages.
+ *
+ * @cache pointer to the PageCache struct
+ * @addr: page address
+ * @good: whether the encoding was worth sending
+ */
+void cache_record_encoding(PageCache *cache, uint64_t addr, bool good);
+
 #endif
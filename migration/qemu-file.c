@@ -23,6 +23,7 @@
  */
 #include "qemu/osdep.h"
 #include <zlib.h>
+#include "qemu/compress.h"
 #include "qemu/madvise.h"
 #include "qemu/error-report.h"
 #include "qemu/iov.h"
@@ -41,6 +42,8 @@
 struct QEMUFile {
     QIOChannel *ioc;
     bool is_writable;
+    /* Send guest RAM iovecs with MSG_ZEROCOPY, see qemu_file_set_zero_copy() */
+    bool zero_copy;
 
     int buf_index;
     int buf_size; /* 0 when writing */
@@ -133,6 +136,14 @@ QEMUFile *qemu_file_new_input(QIOChannel *ioc)
     return qemu_file_new_impl(ioc, false);
 }
 
+void qemu_file_set_zero_copy(QEMUFile *f)
+{
+    assert(f->is_writable);
+    assert(qio_channel_has_feature(f->ioc,
+                                   QIO_CHANNEL_FEATURE_WRITE_ZERO_COPY));
+    f->zero_copy = true;
+}
+
 /*
  * Get last error for stream f with optional Error*
  *
@@ -270,6 +281,23 @@ bool qemu_file_is_seekable(QEMUFile *f)
  * This will flush all pending data. If data was only partially flushed, it
  * will set an error state.
  */
+/*
+ * Whether iovec @i may be handed to the kernel with MSG_ZEROCOPY.  The
+ * kernel keeps referencing the memory until transmission completes, so
+ * this is only safe for buffers whose storage outlives the flush:
+ * guest RAM queued with qemu_put_buffer_async() qualifies, while
+ * f->buf is recycled as soon as we return and may_free buffers are
+ * released right after the flush, so both must go through the normal
+ * copying path.
+ */
+static bool iov_can_zero_copy(QEMUFile *f, unsigned int i)
+{
+    const uint8_t *base = f->iov[i].iov_base;
+
+    return !test_bit(i, f->may_free) &&
+           (base < f->buf || base >= f->buf + IO_BUF_SIZE);
+}
+
 int qemu_fflush(QEMUFile *f)
 {
     if (!qemu_file_is_writable(f)) {
@@ -281,12 +309,37 @@ int qemu_fflush(QEMUFile *f)
     }
     if (f->iovcnt > 0) {
         Error *local_error = NULL;
-        if (qio_channel_writev_all(f->ioc,
-                                   f->iov, f->iovcnt,
-                                   &local_error) < 0) {
+        uint64_t size = iov_size(f->iov, f->iovcnt);
+        ssize_t ret = 0;
+
+        if (f->zero_copy) {
+            /*
+             * Split the flush into runs of iovecs that can and cannot
+             * be sent zero-copy; the stream content is unchanged.
+             */
+            unsigned int i = 0;
+
+            while (i < f->iovcnt && ret >= 0) {
+                bool zero_copy = iov_can_zero_copy(f, i);
+                unsigned int j = i + 1;
+
+                while (j < f->iovcnt && iov_can_zero_copy(f, j) == zero_copy) {
+                    j++;
+                }
+                ret = qio_channel_writev_full_all(f->ioc, &f->iov[i], j - i,
+                                                  NULL, 0,
+                                                  zero_copy ?
+                                                  QIO_CHANNEL_WRITE_FLAG_ZERO_COPY : 0,
+                                                  &local_error);
+                i = j;
+            }
+        } else {
+            ret = qio_channel_writev_all(f->ioc, f->iov, f->iovcnt,
+                                         &local_error);
+        }
+        if (ret < 0) {
             qemu_file_set_error_obj(f, -EIO, local_error);
         } else {
-            uint64_t size = iov_size(f->iov, f->iovcnt);
             stat64_add(&mig_stats.qemu_file_transferred, size);
         }
 
@@ -363,7 +416,18 @@ static ssize_t coroutine_mixed_fn qemu_fill_buffer(QEMUFile *f)
 int qemu_fclose(QEMUFile *f)
 {
     int ret = qemu_fflush(f);
-    int ret2 = qio_channel_close(f->ioc, NULL);
+    int ret2;
+
+    if (f->zero_copy && ret >= 0) {
+        Error *local_err = NULL;
+
+        /* Wait until the kernel is done with all zero-copy sends */
+        if (qio_channel_flush(f->ioc, &local_err) < 0) {
+            error_report_err(local_err);
+            ret = -EIO;
+        }
+    }
+    ret2 = qio_channel_close(f->ioc, NULL);
     if (ret >= 0) {
         ret = ret2;
     }
@@ -817,8 +881,21 @@ ssize_t qemu_put_compression_data(QEMUFile *f, z_stream *stream,
         return -1;
     }
 
-    blen = qemu_compress_data(stream, f->buf + f->buf_index + sizeof(int32_t),
-                              blen, p, size);
+    if (qemu_compress_accelerated(QEMU_COMPRESS_FMT_ZLIB)) {
+        /*
+         * Each page is an independent deflate stream (@stream is reset
+         * per page), so offloading a one-shot compression produces
+         * wire-compatible output.
+         */
+        blen = qemu_compress_one(QEMU_COMPRESS_FMT_ZLIB,
+                                 migrate_compress_level(), 0,
+                                 f->buf + f->buf_index + sizeof(int32_t),
+                                 blen, p, size);
+    } else {
+        blen = qemu_compress_data(stream,
+                                  f->buf + f->buf_index + sizeof(int32_t),
+                                  blen, p, size);
+    }
     if (blen < 0) {
         return -1;
     }
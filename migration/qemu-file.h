@@ -33,6 +33,17 @@ QEMUFile *qemu_file_new_input(QIOChannel *ioc);
 QEMUFile *qemu_file_new_output(QIOChannel *ioc);
 int qemu_fclose(QEMUFile *f);
 
+/*
+ * qemu_file_set_zero_copy:
+ *
+ * Send buffers queued with qemu_put_buffer_async() using MSG_ZEROCOPY.
+ * Only valid on output files whose channel advertises
+ * QIO_CHANNEL_FEATURE_WRITE_ZERO_COPY.  Internal stream buffers keep
+ * using the regular copying path, since their storage doesn't outlive
+ * the flush.
+ */
+void qemu_file_set_zero_copy(QEMUFile *f);
+
 /*
  * qemu_file_transferred:
  *
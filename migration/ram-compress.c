@@ -27,6 +27,7 @@
  */
 
 #include "qemu/osdep.h"
+#include "qemu/compress.h"
 #include "qemu/cutils.h"
 
 #include "ram-compress.h"
@@ -327,6 +328,12 @@ qemu_uncompress_data(z_stream *stream, uint8_t *dest, size_t dest_len,
 {
     int err;
 
+    if (qemu_compress_accelerated(QEMU_COMPRESS_FMT_ZLIB)) {
+        /* every page is an independent deflate stream */
+        return qemu_decompress_one(QEMU_COMPRESS_FMT_ZLIB, 0,
+                                   dest, dest_len, source, source_len);
+    }
+
     err = inflateReset(stream);
     if (err != Z_OK) {
         return -1;
@@ -401,6 +401,16 @@ struct RAMState {
     QemuMutex bitmap_mutex;
     /* The RAMBlock used in the last src_page_requests */
     RAMBlock *last_req_rb;
+    /*
+     * Postcopy fault-pattern state: offset and stride of the most
+     * recent page requests in last_req_rb, and how many times in a row
+     * that stride repeated.  Used to queue predicted-next pages ahead
+     * of the faulting vCPU.
+     */
+    RAMBlock *last_fault_rb;
+    ram_addr_t last_fault_offset;
+    int64_t last_fault_stride;
+    unsigned int fault_stride_hits;
     /* Queue of outstanding page requests from the destination */
     QemuMutex src_page_req_mutex;
     QSIMPLEQ_HEAD(, RAMSrcPageRequest) src_page_requests;
@@ -548,6 +558,17 @@ static void mig_throttle_guest_down(uint64_t bytes_dirty_period,
 
     /* We have not started throttling yet. Let's start it. */
     if (!cpu_throttle_active()) {
+        /*
+         * With the KVM dirty ring we know which vCPUs are dirtying
+         * memory; collect per-vCPU rates so the throttle timer can
+         * spare the vCPUs that aren't.  The stats thread may already
+         * be up if a vcpu-dirty-limit is in service.
+         */
+        if (kvm_enabled() && kvm_dirty_ring_enabled() &&
+            !vcpu_dirty_rate_stat_running()) {
+            vcpu_dirty_rate_stat_initialize();
+            vcpu_dirty_rate_stat_start();
+        }
         cpu_throttle_set(pct_initial);
     } else {
         /* Throttling already on, just increase the rate */
@@ -676,9 +697,12 @@ static int save_xbzrle_page(RAMState *rs, PageSearchStatus *pss,
         trace_save_xbzrle_page_overflow();
         xbzrle_counters.overflow++;
         xbzrle_counters.bytes += TARGET_PAGE_SIZE;
+        cache_record_encoding(XBZRLE.cache, current_addr, false);
         return -1;
     }
 
+    cache_record_encoding(XBZRLE.cache, current_addr, true);
+
     /* Send XBZRLE based compressed page */
     bytes_xbzrle = save_page_header(pss, pss->pss_channel, block,
                                     offset | RAM_SAVE_FLAG_XBZRLE);
@@ -1933,6 +1957,68 @@ static void migration_page_queue_free(RAMState *rs)
  * @start: starting address from the start of the RAMBlock
  * @len: length (in bytes) to send
  */
+/* Number of consecutive identical strides before we start predicting */
+#define POSTCOPY_PREFETCH_MIN_HITS 2
+/* How many predicted requests to queue per incoming fault */
+#define POSTCOPY_PREFETCH_DEPTH 2
+
+/*
+ * Track the stride between consecutive page requests from the
+ * destination and, once it has repeated a few times, queue the pages
+ * the faulting vCPU is predicted to touch next.  The predictions go
+ * through the normal request queue, so get_queued_page() sends them
+ * ahead of the linear background stream and quietly drops any that
+ * were already sent.  Mispredictions therefore cost nothing but a
+ * little queue traffic.
+ *
+ * Called with the iothread unlocked but only from the return path
+ * thread, so the pattern-tracking fields need no locking.
+ */
+static void postcopy_prefetch_queue(RAMState *rs, RAMBlock *ramblock,
+                                    ram_addr_t start, ram_addr_t len)
+{
+    int64_t stride = (int64_t)start - (int64_t)rs->last_fault_offset;
+    ram_addr_t predicted;
+    int i;
+
+    if (ramblock != rs->last_fault_rb || stride == 0) {
+        rs->fault_stride_hits = 0;
+    } else if (stride == rs->last_fault_stride) {
+        rs->fault_stride_hits++;
+    } else {
+        rs->fault_stride_hits = 1;
+    }
+    rs->last_fault_rb = ramblock;
+    rs->last_fault_offset = start;
+    rs->last_fault_stride = stride;
+
+    if (rs->fault_stride_hits < POSTCOPY_PREFETCH_MIN_HITS) {
+        return;
+    }
+
+    predicted = start;
+    for (i = 0; i < POSTCOPY_PREFETCH_DEPTH; i++) {
+        struct RAMSrcPageRequest *new_entry;
+
+        predicted += stride;
+        if (!offset_in_ramblock(ramblock, predicted + len - 1)) {
+            break;
+        }
+
+        trace_postcopy_prefetch_queue(ramblock->idstr, predicted, len);
+
+        new_entry = g_new0(struct RAMSrcPageRequest, 1);
+        new_entry->rb = ramblock;
+        new_entry->offset = predicted;
+        new_entry->len = len;
+
+        memory_region_ref(ramblock->mr);
+        qemu_mutex_lock(&rs->src_page_req_mutex);
+        QSIMPLEQ_INSERT_TAIL(&rs->src_page_requests, new_entry, next_req);
+        qemu_mutex_unlock(&rs->src_page_req_mutex);
+    }
+}
+
 int ram_save_queue_pages(const char *rbname, ram_addr_t start, ram_addr_t len,
                          Error **errp)
 {
@@ -2020,6 +2106,9 @@ int ram_save_queue_pages(const char *rbname, ram_addr_t start, ram_addr_t len,
         };
         qemu_mutex_unlock(&rs->bitmap_mutex);
 
+        if (!ret) {
+            postcopy_prefetch_queue(rs, ramblock, start, page_size);
+        }
         return ret;
     }
 
@@ -2035,6 +2124,8 @@ int ram_save_queue_pages(const char *rbname, ram_addr_t start, ram_addr_t len,
     migration_make_urgent_request();
     qemu_mutex_unlock(&rs->src_page_req_mutex);
 
+    postcopy_prefetch_queue(rs, ramblock, start, len);
+
     return 0;
 }
 
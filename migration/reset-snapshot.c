@@ -0,0 +1,256 @@
+/*
+ * Fast reset through an in-memory snapshot
+ *
+ * Guests that reboot very often pay for a full machine reset and another
+ * firmware boot every time.  x-reset-snapshot-save captures the device
+ * state (into a memory buffer, like COLO does for checkpoints) and a
+ * baseline copy of RAM; subsequent reboots restore that state instead of
+ * resetting the machine, rewriting only the RAM pages the guest dirtied
+ * since the snapshot was taken.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/error-report.h"
+#include "qemu/rcu.h"
+#include "qapi/error.h"
+#include "qapi/qapi-commands-machine.h"
+#include "qapi/qapi-events-run-state.h"
+#include "io/channel-buffer.h"
+#include "exec/ram_addr.h"
+#include "exec/ramblock.h"
+#include "exec/ramlist.h"
+#include "exec/memory.h"
+#include "exec/cpu-common.h"
+#include "sysemu/runstate.h"
+#include "migration/misc.h"
+#include "qemu-file.h"
+#include "savevm.h"
+#include "ram.h"
+
+#define RESET_SNAPSHOT_BUFFER_SIZE (4 * 1024 * 1024)
+
+typedef struct ResetSnapshotBlock {
+    RAMBlock *rb;
+    uint8_t *baseline;
+    ram_addr_t length;
+    QSIMPLEQ_ENTRY(ResetSnapshotBlock) entry;
+} ResetSnapshotBlock;
+
+/* Device state captured by x-reset-snapshot-save */
+static QIOChannelBuffer *reset_snapshot_bioc;
+static QSIMPLEQ_HEAD(, ResetSnapshotBlock) reset_snapshot_blocks =
+    QSIMPLEQ_HEAD_INITIALIZER(reset_snapshot_blocks);
+static bool reset_snapshot_armed;
+/* Set when the RAM layout changed under an armed snapshot */
+static bool reset_snapshot_stale;
+
+static void reset_snapshot_ram_added(RAMBlockNotifier *n, void *host,
+                                     size_t size, size_t max_size)
+{
+    reset_snapshot_stale = true;
+}
+
+static void reset_snapshot_ram_removed(RAMBlockNotifier *n, void *host,
+                                       size_t size, size_t max_size)
+{
+    reset_snapshot_stale = true;
+}
+
+static void reset_snapshot_ram_resized(RAMBlockNotifier *n, void *host,
+                                       size_t old_size, size_t new_size)
+{
+    reset_snapshot_stale = true;
+}
+
+static RAMBlockNotifier reset_snapshot_notifier = {
+    .ram_block_added = reset_snapshot_ram_added,
+    .ram_block_removed = reset_snapshot_ram_removed,
+    .ram_block_resized = reset_snapshot_ram_resized,
+};
+
+static void reset_snapshot_clear(void);
+
+/*
+ * Migration consumes the DIRTY_MEMORY_MIGRATION bits the snapshot relies
+ * on and stops GLOBAL_DIRTY_MIGRATION logging when it finishes, so a
+ * snapshot cannot stay armed across a migration: drop it as soon as one
+ * starts.
+ */
+static int reset_snapshot_migration_state(NotifierWithReturn *notifier,
+                                          MigrationEvent *e, Error **errp)
+{
+    if (e->type == MIG_EVENT_PRECOPY_SETUP) {
+        warn_report("Migration started, dropping the reset snapshot");
+        reset_snapshot_clear();
+    }
+    return 0;
+}
+
+static NotifierWithReturn reset_snapshot_migration_notifier;
+
+static void reset_snapshot_clear(void)
+{
+    ResetSnapshotBlock *block, *next;
+
+    if (reset_snapshot_armed) {
+        memory_global_dirty_log_stop(GLOBAL_DIRTY_MIGRATION);
+        ram_block_notifier_remove(&reset_snapshot_notifier);
+        migration_remove_notifier(&reset_snapshot_migration_notifier);
+        reset_snapshot_armed = false;
+    }
+    QSIMPLEQ_FOREACH_SAFE(block, &reset_snapshot_blocks, entry, next) {
+        g_free(block->baseline);
+        g_free(block);
+    }
+    QSIMPLEQ_INIT(&reset_snapshot_blocks);
+    if (reset_snapshot_bioc) {
+        object_unref(OBJECT(reset_snapshot_bioc));
+        reset_snapshot_bioc = NULL;
+    }
+    reset_snapshot_stale = false;
+}
+
+void qmp_x_reset_snapshot_save(Error **errp)
+{
+    bool saved_vm_running = runstate_is_running();
+    RAMBlock *rb;
+    QEMUFile *f;
+    int ret;
+
+    if (migration_is_running()) {
+        error_setg(errp, "Cannot save a reset snapshot during migration");
+        return;
+    }
+
+    vm_stop(RUN_STATE_SAVE_VM);
+    /* replace any previous snapshot */
+    reset_snapshot_clear();
+
+    reset_snapshot_bioc = qio_channel_buffer_new(RESET_SNAPSHOT_BUFFER_SIZE);
+    qio_channel_set_name(QIO_CHANNEL(reset_snapshot_bioc),
+                         "reset-snapshot-buffer");
+    f = qemu_file_new_output(QIO_CHANNEL(reset_snapshot_bioc));
+    ret = qemu_save_device_state(f);
+    if (qemu_fclose(f) < 0 || ret < 0) {
+        error_setg(errp, "Failed to save the device state");
+        reset_snapshot_clear();
+        goto out;
+    }
+
+    WITH_RCU_READ_LOCK_GUARD() {
+        RAMBLOCK_FOREACH_MIGRATABLE(rb) {
+            ResetSnapshotBlock *block;
+
+            if (!rb->host) {
+                continue;
+            }
+            block = g_new0(ResetSnapshotBlock, 1);
+            block->rb = rb;
+            block->length = rb->used_length;
+            block->baseline = g_try_malloc(block->length);
+            if (!block->baseline) {
+                error_setg(errp, "Not enough memory for the RAM baseline of "
+                           "block '%s'", rb->idstr);
+                g_free(block);
+                reset_snapshot_clear();
+                goto out;
+            }
+            memcpy(block->baseline, rb->host, block->length);
+            /*
+             * The migration bits have been set since the block was
+             * allocated; clear them so that only writes from this point
+             * on diverge from the baseline.
+             */
+            cpu_physical_memory_test_and_clear_dirty(rb->offset,
+                                                     block->length,
+                                                     DIRTY_MEMORY_MIGRATION);
+            QSIMPLEQ_INSERT_TAIL(&reset_snapshot_blocks, block, entry);
+        }
+    }
+
+    memory_global_dirty_log_start(GLOBAL_DIRTY_MIGRATION);
+    ram_block_notifier_add(&reset_snapshot_notifier);
+    migration_add_notifier(&reset_snapshot_migration_notifier,
+                           reset_snapshot_migration_state);
+    reset_snapshot_armed = true;
+
+out:
+    if (saved_vm_running) {
+        vm_start();
+    }
+}
+
+void qmp_x_reset_snapshot_delete(Error **errp)
+{
+    reset_snapshot_clear();
+}
+
+static void reset_snapshot_restore_ram(void)
+{
+    ResetSnapshotBlock *block;
+
+    memory_global_dirty_log_sync(false);
+
+    QSIMPLEQ_FOREACH(block, &reset_snapshot_blocks, entry) {
+        ram_addr_t off;
+
+        for (off = 0; off < block->length; off += TARGET_PAGE_SIZE) {
+            if (cpu_physical_memory_test_and_clear_dirty(
+                    block->rb->offset + off, TARGET_PAGE_SIZE,
+                    DIRTY_MEMORY_MIGRATION)) {
+                memcpy(block->rb->host + off, block->baseline + off,
+                       MIN((ram_addr_t)TARGET_PAGE_SIZE, block->length - off));
+            }
+        }
+    }
+}
+
+bool reset_snapshot_load(ShutdownCause reason)
+{
+    QEMUFile *f;
+    int ret;
+
+    if (!reset_snapshot_armed) {
+        return false;
+    }
+    if (reason != SHUTDOWN_CAUSE_GUEST_RESET &&
+        reason != SHUTDOWN_CAUSE_HOST_QMP_SYSTEM_RESET) {
+        /* only short-circuit whole-machine reboots */
+        return false;
+    }
+    if (reset_snapshot_stale) {
+        warn_report("RAM layout changed, dropping the reset snapshot");
+        reset_snapshot_clear();
+        return false;
+    }
+
+    /* dirtied pages first, device post_load may look at guest memory */
+    reset_snapshot_restore_ram();
+
+    qio_channel_io_seek(QIO_CHANNEL(reset_snapshot_bioc), 0, 0, NULL);
+    f = qemu_file_new_input(QIO_CHANNEL(reset_snapshot_bioc));
+    /*
+     * qemu_save_device_state() wrote the file header, but
+     * qemu_load_device_state() does not expect one; consume it here.
+     */
+    if (qemu_get_be32(f) != QEMU_VM_FILE_MAGIC ||
+        qemu_get_be32(f) != QEMU_VM_FILE_VERSION) {
+        ret = -EINVAL;
+    } else {
+        ret = qemu_load_device_state(f);
+    }
+    qemu_fclose(f);
+    if (ret < 0) {
+        error_report("Failed to load the reset snapshot (%d), "
+                     "falling back to a full reset", ret);
+        reset_snapshot_clear();
+        return false;
+    }
+
+    qapi_event_send_reset(shutdown_caused_by_guest(reason), reason);
+    vm_set_suspended(false);
+    return true;
+}
@@ -217,11 +217,21 @@ typedef struct SaveStateEntry {
     void *opaque;
     CompatEntry *compat;
     int is_ram;
+    /* Time spent saving this entry during the last blackout phase, in us */
+    int64_t complete_save_us;
 } SaveStateEntry;
 
 typedef struct SaveState {
     QTAILQ_HEAD(, SaveStateEntry) handlers;
     SaveStateEntry *handler_pri_head[MIG_PRI_MAX + 1];
+    /*
+     * Indexes of the handlers by idstr and by compat idstr (lists of
+     * SaveStateEntry, created lazily), so that registering a device
+     * does not rescan the whole handler list for instance id
+     * calculation and duplicate detection.
+     */
+    GHashTable *by_idstr;
+    GHashTable *by_compat_idstr;
     int global_section_id;
     uint32_t len;
     const char *name;
@@ -669,15 +679,24 @@ void dump_vmstate_json_to_file(FILE *out_file)
     g_slist_free(list);
 }
 
+/*
+ * Instance ids are always recomputed from the live entries rather than
+ * allocated from a counter, so that unplugging and replugging a device
+ * yields the same id as on a freshly started machine.
+ */
 static uint32_t calculate_new_instance_id(const char *idstr)
 {
     SaveStateEntry *se;
     uint32_t instance_id = 0;
-
-    QTAILQ_FOREACH(se, &savevm_state.handlers, entry) {
-        if (strcmp(idstr, se->idstr) == 0
-            && instance_id <= se->instance_id) {
-            instance_id = se->instance_id + 1;
+    GSList *l;
+
+    if (savevm_state.by_idstr) {
+        for (l = g_hash_table_lookup(savevm_state.by_idstr, idstr);
+             l; l = l->next) {
+            se = l->data;
+            if (instance_id <= se->instance_id) {
+                instance_id = se->instance_id + 1;
+            }
         }
     }
     /* Make sure we never loop over without being noticed */
@@ -689,20 +708,46 @@ static int calculate_compat_instance_id(const char *idstr)
 {
     SaveStateEntry *se;
     int instance_id = 0;
-
-    QTAILQ_FOREACH(se, &savevm_state.handlers, entry) {
-        if (!se->compat) {
-            continue;
-        }
-
-        if (strcmp(idstr, se->compat->idstr) == 0
-            && instance_id <= se->compat->instance_id) {
-            instance_id = se->compat->instance_id + 1;
+    GSList *l;
+
+    if (savevm_state.by_compat_idstr) {
+        for (l = g_hash_table_lookup(savevm_state.by_compat_idstr, idstr);
+             l; l = l->next) {
+            se = l->data;
+            if (instance_id <= se->compat->instance_id) {
+                instance_id = se->compat->instance_id + 1;
+            }
         }
     }
     return instance_id;
 }
 
+static void savevm_index_add(GHashTable **table, const char *idstr,
+                             SaveStateEntry *se)
+{
+    GSList *list;
+
+    if (!*table) {
+        *table = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                       g_free, NULL);
+    }
+    list = g_hash_table_lookup(*table, idstr);
+    g_hash_table_insert(*table, g_strdup(idstr), g_slist_prepend(list, se));
+}
+
+static void savevm_index_remove(GHashTable *table, const char *idstr,
+                                SaveStateEntry *se)
+{
+    GSList *list = g_hash_table_lookup(table, idstr);
+
+    list = g_slist_remove(list, se);
+    if (list) {
+        g_hash_table_insert(table, g_strdup(idstr), list);
+    } else {
+        g_hash_table_remove(table, idstr);
+    }
+}
+
 static inline MigrationPriority save_state_priority(SaveStateEntry *se)
 {
     if (se->vmsd) {
@@ -748,6 +793,12 @@ static void savevm_state_handler_insert(SaveStateEntry *nse)
     if (savevm_state.handler_pri_head[priority] == NULL) {
         savevm_state.handler_pri_head[priority] = nse;
     }
+
+    savevm_index_add(&savevm_state.by_idstr, nse->idstr, nse);
+    if (nse->compat) {
+        savevm_index_add(&savevm_state.by_compat_idstr,
+                         nse->compat->idstr, nse);
+    }
 }
 
 static void savevm_state_handler_remove(SaveStateEntry *se)
@@ -764,6 +815,12 @@ static void savevm_state_handler_remove(SaveStateEntry *se)
         }
     }
     QTAILQ_REMOVE(&savevm_state.handlers, se, entry);
+
+    savevm_index_remove(savevm_state.by_idstr, se->idstr, se);
+    if (se->compat) {
+        savevm_index_remove(savevm_state.by_compat_idstr,
+                            se->compat->idstr, se);
+    }
 }
 
 /* TODO: Individual devices generally have very little idea about the rest
@@ -1524,8 +1581,9 @@ int qemu_savevm_state_complete_precopy_iterable(QEMUFile *f, bool in_postcopy)
             return -1;
         }
         end_ts_each = qemu_clock_get_us(QEMU_CLOCK_REALTIME);
+        se->complete_save_us = end_ts_each - start_ts_each;
         trace_vmstate_downtime_save("iterable", se->idstr, se->instance_id,
-                                    end_ts_each - start_ts_each);
+                                    se->complete_save_us);
     }
 
     trace_vmstate_downtime_checkpoint("src-iterable-saved");
@@ -1559,8 +1617,9 @@ int qemu_savevm_state_complete_precopy_non_iterable(QEMUFile *f,
         }
 
         end_ts_each = qemu_clock_get_us(QEMU_CLOCK_REALTIME);
+        se->complete_save_us = end_ts_each - start_ts_each;
         trace_vmstate_downtime_save("non-iterable", se->idstr, se->instance_id,
-                                    end_ts_each - start_ts_each);
+                                    se->complete_save_us);
     }
 
     if (inactivate_disks) {
@@ -1601,6 +1660,35 @@ int qemu_savevm_state_complete_precopy_non_iterable(QEMUFile *f,
     return 0;
 }
 
+VmstateSaveTimeList *qemu_savevm_downtime_breakdown(void)
+{
+    VmstateSaveTimeList *list = NULL, **tail;
+    SaveStateEntry *se;
+
+    QTAILQ_FOREACH(se, &savevm_state.handlers, entry) {
+        VmstateSaveTime *entry;
+
+        if (!se->complete_save_us) {
+            continue;
+        }
+
+        entry = g_new0(VmstateSaveTime, 1);
+        entry->idstr = g_strdup(se->idstr);
+        entry->instance_id = se->instance_id;
+        entry->save_time = se->complete_save_us;
+
+        /* Insertion sort, largest save time first */
+        for (tail = &list; *tail; tail = &(*tail)->next) {
+            if ((*tail)->value->save_time < entry->save_time) {
+                break;
+            }
+        }
+        QAPI_LIST_PREPEND(*tail, entry);
+    }
+
+    return list;
+}
+
 int qemu_savevm_state_complete_precopy(QEMUFile *f, bool iterable_only,
                                        bool inactivate_disks)
 {
@@ -1792,18 +1880,28 @@ int qemu_save_device_state(QEMUFile *f)
 static SaveStateEntry *find_se(const char *idstr, uint32_t instance_id)
 {
     SaveStateEntry *se;
+    GSList *l;
+
+    if (savevm_state.by_idstr) {
+        for (l = g_hash_table_lookup(savevm_state.by_idstr, idstr);
+             l; l = l->next) {
+            se = l->data;
+            if (instance_id == se->instance_id ||
+                instance_id == se->alias_id) {
+                return se;
+            }
+        }
+    }
 
-    QTAILQ_FOREACH(se, &savevm_state.handlers, entry) {
-        if (!strcmp(se->idstr, idstr) &&
-            (instance_id == se->instance_id ||
-             instance_id == se->alias_id))
-            return se;
-        /* Migrating from an older version? */
-        if (strstr(se->idstr, idstr) && se->compat) {
-            if (!strcmp(se->compat->idstr, idstr) &&
-                (instance_id == se->compat->instance_id ||
-                 instance_id == se->alias_id))
+    /* Migrating from an older version? */
+    if (savevm_state.by_compat_idstr) {
+        for (l = g_hash_table_lookup(savevm_state.by_compat_idstr, idstr);
+             l; l = l->next) {
+            se = l->data;
+            if (instance_id == se->compat->instance_id ||
+                instance_id == se->alias_id) {
                 return se;
+            }
         }
     }
     return NULL;
@@ -70,4 +70,7 @@ int qemu_loadvm_approve_switchover(void);
 int qemu_savevm_state_complete_precopy_non_iterable(QEMUFile *f,
         bool in_postcopy, bool inactivate_disks);
 
+/* Per-device save times of the last blackout phase, largest first */
+VmstateSaveTimeList *qemu_savevm_downtime_breakdown(void);
+
 #endif
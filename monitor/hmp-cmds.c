@@ -27,6 +27,7 @@
 #include "qemu/cutils.h"
 #include "hw/intc/intc.h"
 #include "qemu/log.h"
+#include "sysemu/bql-prof.h"
 #include "sysemu/sysemu.h"
 
 bool hmp_handle_error(Monitor *mon, Error *err)
@@ -118,6 +119,32 @@ void hmp_stop(Monitor *mon, const QDict *qdict)
     qmp_stop(NULL);
 }
 
+void hmp_bql_profile(Monitor *mon, const QDict *qdict)
+{
+    const char *op = qdict_get_try_str(qdict, "op");
+    int64_t threshold = qdict_get_try_int(qdict, "threshold", 0);
+
+    if (op == NULL) {
+        bool on = bql_prof_is_enabled();
+
+        monitor_printf(mon, "bql-profile is %s\n", on ? "on" : "off");
+        return;
+    }
+    if (!strcmp(op, "on")) {
+        bql_prof_enable(threshold);
+    } else if (!strcmp(op, "off")) {
+        bql_prof_disable();
+    } else if (!strcmp(op, "reset")) {
+        bql_prof_reset();
+    } else {
+        Error *err = NULL;
+
+        error_setg(&err, "invalid parameter '%s',"
+                   " expecting 'on', 'off', or 'reset'", op);
+        hmp_handle_error(mon, err);
+    }
+}
+
 void hmp_sync_profile(Monitor *mon, const QDict *qdict)
 {
     const char *op = qdict_get_try_str(qdict, "op");
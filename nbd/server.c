@@ -128,6 +128,12 @@ struct NBDClient {
     QemuMutex lock;
 
     NBDExport *exp;
+    /*
+     * AioContext serving this client's requests, or NULL to follow the
+     * export's context.  Fixed at connection time so that a client's
+     * request coroutines always run in the same thread.
+     */
+    AioContext *ctx;
     QCryptoTLSCreds *tlscreds;
     char *tlsauthz;
     QIOChannelSocket *sioc; /* The underlying data channel */
@@ -1683,7 +1689,7 @@ static void nbd_drained_end(void *opaque)
     }
 }
 
-/* Runs in export AioContext */
+/* Runs in the AioContext serving the client */
 static void nbd_wake_read_bh(void *opaque)
 {
     NBDClient *client = opaque;
@@ -1704,13 +1710,14 @@ static bool nbd_drained_poll(void *opaque)
                  * If there's a coroutine waiting for a request on nbd_read_eof()
                  * enter it here so we don't depend on the client to wake it up.
                  *
-                 * Schedule a BH in the export AioContext to avoid missing the
-                 * wake up due to the race between qio_channel_wake_read() and
-                 * qio_channel_yield().
+                 * Schedule a BH in the AioContext serving the client to avoid
+                 * missing the wake up due to the race between
+                 * qio_channel_wake_read() and qio_channel_yield().
                  */
                 if (client->recv_coroutine != NULL && client->read_yielding) {
-                    aio_bh_schedule_oneshot(nbd_export_aio_context(client->exp),
-                                            nbd_wake_read_bh, client);
+                    aio_bh_schedule_oneshot(
+                        client->ctx ?: nbd_export_aio_context(client->exp),
+                        nbd_wake_read_bh, client);
                 }
 
                 return true;
@@ -3146,7 +3153,8 @@ static void nbd_client_receive_next_request(NBDClient *client)
         nbd_client_get(client);
         req = nbd_request_get(client);
         client->recv_coroutine = qemu_coroutine_create(nbd_trip, req);
-        aio_co_schedule(client->exp->common.ctx, client->recv_coroutine);
+        aio_co_schedule(client->ctx ?: client->exp->common.ctx,
+                        client->recv_coroutine);
     }
 }
 
@@ -3172,10 +3180,13 @@ static coroutine_fn void nbd_co_client_start(void *opaque)
 
 /*
  * Create a new client listener using the given channel @sioc.
- * Begin servicing it in a coroutine.  When the connection closes, call
- * @close_fn with an indication of whether the client completed negotiation.
+ * Begin servicing it in a coroutine.  Requests are processed in @ctx,
+ * or in the export's context if @ctx is NULL.  When the connection
+ * closes, call @close_fn with an indication of whether the client
+ * completed negotiation.
  */
 void nbd_client_new(QIOChannelSocket *sioc,
+                    AioContext *ctx,
                     QCryptoTLSCreds *tlscreds,
                     const char *tlsauthz,
                     void (*close_fn)(NBDClient *, bool))
@@ -3186,6 +3197,7 @@ void nbd_client_new(QIOChannelSocket *sioc,
     client = g_new0(NBDClient, 1);
     qemu_mutex_init(&client->lock);
     client->refcount = 1;
+    client->ctx = ctx;
     client->tlscreds = tlscreds;
     if (tlscreds) {
         object_ref(OBJECT(client->tlscreds));
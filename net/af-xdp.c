@@ -52,6 +52,7 @@ typedef struct AFXDPState {
     uint32_t             n_queues;
     uint32_t             xdp_flags;
     bool                 inhibit;
+    bool                 shared_umem;
 } AFXDPState;
 
 #define AF_XDP_BATCH_SIZE 64
@@ -270,9 +271,15 @@ static void af_xdp_cleanup(NetClientState *nc)
     s->xsk = NULL;
     g_free(s->pool);
     s->pool = NULL;
-    xsk_umem__delete(s->umem);
+    /*
+     * A shared UMEM is registered once and can only be deleted after all
+     * sockets using it are gone, i.e. with the last open queue.
+     */
+    if (!s->shared_umem || nc->queue_index == s->n_queues - 1) {
+        xsk_umem__delete(s->umem);
+        qemu_vfree(s->buffer);
+    }
     s->umem = NULL;
-    qemu_vfree(s->buffer);
     s->buffer = NULL;
 
     /* Remove the program if it's the last open queue. */
@@ -284,7 +291,8 @@ static void af_xdp_cleanup(NetClientState *nc)
     }
 }
 
-static int af_xdp_umem_create(AFXDPState *s, int sock_fd, Error **errp)
+static int af_xdp_umem_create(AFXDPState *s, AFXDPState *s0, int sock_fd,
+                              Error **errp)
 {
     struct xsk_umem_config config = {
         .fill_size = XSK_RING_PROD__DEFAULT_NUM_DESCS,
@@ -294,6 +302,7 @@ static int af_xdp_umem_create(AFXDPState *s, int sock_fd, Error **errp)
     };
     uint64_t n_descs;
     uint64_t size;
+    uint64_t base;
     int64_t i;
     int ret;
 
@@ -302,35 +311,85 @@ static int af_xdp_umem_create(AFXDPState *s, int sock_fd, Error **errp)
                + XSK_RING_CONS__DEFAULT_NUM_DESCS) * 2;
     size = n_descs * XSK_UMEM__DEFAULT_FRAME_SIZE;
 
-    s->buffer = qemu_memalign(qemu_real_host_page_size(), size);
-    memset(s->buffer, 0, size);
-
-    if (sock_fd < 0) {
-        ret = xsk_umem__create(&s->umem, s->buffer, size,
-                               &s->fq, &s->cq, &config);
+    if (s->shared_umem && s != s0) {
+        /* Reuse the region registered by the first queue. */
+        s->buffer = s0->buffer;
+        s->umem = s0->umem;
     } else {
-        ret = xsk_umem__create_with_fd(&s->umem, sock_fd, s->buffer, size,
-                                       &s->fq, &s->cq, &config);
-    }
+        uint64_t total = s->shared_umem ? size * s->n_queues : size;
 
-    if (ret) {
-        qemu_vfree(s->buffer);
-        error_setg_errno(errp, errno,
-                         "failed to create umem for %s queue_index: %d",
-                         s->ifname, s->nc.queue_index);
-        return -1;
+        s->buffer = qemu_memalign(qemu_real_host_page_size(), total);
+        memset(s->buffer, 0, total);
+
+        if (sock_fd < 0) {
+            ret = xsk_umem__create(&s->umem, s->buffer, total,
+                                   &s->fq, &s->cq, &config);
+        } else {
+            ret = xsk_umem__create_with_fd(&s->umem, sock_fd, s->buffer, total,
+                                           &s->fq, &s->cq, &config);
+        }
+
+        if (ret) {
+            qemu_vfree(s->buffer);
+            error_setg_errno(errp, errno,
+                             "failed to create umem for %s queue_index: %d",
+                             s->ifname, s->nc.queue_index);
+            return -1;
+        }
     }
 
+    /* Each queue owns its own slice of the (possibly shared) region. */
+    base = s->shared_umem ? (uint64_t)s->nc.queue_index * size : 0;
     s->pool = g_new(uint64_t, n_descs);
     /* Fill the pool in the opposite order, because it's a LIFO queue. */
-    for (i = n_descs; i >= 0; i--) {
-        s->pool[i] = i * XSK_UMEM__DEFAULT_FRAME_SIZE;
+    for (i = n_descs - 1; i >= 0; i--) {
+        s->pool[i] = base + i * XSK_UMEM__DEFAULT_FRAME_SIZE;
     }
     s->n_pool = n_descs;
 
-    af_xdp_fq_refill(s, XSK_RING_PROD__DEFAULT_NUM_DESCS);
+    return 0;
+}
+
+static int af_xdp_xsk_create(AFXDPState *s, int queue_id,
+                             struct xsk_socket_config *cfg)
+{
+    /*
+     * Sockets beyond the first one binding a shared UMEM bring their own
+     * fill and completion rings; libxdp adds XDP_SHARED_UMEM for them.
+     */
+    if (s->shared_umem && s->nc.queue_index > 0) {
+        return xsk_socket__create_shared(&s->xsk, s->ifname, queue_id, s->umem,
+                                         &s->rx, &s->tx, &s->fq, &s->cq, cfg);
+    }
+
+    return xsk_socket__create(&s->xsk, s->ifname, queue_id, s->umem,
+                              &s->rx, &s->tx, cfg);
+}
+
+static int af_xdp_set_busy_poll(AFXDPState *s, Error **errp)
+{
+#ifdef SO_PREFER_BUSY_POLL
+    int fd = xsk_socket__fd(s->xsk);
+    int prefer = 1;
+    int usecs = 20;
+    int budget = AF_XDP_BATCH_SIZE;
+
+    if (setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL,
+                   &prefer, sizeof(prefer)) ||
+        setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &usecs, sizeof(usecs)) ||
+        setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL_BUDGET,
+                   &budget, sizeof(budget))) {
+        error_setg_errno(errp, errno,
+                         "failed to enable busy polling for %s queue_index: %d",
+                         s->ifname, s->nc.queue_index);
+        return -1;
+    }
 
     return 0;
+#else
+    error_setg(errp, "busy polling is not supported on this host");
+    return -1;
+#endif
 }
 
 static int af_xdp_socket_create(AFXDPState *s,
@@ -363,22 +422,19 @@ static int af_xdp_socket_create(AFXDPState *s,
         /* Specific mode requested. */
         cfg.xdp_flags |= (opts->mode == AFXDP_MODE_NATIVE)
                          ? XDP_FLAGS_DRV_MODE : XDP_FLAGS_SKB_MODE;
-        if (xsk_socket__create(&s->xsk, s->ifname, queue_id,
-                               s->umem, &s->rx, &s->tx, &cfg)) {
+        if (af_xdp_xsk_create(s, queue_id, &cfg)) {
             error = errno;
         }
     } else {
         /* No mode requested, try native first. */
         cfg.xdp_flags |= XDP_FLAGS_DRV_MODE;
 
-        if (xsk_socket__create(&s->xsk, s->ifname, queue_id,
-                               s->umem, &s->rx, &s->tx, &cfg)) {
+        if (af_xdp_xsk_create(s, queue_id, &cfg)) {
             /* Can't use native mode, try skb. */
             cfg.xdp_flags &= ~XDP_FLAGS_DRV_MODE;
             cfg.xdp_flags |= XDP_FLAGS_SKB_MODE;
 
-            if (xsk_socket__create(&s->xsk, s->ifname, queue_id,
-                                   s->umem, &s->rx, &s->tx, &cfg)) {
+            if (af_xdp_xsk_create(s, queue_id, &cfg)) {
                 error = errno;
             }
         }
@@ -391,6 +447,11 @@ static int af_xdp_socket_create(AFXDPState *s,
         return -1;
     }
 
+    if (opts->has_busy_poll && opts->busy_poll &&
+        af_xdp_set_busy_poll(s, errp)) {
+        return -1;
+    }
+
     s->xdp_flags = cfg.xdp_flags;
 
     return 0;
@@ -470,6 +531,11 @@ int net_init_af_xdp(const Netdev *netdev,
         return -1;
     }
 
+    if (opts->has_shared_umem && opts->shared_umem && opts->sock_fds) {
+        error_setg(errp, "'shared-umem=on' is not compatible with 'sock-fds'");
+        return -1;
+    }
+
     if (opts->sock_fds) {
         sock_fds = parse_socket_fds(opts->sock_fds, queues, errp);
         if (!sock_fds) {
@@ -491,14 +557,19 @@ int net_init_af_xdp(const Netdev *netdev,
         pstrcpy(s->ifname, sizeof(s->ifname), opts->ifname);
         s->ifindex = ifindex;
         s->n_queues = queues;
+        s->shared_umem = opts->has_shared_umem && opts->shared_umem;
 
-        if (af_xdp_umem_create(s, sock_fds ? sock_fds[i] : -1, errp)
+        if (af_xdp_umem_create(s, DO_UPCAST(AFXDPState, nc, nc0),
+                               sock_fds ? sock_fds[i] : -1, errp)
             || af_xdp_socket_create(s, opts, errp)) {
             /* Make sure the XDP program will be removed. */
             s->n_queues = i;
             error_propagate(errp, err);
             goto err;
         }
+
+        /* Pre-post the RX buffers now that the fill ring exists. */
+        af_xdp_fq_refill(s, XSK_RING_PROD__DEFAULT_NUM_DESCS);
     }
 
     if (nc0) {
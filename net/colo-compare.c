@@ -32,6 +32,7 @@
 
 #include "block/aio-wait.h"
 #include "qemu/coroutine.h"
+#include "qemu/crc32c.h"
 
 #define TYPE_COLO_COMPARE "colo-compare"
 typedef struct CompareState CompareState;
@@ -343,6 +344,24 @@ static int colo_compare_packet_payload(Packet *ppkt,
     return memcmp(ppkt->data + poffset, spkt->data + soffset, len);
 }
 
+/*
+ * Checksum of the payload region a packet is compared over, computed
+ * once and cached.  When a burst of packets queues up on a connection,
+ * every primary packet is matched against every queued secondary
+ * packet, and comparing cached checksums first means each payload is
+ * read once instead of being memcmp'ed against every candidate.
+ */
+static uint32_t colo_packet_payload_crc(Packet *pkt, uint16_t offset)
+{
+    if (!pkt->payload_crc_valid || pkt->payload_crc_offset != offset) {
+        pkt->payload_crc = crc32c(0xffffffff, pkt->data + offset,
+                                  pkt->size - offset);
+        pkt->payload_crc_offset = offset;
+        pkt->payload_crc_valid = true;
+    }
+    return pkt->payload_crc;
+}
+
 /*
  * return true means that the payload is consist and
  * need to make the next comparison, false means do
@@ -526,6 +545,11 @@ static int colo_packet_compare_udp(Packet *spkt, Packet *ppkt)
         trace_colo_compare_main("UDP: payload size of packets are different");
         return -1;
     }
+    if (colo_packet_payload_crc(ppkt, offset) !=
+        colo_packet_payload_crc(spkt, offset)) {
+        trace_colo_compare_main("UDP: payload checksum mismatch");
+        return -1;
+    }
     if (colo_compare_packet_payload(ppkt, spkt, offset, offset,
                                     ppkt->size - offset)) {
         trace_colo_compare_udp_miscompare("primary pkt size", ppkt->size);
@@ -565,6 +589,11 @@ static int colo_packet_compare_icmp(Packet *spkt, Packet *ppkt)
         trace_colo_compare_main("ICMP: payload size of packets are different");
         return -1;
     }
+    if (colo_packet_payload_crc(ppkt, offset) !=
+        colo_packet_payload_crc(spkt, offset)) {
+        trace_colo_compare_main("ICMP: payload checksum mismatch");
+        return -1;
+    }
     if (colo_compare_packet_payload(ppkt, spkt, offset, offset,
                                     ppkt->size - offset)) {
         trace_colo_compare_icmp_miscompare("primary pkt size",
@@ -594,6 +623,11 @@ static int colo_packet_compare_other(Packet *spkt, Packet *ppkt)
         trace_colo_compare_main("Other: payload size of packets are different");
         return -1;
     }
+    if (colo_packet_payload_crc(ppkt, offset) !=
+        colo_packet_payload_crc(spkt, offset)) {
+        trace_colo_compare_main("Other: payload checksum mismatch");
+        return -1;
+    }
     return colo_compare_packet_payload(ppkt, spkt, offset, offset,
                                        ppkt->size - offset);
 }
@@ -55,6 +55,15 @@ typedef struct Packet {
     /* record the payload offset(the length that has been compared) */
     uint16_t offset;
     uint8_t flags; /* Flags(aka Control bits) */
+    /*
+     * Checksum of the compared payload region, computed on first use
+     * to rule out mismatches cheaply before the full memcmp.  Only
+     * valid when payload_crc_valid is set and the comparison starts at
+     * payload_crc_offset.
+     */
+    uint32_t payload_crc;
+    uint16_t payload_crc_offset;
+    bool payload_crc_valid;
 } Packet;
 
 typedef struct ConnectionKey {
@@ -36,6 +36,12 @@
 #include "qemu/main-loop.h"
 #include "qemu/cutils.h"
 
+/* Datagrams sent or received per syscall when batching is available */
+#define DGRAM_BATCH 32
+
+/* Transmit ring frame size; larger packets fall back to a direct send */
+#define DGRAM_TX_FRAME 4096
+
 typedef struct NetDgramState {
     NetClientState nc;
     int fd;
@@ -45,6 +51,22 @@ typedef struct NetDgramState {
     /* contains destination iff connectionless */
     struct sockaddr *dest_addr;
     socklen_t dest_len;
+#ifdef CONFIG_LINUX
+    /*
+     * Fixed rings of pre-posted buffers for sendmmsg()/recvmmsg()
+     * batching.  Transmitted packets are copied into the ring and
+     * flushed by a bottom half at the end of the event-loop iteration,
+     * so one syscall covers everything a guest TX bottom half produced.
+     */
+    uint8_t *tx_buf;
+    struct iovec tx_iov[DGRAM_BATCH];
+    struct mmsghdr tx_msgs[DGRAM_BATCH];
+    unsigned int tx_num;
+    QEMUBH *tx_bh;
+    uint8_t *rx_buf;
+    struct iovec rx_iov[DGRAM_BATCH];
+    struct mmsghdr rx_msgs[DGRAM_BATCH];
+#endif
 } NetDgramState;
 
 static void net_dgram_send(void *opaque);
@@ -70,19 +92,76 @@ static void net_dgram_write_poll(NetDgramState *s, bool enable)
     net_dgram_update_fd_handler(s);
 }
 
+#ifdef CONFIG_LINUX
+/*
+ * Push out the buffered datagrams.  Returns -1 and enables write
+ * polling if the kernel would block, leaving the remainder buffered.
+ */
+static int net_dgram_tx_flush(NetDgramState *s)
+{
+    unsigned int i, sent = 0;
+    int ret;
+
+    for (i = 0; i < s->tx_num; i++) {
+        s->tx_msgs[i].msg_hdr.msg_name = s->dest_addr;
+        s->tx_msgs[i].msg_hdr.msg_namelen = s->dest_len;
+    }
+
+    while (sent < s->tx_num) {
+        ret = sendmmsg(s->fd, s->tx_msgs + sent, s->tx_num - sent, 0);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN) {
+                /* Keep the remainder for when the fd is writable again */
+                for (i = sent; i < s->tx_num; i++) {
+                    memmove(s->tx_iov[i - sent].iov_base,
+                            s->tx_iov[i].iov_base, s->tx_iov[i].iov_len);
+                    s->tx_iov[i - sent].iov_len = s->tx_iov[i].iov_len;
+                }
+                s->tx_num -= sent;
+                net_dgram_write_poll(s, true);
+                return -1;
+            }
+            /* Datagram socket: drop on any other error, as send() would */
+            break;
+        }
+        sent += ret;
+    }
+
+    s->tx_num = 0;
+    return 0;
+}
+
+static void net_dgram_tx_flush_bh(void *opaque)
+{
+    NetDgramState *s = opaque;
+
+    if (s->tx_num) {
+        net_dgram_tx_flush(s);
+    }
+}
+#endif /* CONFIG_LINUX */
+
 static void net_dgram_writable(void *opaque)
 {
     NetDgramState *s = opaque;
 
     net_dgram_write_poll(s, false);
 
+#ifdef CONFIG_LINUX
+    if (s->tx_num && net_dgram_tx_flush(s) < 0) {
+        return;
+    }
+#endif
+
     qemu_flush_queued_packets(&s->nc);
 }
 
-static ssize_t net_dgram_receive(NetClientState *nc,
-                                 const uint8_t *buf, size_t size)
+static ssize_t net_dgram_send_direct(NetDgramState *s,
+                                     const uint8_t *buf, size_t size)
 {
-    NetDgramState *s = DO_UPCAST(NetDgramState, nc, nc);
     ssize_t ret;
 
     do {
@@ -100,6 +179,36 @@ static ssize_t net_dgram_receive(NetClientState *nc,
     return ret;
 }
 
+static ssize_t net_dgram_receive(NetClientState *nc,
+                                 const uint8_t *buf, size_t size)
+{
+    NetDgramState *s = DO_UPCAST(NetDgramState, nc, nc);
+
+#ifdef CONFIG_LINUX
+    if (size <= DGRAM_TX_FRAME) {
+        if (s->tx_num == DGRAM_BATCH) {
+            if (net_dgram_tx_flush(s) < 0) {
+                /* Ring full and kernel busy: ask to be called back */
+                return 0;
+            }
+        }
+
+        memcpy(s->tx_iov[s->tx_num].iov_base, buf, size);
+        s->tx_iov[s->tx_num].iov_len = size;
+        s->tx_num++;
+        qemu_bh_schedule(s->tx_bh);
+        return size;
+    }
+
+    /* Oversized packet: flush first so datagrams stay in order */
+    if (s->tx_num && net_dgram_tx_flush(s) < 0) {
+        return 0;
+    }
+#endif
+
+    return net_dgram_send_direct(s, buf, size);
+}
+
 static void net_dgram_send_completed(NetClientState *nc, ssize_t len)
 {
     NetDgramState *s = DO_UPCAST(NetDgramState, nc, nc);
@@ -125,6 +234,35 @@ static void net_dgram_send(void *opaque)
     NetDgramState *s = opaque;
     int size;
 
+#ifdef CONFIG_LINUX
+    int i, n;
+
+    n = recvmmsg(s->fd, s->rx_msgs, DGRAM_BATCH, 0, NULL);
+    if (n < 0) {
+        return;
+    }
+
+    for (i = 0; i < n; i++) {
+        size = s->rx_msgs[i].msg_len;
+
+        if (size == 0) {
+            /* end of connection */
+            net_dgram_read_poll(s, false);
+            net_dgram_write_poll(s, false);
+            return;
+        }
+
+        /*
+         * Packets already pulled from the kernel are delivered even if
+         * the peer stalls mid-batch; the net queue holds them and we
+         * only stop polling for more.
+         */
+        if (qemu_send_packet_async(&s->nc, s->rx_iov[i].iov_base, size,
+                                   net_dgram_send_completed) == 0) {
+            net_dgram_read_poll(s, false);
+        }
+    }
+#else
     size = recv(s->fd, s->rs.buf, sizeof(s->rs.buf), 0);
     if (size < 0) {
         return;
@@ -139,6 +277,7 @@ static void net_dgram_send(void *opaque)
                                net_dgram_send_completed) == 0) {
         net_dgram_read_poll(s, false);
     }
+#endif
 }
 
 static int net_dgram_mcast_create(struct sockaddr_in *mcastaddr,
@@ -239,11 +378,26 @@ static void net_dgram_cleanup(NetClientState *nc)
 {
     NetDgramState *s = DO_UPCAST(NetDgramState, nc, nc);
     if (s->fd != -1) {
+#ifdef CONFIG_LINUX
+        if (s->tx_num) {
+            net_dgram_tx_flush(s);
+        }
+#endif
         net_dgram_read_poll(s, false);
         net_dgram_write_poll(s, false);
         close(s->fd);
         s->fd = -1;
     }
+#ifdef CONFIG_LINUX
+    if (s->tx_bh) {
+        qemu_bh_delete(s->tx_bh);
+        s->tx_bh = NULL;
+    }
+    g_free(s->tx_buf);
+    s->tx_buf = NULL;
+    g_free(s->rx_buf);
+    s->rx_buf = NULL;
+#endif
     g_free(s->dest_addr);
     s->dest_addr = NULL;
     s->dest_len = 0;
@@ -271,6 +425,29 @@ static NetDgramState *net_dgram_fd_init(NetClientState *peer,
 
     s->fd = fd;
     net_socket_rs_init(&s->rs, net_dgram_rs_finalize, false);
+
+#ifdef CONFIG_LINUX
+    {
+        int i;
+
+        s->tx_buf = g_malloc(DGRAM_BATCH * DGRAM_TX_FRAME);
+        s->rx_buf = g_malloc(DGRAM_BATCH * (size_t)sizeof(s->rs.buf));
+
+        for (i = 0; i < DGRAM_BATCH; i++) {
+            s->tx_iov[i].iov_base = s->tx_buf + i * DGRAM_TX_FRAME;
+            s->tx_msgs[i].msg_hdr.msg_iov = &s->tx_iov[i];
+            s->tx_msgs[i].msg_hdr.msg_iovlen = 1;
+
+            s->rx_iov[i].iov_base = s->rx_buf + i * (size_t)sizeof(s->rs.buf);
+            s->rx_iov[i].iov_len = sizeof(s->rs.buf);
+            s->rx_msgs[i].msg_hdr.msg_iov = &s->rx_iov[i];
+            s->rx_msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        s->tx_bh = qemu_bh_new(net_dgram_tx_flush_bh, s);
+    }
+#endif
+
     net_dgram_read_poll(s, true);
 
     return s;
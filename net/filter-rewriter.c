@@ -111,10 +111,13 @@ static int handle_primary_tcp_pkt(RewriterState *rf,
         }
         if (conn->offset) {
             /* handle packets to the secondary from the primary */
-            tcp_pkt->th_ack = htonl(ntohl(tcp_pkt->th_ack) + conn->offset);
+            uint32_t old_ack = ntohl(tcp_pkt->th_ack);
+            uint32_t new_ack = old_ack + conn->offset;
 
-            net_checksum_calculate((uint8_t *)pkt->data + pkt->vnet_hdr_len,
-                                   pkt->size - pkt->vnet_hdr_len, CSUM_TCP);
+            tcp_pkt->th_ack = htonl(new_ack);
+            /* adjust the checksum in place instead of re-summing the data */
+            tcp_pkt->th_sum = htons(net_checksum_fixup32(ntohs(tcp_pkt->th_sum),
+                                                         old_ack, new_ack));
         }
 
         /*
@@ -213,10 +216,13 @@ static int handle_secondary_tcp_pkt(RewriterState *rf,
         /* Only need to adjust seq while offset is Non-zero */
         if (conn->offset) {
             /* handle packets to the primary from the secondary*/
-            tcp_pkt->th_seq = htonl(ntohl(tcp_pkt->th_seq) - conn->offset);
+            uint32_t old_seq = ntohl(tcp_pkt->th_seq);
+            uint32_t new_seq = old_seq - conn->offset;
 
-            net_checksum_calculate((uint8_t *)pkt->data + pkt->vnet_hdr_len,
-                                   pkt->size - pkt->vnet_hdr_len, CSUM_TCP);
+            tcp_pkt->th_seq = htonl(new_seq);
+            /* adjust the checksum in place instead of re-summing the data */
+            tcp_pkt->th_sum = htons(net_checksum_fixup32(ntohs(tcp_pkt->th_sum),
+                                                         old_seq, new_seq));
         }
     }
 
@@ -38,8 +38,7 @@ ssize_t qemu_netfilter_receive(NetFilterState *nf,
     }
     if (nf->direction == direction ||
         nf->direction == NET_FILTER_DIRECTION_ALL) {
-        return NETFILTER_GET_CLASS(OBJECT(nf))->receive_iov(
-                                   nf, sender, flags, iov, iovcnt, sent_cb);
+        return nf->receive_iov(nf, sender, flags, iov, iovcnt, sent_cb);
     }
 
     return 0;
@@ -281,6 +280,7 @@ static void netfilter_complete(UserCreatable *uc, Error **errp)
     }
 
     nf->netdev = ncs[0];
+    nf->receive_iov = nfc->receive_iov;
 
     if (nfc->setup) {
         nfc->setup(nf, &local_err);
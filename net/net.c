@@ -639,6 +639,10 @@ static ssize_t filter_receive_iov(NetClientState *nc,
     ssize_t ret = 0;
     NetFilterState *nf = NULL;
 
+    if (likely(QTAILQ_EMPTY(&nc->filters))) {
+        return 0;
+    }
+
     if (direction == NET_FILTER_DIRECTION_TX) {
         QTAILQ_FOREACH(nf, &nc->filters, next) {
             ret = qemu_netfilter_receive(nf, direction, sender, flags, iov,
@@ -698,6 +702,9 @@ void qemu_flush_or_purge_queued_packets(NetClientState *nc, bool purge)
         /* We emptied the queue successfully, signal to the IO thread to repoll
          * the file descriptor (for tap, for example).
          */
+        if (nc->peer && nc->peer->info->queue_flushed) {
+            nc->peer->info->queue_flushed(nc->peer);
+        }
         qemu_notify_event();
     } else if (purge) {
         /* Unable to empty the queue, purge remaining packets */
@@ -23,6 +23,7 @@
 
 #include "qemu/osdep.h"
 #include "net/queue.h"
+#include "qemu/main-loop.h"
 #include "qemu/queue.h"
 #include "net/net.h"
 
@@ -45,10 +46,25 @@ struct NetPacket {
     NetClientState *sender;
     unsigned flags;
     int size;
+    size_t capacity;
     NetPacketSent *sent_cb;
     uint8_t data[];
 };
 
+/*
+ * Recycle up to this many packet buffers per queue; a packet storm
+ * then reuses warm buffers instead of hitting the allocator for every
+ * deferred packet.
+ */
+#define NET_QUEUE_POOL_SIZE 64
+
+/*
+ * Deliver at most this many deferred packets per flush, continuing
+ * from a bottom half, so that draining a long backlog does not stall
+ * the caller for milliseconds.
+ */
+#define NET_QUEUE_FLUSH_BUDGET 256
+
 struct NetQueue {
     void *opaque;
     uint32_t nq_maxlen;
@@ -56,10 +72,42 @@ struct NetQueue {
     NetQueueDeliverFunc *deliver;
 
     QTAILQ_HEAD(, NetPacket) packets;
+    QTAILQ_HEAD(, NetPacket) free_packets;
+    uint32_t free_count;
+    QEMUBH *flush_bh;
 
     unsigned delivering : 1;
 };
 
+static NetPacket *qemu_net_queue_packet_new(NetQueue *queue, size_t size)
+{
+    NetPacket *packet = QTAILQ_FIRST(&queue->free_packets);
+
+    if (packet && packet->capacity >= size) {
+        QTAILQ_REMOVE(&queue->free_packets, packet, entry);
+        queue->free_count--;
+        return packet;
+    }
+    packet = g_malloc(sizeof(NetPacket) + size);
+    packet->capacity = size;
+    return packet;
+}
+
+static void qemu_net_queue_packet_free(NetQueue *queue, NetPacket *packet)
+{
+    if (queue->free_count < NET_QUEUE_POOL_SIZE) {
+        QTAILQ_INSERT_HEAD(&queue->free_packets, packet, entry);
+        queue->free_count++;
+    } else {
+        g_free(packet);
+    }
+}
+
+static void qemu_net_queue_flush_bh(void *opaque)
+{
+    qemu_net_queue_flush(opaque);
+}
+
 NetQueue *qemu_new_net_queue(NetQueueDeliverFunc *deliver, void *opaque)
 {
     NetQueue *queue;
@@ -72,6 +120,8 @@ NetQueue *qemu_new_net_queue(NetQueueDeliverFunc *deliver, void *opaque)
     queue->deliver = deliver;
 
     QTAILQ_INIT(&queue->packets);
+    QTAILQ_INIT(&queue->free_packets);
+    queue->flush_bh = qemu_bh_new(qemu_net_queue_flush_bh, queue);
 
     queue->delivering = 0;
 
@@ -86,6 +136,11 @@ void qemu_del_net_queue(NetQueue *queue)
         QTAILQ_REMOVE(&queue->packets, packet, entry);
         g_free(packet);
     }
+    QTAILQ_FOREACH_SAFE(packet, &queue->free_packets, entry, next) {
+        QTAILQ_REMOVE(&queue->free_packets, packet, entry);
+        g_free(packet);
+    }
+    qemu_bh_delete(queue->flush_bh);
 
     g_free(queue);
 }
@@ -102,7 +157,7 @@ static void qemu_net_queue_append(NetQueue *queue,
     if (queue->nq_count >= queue->nq_maxlen && !sent_cb) {
         return; /* drop if queue full and no callback */
     }
-    packet = g_malloc(sizeof(NetPacket) + size);
+    packet = qemu_net_queue_packet_new(queue, size);
     packet->sender = sender;
     packet->flags = flags;
     packet->size = size;
@@ -131,7 +186,7 @@ void qemu_net_queue_append_iov(NetQueue *queue,
         max_len += iov[i].iov_len;
     }
 
-    packet = g_malloc(sizeof(NetPacket) + max_len);
+    packet = qemu_net_queue_packet_new(queue, max_len);
     packet->sender = sender;
     packet->sent_cb = sent_cb;
     packet->flags = flags;
@@ -265,13 +320,15 @@ void qemu_net_queue_purge(NetQueue *queue, NetClientState *from)
             if (packet->sent_cb) {
                 packet->sent_cb(packet->sender, 0);
             }
-            g_free(packet);
+            qemu_net_queue_packet_free(queue, packet);
         }
     }
 }
 
 bool qemu_net_queue_flush(NetQueue *queue)
 {
+    int budget = NET_QUEUE_FLUSH_BUDGET;
+
     if (queue->delivering)
         return false;
 
@@ -279,6 +336,12 @@ bool qemu_net_queue_flush(NetQueue *queue)
         NetPacket *packet;
         int ret;
 
+        if (budget-- == 0) {
+            /* Long backlog: take a breath and continue from the BH */
+            qemu_bh_schedule(queue->flush_bh);
+            return false;
+        }
+
         packet = QTAILQ_FIRST(&queue->packets);
         QTAILQ_REMOVE(&queue->packets, packet, entry);
         queue->nq_count--;
@@ -298,7 +361,7 @@ bool qemu_net_queue_flush(NetQueue *queue)
             packet->sent_cb(packet->sender, ret);
         }
 
-        g_free(packet);
+        qemu_net_queue_packet_free(queue, packet);
     }
     return true;
 }
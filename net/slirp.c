@@ -426,7 +426,7 @@ static int net_slirp_init(NetClientState *peer, const char *model,
                           const char *vnameserver, const char *vnameserver6,
                           const char *smb_export, const char *vsmbserver,
                           const char **dnssearch, const char *vdomainname,
-                          const char *tftp_server_name,
+                          const char *tftp_server_name, int mtu,
                           Error **errp)
 {
     /* default settings according to historic slirp */
@@ -466,6 +466,11 @@ static int net_slirp_init(NetClientState *peer, const char *model,
         return -1;
     }
 
+    if (mtu && (mtu < 68 || mtu > 65520)) {
+        error_setg(errp, "MTU must be between 68 and 65520");
+        return -1;
+    }
+
     if (vnetwork) {
         if (get_str_sep(buf, sizeof(buf), &vnetwork, '/') < 0) {
             if (!inet_aton(vnetwork, &net)) {
@@ -648,6 +653,9 @@ static int net_slirp_init(NetClientState *peer, const char *model,
     cfg.vnameserver6 = ip6_dns;
     cfg.vdnssearch = dnssearch;
     cfg.vdomainname = vdomainname;
+    /* 0 leaves the historic 1500 byte default in place */
+    cfg.if_mtu = mtu;
+    cfg.if_mru = mtu;
     s->slirp = slirp_new(&cfg, &slirp_cb, s);
     QTAILQ_INSERT_TAIL(&slirp_stacks, s, entry);
 
@@ -1184,7 +1192,8 @@ int net_init_slirp(const Netdev *netdev, const char *name,
                          user->bootfile, user->dhcpstart,
                          user->dns, user->ipv6_dns, user->smb,
                          user->smbserver, dnssearch, user->domainname,
-                         user->tftp_server_name, errp);
+                         user->tftp_server_name,
+                         user->has_mtu ? user->mtu : 0, errp);
 
     while (slirp_configs) {
         config = slirp_configs;
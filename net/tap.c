@@ -181,6 +181,15 @@ static void tap_send_completed(NetClientState *nc, ssize_t len)
     tap_read_poll(s, true);
 }
 
+static void tap_queue_flushed(NetClientState *nc)
+{
+    TAPState *s = DO_UPCAST(TAPState, nc, nc);
+
+    if (!s->read_poll) {
+        tap_read_poll(s, true);
+    }
+}
+
 static void tap_send(void *opaque)
 {
     TAPState *s = opaque;
@@ -192,6 +201,17 @@ static void tap_send(void *opaque)
         uint8_t min_pkt[ETH_ZLEN];
         size_t min_pktsz = sizeof(min_pkt);
 
+        /*
+         * Check for available receive buffers before reading, so packets
+         * back-pressure in the kernel queue instead of being read only to
+         * be copied into the net queue.  The peer re-enables polling
+         * through queue_flushed once it can receive again.
+         */
+        if (!qemu_can_send_packet(&s->nc)) {
+            tap_read_poll(s, false);
+            break;
+        }
+
         size = tap_read_packet(s->fd, s->buf, sizeof(s->buf));
         if (size <= 0) {
             break;
@@ -393,6 +413,7 @@ static NetClientInfo net_tap_info = {
     .receive_raw = tap_receive_raw,
     .receive_iov = tap_receive_iov,
     .poll = tap_poll,
+    .queue_flushed = tap_queue_flushed,
     .cleanup = tap_cleanup,
     .has_ufo = tap_has_ufo,
     .has_uso = tap_has_uso,
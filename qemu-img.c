@@ -1664,7 +1664,7 @@ enum ImgConvertBlockStatus {
     BLK_BACKING_FILE,
 };
 
-#define MAX_COROUTINES 16
+#define MAX_COROUTINES 64
 #define CONVERT_THROTTLE_GROUP "img_convert"
 
 typedef struct ImgConvertState {
@@ -2436,6 +2436,18 @@ static int img_convert(int argc, char **argv)
         goto fail_getopt;
     }
 
+    /*
+     * With sparsification disabled (-S 0) the bounce-buffer path writes
+     * every byte it reads, so copy offloading cannot change the result.
+     * Try it by default in that case: on filesystems with reflink or
+     * copy_file_range() support the data then never passes through this
+     * process, and convert_co_copy_range() transparently falls back to
+     * buffered copying when the host cannot offload.
+     */
+    if (!s.compressed && !s.salvage && s.min_sparse == 0) {
+        s.copy_range = true;
+    }
+
     if (tgt_image_opts && !skip_create) {
         error_report("--target-image-opts requires use of -n flag");
         goto fail_getopt;
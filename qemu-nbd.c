@@ -25,6 +25,7 @@
 #include "qapi/error.h"
 #include "qemu/cutils.h"
 #include "sysemu/block-backend.h"
+#include "sysemu/iothread.h"
 #include "sysemu/runstate.h" /* for qemu_system_killed() prototype */
 #include "block/block_int.h"
 #include "block/nbd.h"
@@ -70,6 +71,7 @@
 #define QEMU_NBD_OPT_PID_FILE      265
 #define QEMU_NBD_OPT_SELINUX_LABEL 266
 #define QEMU_NBD_OPT_TLSHOSTNAME   267
+#define QEMU_NBD_OPT_IOTHREADS     268
 
 #define MBR_SIZE 512
 
@@ -81,6 +83,11 @@ static QIONetListener *server;
 static QCryptoTLSCreds *tlscreds;
 static const char *tlsauthz;
 
+/* I/O threads that client connections are spread across */
+static AioContext **client_ctxs;
+static unsigned n_client_ctxs;
+static unsigned next_client_ctx;
+
 static void usage(const char *name)
 {
     (printf) (
@@ -97,6 +104,7 @@ static void usage(const char *name)
 "  -k, --socket=PATH         path to the unix socket\n"
 "                            (default '"SOCKET_PATH"')\n"
 "  -e, --shared=NUM          device can be shared by NUM clients (default '1')\n"
+"  --iothreads=NUM           spread client connections across NUM I/O threads\n"
 "  -t, --persistent          don't exit on the last connection\n"
 "  -v, --verbose             display extra debugging information\n"
 "  -x, --export-name=NAME    expose export by name (default is empty string)\n"
@@ -384,13 +392,19 @@ static void nbd_client_closed(NBDClient *client, bool negotiated)
 static void nbd_accept(QIONetListener *listener, QIOChannelSocket *cioc,
                        gpointer opaque)
 {
+    AioContext *ctx = NULL;
+
     if (state >= TERMINATE) {
         return;
     }
 
+    if (n_client_ctxs) {
+        ctx = client_ctxs[next_client_ctx++ % n_client_ctxs];
+    }
+
     nb_fds++;
     nbd_update_server_watch();
-    nbd_client_new(cioc, tlscreds, tlsauthz, nbd_client_closed);
+    nbd_client_new(cioc, ctx, tlscreds, tlsauthz, nbd_client_closed);
 }
 
 static void nbd_update_server_watch(void)
@@ -561,6 +575,7 @@ int main(int argc, char **argv)
         { "detect-zeroes", required_argument, NULL,
           QEMU_NBD_OPT_DETECT_ZEROES },
         { "shared", required_argument, NULL, 'e' },
+        { "iothreads", required_argument, NULL, QEMU_NBD_OPT_IOTHREADS },
         { "format", required_argument, NULL, 'f' },
         { "persistent", no_argument, NULL, 't' },
         { "verbose", no_argument, NULL, 'v' },
@@ -582,6 +597,7 @@ int main(int argc, char **argv)
     int opt_ind = 0;
     int flags = BDRV_O_RDWR;
     int ret = 0;
+    int n_iothreads = 0;
     bool seen_cache = false;
     bool seen_discard = false;
     bool seen_aio = false;
@@ -747,6 +763,13 @@ int main(int argc, char **argv)
                 exit(EXIT_FAILURE);
             }
             break;
+        case QEMU_NBD_OPT_IOTHREADS:
+            if (qemu_strtoi(optarg, NULL, 0, &n_iothreads) < 0 ||
+                n_iothreads < 0) {
+                error_report("Invalid number of I/O threads '%s'", optarg);
+                exit(EXIT_FAILURE);
+            }
+            break;
         case 'f':
             fmt = optarg;
             break;
@@ -1088,6 +1111,14 @@ int main(int argc, char **argv)
     bdrv_init();
     atexit(qemu_nbd_shutdown);
 
+    for (int i = 0; i < n_iothreads; i++) {
+        g_autofree char *id = g_strdup_printf("qemu-nbd-iothread-%d", i);
+        IOThread *iothread = iothread_create(id, &error_fatal);
+
+        client_ctxs = g_renew(AioContext *, client_ctxs, n_client_ctxs + 1);
+        client_ctxs[n_client_ctxs++] = iothread_get_aio_context(iothread);
+    }
+
     opts.srcpath = argv[optind];
     if (imageOpts) {
         QemuOpts *o;
@@ -32,6 +32,7 @@ DEF("machine", HAS_ARG, QEMU_OPTION_machine, \
     "                vmport=on|off|auto controls emulation of vmport (default: auto)\n"
     "                dump-guest-core=on|off include guest memory in a core dump (default=on)\n"
     "                mem-merge=on|off controls memory merge support (default: on)\n"
+    "                mem-merge-advisor=on|off advise merging selectively from a background duplicate scan (default: off)\n"
     "                aes-key-wrap=on|off controls support for AES key wrapping (default=on)\n"
     "                dea-key-wrap=on|off controls support for DEA key wrapping (default=on)\n"
     "                suppress-vmdesc=on|off disables self-describing migration (default=off)\n"
@@ -79,6 +80,14 @@ SRST
         supported by the host, de-duplicates identical memory pages
         among VMs instances (enabled by default).
 
+    ``mem-merge-advisor=on|off``
+        With mem-merge=on, mark guest memory mergeable selectively from
+        a background scan for stable duplicate pages, instead of
+        marking all guest RAM up front. This keeps the host KSM
+        scanner away from pages that are unlikely to merge. Per-block
+        scan statistics are available through query-profile (disabled
+        by default).
+
     ``aes-key-wrap=on|off``
         Enables or disables AES key wrapping support on s390-ccw hosts.
         This feature controls whether AES wrapping keys will be created
@@ -187,6 +196,8 @@ DEF("accel", HAS_ARG, QEMU_OPTION_accel,
     "                one-insn-per-tb=on|off (one guest instruction per TCG translation block)\n"
     "                split-wx=on|off (enable TCG split w^x mapping)\n"
     "                tb-size=n (TCG translation block cache size)\n"
+    "                two-tier-tb=on|off (TCG quick first translation, recompile hot blocks)\n"
+    "                numa-regions=on|off (bind TCG code regions to the owning vCPU's NUMA node)\n"
     "                dirty-ring-size=n (KVM dirty ring GFN count, default 0)\n"
     "                eager-split-size=n (KVM Eager Page Split chunk size, default 0, disabled. ARM only)\n"
     "                notify-vmexit=run|internal-error|disable,notify-window=n (enable notify VM exit and set notify window, x86 only)\n"
@@ -230,6 +241,22 @@ SRST
     ``tb-size=n``
         Controls the size (in MiB) of the TCG translation block cache.
 
+    ``numa-regions=on|off``
+        Binds each TCG code generation region to the NUMA node of the
+        vCPU thread that owns it, so that generated code is fetched
+        from node-local memory on multi-socket hosts. Requires QEMU to
+        be built with libnuma support. (default=off)
+
+    ``two-tier-tb=on|off``
+        Makes the TCG accelerator translate guest code quickly with a
+        small per-block instruction budget at first, and recompile
+        blocks at full size once they have executed often enough. Hot
+        blocks chained together are additionally specialized on
+        constants that provably flow across the chain, guarded by a
+        run-time check at block entry. This trades start-up translation
+        time for steady-state performance in long-running guests.
+        (default=off)
+
     ``thread=single|multi``
         Controls number of TCG threads. When the TCG is multi-threaded
         there will be one thread per vCPU therefore taking advantage of
@@ -2811,7 +2838,8 @@ DEF("netdev", HAS_ARG, QEMU_OPTION_netdev,
     "         [,ipv6=on|off][,ipv6-net=addr[/int]][,ipv6-host=addr]\n"
     "         [,restrict=on|off][,hostname=host][,dhcpstart=addr]\n"
     "         [,dns=addr][,ipv6-dns=addr][,dnssearch=domain][,domainname=domain]\n"
-    "         [,tftp=dir][,tftp-server-name=name][,bootfile=f][,hostfwd=rule][,guestfwd=rule]"
+    "         [,tftp=dir][,tftp-server-name=name][,bootfile=f][,hostfwd=rule][,guestfwd=rule]\n"
+    "         [,mtu=mtu]"
 #ifndef _WIN32
                                              "[,smb=dir[,smbserver=addr]]\n"
 #endif
@@ -2919,10 +2947,13 @@ DEF("netdev", HAS_ARG, QEMU_OPTION_netdev,
 #ifdef CONFIG_AF_XDP
     "-netdev af-xdp,id=str,ifname=name[,mode=native|skb][,force-copy=on|off]\n"
     "         [,queues=n][,start-queue=m][,inhibit=on|off][,sock-fds=x:y:...:z]\n"
+    "         [,shared-umem=on|off][,busy-poll=on|off]\n"
     "                attach to the existing network interface 'name' with AF_XDP socket\n"
     "                use 'mode=MODE' to specify an XDP program attach mode\n"
     "                use 'force-copy=on|off' to force XDP copy mode even if device supports zero-copy (default: off)\n"
     "                use 'inhibit=on|off' to inhibit loading of a default XDP program (default: off)\n"
+    "                use 'shared-umem=on|off' to register one UMEM region shared by all queues (default: off)\n"
+    "                use 'busy-poll=on|off' to prefer busy polling over interrupts (default: off)\n"
     "                with inhibit=on,\n"
     "                  use 'sock-fds' to provide file descriptors for already open AF_XDP sockets\n"
     "                  added to a socket map in XDP program.  One socket per queue.\n"
@@ -3124,6 +3155,13 @@ SRST
         load boot files or configurations from a different server than
         the host address.
 
+    ``mtu=mtu``
+        Set the MTU of the virtual network interface, between 68 and
+        65520. The default is 1500. Bulk TCP data crosses the
+        user-mode stack once per segment, so a large MTU considerably
+        raises the achievable throughput; configure the guest
+        interface to match.
+
     ``bootfile=file``
         When using the user mode network stack, broadcast file as the
         BOOTP filename. In conjunction with ``tftp``, this can be used
@@ -3480,6 +3518,13 @@ SRST
         |qemu_system| linux.img -device virtio-net-pci,netdev=n1 \\
             -netdev af-xdp,id=n1,ifname=eth0,queues=3,inhibit=on,sock-fds=15:16:17
 
+    With 'shared-umem=on' a single UMEM region is registered with the
+    kernel and shared by all queues, each binding its own AF_XDP socket
+    with separate fill and completion rings on a slice of that region.
+    'busy-poll=on' additionally marks the sockets as preferring busy
+    polling (SO_PREFER_BUSY_POLL), trading some CPU for latency and
+    throughput on busy interfaces.
+
 ``-netdev vhost-user,chardev=id[,vhostforce=on|off][,queues=n]``
     Establish a vhost-user netdev, backed by a chardev id. The chardev
     should be a unix domain socket backed one. The vhost-user uses a
@@ -4665,13 +4710,13 @@ SRST
 ERST
 
 DEF("icount", HAS_ARG, QEMU_OPTION_icount, \
-    "-icount [shift=N|auto][,align=on|off][,sleep=on|off][,rr=record|replay,rrfile=<filename>[,rrsnapshot=<snapshot>]]\n" \
+    "-icount [shift=N|auto][,align=on|off][,sleep=on|off][,rr=record|replay,rrfile=<filename>[,rrsnapshot=<snapshot>][,rrperiod=<seconds>]]\n" \
     "                enable virtual instruction counter with 2^N clock ticks per\n" \
     "                instruction, enable aligning the host and virtual clocks\n" \
     "                or disable real time cpu sleeping, and optionally enable\n" \
     "                record-and-replay mode\n", QEMU_ARCH_ALL)
 SRST
-``-icount [shift=N|auto][,align=on|off][,sleep=on|off][,rr=record|replay,rrfile=filename[,rrsnapshot=snapshot]]``
+``-icount [shift=N|auto][,align=on|off][,sleep=on|off][,rr=record|replay,rrfile=filename[,rrsnapshot=snapshot][,rrperiod=seconds]]``
     Enable virtual instruction counter. The virtual cpu will execute one
     instruction every 2^N ns of virtual time. If ``auto`` is specified
     then the virtual cpu speed will be automatically adjusted to keep
@@ -4713,6 +4758,11 @@ SRST
     name. In record mode, a new VM snapshot with the given name is created
     at the start of execution recording. In replay mode this option
     specifies the snapshot name used to load the initial VM state.
+    If the ``rrperiod`` option is given then additional VM snapshots named
+    ``periodic_<icount>`` are created every ``rrperiod`` seconds. Reverse
+    debugging commands resume execution from the nearest preceding
+    snapshot, so periodic snapshots bound the amount of execution that
+    has to be repeated for each reverse step.
 ERST
 
 DEF("watchdog-action", HAS_ARG, QEMU_OPTION_watchdog_action, \
@@ -5010,6 +5060,15 @@ SRST
     forcefully killed with SIGKILL before the main QEMU process has
     terminated completely.
 
+    This is particularly useful for guests with very large amounts of RAM
+    (especially hugetlb-backed), where dropping the page tables and
+    returning the pages to the host can take tens of seconds and would
+    otherwise delay the exit visible to the management software, since the
+    whole address-space teardown is charged to the exit of the cleanup
+    process instead. Note that a memory backend configured with
+    ``discard-data=on`` still discards its pages synchronously before the
+    main process exits.
+
     ``chroot=dir`` can be used for doing a chroot to the specified directory
     immediately before starting the guest execution. This is especially useful
     in combination with -runas.
@@ -1317,6 +1317,12 @@ object_property_add(Object *obj, const char *name, const char *type,
                                    opaque, &error_abort);
 }
 
+/*
+ * Bumped whenever a class property is added anywhere, invalidating the
+ * lazily built per-class flattened property tables.
+ */
+static unsigned class_prop_gen = 1;
+
 ObjectProperty *
 object_class_property_add(ObjectClass *klass,
                           const char *name,
@@ -1341,6 +1347,7 @@ object_class_property_add(ObjectClass *klass,
     prop->opaque = opaque;
 
     g_hash_table_insert(klass->properties, prop->name, prop);
+    class_prop_gen++;
 
     return prop;
 }
@@ -1396,20 +1403,42 @@ void object_class_property_iter_init(ObjectPropertyIterator *iter,
     iter->nextclass = object_class_get_parent(klass);
 }
 
-ObjectProperty *object_class_property_find(ObjectClass *klass, const char *name)
+static GHashTable *object_class_flat_properties(ObjectClass *klass)
 {
-    ObjectClass *parent_klass;
+    ObjectClass *k;
 
-    parent_klass = object_class_get_parent(klass);
-    if (parent_klass) {
-        ObjectProperty *prop =
-            object_class_property_find(parent_klass, name);
-        if (prop) {
-            return prop;
+    if (klass->flat_properties &&
+        klass->flat_properties_gen == class_prop_gen) {
+        return klass->flat_properties;
+    }
+
+    /*
+     * The values are borrowed from the per-class tables, which only
+     * ever grow: class properties cannot be deleted.
+     */
+    if (!klass->flat_properties) {
+        klass->flat_properties = g_hash_table_new(g_str_hash, g_str_equal);
+    } else {
+        g_hash_table_remove_all(klass->flat_properties);
+    }
+
+    for (k = klass; k; k = object_class_get_parent(k)) {
+        GHashTableIter iter;
+        gpointer name, prop;
+
+        g_hash_table_iter_init(&iter, k->properties);
+        while (g_hash_table_iter_next(&iter, &name, &prop)) {
+            g_hash_table_insert(klass->flat_properties, name, prop);
         }
     }
+    klass->flat_properties_gen = class_prop_gen;
 
-    return g_hash_table_lookup(klass->properties, name);
+    return klass->flat_properties;
+}
+
+ObjectProperty *object_class_property_find(ObjectClass *klass, const char *name)
+{
+    return g_hash_table_lookup(object_class_flat_properties(klass), name);
 }
 
 ObjectProperty *object_class_property_find_err(ObjectClass *klass,
@@ -105,6 +105,8 @@ extern FILE *replay_file;
 extern uint64_t replay_break_icount;
 /* Timer for the replay breakpoint callback */
 extern QEMUTimer *replay_break_timer;
+/* Period of the periodic snapshots, in seconds (0 = disabled) */
+extern int replay_snapshot_period;
 
 void replay_put_byte(uint8_t byte);
 void replay_put_event(uint8_t event);
@@ -212,4 +214,10 @@ G_NORETURN void replay_sync_error(const char *error);
    to make cached timers available for post_load functions. */
 void replay_vmstate_register(void);
 
+/*! Starts the timer that creates periodic VM snapshots
+    (when enabled with the rrperiod icount suboption). */
+void replay_periodic_snapshot_init(void);
+/*! Stops the periodic snapshot timer. */
+void replay_periodic_snapshot_cleanup(void);
+
 #endif
@@ -16,9 +16,13 @@
 #include "monitor/monitor.h"
 #include "qapi/qmp/qstring.h"
 #include "qemu/error-report.h"
+#include "qemu/timer.h"
 #include "migration/vmstate.h"
 #include "migration/snapshot.h"
 
+/* Timer for the periodic snapshots */
+static QEMUTimer *replay_snapshot_timer;
+
 static int replay_pre_save(void *opaque)
 {
     ReplayState *state = opaque;
@@ -97,3 +101,47 @@ bool replay_can_snapshot(void)
     return replay_mode == REPLAY_MODE_NONE
         || !replay_has_events();
 }
+
+static void replay_snapshot_timer_schedule(void)
+{
+    timer_mod(replay_snapshot_timer,
+              qemu_clock_get_ms(QEMU_CLOCK_REALTIME)
+              + replay_snapshot_period * 1000LL);
+}
+
+static void replay_snapshot_timer_cb(void *opaque)
+{
+    Error *err = NULL;
+
+    if (replay_can_snapshot()) {
+        g_autofree char *name =
+            g_strdup_printf("periodic_%" PRId64, replay_get_current_icount());
+        if (!save_snapshot(name, true, NULL, false, NULL, &err)) {
+            error_report_err(err);
+            error_report("Could not create periodic snapshot, "
+                         "disabling periodic snapshots");
+            return;
+        }
+    }
+    /* If events were in flight, just try again on the next period. */
+    replay_snapshot_timer_schedule();
+}
+
+void replay_periodic_snapshot_init(void)
+{
+    if (!replay_snapshot_period) {
+        return;
+    }
+
+    replay_snapshot_timer = timer_new_ms(QEMU_CLOCK_REALTIME,
+                                         replay_snapshot_timer_cb, NULL);
+    replay_snapshot_timer_schedule();
+}
+
+void replay_periodic_snapshot_cleanup(void)
+{
+    if (replay_snapshot_timer) {
+        timer_free(replay_snapshot_timer);
+        replay_snapshot_timer = NULL;
+    }
+}
@@ -38,6 +38,9 @@ static GSList *replay_blockers;
 uint64_t replay_break_icount = -1ULL;
 QEMUTimer *replay_break_timer;
 
+/* Period of the periodic snapshots, in seconds (0 = disabled) */
+int replay_snapshot_period;
+
 /* Pretty print event names */
 
 static const char *replay_async_event_name(ReplayAsyncEventKind event)
@@ -422,6 +425,7 @@ void replay_configure(QemuOpts *opts)
     }
 
     replay_snapshot = g_strdup(qemu_opt_get(opts, "rrsnapshot"));
+    replay_snapshot_period = qemu_opt_get_number(opts, "rrperiod", 0);
     replay_vmstate_register();
     replay_enable(fname, mode);
 
@@ -444,7 +448,7 @@ void replay_start(void)
         exit(1);
     }
 
-    /* Timer for snapshotting will be set up here. */
+    replay_periodic_snapshot_init();
 
     replay_enable_events();
 }
@@ -476,6 +480,7 @@ void replay_finish(void)
         return;
     }
 
+    replay_periodic_snapshot_cleanup();
     replay_save_instructions();
 
     /* finalize the file */
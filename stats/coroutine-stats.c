@@ -0,0 +1,147 @@
+/*
+ * Coroutine pool and CoMutex statistics for the QMP query-stats command
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or
+ * (at your option) any later version.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/coroutine.h"
+#include "sysemu/stats.h"
+
+static StatsList *coroutine_stats_add(const char *name, uint64_t val,
+                                      strList *names, StatsList *stats_list)
+{
+    Stats *stats;
+
+    if (!apply_str_list_filter(name, names)) {
+        return stats_list;
+    }
+
+    stats = g_new0(Stats, 1);
+    stats->name = g_strdup(name);
+    stats->value = g_new0(StatsValue, 1);
+    stats->value->type = QTYPE_QNUM;
+    stats->value->u.scalar = val;
+
+    QAPI_LIST_PREPEND(stats_list, stats);
+    return stats_list;
+}
+
+typedef struct {
+    StatsList *stats_list;
+    strList *names;
+} CoMutexStatsArgs;
+
+static void co_mutex_stats(const char *name, uint64_t acquisitions,
+                           uint64_t contentions, uint64_t wait_ns,
+                           uint64_t hold_ns, void *opaque)
+{
+    CoMutexStatsArgs *args = opaque;
+    g_autofree char *acq_name = g_strdup_printf("mutex-%s-acquisitions", name);
+    g_autofree char *cont_name = g_strdup_printf("mutex-%s-contentions", name);
+    g_autofree char *wait_name = g_strdup_printf("mutex-%s-wait-ns", name);
+    g_autofree char *hold_name = g_strdup_printf("mutex-%s-hold-ns", name);
+
+    args->stats_list = coroutine_stats_add(acq_name, acquisitions,
+                                           args->names, args->stats_list);
+    args->stats_list = coroutine_stats_add(cont_name, contentions,
+                                           args->names, args->stats_list);
+    args->stats_list = coroutine_stats_add(wait_name, wait_ns,
+                                           args->names, args->stats_list);
+    args->stats_list = coroutine_stats_add(hold_name, hold_ns,
+                                           args->names, args->stats_list);
+}
+
+static void coroutine_stats_cb(StatsResultList **result, StatsTarget target,
+                               strList *names, strList *targets, Error **errp)
+{
+    CoMutexStatsArgs args = { .names = names };
+    uint64_t allocations;
+    uint64_t pool_hits;
+    uint64_t pool_size;
+
+    if (target != STATS_TARGET_VM) {
+        return;
+    }
+
+    qemu_coroutine_pool_stats(&allocations, &pool_hits, &pool_size);
+
+    args.stats_list = coroutine_stats_add("allocations", allocations, names,
+                                          args.stats_list);
+    args.stats_list = coroutine_stats_add("pool-hits", pool_hits, names,
+                                          args.stats_list);
+    args.stats_list = coroutine_stats_add("pool-size", pool_size, names,
+                                          args.stats_list);
+
+    qemu_co_mutex_profile_foreach(co_mutex_stats, &args);
+
+    if (args.stats_list) {
+        add_stats_entry(result, STATS_PROVIDER_COROUTINE, NULL,
+                        args.stats_list);
+    }
+}
+
+static StatsSchemaValueList *coroutine_schema_add(StatsSchemaValueList *list,
+                                                  const char *name,
+                                                  StatsType type,
+                                                  bool nanoseconds)
+{
+    StatsSchemaValueList *entry = g_new0(StatsSchemaValueList, 1);
+
+    entry->value = g_new0(StatsSchemaValue, 1);
+    entry->value->name = g_strdup(name);
+    entry->value->type = type;
+    if (nanoseconds) {
+        entry->value->has_unit = true;
+        entry->value->unit = STATS_UNIT_SECONDS;
+        entry->value->has_base = true;
+        entry->value->base = 10;
+        entry->value->exponent = -9;
+    }
+    entry->next = list;
+    return entry;
+}
+
+static void co_mutex_schemas(const char *name, uint64_t acquisitions,
+                             uint64_t contentions, uint64_t wait_ns,
+                             uint64_t hold_ns, void *opaque)
+{
+    StatsSchemaValueList **list = opaque;
+    g_autofree char *acq_name = g_strdup_printf("mutex-%s-acquisitions", name);
+    g_autofree char *cont_name = g_strdup_printf("mutex-%s-contentions", name);
+    g_autofree char *wait_name = g_strdup_printf("mutex-%s-wait-ns", name);
+    g_autofree char *hold_name = g_strdup_printf("mutex-%s-hold-ns", name);
+
+    *list = coroutine_schema_add(*list, acq_name, STATS_TYPE_CUMULATIVE,
+                                 false);
+    *list = coroutine_schema_add(*list, cont_name, STATS_TYPE_CUMULATIVE,
+                                 false);
+    *list = coroutine_schema_add(*list, wait_name, STATS_TYPE_CUMULATIVE,
+                                 true);
+    *list = coroutine_schema_add(*list, hold_name, STATS_TYPE_CUMULATIVE,
+                                 true);
+}
+
+static void coroutine_schemas_cb(StatsSchemaList **result, Error **errp)
+{
+    StatsSchemaValueList *stats_list = NULL;
+
+    stats_list = coroutine_schema_add(stats_list, "allocations",
+                                      STATS_TYPE_CUMULATIVE, false);
+    stats_list = coroutine_schema_add(stats_list, "pool-hits",
+                                      STATS_TYPE_CUMULATIVE, false);
+    stats_list = coroutine_schema_add(stats_list, "pool-size",
+                                      STATS_TYPE_INSTANT, false);
+
+    qemu_co_mutex_profile_foreach(co_mutex_schemas, &stats_list);
+
+    add_stats_schema(result, STATS_PROVIDER_COROUTINE, STATS_TARGET_VM,
+                     stats_list);
+}
+
+static void __attribute__((constructor)) coroutine_stats_init(void)
+{
+    add_stats_callbacks(STATS_PROVIDER_COROUTINE, coroutine_stats_cb,
+                        coroutine_schemas_cb);
+}
@@ -0,0 +1,99 @@
+/*
+ * QMP commands for the hot-path counter registry
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or
+ * (at your option) any later version.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/profile.h"
+#include "sysemu/stats.h"
+#include "qapi/qapi-commands-stats.h"
+#include "qapi/error.h"
+
+typedef struct ProfileQueryArgs {
+    ProfileInfo *info;
+    strList *names;
+} ProfileQueryArgs;
+
+static void profile_query_counter(ProfileCounter *counter, void *opaque)
+{
+    ProfileQueryArgs *args = opaque;
+    ProfileCounterInfo *entry;
+
+    if (!apply_str_list_filter(counter->name, args->names)) {
+        return;
+    }
+
+    entry = g_new0(ProfileCounterInfo, 1);
+    entry->name = g_strdup(counter->name);
+    entry->value = profile_counter_get(counter);
+    QAPI_LIST_PREPEND(args->info->counters, entry);
+}
+
+static void profile_query_histogram(ProfileHistogram *histogram, void *opaque)
+{
+    ProfileQueryArgs *args = opaque;
+    ProfileHistogramInfo *entry;
+    uint64List **tail;
+    unsigned nbuckets, i;
+
+    if (!apply_str_list_filter(histogram->name, args->names)) {
+        return;
+    }
+
+    nbuckets = PROFILE_HISTOGRAM_BUCKETS;
+    while (nbuckets > 0 &&
+           !profile_histogram_bucket(histogram, nbuckets - 1)) {
+        nbuckets--;
+    }
+
+    entry = g_new0(ProfileHistogramInfo, 1);
+    entry->name = g_strdup(histogram->name);
+    tail = &entry->buckets;
+    for (i = 0; i < nbuckets; i++) {
+        QAPI_LIST_APPEND(tail, profile_histogram_bucket(histogram, i));
+    }
+    QAPI_LIST_PREPEND(args->info->histograms, entry);
+}
+
+ProfileInfo *qmp_query_profile(bool has_names, strList *names, Error **errp)
+{
+    ProfileQueryArgs args = {
+        .info = g_new0(ProfileInfo, 1),
+        .names = names,
+    };
+
+    /* A present but empty list matches nothing, like query-stats */
+    if (has_names && !names) {
+        return args.info;
+    }
+
+    profile_counter_foreach(profile_query_counter, &args);
+    profile_histogram_foreach(profile_query_histogram, &args);
+    return args.info;
+}
+
+static void profile_reset_counter(ProfileCounter *counter, void *opaque)
+{
+    if (apply_str_list_filter(counter->name, opaque)) {
+        profile_counter_reset(counter);
+    }
+}
+
+static void profile_reset_histogram(ProfileHistogram *histogram, void *opaque)
+{
+    if (apply_str_list_filter(histogram->name, opaque)) {
+        profile_histogram_reset(histogram);
+    }
+}
+
+void qmp_profile_reset(bool has_names, strList *names, Error **errp)
+{
+    if (has_names && !names) {
+        return;
+    }
+
+    profile_counter_foreach(profile_reset_counter, names);
+    profile_histogram_foreach(profile_reset_histogram, names);
+}
@@ -0,0 +1,81 @@
+/*
+ * RCU callback queue statistics for the QMP query-stats command
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or
+ * (at your option) any later version.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/rcu.h"
+#include "sysemu/stats.h"
+
+static StatsList *rcu_stats_add(const char *name, uint64_t val,
+                                strList *names, StatsList *stats_list)
+{
+    Stats *stats;
+
+    if (!apply_str_list_filter(name, names)) {
+        return stats_list;
+    }
+
+    stats = g_new0(Stats, 1);
+    stats->name = g_strdup(name);
+    stats->value = g_new0(StatsValue, 1);
+    stats->value->type = QTYPE_QNUM;
+    stats->value->u.scalar = val;
+
+    QAPI_LIST_PREPEND(stats_list, stats);
+    return stats_list;
+}
+
+static void rcu_stats_cb(StatsResultList **result, StatsTarget target,
+                         strList *names, strList *targets, Error **errp)
+{
+    StatsList *stats_list = NULL;
+    uint64_t pending;
+    uint64_t forced_notifies;
+
+    if (target != STATS_TARGET_VM) {
+        return;
+    }
+
+    rcu_call_stats(&pending, &forced_notifies);
+
+    stats_list = rcu_stats_add("pending-callbacks", pending, names,
+                               stats_list);
+    stats_list = rcu_stats_add("forced-notifies", forced_notifies, names,
+                               stats_list);
+
+    if (stats_list) {
+        add_stats_entry(result, STATS_PROVIDER_RCU, NULL, stats_list);
+    }
+}
+
+static StatsSchemaValueList *rcu_schema_add(StatsSchemaValueList *list,
+                                            const char *name, StatsType type)
+{
+    StatsSchemaValueList *entry = g_new0(StatsSchemaValueList, 1);
+
+    entry->value = g_new0(StatsSchemaValue, 1);
+    entry->value->name = g_strdup(name);
+    entry->value->type = type;
+    entry->next = list;
+    return entry;
+}
+
+static void rcu_schemas_cb(StatsSchemaList **result, Error **errp)
+{
+    StatsSchemaValueList *stats_list = NULL;
+
+    stats_list = rcu_schema_add(stats_list, "pending-callbacks",
+                                STATS_TYPE_INSTANT);
+    stats_list = rcu_schema_add(stats_list, "forced-notifies",
+                                STATS_TYPE_CUMULATIVE);
+
+    add_stats_schema(result, STATS_PROVIDER_RCU, STATS_TARGET_VM, stats_list);
+}
+
+static void __attribute__((constructor)) rcu_stats_init(void)
+{
+    add_stats_callbacks(STATS_PROVIDER_RCU, rcu_stats_cb, rcu_schemas_cb);
+}
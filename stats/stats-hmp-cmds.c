@@ -157,6 +157,8 @@ static StatsFilter *stats_filter(StatsTarget target, const char *names,
     }
     case STATS_TARGET_CRYPTODEV:
         break;
+    case STATS_TARGET_VIRTIO:
+        break;
     default:
         break;
     }
@@ -231,6 +233,9 @@ void hmp_info_stats(Monitor *mon, const QDict *qdict)
     case STATS_TARGET_CRYPTODEV:
         filter = stats_filter(target, names, -1, provider);
         break;
+    case STATS_TARGET_VIRTIO:
+        filter = stats_filter(target, names, -1, provider);
+        break;
     default:
         abort();
     }
@@ -66,6 +66,8 @@ static bool invoke_stats_cb(StatsCallbacks *entry,
         break;
     case STATS_TARGET_CRYPTODEV:
         break;
+    case STATS_TARGET_VIRTIO:
+        break;
     default:
         abort();
     }
@@ -0,0 +1,339 @@
+/*
+ * BQL hold/wait profiling
+ *
+ * The BQL is taken from so many places that contention is hard to diagnose
+ * from the outside.  When profiling is enabled, every acquisition records
+ * the time spent waiting for the lock and every release records how long
+ * the lock was held, both attributed to the call site that took the lock.
+ * Holds longer than a configurable threshold additionally capture the
+ * holder's stack, and the aggregated stacks can be dumped in collapsed
+ * form for flamegraph tooling.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+
+#include "qemu/osdep.h"
+#ifdef CONFIG_BACKTRACE
+#include <execinfo.h>
+#endif
+#include "qemu/timer.h"
+#include "qemu/host-utils.h"
+#include "qemu/main-loop.h"
+#include "qapi/error.h"
+#include "qapi/type-helpers.h"
+#include "qapi/qapi-commands-machine.h"
+#include "sysemu/bql-prof.h"
+
+enum {
+    BQL_PROF_HIST_BUCKETS = 64,
+    BQL_PROF_MAX_FRAMES = 32,
+};
+
+/* Holds at least this long have their stack captured */
+#define BQL_PROF_DEFAULT_THRESHOLD_NS (SCALE_MS * 1)
+
+bool bql_prof_enabled;
+
+typedef struct BQLProfCaller {
+    const char *file;
+    int line;
+    uint64_t locks;
+    uint64_t wait_total_ns;
+    uint64_t wait_max_ns;
+    uint64_t hold_total_ns;
+    uint64_t hold_max_ns;
+    /* log2(ns) histograms */
+    uint32_t wait_hist[BQL_PROF_HIST_BUCKETS];
+    uint32_t hold_hist[BQL_PROF_HIST_BUCKETS];
+} BQLProfCaller;
+
+typedef struct BQLProfStack {
+    void *frames[BQL_PROF_MAX_FRAMES];
+    int nframes;
+    /* lock call site, reported when backtraces are not available */
+    const char *file;
+    int line;
+    uint64_t samples;
+    uint64_t hold_total_ns;
+} BQLProfStack;
+
+/*
+ * All of the state below is only accessed with the BQL held: the acquire
+ * and release hooks run in the lock holder, and the monitor commands run
+ * in the main loop.  No further locking is needed.
+ */
+static int64_t bql_prof_threshold_ns = BQL_PROF_DEFAULT_THRESHOLD_NS;
+static GHashTable *bql_prof_callers;
+static GHashTable *bql_prof_stacks;
+
+/* The hold in progress; only valid between acquire and release */
+static const char *holder_file;
+static int holder_line;
+static int64_t holder_t0;
+
+static guint caller_hash(gconstpointer key)
+{
+    const BQLProfCaller *c = key;
+
+    /*
+     * Inlined lock functions can pass distinct string literals for the
+     * same file, so hash the contents rather than the pointer.
+     */
+    return g_str_hash(c->file) ^ g_int_hash(&c->line);
+}
+
+static gboolean caller_equal(gconstpointer ap, gconstpointer bp)
+{
+    const BQLProfCaller *a = ap;
+    const BQLProfCaller *b = bp;
+
+    return a->line == b->line &&
+           (a->file == b->file || !strcmp(a->file, b->file));
+}
+
+static guint stack_hash(gconstpointer key)
+{
+    const BQLProfStack *s = key;
+    guint hash = g_str_hash(s->file) ^ g_int_hash(&s->line);
+    int i;
+
+    for (i = 0; i < s->nframes; i++) {
+        hash = hash * 31 + g_direct_hash(s->frames[i]);
+    }
+    return hash;
+}
+
+static gboolean stack_equal(gconstpointer ap, gconstpointer bp)
+{
+    const BQLProfStack *a = ap;
+    const BQLProfStack *b = bp;
+
+    return a->nframes == b->nframes && a->line == b->line &&
+           !strcmp(a->file, b->file) &&
+           !memcmp(a->frames, b->frames, a->nframes * sizeof(a->frames[0]));
+}
+
+static unsigned hist_bucket(int64_t ns)
+{
+    return ns <= 0 ? 0 : MIN(BQL_PROF_HIST_BUCKETS - 1, 63 - clz64(ns));
+}
+
+void bql_prof_acquire(const char *file, int line, int64_t wait_ns)
+{
+    BQLProfCaller key = { .file = file, .line = line };
+    BQLProfCaller *c;
+
+    holder_file = file;
+    holder_line = line;
+    holder_t0 = get_clock();
+
+    c = g_hash_table_lookup(bql_prof_callers, &key);
+    if (!c) {
+        c = g_new0(BQLProfCaller, 1);
+        c->file = file;
+        c->line = line;
+        g_hash_table_add(bql_prof_callers, c);
+    }
+    c->locks++;
+    c->wait_total_ns += wait_ns;
+    c->wait_max_ns = MAX(c->wait_max_ns, wait_ns);
+    c->wait_hist[hist_bucket(wait_ns)]++;
+}
+
+static void bql_prof_sample_stack(int64_t hold_ns)
+{
+    BQLProfStack key = { .file = holder_file, .line = holder_line };
+    BQLProfStack *s;
+
+#ifdef CONFIG_BACKTRACE
+    key.nframes = backtrace(key.frames, BQL_PROF_MAX_FRAMES);
+#endif
+
+    s = g_hash_table_lookup(bql_prof_stacks, &key);
+    if (!s) {
+        s = g_memdup2(&key, sizeof(key));
+        g_hash_table_add(bql_prof_stacks, s);
+    }
+    s->samples++;
+    s->hold_total_ns += hold_ns;
+}
+
+void bql_prof_release(void)
+{
+    BQLProfCaller key = { .file = holder_file, .line = holder_line };
+    BQLProfCaller *c;
+    int64_t hold_ns;
+
+    if (!holder_file) {
+        /* profiling was enabled in the middle of this hold */
+        return;
+    }
+
+    hold_ns = get_clock() - holder_t0;
+    c = g_hash_table_lookup(bql_prof_callers, &key);
+    if (c) {
+        c->hold_total_ns += hold_ns;
+        c->hold_max_ns = MAX(c->hold_max_ns, hold_ns);
+        c->hold_hist[hist_bucket(hold_ns)]++;
+    }
+
+    if (hold_ns >= bql_prof_threshold_ns) {
+        bql_prof_sample_stack(hold_ns);
+    }
+    holder_file = NULL;
+}
+
+bool bql_prof_is_enabled(void)
+{
+    return qatomic_read(&bql_prof_enabled);
+}
+
+void bql_prof_enable(int64_t threshold_ns)
+{
+    assert(bql_locked());
+
+    if (!bql_prof_callers) {
+        bql_prof_callers = g_hash_table_new_full(caller_hash, caller_equal,
+                                                 g_free, NULL);
+        bql_prof_stacks = g_hash_table_new_full(stack_hash, stack_equal,
+                                                g_free, NULL);
+    }
+    if (threshold_ns > 0) {
+        bql_prof_threshold_ns = threshold_ns;
+    }
+    /* the current hold started unobserved, skip its release */
+    holder_file = NULL;
+    qatomic_set(&bql_prof_enabled, true);
+}
+
+void bql_prof_disable(void)
+{
+    qatomic_set(&bql_prof_enabled, false);
+}
+
+void bql_prof_reset(void)
+{
+    assert(bql_locked());
+
+    if (bql_prof_callers) {
+        g_hash_table_remove_all(bql_prof_callers);
+        g_hash_table_remove_all(bql_prof_stacks);
+    }
+}
+
+static gint caller_cmp_hold(gconstpointer ap, gconstpointer bp)
+{
+    const BQLProfCaller *a = ap;
+    const BQLProfCaller *b = bp;
+
+    if (a->hold_total_ns == b->hold_total_ns) {
+        return 0;
+    }
+    return a->hold_total_ns > b->hold_total_ns ? -1 : 1;
+}
+
+static void format_hist(GString *buf, const char *label,
+                        const uint32_t *hist)
+{
+    int i;
+
+    g_string_append_printf(buf, "    %s (log2 ns):", label);
+    for (i = 0; i < BQL_PROF_HIST_BUCKETS; i++) {
+        if (hist[i]) {
+            g_string_append_printf(buf, " %d:%" PRIu32, i, hist[i]);
+        }
+    }
+    g_string_append_c(buf, '\n');
+}
+
+static void format_callers(GString *buf)
+{
+    GList *list = g_hash_table_get_keys(bql_prof_callers);
+    GList *elem;
+
+    list = g_list_sort(list, caller_cmp_hold);
+    g_string_append_printf(buf, "%10s %14s %14s %14s %14s  %s\n",
+                           "Locks", "Hold time (s)", "Max hold (s)",
+                           "Wait time (s)", "Max wait (s)", "Call site");
+    for (elem = list; elem; elem = elem->next) {
+        BQLProfCaller *c = elem->data;
+
+        g_string_append_printf(buf,
+                               "%10" PRIu64 " %14.6f %14.6f %14.6f %14.6f"
+                               "  %s:%d\n",
+                               c->locks,
+                               c->hold_total_ns / 1e9, c->hold_max_ns / 1e9,
+                               c->wait_total_ns / 1e9, c->wait_max_ns / 1e9,
+                               c->file, c->line);
+        format_hist(buf, "hold", c->hold_hist);
+        format_hist(buf, "wait", c->wait_hist);
+    }
+    g_list_free(list);
+}
+
+static void format_stack(GString *buf, const BQLProfStack *s)
+{
+#ifdef CONFIG_BACKTRACE
+    if (s->nframes) {
+        char **symbols = backtrace_symbols((void *const *)s->frames,
+                                           s->nframes);
+        int i;
+
+        g_string_append(buf, "qemu");
+        /*
+         * Print outermost frame first as flamegraph tooling expects,
+         * skipping the profiler's own frames (bql_prof_sample_stack and
+         * bql_prof_release).
+         */
+        for (i = s->nframes - 1; i >= 2; i--) {
+            char *open, *plus;
+
+            g_string_append_c(buf, ';');
+            open = symbols ? strchr(symbols[i], '(') : NULL;
+            plus = open ? strchr(open, '+') : NULL;
+            if (plus && plus > open + 1) {
+                g_string_append_len(buf, open + 1, plus - open - 1);
+            } else {
+                g_string_append_printf(buf, "%p", s->frames[i]);
+            }
+        }
+        g_string_append_printf(buf, " %" PRIu64 "\n", s->hold_total_ns);
+        free(symbols);
+        return;
+    }
+#endif
+    g_string_append_printf(buf, "qemu;%s:%d %" PRIu64 "\n",
+                           s->file, s->line, s->hold_total_ns);
+}
+
+static void format_stacks(GString *buf)
+{
+    GHashTableIter iter;
+    gpointer key;
+
+    g_string_append_printf(buf,
+                           "Long holds (>= %" PRId64 " ns), collapsed stacks, "
+                           "value is nanoseconds held:\n",
+                           bql_prof_threshold_ns);
+    g_hash_table_iter_init(&iter, bql_prof_stacks);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        format_stack(buf, key);
+    }
+}
+
+HumanReadableText *qmp_x_query_bql(Error **errp)
+{
+    g_autoptr(GString) buf = g_string_new("");
+
+    g_string_append_printf(buf, "BQL profiling is %s\n",
+                           bql_prof_is_enabled() ? "on" : "off");
+    if (!bql_prof_callers) {
+        return human_readable_text_from_str(buf);
+    }
+
+    format_callers(buf);
+    format_stacks(buf);
+
+    return human_readable_text_from_str(buf);
+}
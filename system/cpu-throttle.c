@@ -28,6 +28,7 @@
 #include "qemu/main-loop.h"
 #include "sysemu/cpus.h"
 #include "sysemu/cpu-throttle.h"
+#include "sysemu/dirtylimit.h"
 
 /* vcpu throttling controls */
 static QEMUTimer *throttle_timer;
@@ -66,16 +67,46 @@ static void cpu_throttle_thread(CPUState *cpu, run_on_cpu_data opaque)
     qatomic_set(&cpu->throttle_thread_scheduled, 0);
 }
 
+/*
+ * Returns whether @cpu may be spared from throttling because it is
+ * hardly dirtying memory.  Only meaningful while per-vCPU dirty rates
+ * are being collected (KVM dirty ring); slowing down a vCPU that isn't
+ * producing dirty pages cannot help migration converge, it only hurts
+ * whatever that vCPU is serving.
+ */
+static bool cpu_throttle_skip_cpu(CPUState *cpu, int64_t total_rate)
+{
+    int64_t rate;
+
+    if (total_rate <= 0) {
+        return false;
+    }
+
+    rate = vcpu_dirty_rate_get(cpu->cpu_index);
+
+    /* Spare vCPUs contributing less than 1% of the dirty rate */
+    return rate >= 0 && rate * 100 < total_rate;
+}
+
 static void cpu_throttle_timer_tick(void *opaque)
 {
     CPUState *cpu;
     double pct;
+    int64_t total_rate = 0;
 
     /* Stop the timer if needed */
     if (!cpu_throttle_get_percentage()) {
         return;
     }
+    if (vcpu_dirty_rate_stat_running()) {
+        CPU_FOREACH(cpu) {
+            total_rate += MAX(vcpu_dirty_rate_get(cpu->cpu_index), 0);
+        }
+    }
     CPU_FOREACH(cpu) {
+        if (cpu_throttle_skip_cpu(cpu, total_rate)) {
+            continue;
+        }
         if (!qatomic_xchg(&cpu->throttle_thread_scheduled, 1)) {
             async_run_on_cpu(cpu, cpu_throttle_thread,
                              RUN_ON_CPU_NULL);
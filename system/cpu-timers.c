@@ -83,21 +83,44 @@ int64_t cpu_get_clock_locked(void)
     return time;
 }
 
+/*
+ * The clock parameters change only when the VM is started or stopped
+ * (and, with icount, when the bias is adjusted).  Cache them per thread,
+ * revalidated against the seqlock sequence, so that concurrent clock
+ * readers normally touch a single shared cache line instead of pulling
+ * the whole payload of timers_state.
+ */
+typedef struct CPUClockCache {
+    unsigned sequence;
+    int16_t cpu_ticks_enabled;
+    int64_t cpu_clock_offset;
+} CPUClockCache;
+
+/* sequence 1 is odd and thus never matches a stable seqlock read */
+static __thread CPUClockCache cpu_clock_cache = { .sequence = 1 };
+
 /*
  * Return the monotonic time elapsed in VM, i.e.,
  * the time between vm_start and vm_stop
  */
 int64_t cpu_get_clock(void)
 {
-    int64_t ti;
-    unsigned start;
+    CPUClockCache *c = &cpu_clock_cache;
 
-    do {
-        start = seqlock_read_begin(&timers_state.vm_clock_seqlock);
-        ti = cpu_get_clock_locked();
-    } while (seqlock_read_retry(&timers_state.vm_clock_seqlock, start));
+    if (unlikely(seqlock_read_retry(&timers_state.vm_clock_seqlock,
+                                    c->sequence))) {
+        do {
+            c->sequence = seqlock_read_begin(&timers_state.vm_clock_seqlock);
+            c->cpu_ticks_enabled = timers_state.cpu_ticks_enabled;
+            c->cpu_clock_offset = timers_state.cpu_clock_offset;
+        } while (seqlock_read_retry(&timers_state.vm_clock_seqlock,
+                                    c->sequence));
+    }
 
-    return ti;
+    if (c->cpu_ticks_enabled) {
+        return c->cpu_clock_offset + get_clock();
+    }
+    return c->cpu_clock_offset;
 }
 
 /*
@@ -42,6 +42,7 @@
 #include "sysemu/replay.h"
 #include "sysemu/runstate.h"
 #include "sysemu/cpu-timers.h"
+#include "sysemu/bql-prof.h"
 #include "sysemu/whpx.h"
 #include "hw/boards.h"
 #include "hw/hw.h"
@@ -522,25 +523,48 @@ void bql_lock_impl(const char *file, int line)
     QemuMutexLockFunc bql_lock_fn = qatomic_read(&bql_mutex_lock_func);
 
     g_assert(!bql_locked());
-    bql_lock_fn(&bql, file, line);
+    if (unlikely(qatomic_read(&bql_prof_enabled))) {
+        int64_t t0 = get_clock();
+
+        bql_lock_fn(&bql, file, line);
+        bql_prof_acquire(file, line, get_clock() - t0);
+    } else {
+        bql_lock_fn(&bql, file, line);
+    }
     set_bql_locked(true);
 }
 
 void bql_unlock(void)
 {
     g_assert(bql_locked());
+    if (unlikely(qatomic_read(&bql_prof_enabled))) {
+        bql_prof_release();
+    }
     set_bql_locked(false);
     qemu_mutex_unlock(&bql);
 }
 
 void qemu_cond_wait_bql(QemuCond *cond)
 {
+    /* the BQL is released while waiting, account it as a separate hold */
+    if (unlikely(qatomic_read(&bql_prof_enabled))) {
+        bql_prof_release();
+    }
     qemu_cond_wait(cond, &bql);
+    if (unlikely(qatomic_read(&bql_prof_enabled))) {
+        bql_prof_acquire(__FILE__, __LINE__, 0);
+    }
 }
 
 void qemu_cond_timedwait_bql(QemuCond *cond, int ms)
 {
+    if (unlikely(qatomic_read(&bql_prof_enabled))) {
+        bql_prof_release();
+    }
     qemu_cond_timedwait(cond, &bql, ms);
+    if (unlikely(qatomic_read(&bql_prof_enabled))) {
+        bql_prof_acquire(__FILE__, __LINE__, 0);
+    }
 }
 
 /* signal CPU creation */
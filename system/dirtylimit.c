@@ -127,6 +127,12 @@ int64_t vcpu_dirty_rate_get(int cpu_index)
     return qatomic_read_i64(&rates[cpu_index].dirty_rate);
 }
 
+bool vcpu_dirty_rate_stat_running(void)
+{
+    return vcpu_dirty_rate_stat &&
+           qatomic_read(&vcpu_dirty_rate_stat->running);
+}
+
 void vcpu_dirty_rate_stat_start(void)
 {
     if (qatomic_read(&vcpu_dirty_rate_stat->running)) {
@@ -749,8 +749,31 @@ static MemoryRegion *memory_region_get_flatview_root(MemoryRegion *mr)
     return NULL;
 }
 
+/*
+ * Whether two views describe the same topology.  Unlike flatrange_equal()
+ * this includes the dirty log mask: a mask change must produce a new view,
+ * or the log_start/log_stop listener callbacks would never run.
+ */
+static bool flatview_ranges_equal(FlatView *a, FlatView *b)
+{
+    unsigned i;
+
+    if (a->nr != b->nr) {
+        return false;
+    }
+
+    for (i = 0; i < a->nr; i++) {
+        if (!flatrange_equal(&a->ranges[i], &b->ranges[i]) ||
+            a->ranges[i].dirty_log_mask != b->ranges[i].dirty_log_mask) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 /* Render a memory topology into a list of disjoint absolute ranges. */
-static FlatView *generate_memory_topology(MemoryRegion *mr)
+static FlatView *generate_memory_topology(MemoryRegion *mr, FlatView *old_view)
 {
     int i;
     FlatView *view;
@@ -764,6 +787,19 @@ static FlatView *generate_memory_topology(MemoryRegion *mr)
     }
     flatview_simplify(view);
 
+    /*
+     * If this root's view did not change there is no need to build a new
+     * dispatch: keep the old view, so that address spaces using it skip
+     * the topology update and the RCU replacement entirely.  The new view
+     * was never visible to readers and can be destroyed in place.
+     */
+    if (old_view && flatview_ranges_equal(view, old_view)) {
+        flatview_destroy(view);
+        flatview_ref(old_view);
+        g_hash_table_replace(flat_views, mr, old_view);
+        return old_view;
+    }
+
     view->dispatch = address_space_dispatch_new(view);
     for (i = 0; i < view->nr; i++) {
         MemoryRegionSection mrs =
@@ -1021,7 +1057,7 @@ static void flatviews_init(void)
     flat_views = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
                                        (GDestroyNotify) flatview_unref);
     if (!empty_view) {
-        empty_view = generate_memory_topology(NULL);
+        empty_view = generate_memory_topology(NULL, NULL);
         /* We keep it alive forever in the global variable.  */
         flatview_ref(empty_view);
     } else {
@@ -1033,11 +1069,13 @@ static void flatviews_init(void)
 static void flatviews_reset(void)
 {
     AddressSpace *as;
+    GHashTable *old_views = flat_views;
 
-    if (flat_views) {
-        g_hash_table_unref(flat_views);
-        flat_views = NULL;
-    }
+    /*
+     * Keep the previous views around while re-rendering, so unchanged
+     * roots can hold on to their current view and dispatch.
+     */
+    flat_views = NULL;
     flatviews_init();
 
     /* Render unique FVs */
@@ -1048,7 +1086,14 @@ static void flatviews_reset(void)
             continue;
         }
 
-        generate_memory_topology(physmr);
+        generate_memory_topology(physmr,
+                                 old_views ? g_hash_table_lookup(old_views,
+                                                                 physmr)
+                                           : NULL);
+    }
+
+    if (old_views) {
+        g_hash_table_unref(old_views);
     }
 }
 
@@ -1103,7 +1148,7 @@ static void address_space_update_topology(AddressSpace *as)
 
     flatviews_init();
     if (!g_hash_table_lookup(flat_views, physmr)) {
-        generate_memory_topology(physmr);
+        generate_memory_topology(physmr, NULL);
     }
     address_space_set_flatview(as);
 }
@@ -2556,6 +2601,28 @@ void memory_region_clear_flush_coalesced(MemoryRegion *mr)
     }
 }
 
+void memory_region_set_coalesced_write_merging(MemoryRegion *mr)
+{
+    mr->coalesced_write_merge = true;
+}
+
+bool memory_region_get_coalesced_write_merging(MemoryRegion *mr)
+{
+    return mr->coalesced_write_merge;
+}
+
+void memory_region_enable_lockless_read(MemoryRegion *mr)
+{
+    mr->lockless_read = true;
+    /*
+     * The reentrancy guard is a plain bool updated under the BQL, which
+     * lockless reads no longer take: concurrent readers would corrupt
+     * engaged_in_io and trigger spurious MEMTX_ACCESS_ERROR.  The guard
+     * cannot protect such a region, so disable it entirely.
+     */
+    mr->disable_reentrancy_guard = true;
+}
+
 void memory_region_add_eventfd(MemoryRegion *mr,
                                hwaddr addr,
                                unsigned size,
@@ -3133,6 +3200,10 @@ void address_space_init(AddressSpace *as, MemoryRegion *root, const char *name)
     as->ioeventfds = NULL;
     QTAILQ_INIT(&as->listeners);
     QTAILQ_INSERT_TAIL(&address_spaces, as, address_spaces_link);
+    as->max_bounce_buffer_size = DEFAULT_MAX_BOUNCE_BUFFER_SIZE;
+    as->bounce_buffer_size = 0;
+    qemu_mutex_init(&as->map_client_list_lock);
+    QLIST_INIT(&as->map_client_list);
     as->name = g_strdup(name ? name : "anonymous");
     address_space_update_topology(as);
     address_space_update_ioeventfds(as);
@@ -3141,6 +3212,9 @@ void address_space_init(AddressSpace *as, MemoryRegion *root, const char *name)
 static void do_address_space_destroy(AddressSpace *as)
 {
     assert(QTAILQ_EMPTY(&as->listeners));
+    assert(qatomic_read(&as->bounce_buffer_size) == 0);
+    assert(QLIST_EMPTY(&as->map_client_list));
+    qemu_mutex_destroy(&as->map_client_list_lock);
 
     flatview_unref(as->current_map);
     g_free(as->name);
@@ -0,0 +1,363 @@
+/*
+ * Targeted KSM advice from a background duplicate scan
+ *
+ * Blanket MADV_MERGEABLE (mem-merge=on) makes ksmd checksum every
+ * guest page over and over, which on hosts with many dissimilar pages
+ * burns more CPU than the merging saves.  The advisor inverts that: a
+ * low-priority thread hashes guest pages in the background, and only
+ * ranges whose pages were unchanged across two passes and either zero
+ * or sharing a hash with another page are advised mergeable.  ksmd
+ * then spends its cycles on pages that are actually likely to merge.
+ *
+ * The page hash samples a subset of each page, so false duplicate
+ * candidates are possible; that is harmless, since KSM does a full
+ * compare before merging and advice is only a hint.  Pages are never
+ * un-advised: once merged, KSM breaks sharing on write by itself.
+ *
+ * Copyright (c) 2026 the QEMU developers
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or
+ * (at your option) any later version.
+ */
+
+#include "qemu/osdep.h"
+
+#ifdef CONFIG_LINUX
+#include <sys/resource.h>
+#endif
+
+#include "qemu/bitmap.h"
+#include "qemu/cutils.h"
+#include "qemu/error-report.h"
+#include "qemu/madvise.h"
+#include "qemu/profile.h"
+#include "qemu/queue.h"
+#include "qemu/thread.h"
+#include "exec/cpu-common.h"
+#include "exec/memory.h"
+#include "exec/ramblock.h"
+#include "exec/ramlist.h"
+#include "sysemu/ram-dedup.h"
+
+/* idle time between scan passes */
+#define RAM_DEDUP_PASS_INTERVAL_MS  5000
+/* pages hashed per ram_dedup_lock hold */
+#define RAM_DEDUP_CHUNK_PAGES       16384
+/* breather between chunks, also the hotplug latency bound */
+#define RAM_DEDUP_CHUNK_IDLE_US     2000
+/* 64-bit words sampled per page by the hash */
+#define RAM_DEDUP_HASH_SAMPLES      32
+
+typedef struct RamDedupBlock {
+    void *host;
+    size_t npages;
+    /* per-page hash from the previous pass; 0 means the page was zero */
+    uint64_t *hashes;
+    /* scratch: page unchanged since the previous pass */
+    unsigned long *stable;
+    /* pages already advised mergeable */
+    unsigned long *advised;
+    ProfileCounter *scanned;
+    ProfileCounter *advised_pages;
+    QTAILQ_ENTRY(RamDedupBlock) next;
+} RamDedupBlock;
+
+static QemuMutex ram_dedup_lock;
+static QTAILQ_HEAD(, RamDedupBlock) ram_dedup_blocks =
+    QTAILQ_HEAD_INITIALIZER(ram_dedup_blocks);
+/* bumped on every add/remove/resize; a pass aborts when it changes */
+static unsigned ram_dedup_generation;
+static bool ram_dedup_started;
+static QemuThread ram_dedup_thread;
+
+static uint64_t ram_dedup_hash_page(const void *page, size_t page_size)
+{
+    const uint64_t *words = page;
+    size_t stride = page_size / (RAM_DEDUP_HASH_SAMPLES * sizeof(uint64_t));
+    uint64_t hash = 0xcbf29ce484222325ull;
+    int i;
+
+    /*
+     * Zero pages are the dominant duplicate class and the SIMD kernel
+     * detects them far faster than hashing would.
+     */
+    if (buffer_is_zero(page, page_size)) {
+        return 0;
+    }
+
+    for (i = 0; i < RAM_DEDUP_HASH_SAMPLES; i++) {
+        hash ^= words[i * stride];
+        hash *= 0x100000001b3ull;
+    }
+    return hash ? hash : 1;
+}
+
+/*
+ * Drop the lock between chunks so block hotplug never waits for a
+ * whole pass.  Returns false if the block list changed meanwhile; the
+ * caller must then abort the pass without touching any block state.
+ */
+static bool ram_dedup_yield(unsigned gen)
+{
+    qemu_mutex_unlock(&ram_dedup_lock);
+    g_usleep(RAM_DEDUP_CHUNK_IDLE_US);
+    qemu_mutex_lock(&ram_dedup_lock);
+    return ram_dedup_generation == gen;
+}
+
+/*
+ * First sweep: rehash every page, mark the ones whose hash is
+ * unchanged since the last pass as stable, and count how often each
+ * stable hash occurs across all blocks.  @counts keys point into the
+ * per-block hash arrays, which stay in place while the generation is
+ * unchanged.
+ */
+static bool ram_dedup_hash_sweep(GHashTable *counts, unsigned gen)
+{
+    size_t page_size = qemu_real_host_page_size();
+    RamDedupBlock *block;
+    size_t i;
+
+    QTAILQ_FOREACH(block, &ram_dedup_blocks, next) {
+        for (i = 0; i < block->npages; i++) {
+            uint64_t hash;
+
+            if (i && !(i % RAM_DEDUP_CHUNK_PAGES) && !ram_dedup_yield(gen)) {
+                return false;
+            }
+            if (test_bit(i, block->advised)) {
+                clear_bit(i, block->stable);
+                continue;
+            }
+
+            hash = ram_dedup_hash_page((uint8_t *)block->host + i * page_size,
+                                       page_size);
+            if (hash == block->hashes[i]) {
+                set_bit(i, block->stable);
+                if (hash) {
+                    gpointer old = g_hash_table_lookup(counts,
+                                                       &block->hashes[i]);
+                    g_hash_table_insert(counts, &block->hashes[i],
+                                        GUINT_TO_POINTER(
+                                            GPOINTER_TO_UINT(old) + 1));
+                }
+            } else {
+                clear_bit(i, block->stable);
+                block->hashes[i] = hash;
+            }
+        }
+        profile_counter_add(block->scanned, block->npages);
+        if (!ram_dedup_yield(gen)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void ram_dedup_advise(RamDedupBlock *block, size_t start, size_t npages)
+{
+    size_t page_size = qemu_real_host_page_size();
+
+    if (qemu_madvise((uint8_t *)block->host + start * page_size,
+                     npages * page_size, QEMU_MADV_MERGEABLE) < 0) {
+        warn_report_once("ram-dedup: MADV_MERGEABLE failed: %s",
+                         strerror(errno));
+        return;
+    }
+    bitmap_set(block->advised, start, npages);
+    profile_counter_add(block->advised_pages, npages);
+}
+
+/*
+ * Second sweep: advise runs of candidate pages - stable, not yet
+ * advised, and either zero or sharing their hash with another stable
+ * page - coalescing adjacent candidates into one madvise() call.
+ */
+static bool ram_dedup_advise_sweep(GHashTable *counts, unsigned gen)
+{
+    RamDedupBlock *block;
+    size_t run_start, i;
+
+    QTAILQ_FOREACH(block, &ram_dedup_blocks, next) {
+        run_start = SIZE_MAX;
+        for (i = 0; i <= block->npages; i++) {
+            bool candidate = false;
+
+            if (i < block->npages &&
+                test_bit(i, block->stable) && !test_bit(i, block->advised)) {
+                uint64_t hash = block->hashes[i];
+
+                candidate = !hash ||
+                    GPOINTER_TO_UINT(g_hash_table_lookup(
+                                         counts, &block->hashes[i])) >= 2;
+            }
+
+            if (candidate && run_start == SIZE_MAX) {
+                run_start = i;
+            } else if (!candidate && run_start != SIZE_MAX) {
+                ram_dedup_advise(block, run_start, i - run_start);
+                run_start = SIZE_MAX;
+            }
+        }
+        if (!ram_dedup_yield(gen)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void ram_dedup_pass(void)
+{
+    g_autoptr(GHashTable) counts = g_hash_table_new(g_int64_hash,
+                                                    g_int64_equal);
+    unsigned gen;
+
+    qemu_mutex_lock(&ram_dedup_lock);
+    gen = ram_dedup_generation;
+    if (ram_dedup_hash_sweep(counts, gen)) {
+        ram_dedup_advise_sweep(counts, gen);
+    }
+    qemu_mutex_unlock(&ram_dedup_lock);
+}
+
+static void *ram_dedup_thread_fn(void *opaque)
+{
+#ifdef CONFIG_LINUX
+    /*
+     * Purely advisory work; yield to everything else.  With pid 0,
+     * PRIO_PROCESS adjusts just this thread on Linux.
+     */
+    setpriority(PRIO_PROCESS, 0, 19);
+#endif
+
+    for (;;) {
+        g_usleep(RAM_DEDUP_PASS_INTERVAL_MS * 1000);
+        ram_dedup_pass();
+    }
+    return NULL;
+}
+
+static void ram_dedup_block_added(RAMBlockNotifier *n, void *host,
+                                  size_t size, size_t max_size)
+{
+    size_t page_size = qemu_real_host_page_size();
+    RamDedupBlock *block;
+    const char *name;
+    ram_addr_t offset;
+    RAMBlock *rb;
+
+    rb = qemu_ram_block_from_host(host, false, &offset);
+    if (!rb || qemu_ram_pagesize(rb) != page_size || qemu_ram_is_shared(rb)) {
+        /* KSM only merges ordinary private anonymous pages */
+        return;
+    }
+
+    block = g_new0(RamDedupBlock, 1);
+    block->host = host;
+    block->npages = size / page_size;
+    block->hashes = g_new0(uint64_t, block->npages);
+    block->stable = bitmap_new(block->npages);
+    block->advised = bitmap_new(block->npages);
+
+    /* the migration idstr may not be assigned yet at this point */
+    name = qemu_ram_get_idstr(rb);
+    if (!name[0]) {
+        name = memory_region_name(rb->mr);
+    }
+    block->scanned = g_new0(ProfileCounter, 1);
+    profile_counter_register(block->scanned,
+                             g_strdup_printf("ram-dedup-%s-scanned", name));
+    block->advised_pages = g_new0(ProfileCounter, 1);
+    profile_counter_register(block->advised_pages,
+                             g_strdup_printf("ram-dedup-%s-advised", name));
+
+    qemu_mutex_lock(&ram_dedup_lock);
+    QTAILQ_INSERT_TAIL(&ram_dedup_blocks, block, next);
+    ram_dedup_generation++;
+    qemu_mutex_unlock(&ram_dedup_lock);
+}
+
+static RamDedupBlock *ram_dedup_find(void *host)
+{
+    RamDedupBlock *block;
+
+    QTAILQ_FOREACH(block, &ram_dedup_blocks, next) {
+        if (block->host == host) {
+            return block;
+        }
+    }
+    return NULL;
+}
+
+static void ram_dedup_block_removed(RAMBlockNotifier *n, void *host,
+                                    size_t size, size_t max_size)
+{
+    RamDedupBlock *block;
+
+    qemu_mutex_lock(&ram_dedup_lock);
+    block = ram_dedup_find(host);
+    if (block) {
+        QTAILQ_REMOVE(&ram_dedup_blocks, block, next);
+        ram_dedup_generation++;
+    }
+    qemu_mutex_unlock(&ram_dedup_lock);
+
+    if (!block) {
+        return;
+    }
+    /* the scanner rechecks the generation before touching any block */
+    profile_counter_unregister(block->scanned);
+    g_free((char *)block->scanned->name);
+    g_free(block->scanned);
+    profile_counter_unregister(block->advised_pages);
+    g_free((char *)block->advised_pages->name);
+    g_free(block->advised_pages);
+    g_free(block->hashes);
+    g_free(block->stable);
+    g_free(block->advised);
+    g_free(block);
+}
+
+static void ram_dedup_block_resized(RAMBlockNotifier *n, void *host,
+                                    size_t old_size, size_t new_size)
+{
+    size_t new_pages = new_size / qemu_real_host_page_size();
+    RamDedupBlock *block;
+
+    qemu_mutex_lock(&ram_dedup_lock);
+    block = ram_dedup_find(host);
+    if (block) {
+        if (new_pages > block->npages) {
+            block->hashes = g_renew(uint64_t, block->hashes, new_pages);
+            memset(block->hashes + block->npages, 0,
+                   (new_pages - block->npages) * sizeof(uint64_t));
+            block->stable = bitmap_zero_extend(block->stable, block->npages,
+                                               new_pages);
+            block->advised = bitmap_zero_extend(block->advised, block->npages,
+                                                new_pages);
+        }
+        block->npages = new_pages;
+        ram_dedup_generation++;
+    }
+    qemu_mutex_unlock(&ram_dedup_lock);
+}
+
+static RAMBlockNotifier ram_dedup_notifier = {
+    .ram_block_added = ram_dedup_block_added,
+    .ram_block_removed = ram_dedup_block_removed,
+    .ram_block_resized = ram_dedup_block_resized,
+};
+
+void ram_dedup_start(void)
+{
+    if (ram_dedup_started) {
+        /* serialized by the callers holding the ramlist mutex */
+        return;
+    }
+    ram_dedup_started = true;
+
+    qemu_mutex_init(&ram_dedup_lock);
+    ram_block_notifier_add(&ram_dedup_notifier);
+    qemu_thread_create(&ram_dedup_thread, "ram-dedup", ram_dedup_thread_fn,
+                       NULL, QEMU_THREAD_DETACHED);
+}
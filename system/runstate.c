@@ -41,6 +41,7 @@
 #include "qapi/qapi-commands-run-state.h"
 #include "qapi/qapi-events-run-state.h"
 #include "qemu/accel.h"
+#include "qemu/atomic.h"
 #include "qemu/error-report.h"
 #include "qemu/job.h"
 #include "qemu/log.h"
@@ -184,9 +185,16 @@ static const RunStateTransition runstate_transitions_def[] = {
 
 static bool runstate_valid_transitions[RUN_STATE__MAX][RUN_STATE__MAX];
 
+/*
+ * The current run state may be read without holding the BQL: transitions
+ * happen under the BQL, but the state itself is a single word accessed
+ * atomically, so timer and I/O threads can poll it without contending
+ * with vCPU BQL holders.  Callers that need the state to stay stable
+ * across several operations must still hold the BQL.
+ */
 bool runstate_check(RunState state)
 {
-    return current_run_state == state;
+    return qatomic_read(&current_run_state) == state;
 }
 
 static void runstate_init(void)
@@ -220,12 +228,12 @@ void runstate_set(RunState new_state)
         abort();
     }
 
-    current_run_state = new_state;
+    qatomic_set(&current_run_state, new_state);
 }
 
 RunState runstate_get(void)
 {
-    return current_run_state;
+    return qatomic_read(&current_run_state);
 }
 
 bool runstate_is_running(void)
@@ -242,9 +250,14 @@ bool runstate_needs_reset(void)
 StatusInfo *qmp_query_status(Error **errp)
 {
     StatusInfo *info = g_malloc0(sizeof(*info));
+    /*
+     * Read the state once: the command may run out-of-band, without
+     * the BQL, and both fields should reflect the same state.
+     */
+    RunState state = runstate_get();
 
-    info->running = runstate_is_running();
-    info->status = current_run_state;
+    info->running = state == RUN_STATE_RUNNING;
+    info->status = state;
 
     return info;
 }
@@ -484,6 +497,11 @@ void qemu_system_reset(ShutdownCause reason)
 {
     MachineClass *mc;
 
+    if (reset_snapshot_load(reason)) {
+        /* the snapshot stands in for the whole machine reset */
+        return;
+    }
+
     mc = current_machine ? MACHINE_GET_CLASS(current_machine) : NULL;
 
     cpu_synchronize_all_states();
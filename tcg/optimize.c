@@ -1340,6 +1340,25 @@ static bool fold_andc(OptContext *ctx, TCGOp *op)
     return fold_masks(ctx, op);
 }
 
+/*
+ * Mark a non-constant temp (and its copies) as known to hold @val.
+ * Valid until the temp is written or the basic block ends.
+ */
+static void ts_learn_const(TCGTemp *ts, uint64_t val)
+{
+    TCGTemp *itr = ts;
+
+    do {
+        TempOptInfo *ti = ts_info(itr);
+
+        ti->is_const = true;
+        ti->val = val;
+        ti->z_mask = val;
+        ti->s_mask = smask_from_value(val);
+        itr = ti->next_copy;
+    } while (itr != ts);
+}
+
 static bool fold_brcond(OptContext *ctx, TCGOp *op)
 {
     int i = do_constant_folding_cond1(ctx, op, NO_DEST, &op->args[0],
@@ -1351,6 +1370,16 @@ static bool fold_brcond(OptContext *ctx, TCGOp *op)
     if (i > 0) {
         op->opc = INDEX_op_br;
         op->args[0] = op->args[3];
+        return false;
+    }
+
+    /*
+     * The result is not known, but on the fall-through path a
+     * "branch if not equal" did not branch: the first operand is
+     * known to hold the second operand's constant.
+     */
+    if (op->args[2] == TCG_COND_NE && arg_is_const(op->args[1])) {
+        ts_learn_const(arg_temp(op->args[0]), arg_info(op->args[1])->val);
     }
     return false;
 }
@@ -2592,6 +2621,35 @@ static bool fold_xor(OptContext *ctx, TCGOp *op)
     return fold_masks(ctx, op);
 }
 
+/*
+ * Record one global that holds a known constant at a goto_tb exit, so
+ * that the two-tier engine can specialize the chained successor on it
+ * (see accel/tcg/cpu-exec.c).  A single assumption per exit keeps the
+ * successor's entry guard cheap.
+ */
+static void record_exit_constants(OptContext *ctx, TCGOp *op)
+{
+    TCGContext *s = ctx->tcg;
+    TCGArg slot = op->args[0];
+
+    tcg_debug_assert(slot < ARRAY_SIZE(s->tb_exit_spec_reg));
+    for (int i = 0; i < s->nb_globals; i++) {
+        TCGTemp *ts = &s->temps[i];
+
+        if (ts->kind != TEMP_GLOBAL ||
+            (ts->type != TCG_TYPE_I32 && ts->type != TCG_TYPE_I64)) {
+            continue;
+        }
+        /* Stale state from before the last label does not count. */
+        if (!test_bit(i, ctx->temps_used.l) || !ts_is_const(ts)) {
+            continue;
+        }
+        s->tb_exit_spec_reg[slot] = i;
+        s->tb_exit_spec_val[slot] = ts_info(ts)->val;
+        break;
+    }
+}
+
 /* Propagate constants and copies, fold constant expressions. */
 void tcg_optimize(TCGContext *s)
 {
@@ -2714,6 +2772,9 @@ void tcg_optimize(TCGContext *s)
         case INDEX_op_extrh_i64_i32:
             done = fold_extu(&ctx, op);
             break;
+        case INDEX_op_goto_tb:
+            record_exit_constants(&ctx, op);
+            break;
         CASE_OP_32_64(ld8s):
         CASE_OP_32_64(ld8u):
         CASE_OP_32_64(ld16s):
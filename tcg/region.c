@@ -31,9 +31,15 @@
 #include "qemu/qtree.h"
 #include "qapi/error.h"
 #include "tcg/tcg.h"
+#include "tcg/startup.h"
 #include "exec/translation-block.h"
 #include "tcg-internal.h"
 #include "host/cpuinfo.h"
+#ifdef CONFIG_NUMA
+#include <numa.h>
+#endif
+
+bool tcg_numa_regions;
 
 
 /*
@@ -357,6 +363,22 @@ static void tcg_region_assign(TCGContext *s, size_t curr_region)
     s->code_gen_highwater = end - TCG_HIGHWATER;
 }
 
+/*
+ * Bind a region just assigned to @s to the NUMA node of the calling
+ * thread, which owns the region and will execute the code placed in
+ * it.  Only the pages faulted in after this call are affected, which
+ * is the common case: regions are bound when first claimed, before
+ * any code has been generated into them.
+ */
+static void tcg_region_bind_local(TCGContext *s)
+{
+#ifdef CONFIG_NUMA
+    if (tcg_numa_regions && numa_available() >= 0) {
+        numa_setlocal_memory(s->code_gen_buffer, s->code_gen_buffer_size);
+    }
+#endif
+}
+
 static bool tcg_region_alloc__locked(TCGContext *s)
 {
     if (region.current == region.n) {
@@ -381,6 +403,7 @@ bool tcg_region_alloc(TCGContext *s)
     err = tcg_region_alloc__locked(s);
     if (!err) {
         region.agg_size_full += size_full - TCG_HIGHWATER;
+        tcg_region_bind_local(s);
     }
     qemu_mutex_unlock(&region.lock);
     return err;
@@ -400,6 +423,7 @@ void tcg_region_initial_alloc(TCGContext *s)
 {
     qemu_mutex_lock(&region.lock);
     tcg_region_initial_alloc__locked(s);
+    tcg_region_bind_local(s);
     qemu_mutex_unlock(&region.lock);
 }
 
@@ -1317,6 +1317,7 @@ static void tcg_context_init(unsigned max_cpus)
 
     memset(s, 0, sizeof(*s));
     s->nb_globals = 0;
+    s->tb_entry_spec_reg = -1;
 
     /* Count total number of arguments and allocate the corresponding
        space */
@@ -1515,6 +1516,10 @@ void tcg_func_start(TCGContext *s)
     s->nb_labels = 0;
     s->current_frame_offset = s->frame_start;
 
+    /* No exit constants have been proven for this TB yet. */
+    s->tb_exit_spec_reg[0] = -1;
+    s->tb_exit_spec_reg[1] = -1;
+
 #ifdef CONFIG_DEBUG_TCG
     s->goto_tb_issue_mask = 0;
 #endif
@@ -6074,6 +6079,7 @@ static void tcg_out_st_helper_args(TCGContext *s, const TCGLabelQemuLdst *ldst,
 
 int tcg_gen_code(TCGContext *s, TranslationBlock *tb, uint64_t pc_start)
 {
+    int64_t gen_start = get_clock(), opt_done;
     int i, start_words, num_insns;
     TCGOp *op;
 
@@ -6130,6 +6136,8 @@ int tcg_gen_code(TCGContext *s, TranslationBlock *tb, uint64_t pc_start)
         }
     }
 
+    opt_done = get_clock();
+
     if (unlikely(qemu_loglevel_mask(CPU_LOG_TB_OP_OPT)
                  && qemu_log_in_addr_range(pc_start))) {
         FILE *logfile = qemu_log_trylock();
@@ -6265,9 +6273,60 @@ int tcg_gen_code(TCGContext *s, TranslationBlock *tb, uint64_t pc_start)
                         tcg_ptr_byte_diff(s->code_ptr, s->code_buf));
 #endif
 
+    /*
+     * Account only completed translations; aborted ones are restarted
+     * after a buffer flush and will be counted on the retry.
+     */
+    qatomic_set(&s->stat_tb_count, s->stat_tb_count + 1);
+    qatomic_set(&s->stat_guest_bytes, s->stat_guest_bytes + tb->size);
+    qatomic_set(&s->stat_host_bytes,
+                s->stat_host_bytes + tcg_current_code_size(s));
+    qatomic_set(&s->stat_opt_ns, s->stat_opt_ns + (opt_done - gen_start));
+    qatomic_set(&s->stat_gen_ns, s->stat_gen_ns + (get_clock() - gen_start));
+
     return tcg_current_code_size(s);
 }
 
+/*
+ * Dump the translation cost counters accumulated in tcg_gen_code().
+ * Unlike the removed CONFIG_PROFILER machinery this is cheap enough to
+ * be always on: two clock reads per translation against work that takes
+ * microseconds.  The numbers answer how much time went into translating
+ * how much guest code, which is what moves when the optimizer or a
+ * backend regresses.
+ */
+void tcg_dump_stats(GString *buf)
+{
+    unsigned int n_ctxs = qatomic_read(&tcg_cur_ctxs);
+    uint64_t tb_count = 0, guest_bytes = 0, host_bytes = 0;
+    uint64_t opt_ns = 0, gen_ns = 0;
+    unsigned int i;
+
+    for (i = 0; i < n_ctxs; i++) {
+        const TCGContext *s = qatomic_read(&tcg_ctxs[i]);
+
+        tb_count += qatomic_read(&s->stat_tb_count);
+        guest_bytes += qatomic_read(&s->stat_guest_bytes);
+        host_bytes += qatomic_read(&s->stat_host_bytes);
+        opt_ns += qatomic_read(&s->stat_opt_ns);
+        gen_ns += qatomic_read(&s->stat_gen_ns);
+    }
+
+    g_string_append_printf(buf, "translations        %" PRIu64 "\n",
+                           tb_count);
+    g_string_append_printf(buf, "guest bytes in      %" PRIu64 "\n",
+                           guest_bytes);
+    g_string_append_printf(buf, "host bytes out      %" PRIu64
+                           " (expansion %0.1f)\n", host_bytes,
+                           guest_bytes ? (double)host_bytes / guest_bytes : 0);
+    g_string_append_printf(buf, "translation time    %0.3f s "
+                           "(%0.1f guest MB/s)\n", gen_ns / 1e9,
+                           gen_ns ? guest_bytes * 1e3 / gen_ns : 0);
+    g_string_append_printf(buf, "  opt + liveness    %0.3f s (%" PRIu64
+                           "%%)\n", opt_ns / 1e9,
+                           gen_ns ? opt_ns * 100 / gen_ns : 0);
+}
+
 #ifdef ELF_HOST_MACHINE
 /* In order to use this feature, the backend needs to do three things:
 
@@ -0,0 +1,249 @@
+/*
+ * AioContext event loop benchmark
+ *
+ * Measures the cost of the event loop primitives the I/O path is
+ * built from: aio_notify()-to-handler wakeup latency into a polling
+ * thread, bottom half dispatch throughput inside the context, and
+ * timer overshoot under load. The wakeup numbers exercise whichever
+ * fdmon backend (poll/epoll/io_uring) the host build selected, with
+ * and without adaptive polling, so runs are comparable across builds.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+
+#include "qemu/osdep.h"
+#include <getopt.h>
+
+#include "qapi/error.h"
+#include "block/aio.h"
+#include "qemu/cutils.h"
+#include "qemu/error-report.h"
+#include "qemu/main-loop.h"
+#include "qemu/module.h"
+#include "qemu/thread.h"
+#include "qemu/timer.h"
+
+static AioContext *ctx;
+static QemuThread worker;
+static bool worker_stop;
+
+static int64_t count = 100000;
+static int64_t *samples;
+static int64_t n_samples;
+static QemuEvent done_ev;
+
+static void *worker_fn(void *opaque)
+{
+    qemu_set_current_aio_context(ctx);
+    while (!qatomic_read(&worker_stop)) {
+        aio_poll(ctx, true);
+    }
+    return NULL;
+}
+
+static int compare_sample(const void *a, const void *b)
+{
+    int64_t sa = *(const int64_t *)a;
+    int64_t sb = *(const int64_t *)b;
+
+    return sa < sb ? -1 : sa > sb;
+}
+
+static void report_percentiles(const char *name)
+{
+    qsort(samples, n_samples, sizeof(samples[0]), compare_sample);
+    printf("%s (usec): min %.2f / p50 %.2f / p90 %.2f / p99 %.2f / max %.2f\n",
+           name,
+           samples[0] / 1000.0,
+           samples[n_samples / 2] / 1000.0,
+           samples[(int64_t)(n_samples * 0.9)] / 1000.0,
+           samples[(int64_t)(n_samples * 0.99)] / 1000.0,
+           samples[n_samples - 1] / 1000.0);
+}
+
+/* aio_notify-to-handler latency */
+
+static int64_t notify_start;
+
+static void notify_cb(void *opaque)
+{
+    samples[n_samples++] = qemu_clock_get_ns(QEMU_CLOCK_REALTIME) -
+        notify_start;
+    qemu_event_set(&done_ev);
+}
+
+static void bench_notify(const char *name)
+{
+    int64_t i;
+
+    n_samples = 0;
+    for (i = 0; i < count; i++) {
+        qemu_event_reset(&done_ev);
+        notify_start = qemu_clock_get_ns(QEMU_CLOCK_REALTIME);
+        aio_bh_schedule_oneshot(ctx, notify_cb, NULL);
+        qemu_event_wait(&done_ev);
+    }
+    report_percentiles(name);
+}
+
+/* Bottom half dispatch throughput */
+
+static QEMUBH *bh;
+static int64_t bh_remaining;
+
+static void bh_cb(void *opaque)
+{
+    if (--bh_remaining > 0) {
+        qemu_bh_schedule(bh);
+    } else {
+        qemu_event_set(&done_ev);
+    }
+}
+
+static void bench_bh(void)
+{
+    int64_t start;
+    double seconds;
+
+    bh = aio_bh_new(ctx, bh_cb, NULL);
+    bh_remaining = count;
+    qemu_event_reset(&done_ev);
+
+    start = qemu_clock_get_ns(QEMU_CLOCK_REALTIME);
+    qemu_bh_schedule(bh);
+    qemu_event_wait(&done_ev);
+    seconds = (qemu_clock_get_ns(QEMU_CLOCK_REALTIME) - start) / 1e9;
+
+    printf("bottom half dispatch: %.0f per second\n", count / seconds);
+    qemu_bh_delete(bh);
+}
+
+/* Timer overshoot, optionally with a busy bottom half loading the loop */
+
+#define TIMER_INTERVAL_NS (100 * 1000)
+
+static QEMUTimer *timer;
+static QEMUBH *load_bh;
+static bool load_stop;
+static int64_t timer_expire;
+static int64_t timer_remaining;
+
+static void load_bh_cb(void *opaque)
+{
+    if (!qatomic_read(&load_stop)) {
+        qemu_bh_schedule(load_bh);
+    }
+}
+
+static void timer_cb(void *opaque)
+{
+    samples[n_samples++] = qemu_clock_get_ns(QEMU_CLOCK_REALTIME) -
+        timer_expire;
+    if (--timer_remaining > 0) {
+        timer_expire = qemu_clock_get_ns(QEMU_CLOCK_REALTIME) +
+            TIMER_INTERVAL_NS;
+        timer_mod_ns(timer, timer_expire);
+    } else {
+        qatomic_set(&load_stop, true);
+        qemu_event_set(&done_ev);
+    }
+}
+
+static void bench_timer(const char *name, bool load)
+{
+    int64_t shots = MIN(count, 10000);
+
+    n_samples = 0;
+    timer_remaining = shots;
+    qatomic_set(&load_stop, false);
+    qemu_event_reset(&done_ev);
+
+    timer = aio_timer_new(ctx, QEMU_CLOCK_REALTIME, SCALE_NS,
+                          timer_cb, NULL);
+    if (load) {
+        load_bh = aio_bh_new(ctx, load_bh_cb, NULL);
+        qemu_bh_schedule(load_bh);
+    }
+
+    timer_expire = qemu_clock_get_ns(QEMU_CLOCK_REALTIME) +
+        TIMER_INTERVAL_NS;
+    timer_mod_ns(timer, timer_expire);
+    qemu_event_wait(&done_ev);
+
+    timer_free(timer);
+    if (load) {
+        qemu_bh_delete(load_bh);
+        load_bh = NULL;
+    }
+    report_percentiles(name);
+}
+
+static void usage(const char *name)
+{
+    printf(
+"Usage: %s [OPTIONS]\n"
+"QEMU event loop benchmark\n"
+"\n"
+"  -h, --help         display this help and exit\n"
+"  -c, --count=NUM    iterations per benchmark (default 100000)\n",
+    name);
+}
+
+int main(int argc, char **argv)
+{
+    const char *sopt = "hc:";
+    const struct option lopt[] = {
+        { "help", no_argument, NULL, 'h' },
+        { "count", required_argument, NULL, 'c' },
+        { NULL, 0, NULL, 0 },
+    };
+    int ch;
+
+    error_init(argv[0]);
+    module_call_init(MODULE_INIT_TRACE);
+    qemu_init_main_loop(&error_fatal);
+
+    while ((ch = getopt_long(argc, argv, sopt, lopt, NULL)) != -1) {
+        switch (ch) {
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        case 'c':
+            if (qemu_strtoi64(optarg, NULL, 0, &count) < 0 || count < 1) {
+                error_report("Invalid iteration count '%s'", optarg);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    samples = g_new(int64_t, count);
+    qemu_event_init(&done_ev, false);
+
+    ctx = aio_context_new(&error_fatal);
+    qemu_thread_create(&worker, "aio-bench", worker_fn, NULL,
+                       QEMU_THREAD_JOINABLE);
+
+    /* Handler latency with adaptive polling off, then on */
+    aio_context_set_poll_params(ctx, 0, 0, 0, &error_fatal);
+    bench_notify("notify-to-handler, polling off");
+    aio_context_set_poll_params(ctx, 32 * 1000, 0, 0, &error_fatal);
+    bench_notify("notify-to-handler, polling 32us");
+
+    bench_bh();
+
+    bench_timer("timer overshoot, idle", false);
+    bench_timer("timer overshoot, busy loop", true);
+
+    qatomic_set(&worker_stop, true);
+    aio_notify(ctx);
+    qemu_thread_join(&worker);
+    aio_context_unref(ctx);
+    g_free(samples);
+
+    return 0;
+}
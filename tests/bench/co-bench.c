@@ -0,0 +1,251 @@
+/*
+ * Coroutine primitive benchmark
+ *
+ * Measures the primitives the storage coroutines are built from:
+ * enter/yield round trips within one thread, CoMutex lock/unlock
+ * throughput as contending threads are added, and the round trip cost
+ * of waking a coroutine in another AioContext.  The single-thread
+ * numbers exercise whichever coroutine backend (ucontext/sigaltstack/
+ * windows fibers) the host build selected, so runs are comparable
+ * across builds.  Complements the /perf/ cases in test-coroutine.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ */
+
+#include "qemu/osdep.h"
+#include <getopt.h>
+
+#include "qapi/error.h"
+#include "block/aio.h"
+#include "qemu/coroutine.h"
+#include "qemu/cutils.h"
+#include "qemu/error-report.h"
+#include "qemu/main-loop.h"
+#include "qemu/module.h"
+#include "qemu/thread.h"
+#include "qemu/timer.h"
+
+static int64_t count = 100000;
+static int max_threads = 4;
+
+static AioContext **ctxs;
+static QemuThread *workers;
+static bool worker_stop;
+static QemuEvent done_ev;
+
+static void *worker_fn(void *opaque)
+{
+    AioContext *ctx = opaque;
+
+    qemu_set_current_aio_context(ctx);
+    while (!qatomic_read(&worker_stop)) {
+        aio_poll(ctx, true);
+    }
+    return NULL;
+}
+
+/* enter/yield round trips within the main thread */
+
+static bool yield_done;
+
+static void coroutine_fn yield_fn(void *opaque)
+{
+    while (!yield_done) {
+        qemu_coroutine_yield();
+    }
+}
+
+static void bench_yield(void)
+{
+    Coroutine *co = qemu_coroutine_create(yield_fn, NULL);
+    int64_t start;
+    int64_t i;
+    double seconds;
+
+    start = qemu_clock_get_ns(QEMU_CLOCK_REALTIME);
+    for (i = 0; i < count; i++) {
+        qemu_coroutine_enter(co);
+    }
+    seconds = (qemu_clock_get_ns(QEMU_CLOCK_REALTIME) - start) / 1e9;
+
+    yield_done = true;
+    qemu_coroutine_enter(co);
+
+    printf("enter/yield round trips: %.0f per second\n", count / seconds);
+}
+
+/* CoMutex lock/unlock throughput with contending threads */
+
+static CoMutex comutex;
+static int64_t mutex_remaining;
+static int mutex_active;
+
+static void coroutine_fn mutex_fn(void *opaque)
+{
+    while (qatomic_fetch_dec(&mutex_remaining) > 0) {
+        qemu_co_mutex_lock(&comutex);
+        qemu_co_mutex_unlock(&comutex);
+    }
+    if (qatomic_fetch_dec(&mutex_active) == 1) {
+        qemu_event_set(&done_ev);
+    }
+}
+
+static void bench_comutex(int nthreads)
+{
+    int64_t start;
+    double seconds;
+    int i;
+
+    qemu_co_mutex_init(&comutex);
+    qatomic_set(&mutex_remaining, count);
+    qatomic_set(&mutex_active, nthreads);
+    qemu_event_reset(&done_ev);
+
+    start = qemu_clock_get_ns(QEMU_CLOCK_REALTIME);
+    for (i = 0; i < nthreads; i++) {
+        aio_co_schedule(ctxs[i], qemu_coroutine_create(mutex_fn, NULL));
+    }
+    qemu_event_wait(&done_ev);
+    seconds = (qemu_clock_get_ns(QEMU_CLOCK_REALTIME) - start) / 1e9;
+
+    printf("CoMutex, %d thread%s: %.0f lock/unlock per second\n",
+           nthreads, nthreads == 1 ? "" : "s", count / seconds);
+}
+
+/*
+ * Cross-context wake round trips.  Each coroutine schedules its peer
+ * into the peer's home context and yields; the enter happens on the
+ * peer's thread after its yield completes, so the ping-pong is safe
+ * without further synchronization.
+ */
+
+static Coroutine *ping_co;
+static Coroutine *pong_co;
+static int64_t pp_remaining;
+
+static void coroutine_fn pong_fn(void *opaque)
+{
+    while (qatomic_read(&pp_remaining) > 0) {
+        aio_co_schedule(ctxs[0], ping_co);
+        qemu_coroutine_yield();
+    }
+}
+
+static void coroutine_fn ping_fn(void *opaque)
+{
+    while (qatomic_read(&pp_remaining) > 0) {
+        aio_co_schedule(ctxs[1], pong_co);
+        qemu_coroutine_yield();
+        qatomic_set(&pp_remaining, pp_remaining - 1);
+    }
+    /* Release the peer so it can return */
+    aio_co_schedule(ctxs[1], pong_co);
+    qemu_event_set(&done_ev);
+}
+
+static void bench_cross_wake(void)
+{
+    int64_t start;
+    double seconds;
+
+    qatomic_set(&pp_remaining, count);
+    qemu_event_reset(&done_ev);
+
+    ping_co = qemu_coroutine_create(ping_fn, NULL);
+    pong_co = qemu_coroutine_create(pong_fn, NULL);
+
+    start = qemu_clock_get_ns(QEMU_CLOCK_REALTIME);
+    aio_co_schedule(ctxs[1], pong_co);
+    qemu_event_wait(&done_ev);
+    seconds = (qemu_clock_get_ns(QEMU_CLOCK_REALTIME) - start) / 1e9;
+
+    printf("cross-context wake: %.2f usec round trip, %.0f wakes per second\n",
+           seconds / count * 1e6, 2 * count / seconds);
+}
+
+static void usage(const char *name)
+{
+    printf(
+"Usage: %s [OPTIONS]\n"
+"QEMU coroutine primitive benchmark\n"
+"\n"
+"  -h, --help         display this help and exit\n"
+"  -c, --count=NUM    iterations per benchmark (default 100000)\n"
+"  -t, --threads=NUM  max threads for CoMutex scaling (default 4)\n",
+    name);
+}
+
+int main(int argc, char **argv)
+{
+    const char *sopt = "hc:t:";
+    const struct option lopt[] = {
+        { "help", no_argument, NULL, 'h' },
+        { "count", required_argument, NULL, 'c' },
+        { "threads", required_argument, NULL, 't' },
+        { NULL, 0, NULL, 0 },
+    };
+    int ch, i, nthreads, n_ctxs;
+
+    error_init(argv[0]);
+    module_call_init(MODULE_INIT_TRACE);
+    qemu_init_main_loop(&error_fatal);
+
+    while ((ch = getopt_long(argc, argv, sopt, lopt, NULL)) != -1) {
+        switch (ch) {
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        case 'c':
+            if (qemu_strtoi64(optarg, NULL, 0, &count) < 0 || count < 1) {
+                error_report("Invalid iteration count '%s'", optarg);
+                return 1;
+            }
+            break;
+        case 't':
+            if (qemu_strtoi(optarg, NULL, 0, &max_threads) < 0 ||
+                max_threads < 1) {
+                error_report("Invalid thread count '%s'", optarg);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    qemu_event_init(&done_ev, false);
+
+    /* The cross-context benchmark needs two contexts regardless of -t */
+    n_ctxs = MAX(max_threads, 2);
+    ctxs = g_new(AioContext *, n_ctxs);
+    workers = g_new(QemuThread, n_ctxs);
+    for (i = 0; i < n_ctxs; i++) {
+        ctxs[i] = aio_context_new(&error_fatal);
+        qemu_thread_create(&workers[i], "co-bench", worker_fn, ctxs[i],
+                           QEMU_THREAD_JOINABLE);
+    }
+
+    bench_yield();
+
+    for (nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+        bench_comutex(nthreads);
+    }
+
+    bench_cross_wake();
+
+    qatomic_set(&worker_stop, true);
+    for (i = 0; i < n_ctxs; i++) {
+        aio_notify(ctxs[i]);
+    }
+    for (i = 0; i < n_ctxs; i++) {
+        qemu_thread_join(&workers[i]);
+        aio_context_unref(ctxs[i]);
+    }
+    g_free(workers);
+    g_free(ctxs);
+
+    return 0;
+}
@@ -251,10 +251,55 @@ static void test_resize(void)
     qht_test(QHT_MODE_AUTO_RESIZE);
 }
 
+/*
+ * Exercise lookup/insert/remove while an incremental resize is in flight,
+ * i.e. while ht->prev still holds buckets that have not been migrated to
+ * the new map yet.
+ */
+static void test_resize_in_flight(void)
+{
+    int n = 0;
+
+    qht_init(&ht, is_equal, 0, QHT_MODE_AUTO_RESIZE);
+
+    /* insert until an automatic resize leaves an old map to be drained */
+    while (n < N && qatomic_read(&ht.prev) == NULL) {
+        insert(n, n + 1);
+        n++;
+    }
+    g_assert_cmpint(n, <, N);
+    g_assert_nonnull(qatomic_read(&ht.prev));
+
+    /* lookups must find every entry, whether it has migrated yet or not */
+    check(0, n, true);
+    check(-n, -1, false);
+    check_n(n);
+
+    /* removal and re-insertion must work against both maps */
+    rm(0, n / 2);
+    check(0, n / 2, false);
+    check(n / 2, n, true);
+    insert(0, n / 2);
+    check(0, n, true);
+    check_n(n);
+
+    /* each update migrates a batch of buckets; drain the old map fully */
+    while (n < N && qatomic_read(&ht.prev) != NULL) {
+        insert(n, n + 1);
+        n++;
+    }
+    g_assert_null(qatomic_read(&ht.prev));
+    check(0, n, true);
+    check_n(n);
+
+    qht_destroy(&ht);
+}
+
 int main(int argc, char *argv[])
 {
     g_test_init(&argc, &argv, NULL);
     g_test_add_func("/qht/mode/default", test_default);
     g_test_add_func("/qht/mode/resize", test_resize);
+    g_test_add_func("/qht/mode/resize-in-flight", test_resize_in_flight);
     return g_test_run();
 }
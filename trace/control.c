@@ -17,6 +17,9 @@
 #ifdef CONFIG_TRACE_FTRACE
 #include "trace/ftrace.h"
 #endif
+#ifdef CONFIG_TRACE_RINGBUF
+#include "trace/ringbuf.h"
+#endif
 #ifdef CONFIG_TRACE_LOG
 #include "qemu/log.h"
 #endif
@@ -76,6 +79,9 @@ void trace_event_register_group(TraceEvent **events)
 #ifdef CONFIG_TRACE_SIMPLE
     st_init_group(nevent_groups - 1);
 #endif
+#ifdef CONFIG_TRACE_RINGBUF
+    ringbuf_init_group(nevent_groups - 1);
+#endif
 }
 
 
@@ -243,6 +249,9 @@ void trace_init_file(void)
     if (init_trace_on_startup) {
         st_set_trace_file_enabled(true);
     }
+#elif defined CONFIG_TRACE_RINGBUF
+    /* "--trace file" names the UNIX socket the trace stream is served on */
+    ringbuf_set_socket_path(trace_opts_file);
 #elif defined CONFIG_TRACE_LOG
     /*
      * If both the simple and the log backends are enabled, "--trace file"
@@ -271,6 +280,13 @@ bool trace_init_backends(void)
     }
 #endif
 
+#ifdef CONFIG_TRACE_RINGBUF
+    if (!ringbuf_init()) {
+        fprintf(stderr, "failed to initialize ringbuf tracing backend.\n");
+        return false;
+    }
+#endif
+
 #ifdef CONFIG_TRACE_FTRACE
     if (!ftrace_init()) {
         fprintf(stderr, "failed to initialize ftrace backend.\n");
@@ -0,0 +1,591 @@
+/*
+ * Ring buffer trace backend
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2.  See
+ * the COPYING file in the top-level directory.
+ *
+ */
+
+#include "qemu/osdep.h"
+#include <pthread.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "qemu/timer.h"
+#include "qemu/cutils.h"
+#include "qemu/queue.h"
+#include "trace/control.h"
+#include "trace/ringbuf.h"
+#include "qemu/error-report.h"
+
+/*
+ * Every thread that emits trace events owns a fixed-size ring buffer.  Trace
+ * points append records to it without taking any locks; a dedicated consumer
+ * thread drains all rings and streams the records to a client connected to a
+ * UNIX socket.  The stream reuses the simple backend's on-disk format (header,
+ * event ID mappings, then framed records), so it can be decoded with
+ * scripts/simpletrace.py.
+ */
+
+/** Stream header event ID, picked to avoid conflict with real event IDs */
+#define HEADER_EVENT_ID (~(uint64_t)0)
+
+/** Stream magic number */
+#define HEADER_MAGIC 0xf2b177cb0aa429b4ULL
+
+/** Stream version number, matches the simple backend's trace file format */
+#define HEADER_VERSION 4
+
+/** Records were dropped event ID */
+#define DROPPED_EVENT_ID (~(uint64_t)0 - 1)
+
+#define TRACE_RECORD_TYPE_MAPPING 0
+#define TRACE_RECORD_TYPE_EVENT   1
+
+enum {
+    /* Per-thread ring size; must hold the largest record comfortably */
+    RING_BUF_LEN = 4096 * 16,
+};
+
+/* * Trace buffer entry, must match the simple backend's record layout */
+typedef struct {
+    uint64_t event; /* event ID value */
+    uint64_t timestamp_ns;
+    uint32_t length;   /*    in bytes */
+    uint32_t pid;
+    uint64_t arguments[];
+} TraceRecord;
+
+typedef struct {
+    uint64_t header_event_id; /* HEADER_EVENT_ID */
+    uint64_t header_magic;    /* HEADER_MAGIC    */
+    uint64_t header_version;  /* HEADER_VERSION  */
+} TraceLogHeader;
+
+struct TraceRing {
+    uint8_t buf[RING_BUF_LEN];
+    volatile gint head;     /* next byte to write, owned by the producer */
+    volatile gint tail;     /* next byte to read, owned by the consumer */
+    volatile gint dropped;  /* events lost because the ring was full */
+    volatile gint dead;     /* owning thread has exited */
+    QLIST_ENTRY(TraceRing) link;
+};
+
+static QLIST_HEAD(, TraceRing) trace_rings =
+    QLIST_HEAD_INITIALIZER(trace_rings);
+
+/* Protects the ring list; taken once per thread, never per event */
+static GMutex ring_list_lock;
+
+static __thread TraceRing *trace_ring;
+
+static void ringbuf_thread_exit(gpointer data);
+static GPrivate ring_key = G_PRIVATE_INIT(ringbuf_thread_exit);
+
+static uint32_t trace_pid;
+static volatile gint registered_groups;
+static bool consumer_running;
+
+/* Pending socket path handed from the control code to the consumer */
+static GMutex path_lock;
+static char *path_pending;
+
+/* Synchronization for ringbuf_flush() */
+static GMutex flush_lock;
+static GCond flush_done_cond;
+static bool flush_requested;
+
+static int wakeup_fds[2] = { -1, -1 };
+
+/* The remaining state belongs to the consumer thread */
+static int listen_fd = -1;
+static int client_fd = -1;
+static char *listen_path;
+static size_t mapped_groups;
+static uint8_t record_scratch[RING_BUF_LEN];
+
+static void ringbuf_wakeup(void)
+{
+    ssize_t unused __attribute__ ((unused));
+
+    if (wakeup_fds[1] >= 0) {
+        unused = write(wakeup_fds[1], "", 1);
+    }
+}
+
+static TraceRing *ringbuf_register_thread(void)
+{
+    TraceRing *ring;
+
+    /* don't use g_malloc, can deadlock when traced */
+    ring = calloc(1, sizeof(*ring));
+    if (!ring) {
+        return NULL;
+    }
+
+    if (!trace_pid) {
+        trace_pid = getpid();
+    }
+
+    g_mutex_lock(&ring_list_lock);
+    QLIST_INSERT_HEAD(&trace_rings, ring, link);
+    g_mutex_unlock(&ring_list_lock);
+
+    trace_ring = ring;
+    g_private_set(&ring_key, ring);
+    return ring;
+}
+
+static void ringbuf_thread_exit(gpointer data)
+{
+    TraceRing *ring = data;
+
+    /* The consumer frees the ring once the remaining records are drained */
+    g_atomic_int_set(&ring->dead, true);
+}
+
+static void ring_read(TraceRing *ring, unsigned int idx, void *dataptr,
+                      size_t size)
+{
+    uint8_t *data_ptr = dataptr;
+    uint32_t x = 0;
+    while (x < size) {
+        if (idx >= RING_BUF_LEN) {
+            idx = idx % RING_BUF_LEN;
+        }
+        data_ptr[x++] = ring->buf[idx++];
+    }
+}
+
+static unsigned int ring_write(TraceRing *ring, unsigned int idx,
+                               void *dataptr, size_t size)
+{
+    uint8_t *data_ptr = dataptr;
+    uint32_t x = 0;
+    while (x < size) {
+        if (idx >= RING_BUF_LEN) {
+            idx = idx % RING_BUF_LEN;
+        }
+        ring->buf[idx++] = data_ptr[x++];
+    }
+    return idx; /* most callers wants to know where to write next */
+}
+
+void ringbuf_record_write_u64(RingBufferRecord *rec, uint64_t val)
+{
+    rec->rec_off = ring_write(rec->ring, rec->rec_off, &val, sizeof(uint64_t));
+}
+
+void ringbuf_record_write_str(RingBufferRecord *rec, const char *s,
+                              uint32_t slen)
+{
+    /* Write string length first */
+    rec->rec_off = ring_write(rec->ring, rec->rec_off, &slen, sizeof(slen));
+    /* Write actual string now */
+    rec->rec_off = ring_write(rec->ring, rec->rec_off, (void *)s, slen);
+}
+
+int ringbuf_record_start(RingBufferRecord *rec, uint32_t event, size_t datasize)
+{
+    TraceRing *ring = trace_ring;
+    uint32_t rec_len = sizeof(TraceRecord) + datasize;
+    uint64_t event_u64 = event;
+    uint64_t timestamp_ns = get_clock();
+    unsigned int head, rec_off;
+
+    if (!ring) {
+        ring = ringbuf_register_thread();
+        if (!ring) {
+            return -ENOMEM;
+        }
+    }
+
+    /* The producer is the only writer of head, no atomics needed to read it */
+    head = ring->head;
+    if (head + rec_len - (unsigned int)g_atomic_int_get(&ring->tail)
+        > RING_BUF_LEN) {
+        /* Ring Buffer Full, Event dropped ! */
+        g_atomic_int_inc(&ring->dropped);
+        return -ENOSPC;
+    }
+
+    rec_off = head % RING_BUF_LEN;
+    rec_off = ring_write(ring, rec_off, &event_u64, sizeof(event_u64));
+    rec_off = ring_write(ring, rec_off, &timestamp_ns, sizeof(timestamp_ns));
+    rec_off = ring_write(ring, rec_off, &rec_len, sizeof(rec_len));
+    rec_off = ring_write(ring, rec_off, &trace_pid, sizeof(trace_pid));
+
+    rec->ring = ring;
+    rec->rec_off = rec_off;
+    rec->new_head = head + rec_len;
+    return 0;
+}
+
+void ringbuf_record_finish(RingBufferRecord *rec)
+{
+    smp_wmb(); /* write barrier before publishing the record */
+    g_atomic_int_set(&rec->ring->head, rec->new_head);
+}
+
+/**
+ * Write to the connected client, dropping the connection on errors
+ *
+ * The client socket stays blocking: a slow consumer exerts backpressure on
+ * the stream, the rings fill up and the producers drop events rather than
+ * stall.
+ */
+static void consumer_write(const void *buf, size_t size)
+{
+    const uint8_t *ptr = buf;
+
+    while (client_fd >= 0 && size > 0) {
+        ssize_t len = send(client_fd, ptr, size, MSG_NOSIGNAL);
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            close(client_fd);
+            client_fd = -1;
+            return;
+        }
+        ptr += len;
+        size -= len;
+    }
+}
+
+static void ringbuf_write_record(const TraceRecord *record)
+{
+    uint64_t type = TRACE_RECORD_TYPE_EVENT;
+
+    consumer_write(&type, sizeof(type));
+    consumer_write(record, record->length);
+}
+
+/**
+ * Send event ID mappings for groups the client has not seen yet
+ */
+static void ringbuf_send_mappings(void)
+{
+    while (client_fd >= 0 &&
+           mapped_groups < (size_t)g_atomic_int_get(&registered_groups)) {
+        TraceEventIter iter;
+        TraceEvent *ev;
+
+        trace_event_iter_init_group(&iter, mapped_groups);
+        while ((ev = trace_event_iter_next(&iter)) != NULL) {
+            uint64_t type = TRACE_RECORD_TYPE_MAPPING;
+            uint64_t id = trace_event_get_id(ev);
+            const char *name = trace_event_get_name(ev);
+            uint32_t len = strlen(name);
+
+            consumer_write(&type, sizeof(type));
+            consumer_write(&id, sizeof(id));
+            consumer_write(&len, sizeof(len));
+            consumer_write(name, len);
+        }
+        mapped_groups++;
+    }
+}
+
+static void ringbuf_drain_ring(TraceRing *ring)
+{
+    unsigned int head = (unsigned int)g_atomic_int_get(&ring->head);
+    unsigned int tail = (unsigned int)ring->tail;
+    int dropped;
+
+    smp_rmb(); /* read memory barrier before accessing records */
+
+    while (tail != head) {
+        TraceRecord *record = (TraceRecord *)record_scratch;
+
+        /* read the record header to know the record length */
+        ring_read(ring, tail % RING_BUF_LEN, record, sizeof(*record));
+        ring_read(ring, tail % RING_BUF_LEN, record, record->length);
+        if (client_fd >= 0) {
+            ringbuf_write_record(record);
+        }
+        tail += record->length;
+    }
+    g_atomic_int_set(&ring->tail, tail);
+
+    dropped = g_atomic_int_get(&ring->dropped);
+    if (dropped) {
+        union {
+            TraceRecord rec;
+            uint8_t bytes[sizeof(TraceRecord) + sizeof(uint64_t)];
+        } u;
+
+        while (!g_atomic_int_compare_and_exchange(&ring->dropped,
+                                                  dropped, 0)) {
+            dropped = g_atomic_int_get(&ring->dropped);
+        }
+
+        u.rec.event = DROPPED_EVENT_ID;
+        u.rec.timestamp_ns = get_clock();
+        u.rec.length = sizeof(TraceRecord) + sizeof(uint64_t);
+        u.rec.pid = trace_pid;
+        u.rec.arguments[0] = dropped;
+        if (client_fd >= 0) {
+            ringbuf_write_record(&u.rec);
+        }
+    }
+}
+
+static void ringbuf_drain_all(void)
+{
+    TraceRing *ring, *next;
+
+    g_mutex_lock(&ring_list_lock);
+    QLIST_FOREACH_SAFE(ring, &trace_rings, link, next) {
+        ringbuf_drain_ring(ring);
+        if (g_atomic_int_get(&ring->dead) &&
+            ring->tail == g_atomic_int_get(&ring->head)) {
+            QLIST_REMOVE(ring, link);
+            free(ring);
+        }
+    }
+    g_mutex_unlock(&ring_list_lock);
+}
+
+static void ringbuf_update_socket(void)
+{
+    struct sockaddr_un addr;
+    char *path;
+
+    g_mutex_lock(&path_lock);
+    path = path_pending;
+    path_pending = NULL;
+    g_mutex_unlock(&path_lock);
+
+    if (!path) {
+        return;
+    }
+
+    if (client_fd >= 0) {
+        close(client_fd);
+        client_fd = -1;
+    }
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        listen_fd = -1;
+    }
+    if (listen_path) {
+        unlink(listen_path);
+        g_free(listen_path);
+        listen_path = NULL;
+    }
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        error_report("trace socket path \"%s\" is too long", path);
+        g_free(path);
+        return;
+    }
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        error_report("could not create trace socket: %s", strerror(errno));
+        g_free(path);
+        return;
+    }
+    qemu_set_cloexec(listen_fd);
+    g_unix_set_fd_nonblocking(listen_fd, true, NULL);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    pstrcpy(addr.sun_path, sizeof(addr.sun_path), path);
+    unlink(path);
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(listen_fd, 1) < 0) {
+        error_report("could not listen on trace socket \"%s\": %s",
+                     path, strerror(errno));
+        close(listen_fd);
+        listen_fd = -1;
+        g_free(path);
+        return;
+    }
+
+    listen_path = path;
+}
+
+static void ringbuf_accept(void)
+{
+    static const TraceLogHeader header = {
+        .header_event_id = HEADER_EVENT_ID,
+        .header_magic = HEADER_MAGIC,
+        /* Older log readers will check for version at next location */
+        .header_version = HEADER_VERSION,
+    };
+    int fd;
+
+    fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return;
+    }
+    qemu_set_cloexec(fd);
+
+    client_fd = fd;
+    mapped_groups = 0;
+    consumer_write(&header, sizeof(header));
+}
+
+static gpointer ringbuf_consumer_thread(gpointer opaque)
+{
+    for (;;) {
+        struct pollfd pfds[3];
+        nfds_t nfds = 0;
+        int wakeup_idx = -1, listen_idx = -1, client_idx = -1;
+
+        if (wakeup_fds[0] >= 0) {
+            wakeup_idx = nfds;
+            pfds[nfds++] = (struct pollfd) {
+                .fd = wakeup_fds[0], .events = POLLIN,
+            };
+        }
+        if (listen_fd >= 0 && client_fd < 0) {
+            listen_idx = nfds;
+            pfds[nfds++] = (struct pollfd) {
+                .fd = listen_fd, .events = POLLIN,
+            };
+        }
+        if (client_fd >= 0) {
+            client_idx = nfds;
+            pfds[nfds++] = (struct pollfd) {
+                .fd = client_fd, .events = POLLIN,
+            };
+        }
+
+        /* wake up periodically to keep draining the rings */
+        if (poll(pfds, nfds, 10) < 0 && errno != EINTR) {
+            break;
+        }
+
+        if (wakeup_idx >= 0 && (pfds[wakeup_idx].revents & POLLIN)) {
+            uint8_t buf[64];
+            ssize_t unused __attribute__ ((unused));
+
+            unused = read(wakeup_fds[0], buf, sizeof(buf));
+        }
+
+        ringbuf_update_socket();
+
+        if (listen_idx >= 0 && (pfds[listen_idx].revents & POLLIN)) {
+            ringbuf_accept();
+        }
+
+        if (client_idx >= 0 &&
+            (pfds[client_idx].revents & (POLLIN | POLLERR | POLLHUP))) {
+            uint8_t buf[64];
+
+            /* the client never sends data; readable means it hung up */
+            if (read(client_fd, buf, sizeof(buf)) <= 0) {
+                close(client_fd);
+                client_fd = -1;
+            }
+        }
+
+        ringbuf_send_mappings();
+        ringbuf_drain_all();
+
+        g_mutex_lock(&flush_lock);
+        if (flush_requested) {
+            flush_requested = false;
+            g_cond_broadcast(&flush_done_cond);
+        }
+        g_mutex_unlock(&flush_lock);
+    }
+    return NULL;
+}
+
+/**
+ * Wait for the consumer thread to complete a full drain pass
+ */
+void ringbuf_flush(void)
+{
+    gint64 deadline = g_get_monotonic_time() + G_TIME_SPAN_SECOND;
+
+    if (!consumer_running) {
+        return;
+    }
+
+    g_mutex_lock(&flush_lock);
+    flush_requested = true;
+    ringbuf_wakeup();
+    while (flush_requested) {
+        if (!g_cond_wait_until(&flush_done_cond, &flush_lock, deadline)) {
+            break;
+        }
+    }
+    g_mutex_unlock(&flush_lock);
+}
+
+/**
+ * Set the path of the UNIX socket the trace stream is served on
+ *
+ * @file        The socket path or NULL for the default name-<pid>.sock set
+ *              at config time
+ */
+void ringbuf_set_socket_path(const char *file)
+{
+    char *path;
+
+    if (!file) {
+        path = g_strdup_printf(CONFIG_TRACE_FILE "-" FMT_pid ".sock",
+                               getpid());
+    } else {
+        path = g_strdup(file);
+    }
+
+    g_mutex_lock(&path_lock);
+    g_free(path_pending);
+    path_pending = path;
+    g_mutex_unlock(&path_lock);
+    ringbuf_wakeup();
+}
+
+void ringbuf_init_group(size_t group)
+{
+    g_atomic_int_inc(&registered_groups);
+    ringbuf_wakeup();
+}
+
+/* Helper function to create a thread with signals blocked.  Use glib's
+ * portable threads since QEMU abstractions cannot be used due to reentrancy in
+ * the tracer.  Also note the signal masking on POSIX hosts so that the thread
+ * does not steal signals when the rest of the program wants them blocked.
+ */
+static GThread *trace_thread_create(GThreadFunc fn)
+{
+    GThread *thread;
+    sigset_t set, oldset;
+
+    sigfillset(&set);
+    pthread_sigmask(SIG_SETMASK, &set, &oldset);
+    thread = g_thread_new("trace-ringbuf", fn, NULL);
+    pthread_sigmask(SIG_SETMASK, &oldset, NULL);
+
+    return thread;
+}
+
+bool ringbuf_init(void)
+{
+    GThread *thread;
+
+    trace_pid = getpid();
+
+    if (!g_unix_open_pipe(wakeup_fds, FD_CLOEXEC, NULL)) {
+        warn_report("unable to initialize ringbuf trace backend");
+        return false;
+    }
+    g_unix_set_fd_nonblocking(wakeup_fds[0], true, NULL);
+    g_unix_set_fd_nonblocking(wakeup_fds[1], true, NULL);
+
+    thread = trace_thread_create(ringbuf_consumer_thread);
+    if (!thread) {
+        warn_report("unable to initialize ringbuf trace backend");
+        return false;
+    }
+    consumer_running = true;
+
+    atexit(ringbuf_flush);
+    return true;
+}
@@ -0,0 +1,55 @@
+/*
+ * Ring buffer trace backend
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2.  See
+ * the COPYING file in the top-level directory.
+ *
+ */
+
+#ifndef TRACE_RINGBUF_H
+#define TRACE_RINGBUF_H
+
+bool ringbuf_init(void);
+void ringbuf_init_group(size_t group);
+void ringbuf_set_socket_path(const char *path);
+void ringbuf_flush(void);
+
+typedef struct TraceRing TraceRing;
+
+typedef struct {
+    TraceRing *ring;
+    unsigned int rec_off;
+    unsigned int new_head;
+} RingBufferRecord;
+
+#ifndef MAX_TRACE_STRLEN
+#define MAX_TRACE_STRLEN 512
+#endif
+
+/**
+ * Initialize a trace record and claim space for it in the calling thread's
+ * ring buffer
+ *
+ * @arglen  number of bytes required for arguments
+ */
+int ringbuf_record_start(RingBufferRecord *rec, uint32_t id, size_t arglen);
+
+/**
+ * Append a 64-bit argument to a trace record
+ */
+void ringbuf_record_write_u64(RingBufferRecord *rec, uint64_t val);
+
+/**
+ * Append a string argument to a trace record
+ */
+void ringbuf_record_write_str(RingBufferRecord *rec, const char *s,
+                              uint32_t slen);
+
+/**
+ * Publish a trace record to the consumer thread
+ *
+ * Don't append any more arguments to the trace record after calling this.
+ */
+void ringbuf_record_finish(RingBufferRecord *rec);
+
+#endif /* TRACE_RINGBUF_H */
@@ -14,6 +14,12 @@
 #define FONT_HEIGHT 16
 #define FONT_WIDTH 8
 
+/*
+ * Capacity of the per-console pending damage ring.  On overflow all
+ * pending rectangles are collapsed into their bounding box.
+ */
+#define QEMU_CONSOLE_DAMAGE_MAX 16
+
 struct QemuConsole {
     Object parent;
 
@@ -32,6 +38,18 @@ struct QemuConsole {
     void *hw;
     CoQueue dump_queue;
 
+    /*
+     * Damage reported by the device outside of the refresh cycle is
+     * aggregated here and delivered to the listeners from a bottom
+     * half, so scanout flushes do not run listener update code
+     * synchronously.
+     */
+    struct {
+        int x, y, w, h;
+    } damage[QEMU_CONSOLE_DAMAGE_MAX];
+    unsigned int damage_count;
+    QEMUBH *damage_bh;
+
     QTAILQ_ENTRY(QemuConsole) next;
 };
 
@@ -76,6 +76,7 @@ static bool console_compatible_with(QemuConsole *con,
                                     DisplayChangeListener *dcl, Error **errp);
 static QemuConsole *qemu_graphic_console_lookup_unused(void);
 static void dpy_set_ui_info_timer(void *opaque);
+static void dpy_gfx_damage_flush(void *opaque);
 
 static void gui_update(void *opaque)
 {
@@ -396,6 +397,7 @@ qemu_console_finalize(Object *obj)
     g_clear_pointer(&c->surface, qemu_free_displaysurface);
     g_clear_pointer(&c->gl_unblock_timer, timer_free);
     g_clear_pointer(&c->ui_timer, timer_free);
+    g_clear_pointer(&c->damage_bh, qemu_bh_delete);
 }
 
 static void
@@ -414,6 +416,7 @@ qemu_console_init(Object *obj)
     c->window_id = -1;
     c->ui_timer = timer_new_ms(QEMU_CLOCK_REALTIME,
                                dpy_set_ui_info_timer, c);
+    c->damage_bh = qemu_bh_new(dpy_gfx_damage_flush, c);
     qemu_console_register(c);
 }
 
@@ -793,10 +796,82 @@ int dpy_set_ui_info(QemuConsole *con, QemuUIInfo *info, bool delay)
     return 0;
 }
 
-void dpy_gfx_update(QemuConsole *con, int x, int y, int w, int h)
+static void dpy_gfx_update_one(QemuConsole *con, int x, int y, int w, int h)
 {
     DisplayState *s = con->ds;
     DisplayChangeListener *dcl;
+
+    dpy_gfx_update_texture(con, con->surface, x, y, w, h);
+    QLIST_FOREACH(dcl, &s->listeners, next) {
+        if (con != dcl->con) {
+            continue;
+        }
+        if (dcl->ops->dpy_gfx_update) {
+            dcl->ops->dpy_gfx_update(dcl, x, y, w, h);
+        }
+    }
+}
+
+static void dpy_gfx_damage_flush(void *opaque)
+{
+    QemuConsole *con = opaque;
+    unsigned int i;
+
+    trace_console_damage_flush(con->index, con->damage_count);
+    for (i = 0; i < con->damage_count; i++) {
+        dpy_gfx_update_one(con, con->damage[i].x, con->damage[i].y,
+                           con->damage[i].w, con->damage[i].h);
+    }
+    con->damage_count = 0;
+}
+
+static void dpy_gfx_damage_add(QemuConsole *con, int x, int y, int w, int h)
+{
+    unsigned int i;
+
+    for (i = 0; i < con->damage_count; i++) {
+        /* grow an existing rectangle the new one overlaps or touches */
+        if (x <= con->damage[i].x + con->damage[i].w &&
+            con->damage[i].x <= x + w &&
+            y <= con->damage[i].y + con->damage[i].h &&
+            con->damage[i].y <= y + h) {
+            int x2 = MAX(con->damage[i].x + con->damage[i].w, x + w);
+            int y2 = MAX(con->damage[i].y + con->damage[i].h, y + h);
+
+            con->damage[i].x = MIN(con->damage[i].x, x);
+            con->damage[i].y = MIN(con->damage[i].y, y);
+            con->damage[i].w = x2 - con->damage[i].x;
+            con->damage[i].h = y2 - con->damage[i].y;
+            return;
+        }
+    }
+
+    if (con->damage_count == QEMU_CONSOLE_DAMAGE_MAX) {
+        for (i = 1; i < con->damage_count; i++) {
+            int x2 = MAX(con->damage[0].x + con->damage[0].w,
+                         con->damage[i].x + con->damage[i].w);
+            int y2 = MAX(con->damage[0].y + con->damage[0].h,
+                         con->damage[i].y + con->damage[i].h);
+
+            con->damage[0].x = MIN(con->damage[0].x, con->damage[i].x);
+            con->damage[0].y = MIN(con->damage[0].y, con->damage[i].y);
+            con->damage[0].w = x2 - con->damage[0].x;
+            con->damage[0].h = y2 - con->damage[0].y;
+        }
+        con->damage_count = 1;
+        return dpy_gfx_damage_add(con, x, y, w, h);
+    }
+
+    con->damage[con->damage_count].x = x;
+    con->damage[con->damage_count].y = y;
+    con->damage[con->damage_count].w = w;
+    con->damage[con->damage_count].h = h;
+    con->damage_count++;
+    qemu_bh_schedule(con->damage_bh);
+}
+
+void dpy_gfx_update(QemuConsole *con, int x, int y, int w, int h)
+{
     int width = qemu_console_get_width(con, x + w);
     int height = qemu_console_get_height(con, y + h);
 
@@ -810,15 +885,21 @@ void dpy_gfx_update(QemuConsole *con, int x, int y, int w, int h)
     if (!qemu_console_is_visible(con)) {
         return;
     }
-    dpy_gfx_update_texture(con, con->surface, x, y, w, h);
-    QLIST_FOREACH(dcl, &s->listeners, next) {
-        if (con != dcl->con) {
-            continue;
-        }
-        if (dcl->ops->dpy_gfx_update) {
-            dcl->ops->dpy_gfx_update(dcl, x, y, w, h);
-        }
+    if (con->ds->refreshing) {
+        /*
+         * The update was requested by a listener's dpy_refresh; it is
+         * consuming right now, deliver directly.
+         */
+        dpy_gfx_update_one(con, x, y, w, h);
+        return;
     }
+    /*
+     * Device-initiated damage (e.g. a virtio-gpu RESOURCE_FLUSH burst)
+     * is only aggregated here; the listeners consume the coalesced
+     * rectangles from a bottom half, after the device has finished its
+     * command batch.
+     */
+    dpy_gfx_damage_add(con, x, y, w, h);
 }
 
 void dpy_gfx_update_full(QemuConsole *con)
@@ -854,6 +935,12 @@ void dpy_gfx_replace_surface(QemuConsole *con,
 
     assert(old_surface != new_surface);
 
+    /*
+     * Pending damage refers to the old surface; the listeners repaint
+     * from scratch on switch anyway.
+     */
+    con->damage_count = 0;
+
     con->scanout.kind = SCANOUT_SURFACE;
     con->surface = new_surface;
     dpy_gfx_create_texture(con, new_surface);
@@ -63,8 +63,11 @@ struct _DBusDisplayListener {
 #ifdef CONFIG_PIXMAN
     /* Keep track of the damage region */
     pixman_region32_t gl_damage;
+    /* Pending 2D damage, flushed from dbus_refresh() */
+    pixman_region32_t damage;
 #else
     int gl_damage;
+    int damage;
 #endif
 
     DisplayChangeListener dcl;
@@ -92,6 +95,8 @@ G_DEFINE_TYPE(DBusDisplayListener, dbus_display_listener, G_TYPE_OBJECT)
 
 static void dbus_gfx_update(DisplayChangeListener *dcl,
                             int x, int y, int w, int h);
+static void dbus_gfx_update_now(DBusDisplayListener *ddl,
+                                int x, int y, int w, int h);
 
 static void ddl_discard_pending_messages(DBusDisplayListener *ddl)
 {
@@ -583,7 +588,36 @@ static void dbus_gl_refresh(DisplayChangeListener *dcl)
 
 static void dbus_refresh(DisplayChangeListener *dcl)
 {
+    DBusDisplayListener *ddl = container_of(dcl, DBusDisplayListener, dcl);
+
     graphic_hw_update(dcl->con);
+
+    if (!ddl->ds) {
+        return;
+    }
+
+#ifdef CONFIG_PIXMAN
+    /* drop stale damage that may be left over from a surface switch */
+    pixman_region32_intersect_rect(&ddl->damage, &ddl->damage, 0, 0,
+                                   surface_width(ddl->ds),
+                                   surface_height(ddl->ds));
+
+    int n_rects = pixman_region32_n_rects(&ddl->damage);
+
+    for (int i = 0; i < n_rects; i++) {
+        pixman_box32_t *box;
+        box = pixman_region32_rectangles(&ddl->damage, NULL) + i;
+        dbus_gfx_update_now(ddl, box->x1, box->y1,
+                            box->x2 - box->x1, box->y2 - box->y1);
+    }
+    pixman_region32_clear(&ddl->damage);
+#else
+    if (ddl->damage) {
+        ddl->damage = 0;
+        dbus_gfx_update_now(ddl, 0, 0, surface_width(ddl->ds),
+                            surface_height(ddl->ds));
+    }
+#endif
 }
 
 #ifdef CONFIG_OPENGL
@@ -663,15 +697,9 @@ static void ddl_scanout(DBusDisplayListener *ddl)
         g_object_ref(ddl));
 }
 
-static void dbus_gfx_update(DisplayChangeListener *dcl,
-                            int x, int y, int w, int h)
+static void dbus_gfx_update_now(DBusDisplayListener *ddl,
+                                int x, int y, int w, int h)
 {
-    DBusDisplayListener *ddl = container_of(dcl, DBusDisplayListener, dcl);
-
-    assert(ddl->ds);
-
-    trace_dbus_update(x, y, w, h);
-
 #ifdef WIN32
     if (dbus_scanout_map(ddl)) {
         qemu_dbus_display1_listener_win32_map_call_update_map(
@@ -690,6 +718,30 @@ static void dbus_gfx_update(DisplayChangeListener *dcl,
     dbus_gfx_update_sub(ddl, x, y, w, h);
 }
 
+static void dbus_gfx_update(DisplayChangeListener *dcl,
+                            int x, int y, int w, int h)
+{
+    DBusDisplayListener *ddl = container_of(dcl, DBusDisplayListener, dcl);
+
+    assert(ddl->ds);
+
+    trace_dbus_update(x, y, w, h);
+
+    /*
+     * Accumulate the damage and send it from dbus_refresh(), so that a
+     * guest repainting in many small steps costs one batch of messages
+     * per refresh tick instead of one copy and message per rectangle.
+     */
+#ifdef CONFIG_PIXMAN
+    pixman_region32_t rect_region;
+    pixman_region32_init_rect(&rect_region, x, y, w, h);
+    pixman_region32_union(&ddl->damage, &ddl->damage, &rect_region);
+    pixman_region32_fini(&rect_region);
+#else
+    ddl->damage++;
+#endif
+}
+
 #ifdef CONFIG_OPENGL
 static void dbus_gl_gfx_switch(DisplayChangeListener *dcl,
                                struct DisplaySurface *new_surface)
@@ -718,6 +770,11 @@ static void dbus_gfx_switch(DisplayChangeListener *dcl,
 
     ddl->ds = new_surface;
     ddl->ds_share = SHARE_KIND_NONE;
+#ifdef CONFIG_PIXMAN
+    pixman_region32_clear(&ddl->damage);
+#else
+    ddl->damage = 0;
+#endif
 }
 
 static void dbus_mouse_set(DisplayChangeListener *dcl,
@@ -807,6 +864,9 @@ dbus_display_listener_dispose(GObject *object)
 #ifdef CONFIG_OPENGL
     egl_fb_destroy(&ddl->fb);
 #endif
+#endif
+#ifdef CONFIG_PIXMAN
+    pixman_region32_fini(&ddl->damage);
 #endif
 
     G_OBJECT_CLASS(dbus_display_listener_parent_class)->dispose(object);
@@ -841,6 +901,7 @@ dbus_display_listener_init(DBusDisplayListener *ddl)
 {
 #ifdef CONFIG_PIXMAN
     pixman_region32_init(&ddl->gl_damage);
+    pixman_region32_init(&ddl->damage);
 #endif
 }
 
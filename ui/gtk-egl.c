@@ -129,17 +129,20 @@ void gd_egl_update(DisplayChangeListener *dcl,
                    int x, int y, int w, int h)
 {
     VirtualConsole *vc = container_of(dcl, VirtualConsole, gfx.dcl);
+    QemuRect update;
 
     if (!vc->gfx.gls || !vc->gfx.ds) {
         return;
     }
 
-    eglMakeCurrent(qemu_egl_display, vc->gfx.esurface,
-                   vc->gfx.esurface, vc->gfx.ectx);
-    surface_gl_update_texture(vc->gfx.gls, vc->gfx.ds, x, y, w, h);
+    /*
+     * Just accumulate the damage; the texture is updated from the
+     * refresh handler, with a single context switch per frame no
+     * matter how many update rectangles were reported.
+     */
+    qemu_rect_init(&update, x, y, w, h);
+    qemu_rect_union(&vc->gfx.gldamage, &update);
     vc->gfx.glupdates++;
-    eglMakeCurrent(qemu_egl_display, EGL_NO_SURFACE,
-                   EGL_NO_SURFACE, EGL_NO_CONTEXT);
 }
 
 void gd_egl_refresh(DisplayChangeListener *dcl)
@@ -174,7 +177,20 @@ void gd_egl_refresh(DisplayChangeListener *dcl)
     graphic_hw_update(dcl->con);
 
     if (vc->gfx.glupdates) {
+        QemuRect rect;
+
         vc->gfx.glupdates = 0;
+        eglMakeCurrent(qemu_egl_display, vc->gfx.esurface,
+                       vc->gfx.esurface, vc->gfx.ectx);
+        /* the surface may have been replaced since the damage was queued */
+        qemu_rect_init(&rect, 0, 0, surface_width(vc->gfx.ds),
+                       surface_height(vc->gfx.ds));
+        if (qemu_rect_intersect(&vc->gfx.gldamage, &rect, &rect)) {
+            surface_gl_update_texture(vc->gfx.gls, vc->gfx.ds,
+                                      rect.x, rect.y,
+                                      rect.width, rect.height);
+        }
+        qemu_rect_init(&vc->gfx.gldamage, 0, 0, 0, 0);
         gtk_egl_set_scanout_mode(vc, false);
         gd_egl_draw(vc);
     }
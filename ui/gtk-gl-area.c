@@ -108,15 +108,20 @@ void gd_gl_area_update(DisplayChangeListener *dcl,
                    int x, int y, int w, int h)
 {
     VirtualConsole *vc = container_of(dcl, VirtualConsole, gfx.dcl);
+    QemuRect update;
 
     if (!vc->gfx.gls || !vc->gfx.ds) {
         return;
     }
 
-    gtk_gl_area_make_current(GTK_GL_AREA(vc->gfx.drawing_area));
-    surface_gl_update_texture(vc->gfx.gls, vc->gfx.ds, x, y, w, h);
+    /*
+     * Just accumulate the damage; the texture is updated from the
+     * refresh handler, with a single context switch per frame no
+     * matter how many update rectangles were reported.
+     */
+    qemu_rect_init(&update, x, y, w, h);
+    qemu_rect_union(&vc->gfx.gldamage, &update);
     vc->gfx.glupdates++;
-    gdk_gl_context_clear_current();
 }
 
 void gd_gl_area_refresh(DisplayChangeListener *dcl)
@@ -143,7 +148,20 @@ void gd_gl_area_refresh(DisplayChangeListener *dcl)
     graphic_hw_update(dcl->con);
 
     if (vc->gfx.glupdates) {
+        QemuRect rect;
+
         vc->gfx.glupdates = 0;
+        gtk_gl_area_make_current(GTK_GL_AREA(vc->gfx.drawing_area));
+        /* the surface may have been replaced since the damage was queued */
+        qemu_rect_init(&rect, 0, 0, surface_width(vc->gfx.ds),
+                       surface_height(vc->gfx.ds));
+        if (qemu_rect_intersect(&vc->gfx.gldamage, &rect, &rect)) {
+            surface_gl_update_texture(vc->gfx.gls, vc->gfx.ds,
+                                      rect.x, rect.y,
+                                      rect.width, rect.height);
+        }
+        qemu_rect_init(&vc->gfx.gldamage, 0, 0, 0, 0);
+        gdk_gl_context_clear_current();
         gtk_gl_area_set_scanout_mode(vc, false);
         gtk_gl_area_queue_render(GTK_GL_AREA(vc->gfx.drawing_area));
     }
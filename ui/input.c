@@ -45,6 +45,24 @@ static uint32_t kbd_default_delay_ms = 10;
 static uint32_t queue_count;
 static uint32_t queue_limit = 1024;
 
+/*
+ * Pointer motion coalescing.  High-rate mice easily produce a
+ * thousand motion reports per second, and forwarding each one
+ * separately costs the guest an interrupt per report.  Motion is
+ * accumulated here instead -- newest position for absolute axes,
+ * summed deltas for relative axes -- and delivered as one report with
+ * one sync when the flush timer fires.  Any other event flushes the
+ * pending motion first, so ordering is preserved.
+ */
+static uint32_t ptr_coalesce_ms = 5;
+static QEMUTimer *ptr_flush_timer;
+static QemuConsole *ptr_src;
+static bool ptr_pending;
+static bool ptr_abs_pending[INPUT_AXIS__MAX];
+static int ptr_abs[INPUT_AXIS__MAX];
+static bool ptr_rel_pending;
+static int ptr_rel[INPUT_AXIS__MAX];
+
 QemuInputHandlerState *qemu_input_handler_register(DeviceState *dev,
                                             const QemuInputHandler *handler)
 {
@@ -334,6 +352,108 @@ static void qemu_input_queue_sync(QemuInputEventQueueHead *queue)
     queue_count++;
 }
 
+static void qemu_input_event_deliver(QemuConsole *src, InputEvent *evt)
+{
+    if (!runstate_is_running() && !runstate_check(RUN_STATE_SUSPENDED)) {
+        return;
+    }
+
+    replay_input_event(src, evt);
+}
+
+static bool qemu_input_ptr_flush(void)
+{
+    InputAxis axis;
+
+    if (!ptr_pending) {
+        return false;
+    }
+    ptr_pending = false;
+
+    for (axis = 0; axis < INPUT_AXIS__MAX; axis++) {
+        if (ptr_abs_pending[axis]) {
+            InputMoveEvent move = {
+                .axis = axis,
+                .value = ptr_abs[axis],
+            };
+            InputEvent evt = {
+                .type = INPUT_EVENT_KIND_ABS,
+                .u.abs.data = &move,
+            };
+
+            ptr_abs_pending[axis] = false;
+            qemu_input_event_deliver(ptr_src, &evt);
+        }
+    }
+
+    if (ptr_rel_pending) {
+        ptr_rel_pending = false;
+        for (axis = 0; axis < INPUT_AXIS__MAX; axis++) {
+            if (ptr_rel[axis]) {
+                InputMoveEvent move = {
+                    .axis = axis,
+                    .value = ptr_rel[axis],
+                };
+                InputEvent evt = {
+                    .type = INPUT_EVENT_KIND_REL,
+                    .u.rel.data = &move,
+                };
+
+                ptr_rel[axis] = 0;
+                qemu_input_event_deliver(ptr_src, &evt);
+            }
+        }
+    }
+
+    return true;
+}
+
+static void qemu_input_ptr_flush_timer(void *opaque)
+{
+    if (qemu_input_ptr_flush()) {
+        qemu_input_event_sync();
+    }
+}
+
+static bool qemu_input_ptr_coalesce(QemuConsole *src, InputEvent *evt)
+{
+    InputMoveEvent *move;
+
+    if (evt->type != INPUT_EVENT_KIND_REL &&
+        evt->type != INPUT_EVENT_KIND_ABS) {
+        qemu_input_ptr_flush();
+        return false;
+    }
+
+    if (ptr_pending && ptr_src != src) {
+        /* don't merge motion coming from different sources */
+        qemu_input_ptr_flush();
+    }
+
+    if (!ptr_pending) {
+        ptr_pending = true;
+        ptr_src = src;
+        if (!ptr_flush_timer) {
+            ptr_flush_timer = timer_new_full(NULL, QEMU_CLOCK_VIRTUAL,
+                                             SCALE_MS, QEMU_TIMER_ATTR_EXTERNAL,
+                                             qemu_input_ptr_flush_timer, NULL);
+        }
+        timer_mod(ptr_flush_timer, qemu_clock_get_ms(QEMU_CLOCK_VIRTUAL)
+                  + ptr_coalesce_ms);
+    }
+
+    if (evt->type == INPUT_EVENT_KIND_REL) {
+        move = evt->u.rel.data;
+        ptr_rel[move->axis] += move->value;
+        ptr_rel_pending = true;
+    } else {
+        move = evt->u.abs.data;
+        ptr_abs[move->axis] = move->value;
+        ptr_abs_pending[move->axis] = true;
+    }
+    return true;
+}
+
 void qemu_input_event_send_impl(QemuConsole *src, InputEvent *evt)
 {
     QemuInputHandlerState *s;
@@ -379,6 +499,10 @@ void qemu_input_event_send(QemuConsole *src, InputEvent *evt)
         return;
     }
 
+    if (qemu_input_ptr_coalesce(src, evt)) {
+        return;
+    }
+
     replay_input_event(src, evt);
 }
 
@@ -405,6 +529,14 @@ void qemu_input_event_sync(void)
         return;
     }
 
+    if (ptr_pending) {
+        /*
+         * Only coalesced motion is outstanding; the flush timer will
+         * emit the sync together with the accumulated report.
+         */
+        return;
+    }
+
     replay_input_sync_event();
 }
 
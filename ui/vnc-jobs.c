@@ -39,34 +39,45 @@
  *
  * There are three levels of locking:
  * - jobs queue lock: for each operation on the queue (push, pop, isEmpty?)
- * - VncDisplay global lock: mainly used for framebuffer updates to avoid
- *                      screen corruption if the framebuffer is updated
- *                      while the worker is doing something.
+ * - VncDisplay surface lock: taken shared by the workers while they encode
+ *                      from the server surface, exclusively while the
+ *                      surface is refreshed, to avoid screen corruption.
  * - VncState::output lock: used to make sure the output buffer is not corrupted
  *                          if two threads try to write on it at the same time
  *
- * While the VNC worker thread is working, the VncDisplay global lock is held
- * to avoid screen corruption (this does not block vnc_refresh() because it
- * uses trylock()) but the output lock is not held because the thread works on
- * its own output buffer.
+ * While a VNC worker thread is working, the VncDisplay surface lock is held
+ * shared, so workers encoding different clients can run in parallel (this
+ * does not block vnc_refresh() for long because it uses trylock()), but the
+ * output lock is not held because the thread works on its own output buffer.
  * When the encoding job is done, the worker thread will hold the output lock
  * and copy its output buffer in vs->output.
+ *
+ * Each client has at most one job in flight (either queued or owned by a
+ * worker), so two workers never encode for the same client concurrently
+ * and the per-client encoder state needs no extra locking.
+ */
+
+/*
+ * Number of encoding threads. Each client has at most one job in
+ * flight (enforced by vnc_should_update()), so the useful parallelism
+ * is bounded by the number of connected clients anyway; a small pool
+ * keeps a client with an expensive update from delaying the others.
  */
+#define VNC_NUM_WORKER_THREADS 4
 
 struct VncJobQueue {
     QemuCond cond;
     QemuMutex mutex;
-    QemuThread thread;
+    unsigned threads;
     bool exit;
     QTAILQ_HEAD(, VncJob) jobs;
+    /* Jobs currently owned by a worker thread */
+    QTAILQ_HEAD(, VncJob) inflight;
 };
 
 typedef struct VncJobQueue VncJobQueue;
 
-/*
- * We use a single global queue, but most of the functions are
- * already reentrant, so we can easily add more than one encoding thread
- */
+/* All encoding threads pull their jobs from a single global queue */
 static VncJobQueue *queue;
 
 static void vnc_lock_queue(VncJobQueue *queue)
@@ -129,6 +140,11 @@ static bool vnc_has_job_locked(VncState *vs)
             return true;
         }
     }
+    QTAILQ_FOREACH(job, &queue->inflight, next) {
+        if (job->vs == vs || !vs) {
+            return true;
+        }
+    }
     return false;
 }
 
@@ -247,13 +263,19 @@ static int vnc_worker_thread_loop(VncJobQueue *queue)
     while (QTAILQ_EMPTY(&queue->jobs) && !queue->exit) {
         qemu_cond_wait(&queue->cond, &queue->mutex);
     }
-    /* Here job can only be NULL if queue->exit is true */
-    job = QTAILQ_FIRST(&queue->jobs);
-    vnc_unlock_queue(queue);
-
     if (queue->exit) {
+        vnc_unlock_queue(queue);
         return -1;
     }
+    /*
+     * Take ownership of the job so that no other worker picks it up;
+     * vnc_has_job_locked() also scans the inflight list, keeping
+     * vnc_jobs_join() semantics intact.
+     */
+    job = QTAILQ_FIRST(&queue->jobs);
+    QTAILQ_REMOVE(&queue->jobs, job, next);
+    QTAILQ_INSERT_TAIL(&queue->inflight, job, next);
+    vnc_unlock_queue(queue);
 
     assert(job->vs->magic == VNC_MAGIC);
 
@@ -283,12 +305,12 @@ static int vnc_worker_thread_loop(VncJobQueue *queue)
     saved_offset = vs.output.offset;
     vnc_write_u16(&vs, 0);
 
-    vnc_lock_display(job->vs->vd);
+    vnc_lock_display_shared(job->vs->vd);
     QLIST_FOREACH_SAFE(entry, &job->rectangles, next, tmp) {
         int n;
 
         if (job->vs->ioc == NULL) {
-            vnc_unlock_display(job->vs->vd);
+            vnc_unlock_display_shared(job->vs->vd);
             /* Copy persistent encoding data */
             vnc_async_encoding_end(job->vs, &vs);
             goto disconnected;
@@ -305,7 +327,7 @@ static int vnc_worker_thread_loop(VncJobQueue *queue)
         g_free(entry);
     }
     trace_vnc_job_nrects(&vs, job, n_rectangles);
-    vnc_unlock_display(job->vs->vd);
+    vnc_unlock_display_shared(job->vs->vd);
 
     /* Put n_rectangles at the beginning of the message */
     vs.output.buffer[saved_offset] = (n_rectangles >> 8) & 0xFF;
@@ -327,7 +349,7 @@ static int vnc_worker_thread_loop(VncJobQueue *queue)
 
 disconnected:
     vnc_lock_queue(queue);
-    QTAILQ_REMOVE(&queue->jobs, job, next);
+    QTAILQ_REMOVE(&queue->inflight, job, next);
     vnc_unlock_queue(queue);
     qemu_cond_broadcast(&queue->cond);
     g_free(job);
@@ -342,6 +364,7 @@ static VncJobQueue *vnc_queue_init(void)
     qemu_cond_init(&queue->cond);
     qemu_mutex_init(&queue->mutex);
     QTAILQ_INIT(&queue->jobs);
+    QTAILQ_INIT(&queue->inflight);
     return queue;
 }
 
@@ -356,11 +379,16 @@ static void vnc_queue_clear(VncJobQueue *q)
 static void *vnc_worker_thread(void *arg)
 {
     VncJobQueue *queue = arg;
-
-    qemu_thread_get_self(&queue->thread);
+    bool last;
 
     while (!vnc_worker_thread_loop(queue)) ;
-    vnc_queue_clear(queue);
+
+    vnc_lock_queue(queue);
+    last = --queue->threads == 0;
+    vnc_unlock_queue(queue);
+    if (last) {
+        vnc_queue_clear(queue);
+    }
     return NULL;
 }
 
@@ -372,12 +400,18 @@ static bool vnc_worker_thread_running(void)
 void vnc_start_worker_thread(void)
 {
     VncJobQueue *q;
+    int i;
 
     if (vnc_worker_thread_running())
         return;
 
     q = vnc_queue_init();
-    qemu_thread_create(&q->thread, "vnc_worker", vnc_worker_thread, q,
-                       QEMU_THREAD_DETACHED);
+    q->threads = VNC_NUM_WORKER_THREADS;
+    for (i = 0; i < VNC_NUM_WORKER_THREADS; i++) {
+        QemuThread thread;
+
+        qemu_thread_create(&thread, "vnc_worker", vnc_worker_thread, q,
+                           QEMU_THREAD_DETACHED);
+    }
     queue = q; /* Set global queue */
 }
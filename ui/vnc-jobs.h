@@ -42,17 +42,23 @@ void vnc_start_worker_thread(void);
 /* Locks */
 static inline int vnc_trylock_display(VncDisplay *vd)
 {
-    return qemu_mutex_trylock(&vd->mutex);
+    /* 0 on success, like qemu_mutex_trylock() */
+    return !g_rw_lock_writer_trylock(&vd->surface_lock);
 }
 
-static inline void vnc_lock_display(VncDisplay *vd)
+static inline void vnc_unlock_display(VncDisplay *vd)
 {
-    qemu_mutex_lock(&vd->mutex);
+    g_rw_lock_writer_unlock(&vd->surface_lock);
 }
 
-static inline void vnc_unlock_display(VncDisplay *vd)
+static inline void vnc_lock_display_shared(VncDisplay *vd)
+{
+    g_rw_lock_reader_lock(&vd->surface_lock);
+}
+
+static inline void vnc_unlock_display_shared(VncDisplay *vd)
 {
-    qemu_mutex_unlock(&vd->mutex);
+    g_rw_lock_reader_unlock(&vd->surface_lock);
 }
 
 static inline void vnc_lock_output(VncState *vs)
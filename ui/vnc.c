@@ -3150,41 +3150,53 @@ static int vnc_refresh_server_surface(VncDisplay *vd)
     line_bytes = MIN(server_stride, guest_ll);
 
     for (;;) {
-        y = offset / VNC_DIRTY_BPL(&vd->guest);
-        x = offset % VNC_DIRTY_BPL(&vd->guest);
+        int x0, xlast, xlimit;
 
-        server_ptr = server_row0 + y * server_stride + x * cmp_bytes;
+        y = offset / VNC_DIRTY_BPL(&vd->guest);
+        x0 = offset % VNC_DIRTY_BPL(&vd->guest);
+        xlimit = DIV_ROUND_UP(width, VNC_DIRTY_PIXELS_PER_BIT);
+
+        /* x0 >= xlimit means the dirty bits are beyond the shared width */
+        if (x0 < xlimit) {
+            xlast = find_last_bit(vd->guest.dirty[y], xlimit);
+
+            server_ptr = server_row0 + y * server_stride + x0 * cmp_bytes;
+
+            if (vd->guest.format != VNC_SERVER_FB_FORMAT) {
+                /* only convert the span of the row that is actually dirty */
+                int px = x0 * VNC_DIRTY_PIXELS_PER_BIT;
+                int npx = MIN((xlast + 1) * VNC_DIRTY_PIXELS_PER_BIT,
+                              width) - px;
+                qemu_pixman_linebuf_fill(tmpbuf, vd->guest.fb, npx, px, y);
+                guest_ptr = (uint8_t *)pixman_image_get_data(tmpbuf);
+            } else {
+                guest_ptr = guest_row0 + y * guest_stride + x0 * cmp_bytes;
+            }
 
-        if (vd->guest.format != VNC_SERVER_FB_FORMAT) {
-            qemu_pixman_linebuf_fill(tmpbuf, vd->guest.fb, width, 0, y);
-            guest_ptr = (uint8_t *)pixman_image_get_data(tmpbuf);
-        } else {
-            guest_ptr = guest_row0 + y * guest_stride;
-        }
-        guest_ptr += x * cmp_bytes;
+            for (x = x0; x < xlimit;
+                 x = find_next_bit(vd->guest.dirty[y], xlimit, x + 1)) {
+                int _cmp_bytes = cmp_bytes;
+                uint8_t *gp = guest_ptr + (x - x0) * cmp_bytes;
+                uint8_t *sp = server_ptr + (x - x0) * cmp_bytes;
 
-        for (; x < DIV_ROUND_UP(width, VNC_DIRTY_PIXELS_PER_BIT);
-             x++, guest_ptr += cmp_bytes, server_ptr += cmp_bytes) {
-            int _cmp_bytes = cmp_bytes;
-            if (!test_and_clear_bit(x, vd->guest.dirty[y])) {
-                continue;
-            }
-            if ((x + 1) * cmp_bytes > line_bytes) {
-                _cmp_bytes = line_bytes - x * cmp_bytes;
-            }
-            assert(_cmp_bytes >= 0);
-            if (memcmp(server_ptr, guest_ptr, _cmp_bytes) == 0) {
-                continue;
-            }
-            memcpy(server_ptr, guest_ptr, _cmp_bytes);
-            if (!vd->non_adaptive) {
-                vnc_rect_updated(vd, x * VNC_DIRTY_PIXELS_PER_BIT,
-                                 y, &tv);
-            }
-            QTAILQ_FOREACH(vs, &vd->clients, next) {
-                set_bit(x, vs->dirty[y]);
+                clear_bit(x, vd->guest.dirty[y]);
+                if ((x + 1) * cmp_bytes > line_bytes) {
+                    _cmp_bytes = line_bytes - x * cmp_bytes;
+                }
+                assert(_cmp_bytes >= 0);
+                if (memcmp(sp, gp, _cmp_bytes) == 0) {
+                    continue;
+                }
+                memcpy(sp, gp, _cmp_bytes);
+                if (!vd->non_adaptive) {
+                    vnc_rect_updated(vd, x * VNC_DIRTY_PIXELS_PER_BIT,
+                                     y, &tv);
+                }
+                QTAILQ_FOREACH(vs, &vd->clients, next) {
+                    set_bit(x, vs->dirty[y]);
+                }
+                has_dirty++;
             }
-            has_dirty++;
         }
 
         y++;
@@ -3416,7 +3428,7 @@ void vnc_display_init(const char *id, Error **errp)
     vd->share_policy = VNC_SHARE_POLICY_ALLOW_EXCLUSIVE;
     vd->connections_limit = 32;
 
-    qemu_mutex_init(&vd->mutex);
+    g_rw_lock_init(&vd->surface_lock);
     vnc_start_worker_thread();
 
     vd->dcl.ops = &dcl_ops;
@@ -157,7 +157,12 @@ struct VncDisplay
     QEMUPutLEDEntry *led;
     int ledstate;
     QKbdState *kbd;
-    QemuMutex mutex;
+    /*
+     * Taken exclusively while the server surface is refreshed from the
+     * guest surface, shared by the worker threads encoding from it, so
+     * that clients of the same display can be encoded in parallel.
+     */
+    GRWLock surface_lock;
 
     int cursor_msize;
     uint8_t *cursor_mask;
@@ -578,13 +578,24 @@ static bool run_poll_handlers(AioContext *ctx, AioHandlerList *ready_list,
 static bool try_poll_mode(AioContext *ctx, AioHandlerList *ready_list,
                           int64_t *timeout)
 {
-    int64_t max_ns;
+    AioHandler *node;
+    int64_t max_ns = 0;
 
     if (QLIST_EMPTY_RCU(&ctx->poll_aio_handlers)) {
         return false;
     }
 
-    max_ns = qemu_soonest_timeout(*timeout, ctx->poll_ns);
+    /*
+     * Each handler earns its own polling budget, so one busy handler
+     * does not keep the loop spinning on behalf of quiet ones forever;
+     * the window is simply long enough for the most active handler.
+     */
+    QLIST_FOREACH(node, &ctx->poll_aio_handlers, node_poll) {
+        max_ns = MAX(max_ns, node->poll_ns);
+    }
+    max_ns = MIN(max_ns, ctx->poll_max_ns);
+
+    max_ns = qemu_soonest_timeout(*timeout, max_ns);
     if (max_ns && !ctx->fdmon_ops->need_wait(ctx)) {
         /*
          * Enable poll mode. It pairs with the poll_set_started() in
@@ -681,41 +692,54 @@ bool aio_poll(AioContext *ctx, bool blocking)
     /* Adjust polling time */
     if (ctx->poll_max_ns) {
         int64_t block_ns = qemu_clock_get_ns(QEMU_CLOCK_REALTIME) - start;
+        AioHandler *node;
 
-        if (block_ns <= ctx->poll_ns) {
-            /* This is the sweet spot, no adjustment needed */
-        } else if (block_ns > ctx->poll_max_ns) {
+        if (block_ns > ctx->poll_max_ns) {
             /* We'd have to poll for too long, poll less */
-            int64_t old = ctx->poll_ns;
+            QLIST_FOREACH(node, &ctx->poll_aio_handlers, node_poll) {
+                int64_t old = node->poll_ns;
+
+                if (ctx->poll_shrink) {
+                    node->poll_ns /= ctx->poll_shrink;
+                } else {
+                    node->poll_ns = 0;
+                }
 
-            if (ctx->poll_shrink) {
-                ctx->poll_ns /= ctx->poll_shrink;
-            } else {
-                ctx->poll_ns = 0;
+                trace_poll_shrink(ctx, old, node->poll_ns);
             }
+        } else {
+            /*
+             * Grow the budgets of the handlers that became ready within
+             * the window.  Quiet handlers keep their budget, and
+             * remove_idle_poll_handlers() drops them from the poll set
+             * entirely when they stay silent.
+             */
+            QLIST_FOREACH(node, &ready_list, node_ready) {
+                int64_t old = node->poll_ns;
+                int64_t grow = ctx->poll_grow;
+
+                if (!node->io_poll || block_ns <= node->poll_ns ||
+                    node->poll_ns >= ctx->poll_max_ns) {
+                    /* Not pollable, or already in the sweet spot */
+                    continue;
+                }
 
-            trace_poll_shrink(ctx, old, ctx->poll_ns);
-        } else if (ctx->poll_ns < ctx->poll_max_ns &&
-                   block_ns < ctx->poll_max_ns) {
-            /* There is room to grow, poll longer */
-            int64_t old = ctx->poll_ns;
-            int64_t grow = ctx->poll_grow;
+                if (grow == 0) {
+                    grow = 2;
+                }
 
-            if (grow == 0) {
-                grow = 2;
-            }
+                if (node->poll_ns) {
+                    node->poll_ns *= grow;
+                } else {
+                    node->poll_ns = 4000; /* start polling at 4 microseconds */
+                }
 
-            if (ctx->poll_ns) {
-                ctx->poll_ns *= grow;
-            } else {
-                ctx->poll_ns = 4000; /* start polling at 4 microseconds */
-            }
+                if (node->poll_ns > ctx->poll_max_ns) {
+                    node->poll_ns = ctx->poll_max_ns;
+                }
 
-            if (ctx->poll_ns > ctx->poll_max_ns) {
-                ctx->poll_ns = ctx->poll_max_ns;
+                trace_poll_grow(ctx, old, node->poll_ns);
             }
-
-            trace_poll_grow(ctx, old, ctx->poll_ns);
         }
     }
 
@@ -770,7 +794,6 @@ void aio_context_set_poll_params(AioContext *ctx, int64_t max_ns,
      * is used once.
      */
     ctx->poll_max_ns = max_ns;
-    ctx->poll_ns = 0;
     ctx->poll_grow = grow;
     ctx->poll_shrink = shrink;
 
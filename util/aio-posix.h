@@ -37,6 +37,7 @@ struct AioHandler {
     unsigned flags; /* see fdmon-io_uring.c */
 #endif
     int64_t poll_idle_timeout; /* when to stop userspace polling */
+    int64_t poll_ns; /* grow/shrink polling time budget for this handler */
     bool poll_ready; /* has polling detected an event? */
 };
 
@@ -58,6 +58,11 @@ enum {
     BH_IDLE      = (1 << 4),
 };
 
+enum {
+    /* Dispatch budget for QEMU_BH_PRIORITY_BACKGROUND per aio_bh_poll() */
+    BH_BACKGROUND_BUDGET = 8,
+};
+
 struct QEMUBH {
     AioContext *ctx;
     const char *name;
@@ -65,6 +70,7 @@ struct QEMUBH {
     void *opaque;
     QSLIST_ENTRY(QEMUBH) next;
     unsigned flags;
+    QEMUBHPriority priority;
     MemReentrancyGuard *reentrancy_guard;
 };
 
@@ -90,7 +96,7 @@ static void aio_bh_enqueue(QEMUBH *bh, unsigned new_flags)
          * 2. ctx is loaded before the callback has a chance to execute and bh
          *    could be freed.
          */
-        QSLIST_INSERT_HEAD_ATOMIC(&ctx->bh_list, bh, next);
+        QSLIST_INSERT_HEAD_ATOMIC(&ctx->bh_list[bh->priority], bh, next);
     }
 
     aio_notify(ctx);
@@ -135,6 +141,7 @@ void aio_bh_schedule_oneshot_full(AioContext *ctx, QEMUBHFunc *cb,
         .cb = cb,
         .opaque = opaque,
         .name = name,
+        .priority = QEMU_BH_PRIORITY_NORMAL,
     };
     aio_bh_enqueue(bh, BH_SCHEDULED | BH_ONESHOT);
 }
@@ -149,6 +156,7 @@ QEMUBH *aio_bh_new_full(AioContext *ctx, QEMUBHFunc *cb, void *opaque,
         .cb = cb,
         .opaque = opaque,
         .name = name,
+        .priority = QEMU_BH_PRIORITY_NORMAL,
         .reentrancy_guard = reentrancy_guard,
     };
     return bh;
@@ -180,10 +188,13 @@ int aio_bh_poll(AioContext *ctx)
 {
     BHListSlice slice;
     BHListSlice *s;
+    int budget = BH_BACKGROUND_BUDGET;
     int ret = 0;
 
     /* Synchronizes with QSLIST_INSERT_HEAD_ATOMIC in aio_bh_enqueue().  */
-    QSLIST_MOVE_ATOMIC(&slice.bh_list, &ctx->bh_list);
+    for (int i = 0; i < QEMU_BH_PRIORITY__MAX; i++) {
+        QSLIST_MOVE_ATOMIC(&slice.bh_list[i], &ctx->bh_list[i]);
+    }
 
     /*
      * GCC13 [-Werror=dangling-pointer=] complains that the local variable
@@ -201,16 +212,35 @@ int aio_bh_poll(AioContext *ctx)
 #endif
 
     while ((s = QSIMPLEQ_FIRST(&ctx->bh_slice_list))) {
-        QEMUBH *bh;
+        QEMUBH *bh = NULL;
         unsigned flags;
+        int i;
 
-        bh = aio_bh_dequeue(&s->bh_list, &flags);
+        /* Each priority class drains before the next one is dispatched */
+        for (i = 0; i < QEMU_BH_PRIORITY__MAX; i++) {
+            bh = aio_bh_dequeue(&s->bh_list[i], &flags);
+            if (bh) {
+                break;
+            }
+        }
         if (!bh) {
             QSIMPLEQ_REMOVE_HEAD(&ctx->bh_slice_list, next);
             continue;
         }
 
         if ((flags & (BH_SCHEDULED | BH_DELETED)) == BH_SCHEDULED) {
+            if (i == QEMU_BH_PRIORITY_BACKGROUND) {
+                if (budget == 0) {
+                    /*
+                     * Out of budget: hand the callback back to the event
+                     * loop so it runs on the next iteration instead of
+                     * delaying timers and fd handlers any further.
+                     */
+                    aio_bh_enqueue(bh, BH_SCHEDULED | (flags & BH_IDLE));
+                    continue;
+                }
+                budget--;
+            }
             /* Idle BHs don't count as progress */
             if (!(flags & BH_IDLE)) {
                 ret = 1;
@@ -235,6 +265,14 @@ void qemu_bh_schedule(QEMUBH *bh)
     aio_bh_enqueue(bh, BH_SCHEDULED);
 }
 
+void qemu_bh_set_priority(QEMUBH *bh, QEMUBHPriority priority)
+{
+    assert(priority < QEMU_BH_PRIORITY__MAX);
+    /* A pending BH is already on the list for its old priority class */
+    assert(!(qatomic_read(&bh->flags) & BH_PENDING));
+    bh->priority = priority;
+}
+
 /* This func is async.
  */
 void qemu_bh_cancel(QEMUBH *bh)
@@ -277,16 +315,21 @@ aio_compute_timeout(AioContext *ctx)
     BHListSlice *s;
     int64_t deadline;
     int timeout = -1;
+    int i;
 
-    timeout = aio_compute_bh_timeout(&ctx->bh_list, timeout);
-    if (timeout == 0) {
-        return 0;
+    for (i = 0; i < QEMU_BH_PRIORITY__MAX; i++) {
+        timeout = aio_compute_bh_timeout(&ctx->bh_list[i], timeout);
+        if (timeout == 0) {
+            return 0;
+        }
     }
 
     QSIMPLEQ_FOREACH(s, &ctx->bh_slice_list, next) {
-        timeout = aio_compute_bh_timeout(&s->bh_list, timeout);
-        if (timeout == 0) {
-            return 0;
+        for (i = 0; i < QEMU_BH_PRIORITY__MAX; i++) {
+            timeout = aio_compute_bh_timeout(&s->bh_list[i], timeout);
+            if (timeout == 0) {
+                return 0;
+            }
         }
     }
 
@@ -333,16 +376,20 @@ aio_ctx_check(GSource *source)
     qatomic_store_release(&ctx->notify_me, qatomic_read(&ctx->notify_me) & ~1);
     aio_notify_accept(ctx);
 
-    QSLIST_FOREACH_RCU(bh, &ctx->bh_list, next) {
-        if ((bh->flags & (BH_SCHEDULED | BH_DELETED)) == BH_SCHEDULED) {
-            return true;
+    for (int i = 0; i < QEMU_BH_PRIORITY__MAX; i++) {
+        QSLIST_FOREACH_RCU(bh, &ctx->bh_list[i], next) {
+            if ((bh->flags & (BH_SCHEDULED | BH_DELETED)) == BH_SCHEDULED) {
+                return true;
+            }
         }
     }
 
     QSIMPLEQ_FOREACH(s, &ctx->bh_slice_list, next) {
-        QSLIST_FOREACH_RCU(bh, &s->bh_list, next) {
-            if ((bh->flags & (BH_SCHEDULED | BH_DELETED)) == BH_SCHEDULED) {
-                return true;
+        for (int i = 0; i < QEMU_BH_PRIORITY__MAX; i++) {
+            QSLIST_FOREACH_RCU(bh, &s->bh_list[i], next) {
+                if ((bh->flags & (BH_SCHEDULED | BH_DELETED)) == BH_SCHEDULED) {
+                    return true;
+                }
             }
         }
     }
@@ -392,23 +439,26 @@ aio_ctx_finalize(GSource     *source)
     /* There must be no aio_bh_poll() calls going on */
     assert(QSIMPLEQ_EMPTY(&ctx->bh_slice_list));
 
-    while ((bh = aio_bh_dequeue(&ctx->bh_list, &flags))) {
-        /*
-         * qemu_bh_delete() must have been called on BHs in this AioContext. In
-         * many cases memory leaks, hangs, or inconsistent state occur when a
-         * BH is leaked because something still expects it to run.
-         *
-         * If you hit this, fix the lifecycle of the BH so that
-         * qemu_bh_delete() and any associated cleanup is called before the
-         * AioContext is finalized.
-         */
-        if (unlikely(!(flags & BH_DELETED))) {
-            fprintf(stderr, "%s: BH '%s' leaked, aborting...\n",
-                    __func__, bh->name);
-            abort();
-        }
+    for (int i = 0; i < QEMU_BH_PRIORITY__MAX; i++) {
+        while ((bh = aio_bh_dequeue(&ctx->bh_list[i], &flags))) {
+            /*
+             * qemu_bh_delete() must have been called on BHs in this
+             * AioContext. In many cases memory leaks, hangs, or inconsistent
+             * state occur when a BH is leaked because something still expects
+             * it to run.
+             *
+             * If you hit this, fix the lifecycle of the BH so that
+             * qemu_bh_delete() and any associated cleanup is called before
+             * the AioContext is finalized.
+             */
+            if (unlikely(!(flags & BH_DELETED))) {
+                fprintf(stderr, "%s: BH '%s' leaked, aborting...\n",
+                        __func__, bh->name);
+                abort();
+            }
 
-        g_free(bh);
+            g_free(bh);
+        }
     }
 
     aio_set_event_notifier(ctx, &ctx->notifier, NULL, NULL, NULL);
@@ -577,7 +627,9 @@ AioContext *aio_context_new(Error **errp)
     AioContext *ctx;
 
     ctx = (AioContext *) g_source_new(&aio_source_funcs, sizeof(AioContext));
-    QSLIST_INIT(&ctx->bh_list);
+    for (int i = 0; i < QEMU_BH_PRIORITY__MAX; i++) {
+        QSLIST_INIT(&ctx->bh_list[i]);
+    }
     QSIMPLEQ_INIT(&ctx->bh_slice_list);
     aio_context_setup(ctx);
 
@@ -608,7 +660,6 @@ AioContext *aio_context_new(Error **errp)
     qemu_rec_mutex_init(&ctx->lock);
     timerlistgroup_init(&ctx->tlg, aio_timerlist_notify, ctx);
 
-    ctx->poll_ns = 0;
     ctx->poll_max_ns = 0;
     ctx->poll_grow = 0;
     ctx->poll_shrink = 0;
@@ -0,0 +1,400 @@
+/*
+ * Shared compression service
+ *
+ * See include/qemu/compress.h for the design.  The software backend
+ * here carries the codec subtleties that used to live in qcow2: raw
+ * deflate framing via negative window_bits, tolerating Z_BUF_ERROR
+ * when the source length is only known at sector granularity, and
+ * zstd streams made up of multiple frames.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or
+ * (at your option) any later version.
+ */
+
+#include "qemu/osdep.h"
+
+#define ZLIB_CONST
+#include <zlib.h>
+
+#ifdef CONFIG_ZSTD
+#include <zstd.h>
+#include <zstd_errors.h>
+#endif
+
+#include "qemu/compress.h"
+#include "qemu/thread.h"
+
+static QemuMutex compress_lock;
+static QTAILQ_HEAD(, QemuCompressBackend) compress_backends =
+    QTAILQ_HEAD_INITIALIZER(compress_backends);
+
+static ssize_t qemu_zlib_compress(void *dst, size_t dst_size,
+                                  const void *src, size_t src_size,
+                                  int level, int window_bits)
+{
+    ssize_t ret;
+    z_stream strm;
+
+    memset(&strm, 0, sizeof(strm));
+    ret = deflateInit2(&strm, level ? level : Z_DEFAULT_COMPRESSION,
+                       Z_DEFLATED, window_bits ? window_bits : 15, 9,
+                       Z_DEFAULT_STRATEGY);
+    if (ret != Z_OK) {
+        return -EIO;
+    }
+
+    /*
+     * strm.next_in is not const in old zlib versions, such as those used on
+     * OpenBSD/NetBSD, so cast the const away
+     */
+    strm.avail_in = src_size;
+    strm.next_in = (void *) src;
+    strm.avail_out = dst_size;
+    strm.next_out = dst;
+
+    ret = deflate(&strm, Z_FINISH);
+    if (ret == Z_STREAM_END) {
+        ret = dst_size - strm.avail_out;
+    } else {
+        ret = (ret == Z_OK ? -ENOMEM : -EIO);
+    }
+
+    deflateEnd(&strm);
+
+    return ret;
+}
+
+static ssize_t qemu_zlib_decompress(void *dst, size_t dst_size,
+                                    const void *src, size_t src_size,
+                                    int window_bits)
+{
+    ssize_t ret;
+    z_stream strm;
+
+    memset(&strm, 0, sizeof(strm));
+    strm.avail_in = src_size;
+    strm.next_in = (void *) src;
+    strm.avail_out = dst_size;
+    strm.next_out = dst;
+
+    ret = inflateInit2(&strm, window_bits ? window_bits : 15);
+    if (ret != Z_OK) {
+        return -EIO;
+    }
+
+    ret = inflate(&strm, Z_FINISH);
+    if (ret == Z_STREAM_END) {
+        ret = strm.total_out;
+    } else if (ret == Z_BUF_ERROR && strm.avail_out == 0) {
+        /*
+         * We approve Z_BUF_ERROR because the caller may only know the
+         * source length imprecisely (qcow2 knows the size of compressed
+         * data with precision of one sector), so @src may be processed
+         * only partly while @dst is completely filled.
+         */
+        ret = strm.total_out;
+    } else {
+        ret = -EIO;
+    }
+
+    inflateEnd(&strm);
+
+    return ret;
+}
+
+#ifdef CONFIG_ZSTD
+
+static ssize_t qemu_zstd_compress(void *dst, size_t dst_size,
+                                  const void *src, size_t src_size, int level)
+{
+    ssize_t ret;
+    size_t zstd_ret;
+    ZSTD_outBuffer output = {
+        .dst = dst,
+        .size = dst_size,
+        .pos = 0
+    };
+    ZSTD_inBuffer input = {
+        .src = src,
+        .size = src_size,
+        .pos = 0
+    };
+    ZSTD_CCtx *cctx = ZSTD_createCCtx();
+
+    if (!cctx) {
+        return -EIO;
+    }
+    if (level) {
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level);
+    }
+    /*
+     * Use the zstd streamed interface for symmetry with decompression,
+     * where streaming is essential since the exact compressed size may
+     * not be recorded.
+     *
+     * ZSTD_compressStream2() tries to compress everything it could
+     * with a single call. Although, ZSTD docs says that:
+     * "You must continue calling ZSTD_compressStream2() with ZSTD_e_end
+     * until it returns 0, at which point you are free to start a new frame",
+     * in out tests we saw the only case when it returned with >0 -
+     * when the output buffer was too small. In that case,
+     * ZSTD_compressStream2() expects a bigger buffer on the next call.
+     * We can't provide a bigger buffer because we are limited with dest_size
+     * which we pass to the ZSTD_compressStream2() at once.
+     * So, we don't need any loops and just abort the compression when we
+     * don't get 0 result on the first call.
+     */
+    zstd_ret = ZSTD_compressStream2(cctx, &output, &input, ZSTD_e_end);
+
+    if (zstd_ret) {
+        if (zstd_ret > output.size - output.pos) {
+            ret = -ENOMEM;
+        } else {
+            ret = -EIO;
+        }
+        goto out;
+    }
+
+    /* make sure that zstd didn't overflow the dest buffer */
+    assert(output.pos <= dst_size);
+    ret = output.pos;
+out:
+    ZSTD_freeCCtx(cctx);
+    return ret;
+}
+
+static ssize_t qemu_zstd_decompress(void *dst, size_t dst_size,
+                                    const void *src, size_t src_size)
+{
+    size_t zstd_ret = 0;
+    ssize_t ret = 0;
+    ZSTD_outBuffer output = {
+        .dst = dst,
+        .size = dst_size,
+        .pos = 0
+    };
+    ZSTD_inBuffer input = {
+        .src = src,
+        .size = src_size,
+        .pos = 0
+    };
+    ZSTD_DCtx *dctx = ZSTD_createDCtx();
+
+    if (!dctx) {
+        return -EIO;
+    }
+
+    /*
+     * The compressed stream from the input buffer may consist of more
+     * than one zstd frame. So we iterate until the output buffer is
+     * completely filled.
+     * From zstd docs related to ZSTD_decompressStream:
+     * "return : 0 when a frame is completely decoded and fully flushed"
+     * We suppose that this means: each time ZSTD_decompressStream reads
+     * only ONE full frame and returns 0 if and only if that frame
+     * is completely decoded and flushed. Only after returning 0,
+     * ZSTD_decompressStream reads another ONE full frame.
+     */
+    while (output.pos < output.size) {
+        size_t last_in_pos = input.pos;
+        size_t last_out_pos = output.pos;
+        zstd_ret = ZSTD_decompressStream(dctx, &output, &input);
+
+        if (ZSTD_isError(zstd_ret)) {
+            ret = -EIO;
+            break;
+        }
+
+        /*
+         * The ZSTD manual is vague about what to do if it reads
+         * the buffer partially, and we don't want to get stuck
+         * in an infinite loop where ZSTD_decompressStream
+         * returns > 0 waiting for another input chunk. So, we add
+         * a check which ensures that the loop makes some progress
+         * on each step.
+         */
+        if (last_in_pos >= input.pos &&
+            last_out_pos >= output.pos) {
+            ret = -EIO;
+            break;
+        }
+    }
+    /*
+     * Make sure that we have the frame fully flushed here; if not, the
+     * uncompressed data is somehow larger than the output buffer,
+     * possibly because of damage.
+     */
+    if (zstd_ret > 0) {
+        ret = -EIO;
+    }
+
+    if (!ret) {
+        ret = output.pos;
+    }
+
+    ZSTD_freeDCtx(dctx);
+    return ret;
+}
+
+#endif /* CONFIG_ZSTD */
+
+static bool qemu_compress_sw_supports(QemuCompressFormat fmt)
+{
+    switch (fmt) {
+    case QEMU_COMPRESS_FMT_ZLIB:
+        return true;
+#ifdef CONFIG_ZSTD
+    case QEMU_COMPRESS_FMT_ZSTD:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+static void qemu_compress_sw_compress(QemuCompressFormat fmt,
+                                      QemuCompressReq *reqs, size_t nreqs)
+{
+    size_t i;
+
+    for (i = 0; i < nreqs; i++) {
+        QemuCompressReq *req = &reqs[i];
+
+        switch (fmt) {
+        case QEMU_COMPRESS_FMT_ZLIB:
+            req->result = qemu_zlib_compress(req->dst, req->dst_size,
+                                             req->src, req->src_size,
+                                             req->level, req->window_bits);
+            break;
+#ifdef CONFIG_ZSTD
+        case QEMU_COMPRESS_FMT_ZSTD:
+            req->result = qemu_zstd_compress(req->dst, req->dst_size,
+                                             req->src, req->src_size,
+                                             req->level);
+            break;
+#endif
+        default:
+            req->result = -ENOTSUP;
+            break;
+        }
+    }
+}
+
+static void qemu_compress_sw_decompress(QemuCompressFormat fmt,
+                                        QemuCompressReq *reqs, size_t nreqs)
+{
+    size_t i;
+
+    for (i = 0; i < nreqs; i++) {
+        QemuCompressReq *req = &reqs[i];
+
+        switch (fmt) {
+        case QEMU_COMPRESS_FMT_ZLIB:
+            req->result = qemu_zlib_decompress(req->dst, req->dst_size,
+                                               req->src, req->src_size,
+                                               req->window_bits);
+            break;
+#ifdef CONFIG_ZSTD
+        case QEMU_COMPRESS_FMT_ZSTD:
+            req->result = qemu_zstd_decompress(req->dst, req->dst_size,
+                                               req->src, req->src_size);
+            break;
+#endif
+        default:
+            req->result = -ENOTSUP;
+            break;
+        }
+    }
+}
+
+static QemuCompressBackend qemu_compress_sw_backend = {
+    .name = "software",
+    .priority = 0,
+    .supports = qemu_compress_sw_supports,
+    .compress = qemu_compress_sw_compress,
+    .decompress = qemu_compress_sw_decompress,
+};
+
+static void __attribute__((constructor)) qemu_compress_init(void)
+{
+    qemu_mutex_init(&compress_lock);
+    QTAILQ_INSERT_TAIL(&compress_backends, &qemu_compress_sw_backend, next);
+}
+
+void qemu_compress_backend_register(QemuCompressBackend *backend)
+{
+    QemuCompressBackend *cur;
+
+    qemu_mutex_lock(&compress_lock);
+    QTAILQ_FOREACH(cur, &compress_backends, next) {
+        if (backend->priority > cur->priority) {
+            QTAILQ_INSERT_BEFORE(cur, backend, next);
+            qemu_mutex_unlock(&compress_lock);
+            return;
+        }
+    }
+    QTAILQ_INSERT_TAIL(&compress_backends, backend, next);
+    qemu_mutex_unlock(&compress_lock);
+}
+
+static QemuCompressBackend *qemu_compress_backend_for(QemuCompressFormat fmt)
+{
+    QemuCompressBackend *backend;
+
+    QTAILQ_FOREACH(backend, &compress_backends, next) {
+        if (backend->supports(fmt)) {
+            return backend;
+        }
+    }
+    return &qemu_compress_sw_backend;
+}
+
+bool qemu_compress_accelerated(QemuCompressFormat fmt)
+{
+    return qemu_compress_backend_for(fmt)->priority > 0;
+}
+
+void qemu_compress_batch(QemuCompressFormat fmt, QemuCompressReq *reqs,
+                         size_t nreqs)
+{
+    qemu_compress_backend_for(fmt)->compress(fmt, reqs, nreqs);
+}
+
+void qemu_decompress_batch(QemuCompressFormat fmt, QemuCompressReq *reqs,
+                           size_t nreqs)
+{
+    qemu_compress_backend_for(fmt)->decompress(fmt, reqs, nreqs);
+}
+
+ssize_t qemu_compress_one(QemuCompressFormat fmt, int level, int window_bits,
+                          void *dst, size_t dst_size,
+                          const void *src, size_t src_size)
+{
+    QemuCompressReq req = {
+        .src = src,
+        .src_size = src_size,
+        .dst = dst,
+        .dst_size = dst_size,
+        .level = level,
+        .window_bits = window_bits,
+    };
+
+    qemu_compress_batch(fmt, &req, 1);
+    return req.result;
+}
+
+ssize_t qemu_decompress_one(QemuCompressFormat fmt, int window_bits,
+                            void *dst, size_t dst_size,
+                            const void *src, size_t src_size)
+{
+    QemuCompressReq req = {
+        .src = src,
+        .src_size = src_size,
+        .dst = dst,
+        .dst_size = dst_size,
+        .window_bits = window_bits,
+    };
+
+    qemu_decompress_batch(fmt, &req, 1);
+    return req.result;
+}
@@ -25,7 +25,10 @@
  *
  * File descriptor monitoring is implemented using the following operations:
  *
- * 1. IORING_OP_POLL_ADD - adds a file descriptor to be monitored.
+ * 1. IORING_OP_POLL_ADD - adds a file descriptor to be monitored.  When the
+ *    host supports IORING_POLL_ADD_MULTI the request is armed in multishot
+ *    mode so it stays active across completions and does not need to be
+ *    resubmitted for every event.
  * 2. IORING_OP_POLL_REMOVE - removes a file descriptor being monitored.  When
  *    the poll mask changes for a file descriptor it is first removed and then
  *    re-added with the new poll mask, so this operation is also used as part
@@ -57,6 +60,15 @@ enum {
     FDMON_IO_URING_REMOVE   = (1 << 2),
 };
 
+#ifdef IORING_POLL_ADD_MULTI
+/*
+ * Multishot poll (Linux 5.13) posts a cqe for every event while keeping the
+ * request armed, so steady-state event loops submit no sqes at all.  Cleared
+ * at runtime if the host kernel rejects the flag.
+ */
+static bool poll_add_multishot = true;
+#endif
+
 static inline int poll_events_from_pfd(int pfd_events)
 {
     return (pfd_events & G_IO_IN ? POLLIN : 0) |
@@ -172,6 +184,11 @@ static void add_poll_add_sqe(AioContext *ctx, AioHandler *node)
     int events = poll_events_from_pfd(node->pfd.events);
 
     io_uring_prep_poll_add(sqe, node->pfd.fd, events);
+#ifdef IORING_POLL_ADD_MULTI
+    if (qatomic_read(&poll_add_multishot)) {
+        sqe->len |= IORING_POLL_ADD_MULTI;
+    }
+#endif
     io_uring_sqe_set_data(sqe, node);
 }
 
@@ -227,6 +244,7 @@ static bool process_cqe(AioContext *ctx,
                         struct io_uring_cqe *cqe)
 {
     AioHandler *node = io_uring_cqe_get_data(cqe);
+    bool more = false;
     unsigned flags;
 
     /* poll_timeout and poll_remove have a zero user_data field */
@@ -234,21 +252,44 @@ static bool process_cqe(AioContext *ctx,
         return false;
     }
 
+#ifdef IORING_POLL_ADD_MULTI
+    /* A multishot request stays armed while IORING_CQE_F_MORE is set */
+    more = cqe->flags & IORING_CQE_F_MORE;
+
+    if (unlikely(cqe->res == -EINVAL && qatomic_read(&poll_add_multishot))) {
+        /* The kernel predates IORING_POLL_ADD_MULTI, fall back to one-shot */
+        qatomic_set(&poll_add_multishot, false);
+        add_poll_add_sqe(ctx, node);
+        return false;
+    }
+#endif
+
     /*
-     * Deletion can only happen when IORING_OP_POLL_ADD completes.  If we race
-     * with enqueue() here then we can safely clear the FDMON_IO_URING_REMOVE
-     * bit before IORING_OP_POLL_REMOVE is submitted.
+     * Deletion can only happen when the poll request has been retired.  A
+     * multishot request will post further cqes, so hold off until the final
+     * one (triggered by IORING_OP_POLL_REMOVE) arrives.  If we race with
+     * enqueue() here then we can safely clear the FDMON_IO_URING_REMOVE bit
+     * before IORING_OP_POLL_REMOVE is submitted.
      */
-    flags = qatomic_fetch_and(&node->flags, ~FDMON_IO_URING_REMOVE);
-    if (flags & FDMON_IO_URING_REMOVE) {
-        QLIST_INSERT_HEAD_RCU(&ctx->deleted_aio_handlers, node, node_deleted);
-        return false;
+    if (more) {
+        if (qatomic_read(&node->flags) & FDMON_IO_URING_REMOVE) {
+            return false; /* ignore events on a handler that is going away */
+        }
+    } else {
+        flags = qatomic_fetch_and(&node->flags, ~FDMON_IO_URING_REMOVE);
+        if (flags & FDMON_IO_URING_REMOVE) {
+            QLIST_INSERT_HEAD_RCU(&ctx->deleted_aio_handlers, node,
+                                  node_deleted);
+            return false;
+        }
     }
 
     aio_add_ready_handler(ready_list, node, pfd_events_from_poll(cqe->res));
 
-    /* IORING_OP_POLL_ADD is one-shot so we must re-arm it */
-    add_poll_add_sqe(ctx, node);
+    /* One-shot requests (and retired multishot ones) must be re-armed */
+    if (!more) {
+        add_poll_add_sqe(ctx, node);
+    }
     return true;
 }
 
@@ -286,6 +327,16 @@ static int fdmon_io_uring_wait(AioContext *ctx, AioHandlerList *ready_list,
 
     fill_sq_ring(ctx);
 
+    /*
+     * With multishot poll the sq ring is empty in the steady state, so a
+     * non-blocking check can be satisfied straight from the cq ring without
+     * entering the kernel.  Sqes generated while draining the cq ring are
+     * submitted by the next blocking call.
+     */
+    if (wait_nr == 0 && io_uring_sq_ready(&ctx->fdmon_io_uring) == 0) {
+        return process_cq_ring(ctx, ready_list);
+    }
+
     do {
         ret = io_uring_submit_and_wait(&ctx->fdmon_io_uring, wait_nr);
     } while (ret == -EINTR);
@@ -411,7 +411,8 @@ static uint64_t hb_count_between(HBitmap *hb, uint64_t start, uint64_t last)
 /* Setting starts at the last layer and propagates up if an element
  * changes.
  */
-static inline bool hb_set_elem(unsigned long *elem, uint64_t start, uint64_t last)
+static inline bool hb_set_elem(unsigned long *elem, uint64_t start, uint64_t last,
+                               uint64_t *set)
 {
     unsigned long mask;
     unsigned long old;
@@ -423,13 +424,17 @@ static inline bool hb_set_elem(unsigned long *elem, uint64_t start, uint64_t las
     mask -= 1UL << (start & (BITS_PER_LONG - 1));
     old = *elem;
     *elem |= mask;
+    if (set) {
+        *set += ctpopl(mask & ~old);
+    }
     return old != *elem;
 }
 
 /* The recursive workhorse (the depth is limited to HBITMAP_LEVELS)...
- * Returns true if at least one bit is changed. */
+ * Returns true if at least one bit is changed.  @set, when non-NULL,
+ * accumulates the number of bits that went from zero to one. */
 static bool hb_set_between(HBitmap *hb, int level, uint64_t start,
-                           uint64_t last)
+                           uint64_t last, uint64_t *set)
 {
     size_t pos = start >> BITS_PER_LEVEL;
     size_t lastpos = last >> BITS_PER_LEVEL;
@@ -439,7 +444,7 @@ static bool hb_set_between(HBitmap *hb, int level, uint64_t start,
     i = pos;
     if (i < lastpos) {
         uint64_t next = (start | (BITS_PER_LONG - 1)) + 1;
-        changed |= hb_set_elem(&hb->levels[level][i], start, next - 1);
+        changed |= hb_set_elem(&hb->levels[level][i], start, next - 1, set);
         for (;;) {
             start = next;
             next += BITS_PER_LONG;
@@ -447,16 +452,19 @@ static bool hb_set_between(HBitmap *hb, int level, uint64_t start,
                 break;
             }
             changed |= (hb->levels[level][i] == 0);
+            if (set) {
+                *set += BITS_PER_LONG - ctpopl(hb->levels[level][i]);
+            }
             hb->levels[level][i] = ~0UL;
         }
     }
-    changed |= hb_set_elem(&hb->levels[level][i], start, last);
+    changed |= hb_set_elem(&hb->levels[level][i], start, last, set);
 
     /* If there was any change in this layer, we may have to update
      * the one above.
      */
     if (level > 0 && changed) {
-        hb_set_between(hb, level - 1, pos, lastpos);
+        hb_set_between(hb, level - 1, pos, lastpos, NULL);
     }
     return changed;
 }
@@ -464,7 +472,8 @@ static bool hb_set_between(HBitmap *hb, int level, uint64_t start,
 void hbitmap_set(HBitmap *hb, uint64_t start, uint64_t count)
 {
     /* Compute range in the last layer.  */
-    uint64_t first, n;
+    uint64_t first;
+    uint64_t newly_set = 0;
     uint64_t last = start + count - 1;
 
     if (count == 0) {
@@ -477,19 +486,19 @@ void hbitmap_set(HBitmap *hb, uint64_t start, uint64_t count)
     first = start >> hb->granularity;
     last >>= hb->granularity;
     assert(last < hb->size);
-    n = last - first + 1;
 
-    hb->count += n - hb_count_between(hb, first, last);
-    if (hb_set_between(hb, HBITMAP_LEVELS - 1, first, last) &&
+    if (hb_set_between(hb, HBITMAP_LEVELS - 1, first, last, &newly_set) &&
         hb->meta) {
         hbitmap_set(hb->meta, start, count);
     }
+    hb->count += newly_set;
 }
 
 /* Resetting works the other way round: propagate up if the new
  * value is zero.
  */
-static inline bool hb_reset_elem(unsigned long *elem, uint64_t start, uint64_t last)
+static inline bool hb_reset_elem(unsigned long *elem, uint64_t start, uint64_t last,
+                                 uint64_t *cleared)
 {
     unsigned long mask;
     bool blanked;
@@ -500,14 +509,18 @@ static inline bool hb_reset_elem(unsigned long *elem, uint64_t start, uint64_t l
     mask = 2UL << (last & (BITS_PER_LONG - 1));
     mask -= 1UL << (start & (BITS_PER_LONG - 1));
     blanked = *elem != 0 && ((*elem & ~mask) == 0);
+    if (cleared) {
+        *cleared += ctpopl(*elem & mask);
+    }
     *elem &= ~mask;
     return blanked;
 }
 
 /* The recursive workhorse (the depth is limited to HBITMAP_LEVELS)...
- * Returns true if at least one bit is changed. */
+ * Returns true if at least one bit is changed.  @cleared, when non-NULL,
+ * accumulates the number of bits that went from one to zero. */
 static bool hb_reset_between(HBitmap *hb, int level, uint64_t start,
-                             uint64_t last)
+                             uint64_t last, uint64_t *cleared)
 {
     size_t pos = start >> BITS_PER_LEVEL;
     size_t lastpos = last >> BITS_PER_LEVEL;
@@ -523,7 +536,7 @@ static bool hb_reset_between(HBitmap *hb, int level, uint64_t start,
          * unless the lower-level word became entirely zero.  So, remove pos
          * from the upper-level range if bits remain set.
          */
-        if (hb_reset_elem(&hb->levels[level][i], start, next - 1)) {
+        if (hb_reset_elem(&hb->levels[level][i], start, next - 1, cleared)) {
             changed = true;
         } else {
             pos++;
@@ -536,19 +549,22 @@ static bool hb_reset_between(HBitmap *hb, int level, uint64_t start,
                 break;
             }
             changed |= (hb->levels[level][i] != 0);
+            if (cleared) {
+                *cleared += ctpopl(hb->levels[level][i]);
+            }
             hb->levels[level][i] = 0UL;
         }
     }
 
     /* Same as above, this time for lastpos.  */
-    if (hb_reset_elem(&hb->levels[level][i], start, last)) {
+    if (hb_reset_elem(&hb->levels[level][i], start, last, cleared)) {
         changed = true;
     } else {
         lastpos--;
     }
 
     if (level > 0 && changed) {
-        hb_reset_between(hb, level - 1, pos, lastpos);
+        hb_reset_between(hb, level - 1, pos, lastpos, NULL);
     }
 
     return changed;
@@ -559,6 +575,7 @@ void hbitmap_reset(HBitmap *hb, uint64_t start, uint64_t count)
 {
     /* Compute range in the last layer.  */
     uint64_t first;
+    uint64_t cleared = 0;
     uint64_t last = start + count - 1;
     uint64_t gran = 1ULL << hb->granularity;
 
@@ -576,11 +593,11 @@ void hbitmap_reset(HBitmap *hb, uint64_t start, uint64_t count)
     last >>= hb->granularity;
     assert(last < hb->size);
 
-    hb->count -= hb_count_between(hb, first, last);
-    if (hb_reset_between(hb, HBITMAP_LEVELS - 1, first, last) &&
+    if (hb_reset_between(hb, HBITMAP_LEVELS - 1, first, last, &cleared) &&
         hb->meta) {
         hbitmap_set(hb->meta, start, count);
     }
+    hb->count -= cleared;
 }
 
 void hbitmap_reset_all(HBitmap *hb)
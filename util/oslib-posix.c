@@ -205,6 +205,14 @@ void *qemu_anon_ram_alloc(size_t size, uint64_t *alignment, bool shared,
         *alignment = align;
     }
 
+    /*
+     * Anonymous guest RAM benefits from transparent hugepages; ask for
+     * them explicitly so hosts running with THP set to "madvise" use
+     * them too.  The mapping is aligned to QEMU_VMALLOC_ALIGN, which is
+     * sized with THP in mind.
+     */
+    qemu_madvise(ptr, size, QEMU_MADV_HUGEPAGE);
+
     trace_qemu_anon_ram_alloc(size, ptr);
     return ptr;
 }
@@ -445,10 +453,12 @@ static int touch_all_pages(char *area, size_t hpagesize, size_t numpages,
     char *addr = area;
 
     /*
-     * Asynchronous preallocation is only allowed when using MADV_POPULATE_WRITE
-     * and prealloc context for thread placement.
+     * Asynchronous preallocation is only allowed when using
+     * MADV_POPULATE_WRITE: NUMA placement then follows the memory policy
+     * already applied to the area, so it does not depend on where the touch
+     * threads themselves run and needs no SIGBUS handling.
      */
-    if (!use_madv_populate_write || !tc) {
+    if (!use_madv_populate_write) {
         async = false;
     }
 
@@ -503,11 +513,17 @@ static int touch_all_pages(char *area, size_t hpagesize, size_t numpages,
 
     if (async) {
         /*
-         * async requests currently require the BQL. Add it to the list and kick
-         * preallocation off during qemu_finish_async_prealloc_mem().
+         * async requests currently require the BQL. Add it to the list and
+         * release the touch threads right away, so preallocation overlaps
+         * whatever setup runs until qemu_finish_async_prealloc_mem() collects
+         * the results.
          */
         assert(bql_locked());
         QLIST_INSERT_HEAD(&memset_contexts, context, next);
+        qemu_mutex_lock(&page_mutex);
+        context->all_threads_created = true;
+        qemu_cond_broadcast(&page_cond);
+        qemu_mutex_unlock(&page_mutex);
         return 0;
     }
 
@@ -539,13 +555,7 @@ bool qemu_finish_async_prealloc_mem(Error **errp)
         return true;
     }
 
-    qemu_mutex_lock(&page_mutex);
-    QLIST_FOREACH(context, &memset_contexts, next) {
-        context->all_threads_created = true;
-    }
-    qemu_cond_broadcast(&page_cond);
-    qemu_mutex_unlock(&page_mutex);
-
+    /* The touch threads were released when each request was queued */
     QLIST_FOREACH_SAFE(context, &memset_contexts, next, next_context) {
         QLIST_REMOVE(context, next);
         tmp = wait_and_free_mem_prealloc_context(context);
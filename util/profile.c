@@ -0,0 +1,141 @@
+/*
+ * Unified hot-path counter registry
+ *
+ * See include/qemu/profile.h for the design.  The registry itself is
+ * only locked during registration, iteration and reset; hot-path
+ * updates go straight to the caller's per-thread shard.
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or
+ * (at your option) any later version.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/host-utils.h"
+#include "qemu/profile.h"
+#include "qemu/thread.h"
+
+static QemuMutex profile_lock;
+static QTAILQ_HEAD(, ProfileCounter) profile_counters =
+    QTAILQ_HEAD_INITIALIZER(profile_counters);
+static QTAILQ_HEAD(, ProfileHistogram) profile_histograms =
+    QTAILQ_HEAD_INITIALIZER(profile_histograms);
+
+__thread unsigned profile_thread_shard;
+static unsigned profile_next_shard;
+
+static void __attribute__((constructor)) profile_init(void)
+{
+    qemu_mutex_init(&profile_lock);
+}
+
+unsigned profile_shard_index_slow(void)
+{
+    unsigned shard = qatomic_fetch_inc(&profile_next_shard) %
+        PROFILE_COUNTER_SHARDS;
+
+    profile_thread_shard = shard + 1;
+    return shard;
+}
+
+void profile_counter_register(ProfileCounter *counter, const char *name)
+{
+    counter->name = name;
+    qemu_mutex_lock(&profile_lock);
+    QTAILQ_INSERT_TAIL(&profile_counters, counter, next);
+    qemu_mutex_unlock(&profile_lock);
+}
+
+void profile_counter_unregister(ProfileCounter *counter)
+{
+    qemu_mutex_lock(&profile_lock);
+    QTAILQ_REMOVE(&profile_counters, counter, next);
+    qemu_mutex_unlock(&profile_lock);
+}
+
+void profile_histogram_register(ProfileHistogram *histogram, const char *name)
+{
+    histogram->name = name;
+    qemu_mutex_lock(&profile_lock);
+    QTAILQ_INSERT_TAIL(&profile_histograms, histogram, next);
+    qemu_mutex_unlock(&profile_lock);
+}
+
+void profile_histogram_record(ProfileHistogram *histogram, uint64_t value)
+{
+    unsigned bucket = value ? 63 - clz64(value) : 0;
+
+    stat64_add(&histogram->shards[profile_shard_index()].buckets[bucket], 1);
+}
+
+uint64_t profile_counter_get(ProfileCounter *counter)
+{
+    uint64_t total = 0;
+    int i;
+
+    for (i = 0; i < PROFILE_COUNTER_SHARDS; i++) {
+        total += stat64_get(&counter->shards[i].value);
+    }
+    return total;
+}
+
+uint64_t profile_histogram_bucket(ProfileHistogram *histogram,
+                                  unsigned bucket)
+{
+    uint64_t total = 0;
+    int i;
+
+    assert(bucket < PROFILE_HISTOGRAM_BUCKETS);
+    for (i = 0; i < PROFILE_COUNTER_SHARDS; i++) {
+        total += stat64_get(&histogram->shards[i].buckets[bucket]);
+    }
+    return total;
+}
+
+/*
+ * Resets race benignly with concurrent updates: an increment can land
+ * in a shard that was already zeroed or in one about to be, losing or
+ * keeping that one sample.  Snapshot consumers difference counters
+ * over intervals, so this is acceptable in exchange for a lock-free
+ * update path.
+ */
+void profile_counter_reset(ProfileCounter *counter)
+{
+    int i;
+
+    for (i = 0; i < PROFILE_COUNTER_SHARDS; i++) {
+        stat64_init(&counter->shards[i].value, 0);
+    }
+}
+
+void profile_histogram_reset(ProfileHistogram *histogram)
+{
+    int i, j;
+
+    for (i = 0; i < PROFILE_COUNTER_SHARDS; i++) {
+        for (j = 0; j < PROFILE_HISTOGRAM_BUCKETS; j++) {
+            stat64_init(&histogram->shards[i].buckets[j], 0);
+        }
+    }
+}
+
+void profile_counter_foreach(ProfileCounterIter *fn, void *opaque)
+{
+    ProfileCounter *counter;
+
+    qemu_mutex_lock(&profile_lock);
+    QTAILQ_FOREACH(counter, &profile_counters, next) {
+        fn(counter, opaque);
+    }
+    qemu_mutex_unlock(&profile_lock);
+}
+
+void profile_histogram_foreach(ProfileHistogramIter *fn, void *opaque)
+{
+    ProfileHistogram *histogram;
+
+    qemu_mutex_lock(&profile_lock);
+    QTAILQ_FOREACH(histogram, &profile_histograms, next) {
+        fn(histogram, opaque);
+    }
+    qemu_mutex_unlock(&profile_lock);
+}
@@ -30,6 +30,8 @@
 #include "qemu/coroutine_int.h"
 #include "qemu/processor.h"
 #include "qemu/queue.h"
+#include "qemu/stats64.h"
+#include "qemu/timer.h"
 #include "block/aio.h"
 #include "trace.h"
 
@@ -181,6 +183,64 @@ void qemu_co_mutex_init(CoMutex *mutex)
     memset(mutex, 0, sizeof(*mutex));
 }
 
+/*
+ * Contention profiles are aggregated by name and never freed, so their
+ * statistics survive the mutexes they describe (e.g. a qcow2 metadata lock
+ * going away when the image is closed).
+ */
+typedef struct CoMutexProfile {
+    const char *name;
+    Stat64 acquisitions;
+    Stat64 contentions;
+    Stat64 wait_ns;
+    Stat64 hold_ns;
+    QSLIST_ENTRY(CoMutexProfile) next;
+} CoMutexProfile;
+
+static QemuMutex co_mutex_profile_lock;
+static QSLIST_HEAD(, CoMutexProfile) co_mutex_profiles =
+    QSLIST_HEAD_INITIALIZER(co_mutex_profiles);
+
+static void __attribute__((constructor)) co_mutex_profile_init(void)
+{
+    qemu_mutex_init(&co_mutex_profile_lock);
+}
+
+void qemu_co_mutex_init_profiled(CoMutex *mutex, const char *name)
+{
+    CoMutexProfile *profile;
+
+    qemu_co_mutex_init(mutex);
+
+    QEMU_LOCK_GUARD(&co_mutex_profile_lock);
+    QSLIST_FOREACH(profile, &co_mutex_profiles, next) {
+        if (!strcmp(profile->name, name)) {
+            break;
+        }
+    }
+    if (!profile) {
+        profile = g_new0(CoMutexProfile, 1);
+        profile->name = name;
+        QSLIST_INSERT_HEAD(&co_mutex_profiles, profile, next);
+    }
+    mutex->profile = profile;
+}
+
+void qemu_co_mutex_profile_foreach(CoMutexProfileFunc *fn, void *opaque)
+{
+    CoMutexProfile *profile;
+
+    QEMU_LOCK_GUARD(&co_mutex_profile_lock);
+    QSLIST_FOREACH(profile, &co_mutex_profiles, next) {
+        fn(profile->name,
+           stat64_get(&profile->acquisitions),
+           stat64_get(&profile->contentions),
+           stat64_get(&profile->wait_ns),
+           stat64_get(&profile->hold_ns),
+           opaque);
+    }
+}
+
 static void coroutine_fn qemu_co_mutex_wake(CoMutex *mutex, Coroutine *co)
 {
     /* Read co before co->ctx; pairs with smp_wmb() in
@@ -237,6 +297,8 @@ void coroutine_fn qemu_co_mutex_lock(CoMutex *mutex)
 {
     AioContext *ctx = qemu_get_current_aio_context();
     Coroutine *self = qemu_coroutine_self();
+    CoMutexProfile *profile = mutex->profile;
+    int64_t start_ns = profile ? get_clock() : 0;
     int waiters, i;
 
     /* Running a very small critical section on pthread_mutex_t and CoMutex
@@ -268,9 +330,17 @@ retry_fast_path:
         mutex->ctx = ctx;
     } else {
         qemu_co_mutex_lock_slowpath(ctx, mutex);
+        if (profile) {
+            stat64_add(&profile->contentions, 1);
+            stat64_add(&profile->wait_ns, get_clock() - start_ns);
+        }
     }
     mutex->holder = self;
     self->locks_held++;
+    if (profile) {
+        stat64_add(&profile->acquisitions, 1);
+        mutex->hold_start_ns = get_clock();
+    }
 }
 
 void coroutine_fn qemu_co_mutex_unlock(CoMutex *mutex)
@@ -283,6 +353,11 @@ void coroutine_fn qemu_co_mutex_unlock(CoMutex *mutex)
     assert(mutex->holder == self);
     assert(qemu_in_coroutine());
 
+    if (mutex->profile) {
+        stat64_add(&mutex->profile->hold_ns,
+                   get_clock() - mutex->hold_start_ns);
+    }
+
     mutex->ctx = NULL;
     mutex->holder = NULL;
     self->locks_held--;
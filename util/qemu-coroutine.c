@@ -19,6 +19,7 @@
 #include "qemu/coroutine_int.h"
 #include "qemu/coroutine-tls.h"
 #include "qemu/cutils.h"
+#include "qemu/stats64.h"
 #include "block/aio.h"
 
 enum {
@@ -67,6 +68,10 @@ static unsigned int global_pool_max_size = COROUTINE_POOL_BATCH_MAX_SIZE;
 QEMU_DEFINE_STATIC_CO_TLS(CoroutinePool, local_pool);
 QEMU_DEFINE_STATIC_CO_TLS(Notifier, local_pool_cleanup_notifier);
 
+/* Pool statistics for the "coroutine" query-stats provider */
+static Stat64 coroutine_alloc_count;
+static Stat64 coroutine_pool_hit_count;
+
 static CoroutinePoolBatch *coroutine_pool_batch_new(void)
 {
     CoroutinePoolBatch *batch = g_new(CoroutinePoolBatch, 1);
@@ -222,8 +227,11 @@ Coroutine *qemu_coroutine_create(CoroutineEntry *entry, void *opaque)
         co = coroutine_pool_get();
     }
 
-    if (!co) {
+    if (co) {
+        stat64_add(&coroutine_pool_hit_count, 1);
+    } else {
         co = qemu_coroutine_new();
+        stat64_add(&coroutine_alloc_count, 1);
     }
 
     co->entry = entry;
@@ -361,6 +369,17 @@ void qemu_coroutine_dec_pool_size(unsigned int removing_pool_size)
     global_pool_max_size -= removing_pool_size;
 }
 
+void qemu_coroutine_pool_stats(uint64_t *allocations, uint64_t *pool_hits,
+                               uint64_t *pool_size)
+{
+    *allocations = stat64_get(&coroutine_alloc_count);
+    *pool_hits = stat64_get(&coroutine_pool_hit_count);
+
+    WITH_QEMU_LOCK_GUARD(&global_pool_lock) {
+        *pool_size = global_pool_size;
+    }
+}
+
 static unsigned int get_global_pool_hard_max_size(void)
 {
 #ifdef __linux__
@@ -446,6 +446,21 @@ void timer_mod_ns(QEMUTimer *ts, int64_t expire_time)
     bool rearm;
 
     qemu_mutex_lock(&timer_list->active_timers_lock);
+
+    /*
+     * Pushing the deadline of a pending timer further out without
+     * overtaking its successor leaves the list sorted with the timer in
+     * place, so the unlink/reinsert walks can be skipped.  No notify is
+     * needed either: at worst the event loop wakes up at the old, earlier
+     * deadline, finds nothing expired and recomputes its timeout.
+     */
+    if (ts->expire_time >= 0 && expire_time >= ts->expire_time &&
+        (!ts->next || expire_time <= ts->next->expire_time)) {
+        ts->expire_time = expire_time;
+        qemu_mutex_unlock(&timer_list->active_timers_lock);
+        return;
+    }
+
     timer_del_locked(timer_list, ts);
     rearm = timer_mod_ns_locked(timer_list, ts, expire_time);
     qemu_mutex_unlock(&timer_list->active_timers_lock);
@@ -43,10 +43,20 @@
  * just-removed entry. This makes lookups slightly faster, since the moment an
  * invalid entry is found, the (failed) lookup is over.
  *
- * Resizing is done by taking all bucket spinlocks (so that no other writers can
- * race with us) and then copying all entries into a new hash map. Then, the
- * ht->map pointer is set, and the old map is freed once no RCU readers can see
- * it anymore.
+ * Explicit resizes (qht_resize, qht_reset_size) are done by taking all bucket
+ * spinlocks (so that no other writers can race with us) and then copying all
+ * entries into a new hash map. Then, the ht->map pointer is set, and the old
+ * map is freed once no RCU readers can see it anymore.
+ *
+ * Automatic resizes are incremental: the new (larger) map is published with
+ * all of the old map's bucket locks held, but no entries are copied at that
+ * point; the old map remains reachable via ht->prev. Subsequent inserts each
+ * migrate a bounded number of old buckets, so the latency cost of the resize
+ * is spread over many operations instead of stalling one insert for the
+ * duration of a full rehash. Lookups that miss in ht->map retry in ht->prev;
+ * a migrating entry is published in the new map before it is cleared from the
+ * old one, so a lookup that misses it in the old map must find it in the new
+ * one.
  *
  * Writers check for concurrent resizes by comparing ht->map before and after
  * acquiring their bucket lock. If they don't match, a resize has occurred
@@ -194,6 +204,9 @@ struct qht_map {
 /* trigger a resize when n_added_buckets > n_buckets / div */
 #define QHT_NR_ADDED_BUCKETS_THRESHOLD_DIV 8
 
+/* old-map head buckets migrated per insert during an incremental resize */
+#define QHT_MIGRATE_BATCH 16
+
 static void qht_do_resize_reset(struct qht *ht, struct qht_map *new,
                                 bool reset);
 static void qht_grow_maybe(struct qht *ht);
@@ -341,35 +354,6 @@ static inline bool qht_map_is_stale__locked(const struct qht *ht,
     return map != ht->map;
 }
 
-/*
- * Grab all bucket locks, and set @pmap after making sure the map isn't stale.
- *
- * Pairs with qht_map_unlock_buckets(), hence the pass-by-reference.
- *
- * Note: callers cannot have ht->lock held.
- */
-static inline
-void qht_map_lock_buckets__no_stale(struct qht *ht, struct qht_map **pmap)
-{
-    struct qht_map *map;
-
-    map = qatomic_rcu_read(&ht->map);
-    qht_map_lock_buckets(map);
-    if (likely(!qht_map_is_stale__locked(ht, map))) {
-        *pmap = map;
-        return;
-    }
-    qht_map_unlock_buckets(map);
-
-    /* we raced with a resize; acquire ht->lock to see the updated ht->map */
-    qht_lock(ht);
-    map = ht->map;
-    qht_map_lock_buckets(map);
-    qht_unlock(ht);
-    *pmap = map;
-    return;
-}
-
 /*
  * Get a head bucket and lock it, making sure its parent map is not stale.
  * @pmap is filled with a pointer to the bucket's parent map.
@@ -471,6 +455,8 @@ void qht_init(struct qht *ht, qht_cmp_func_t cmp, size_t n_elems,
     g_assert(cmp);
     ht->cmp = cmp;
     ht->mode = mode;
+    ht->prev = NULL;
+    ht->migrate_next = 0;
     qemu_mutex_init(&ht->lock);
     map = qht_map_create(n_buckets);
     qatomic_rcu_set(&ht->map, map);
@@ -479,6 +465,9 @@ void qht_init(struct qht *ht, qht_cmp_func_t cmp, size_t n_elems,
 /* call only when there are no readers/writers left */
 void qht_destroy(struct qht *ht)
 {
+    if (ht->prev) {
+        qht_map_destroy(ht->prev);
+    }
     qht_map_destroy(ht->map);
     memset(ht, 0, sizeof(*ht));
 }
@@ -518,9 +507,22 @@ void qht_reset(struct qht *ht)
 {
     struct qht_map *map;
 
-    qht_map_lock_buckets__no_stale(ht, &map);
+    qht_lock(ht);
+    /* dropping all entries also completes any in-flight incremental resize */
+    if (unlikely(ht->prev != NULL)) {
+        struct qht_map *prev = ht->prev;
+
+        qht_map_lock_buckets(prev);
+        qht_map_reset__all_locked(prev);
+        qht_map_unlock_buckets(prev);
+        qatomic_rcu_set(&ht->prev, NULL);
+        call_rcu(prev, qht_map_destroy, rcu);
+    }
+    map = ht->map;
+    qht_map_lock_buckets(map);
     qht_map_reset__all_locked(map);
     qht_map_unlock_buckets(map);
+    qht_unlock(ht);
 }
 
 static inline void qht_do_resize(struct qht *ht, struct qht_map *new)
@@ -579,9 +581,15 @@ void *qht_do_lookup(const struct qht_bucket *head, qht_lookup_func_t func,
     return NULL;
 }
 
+/*
+ * @versionp, if non-NULL, returns the seqlock version of the consistent
+ * read that produced the result, so callers can later detect whether
+ * the bucket has been modified since.
+ */
 static __attribute__((noinline))
 void *qht_lookup__slowpath(const struct qht_bucket *b, qht_lookup_func_t func,
-                           const void *userp, uint32_t hash)
+                           const void *userp, uint32_t hash,
+                           unsigned int *versionp)
 {
     unsigned int version;
     void *ret;
@@ -590,30 +598,103 @@ void *qht_lookup__slowpath(const struct qht_bucket *b, qht_lookup_func_t func,
         version = seqlock_read_begin(&b->sequence);
         ret = qht_do_lookup(b, func, userp, hash);
     } while (seqlock_read_retry(&b->sequence, version));
+    if (versionp) {
+        *versionp = version;
+    }
     return ret;
 }
 
+/*
+ * Lookup retry for misses while an incremental resize is in flight.
+ *
+ * The entry might have been migrated out of @prev after we missed it in
+ * @map.  Migration publishes entries in the new map before clearing them
+ * from the old one, so if the entry is gone from @prev it must already
+ * be visible in @map -- provided @map is still the current map.  A double
+ * miss is therefore only conclusive once the caller has re-checked that
+ * ht->map and ht->prev did not change underneath us.
+ */
+static __attribute__((noinline))
+void *qht_lookup__prev(const struct qht_map *map, const struct qht_map *prev,
+                       const void *userp, uint32_t hash, qht_lookup_func_t func)
+{
+    void *ret;
+
+    ret = qht_lookup__slowpath(qht_map_to_bucket(prev, hash), func, userp,
+                               hash, NULL);
+    if (ret) {
+        return ret;
+    }
+    return qht_lookup__slowpath(qht_map_to_bucket(map, hash), func, userp,
+                                hash, NULL);
+}
+
 void *qht_lookup_custom(const struct qht *ht, const void *userp, uint32_t hash,
                         qht_lookup_func_t func)
 {
     const struct qht_bucket *b;
     const struct qht_map *map;
+    const struct qht_map *prev;
     unsigned int version;
     void *ret;
 
-    map = qatomic_rcu_read(&ht->map);
-    b = qht_map_to_bucket(map, hash);
+    for (;;) {
+        map = qatomic_rcu_read(&ht->map);
+        b = qht_map_to_bucket(map, hash);
 
-    version = seqlock_read_begin(&b->sequence);
-    ret = qht_do_lookup(b, func, userp, hash);
-    if (likely(!seqlock_read_retry(&b->sequence, version))) {
-        return ret;
+        version = seqlock_read_begin(&b->sequence);
+        ret = qht_do_lookup(b, func, userp, hash);
+        if (unlikely(seqlock_read_retry(&b->sequence, version))) {
+            /*
+             * Removing the do/while from the fastpath gives a 4% perf.
+             * increase when running a 100%-lookup microbenchmark.
+             */
+            ret = qht_lookup__slowpath(b, func, userp, hash, &version);
+        }
+        if (likely(ret != NULL)) {
+            return ret;
+        }
+        /* during an incremental resize the entry may not have migrated yet */
+        prev = qatomic_rcu_read(&ht->prev);
+        if (unlikely(prev != NULL)) {
+            /*
+             * prev == map means a resize was published after we read
+             * ht->map: @map is the old map and the current one has not
+             * been searched at all.  Start over.
+             */
+            if (unlikely(prev == map)) {
+                continue;
+            }
+            ret = qht_lookup__prev(map, prev, userp, hash, func);
+            if (ret) {
+                return ret;
+            }
+            /*
+             * Entries only ever migrate from ht->prev to ht->map, so as
+             * long as neither changed we have seen every map the entry
+             * could be in; mirrors the retry loop in qht_remove().
+             */
+            if (likely(qatomic_rcu_read(&ht->map) == map &&
+                       qatomic_rcu_read(&ht->prev) == prev)) {
+                return NULL;
+            }
+            continue;
+        }
+        /*
+         * No resize is in flight now, but one may have run between our
+         * miss and the ht->prev read.  If it replaced @map, the entry
+         * may live in the current map and @b's seqlock tells us nothing
+         * about that; @map cannot be reused while our RCU read section
+         * pins it, so comparing against ht->map detects this.  If the
+         * resize instead drained into @map, it may have migrated the
+         * entry into this very bucket, which bumps @b's seqlock.  An
+         * unchanged map and version prove the miss genuine.
+         */
+        if (likely(qatomic_rcu_read(&ht->map) == map &&
+                   !seqlock_read_retry(&b->sequence, version))) {
+            return NULL;
+        }
     }
-    /*
-     * Removing the do/while from the fastpath gives a 4% perf. increase when
-     * running a 100%-lookup microbenchmark.
-     */
-    return qht_lookup__slowpath(b, func, userp, hash);
 }
 
 void *qht_lookup(const struct qht *ht, const void *userp, uint32_t hash)
@@ -671,6 +752,90 @@ static void *qht_insert__locked(const struct qht *ht, struct qht_map *map,
     return NULL;
 }
 
+/*
+ * Migrate all entries chained off @head into @map.
+ *
+ * Entries are published in @map before they are cleared from @head, so that
+ * lookups that miss in one map are guaranteed to find migrating entries in
+ * the other.  Note that @head's seqlock is never write-held while a new
+ * bucket's lock is acquired: writers to @map read old buckets under their
+ * seqlock while holding a new bucket lock, and would deadlock against us
+ * otherwise.
+ */
+static void qht_migrate_bucket(struct qht *ht, struct qht_map *old,
+                               struct qht_bucket *head, struct qht_map *map)
+{
+    struct qht_bucket *b;
+    int i;
+
+    qht_bucket_lock(old, head);
+    for (b = head; b; b = b->next) {
+        for (i = 0; i < QHT_BUCKET_ENTRIES; i++) {
+            struct qht_bucket *dest;
+            void *p = b->pointers[i];
+
+            if (p == NULL) {
+                goto copied;
+            }
+            dest = qht_map_to_bucket(map, b->hashes[i]);
+            qht_bucket_lock(map, dest);
+            qht_insert__locked(ht, map, dest, p, b->hashes[i], NULL);
+            qht_bucket_unlock(map, dest);
+        }
+    }
+ copied:
+    qht_bucket_reset__locked(head);
+    qht_bucket_unlock(old, head);
+}
+
+/*
+ * Migrate a bounded number of buckets from ht->prev into ht->map, freeing
+ * the old map once it has been fully drained.  Called on the insert path so
+ * that the cost of an automatic resize is spread over many inserts instead
+ * of stalling a single one.
+ */
+static void qht_migrate_step(struct qht *ht)
+{
+    struct qht_map *old;
+
+    /* if the lock is taken, someone else is making progress; bail out */
+    if (qht_trylock(ht)) {
+        return;
+    }
+    old = ht->prev;
+    if (old) {
+        struct qht_map *map = ht->map;
+        size_t end = MIN(ht->migrate_next + QHT_MIGRATE_BATCH, old->n_buckets);
+        size_t i;
+
+        for (i = ht->migrate_next; i < end; i++) {
+            qht_migrate_bucket(ht, old, &old->buckets[i], map);
+        }
+        ht->migrate_next = end;
+        if (end == old->n_buckets) {
+            qatomic_rcu_set(&ht->prev, NULL);
+            call_rcu(old, qht_map_destroy, rcu);
+        }
+    }
+    qht_unlock(ht);
+}
+
+/* call with ht->lock held */
+static void qht_migrate_finish__locked(struct qht *ht)
+{
+    struct qht_map *old = ht->prev;
+    size_t i;
+
+    if (old == NULL) {
+        return;
+    }
+    for (i = ht->migrate_next; i < old->n_buckets; i++) {
+        qht_migrate_bucket(ht, old, &old->buckets[i], ht->map);
+    }
+    qatomic_rcu_set(&ht->prev, NULL);
+    call_rcu(old, qht_map_destroy, rcu);
+}
+
 static __attribute__((noinline)) void qht_grow_maybe(struct qht *ht)
 {
     struct qht_map *map;
@@ -683,30 +848,64 @@ static __attribute__((noinline)) void qht_grow_maybe(struct qht *ht)
         return;
     }
     map = ht->map;
-    /* another thread might have just performed the resize we were after */
-    if (qht_map_needs_resize(map)) {
+    /*
+     * Another thread might have just performed the resize we were after;
+     * if an earlier incremental resize is still draining, let it finish
+     * before starting a new one.
+     */
+    if (ht->prev == NULL && qht_map_needs_resize(map)) {
         struct qht_map *new = qht_map_create(map->n_buckets * 2);
 
-        qht_do_resize(ht, new);
+        /*
+         * Publish the new map with all of the old map's bucket locks held.
+         * No entries are copied here: once every writer that could still
+         * see the old map has drained, inserts go to the new map and
+         * lookups fall back to the old one, which is then drained
+         * incrementally by qht_migrate_step().
+         *
+         * ht->prev is set before ht->map so that a reader that sees the
+         * new map is guaranteed to also see the old one.
+         */
+        qht_map_lock_buckets(map);
+        qatomic_rcu_set(&ht->prev, map);
+        ht->migrate_next = 0;
+        qatomic_rcu_set(&ht->map, new);
+        qht_map_unlock_buckets(map);
     }
     qht_unlock(ht);
 }
 
 bool qht_insert(struct qht *ht, void *p, uint32_t hash, void **existing)
 {
+    struct qht_map *prev_map;
     struct qht_bucket *b;
     struct qht_map *map;
     bool needs_resize = false;
-    void *prev;
+    void *prev = NULL;
 
     /* NULL pointers are not supported */
     qht_debug_assert(p);
 
     b = qht_bucket_lock__no_stale(ht, hash, &map);
-    prev = qht_insert__locked(ht, map, b, p, hash, &needs_resize);
+    prev_map = qatomic_rcu_read(&ht->prev);
+    if (unlikely(prev_map != NULL)) {
+        /*
+         * An equivalent entry may not have been migrated out of the old map
+         * yet.  Migration into @b cannot complete while we hold its lock,
+         * so looking at the old bucket here cannot miss such an entry.
+         */
+        prev = qht_lookup__slowpath(qht_map_to_bucket(prev_map, hash),
+                                    ht->cmp, p, hash, NULL);
+    }
+    if (likely(prev == NULL)) {
+        prev = qht_insert__locked(ht, map, b, p, hash, &needs_resize);
+    }
     qht_bucket_debug__locked(b);
     qht_bucket_unlock(map, b);
 
+    if (unlikely(qatomic_read(&ht->prev) != NULL)) {
+        qht_migrate_step(ht);
+    }
     if (unlikely(needs_resize) && ht->mode & QHT_MODE_AUTO_RESIZE) {
         qht_grow_maybe(ht);
     }
@@ -806,18 +1005,43 @@ bool qht_remove__locked(struct qht_bucket *head, const void *p, uint32_t hash)
 
 bool qht_remove(struct qht *ht, const void *p, uint32_t hash)
 {
-    struct qht_bucket *b;
-    struct qht_map *map;
-    bool ret;
-
     /* NULL pointers are not supported */
     qht_debug_assert(p);
 
-    b = qht_bucket_lock__no_stale(ht, hash, &map);
-    ret = qht_remove__locked(b, p, hash);
-    qht_bucket_debug__locked(b);
-    qht_bucket_unlock(map, b);
-    return ret;
+    for (;;) {
+        struct qht_map *prev_map = qatomic_rcu_read(&ht->prev);
+        struct qht_bucket *b;
+        struct qht_map *map;
+        bool ret;
+
+        if (unlikely(prev_map != NULL)) {
+            /* the entry may not have been migrated out of the old map yet */
+            b = qht_map_to_bucket(prev_map, hash);
+            qht_bucket_lock(prev_map, b);
+            ret = qht_remove__locked(b, p, hash);
+            qht_bucket_unlock(prev_map, b);
+            if (ret) {
+                return true;
+            }
+        }
+        b = qht_bucket_lock__no_stale(ht, hash, &map);
+        ret = qht_remove__locked(b, p, hash);
+        qht_bucket_debug__locked(b);
+        qht_bucket_unlock(map, b);
+        if (ret) {
+            return true;
+        }
+        /*
+         * An incremental resize may have been published in between the two
+         * lookups above, in which case the entry could sit in a map we did
+         * not look at.  Entries only ever migrate from ht->prev to ht->map,
+         * so if ht->prev has not changed we have seen every map the entry
+         * could be in.
+         */
+        if (likely(qatomic_rcu_read(&ht->prev) == prev_map)) {
+            return false;
+        }
+    }
 }
 
 static inline void qht_bucket_iter(struct qht_bucket *head,
@@ -872,10 +1096,24 @@ do_qht_iter(struct qht *ht, const struct qht_iter *iter, void *userp)
 {
     struct qht_map *map;
 
-    map = qatomic_rcu_read(&ht->map);
+    /*
+     * Hold ht->lock so that an incremental resize cannot migrate entries
+     * between the two maps while we iterate over them; a migrating entry
+     * could otherwise be visited twice or not at all.
+     */
+    qht_lock(ht);
+    if (unlikely(ht->prev != NULL)) {
+        struct qht_map *prev = ht->prev;
+
+        qht_map_lock_buckets(prev);
+        qht_map_iter__all_locked(prev, iter, userp);
+        qht_map_unlock_buckets(prev);
+    }
+    map = ht->map;
     qht_map_lock_buckets(map);
     qht_map_iter__all_locked(map, iter, userp);
     qht_map_unlock_buckets(map);
+    qht_unlock(ht);
 }
 
 void qht_iter(struct qht *ht, qht_iter_func_t func, void *userp)
@@ -927,6 +1165,9 @@ static void qht_do_resize_reset(struct qht *ht, struct qht_map *new, bool reset)
     };
     struct qht_map_copy_data data;
 
+    /* finish any in-flight incremental resize before replacing the map */
+    qht_migrate_finish__locked(ht);
+
     old = ht->map;
     qht_map_lock_buckets(old);
 
@@ -968,25 +1209,11 @@ bool qht_resize(struct qht *ht, size_t n_elems)
     return ret;
 }
 
-/* pass @stats to qht_statistics_destroy() when done */
-void qht_statistics_init(const struct qht *ht, struct qht_stats *stats)
+static void qht_map_statistics(const struct qht_map *map,
+                               struct qht_stats *stats)
 {
-    const struct qht_map *map;
     int i;
 
-    map = qatomic_rcu_read(&ht->map);
-
-    stats->used_head_buckets = 0;
-    stats->entries = 0;
-    qdist_init(&stats->chain);
-    qdist_init(&stats->occupancy);
-    /* bail out if the qht has not yet been initialized */
-    if (unlikely(map == NULL)) {
-        stats->head_buckets = 0;
-        return;
-    }
-    stats->head_buckets = map->n_buckets;
-
     for (i = 0; i < map->n_buckets; i++) {
         const struct qht_bucket *head = &map->buckets[i];
         const struct qht_bucket *b;
@@ -1024,6 +1251,36 @@ void qht_statistics_init(const struct qht *ht, struct qht_stats *stats)
     }
 }
 
+/* pass @stats to qht_statistics_destroy() when done */
+void qht_statistics_init(const struct qht *ht, struct qht_stats *stats)
+{
+    const struct qht_map *map;
+    const struct qht_map *prev;
+
+    map = qatomic_rcu_read(&ht->map);
+
+    stats->used_head_buckets = 0;
+    stats->entries = 0;
+    qdist_init(&stats->chain);
+    qdist_init(&stats->occupancy);
+    /* bail out if the qht has not yet been initialized */
+    if (unlikely(map == NULL)) {
+        stats->head_buckets = 0;
+        return;
+    }
+    stats->head_buckets = map->n_buckets;
+
+    /*
+     * Entries that have not yet been migrated out of an in-flight
+     * incremental resize are accounted for in the old map's buckets.
+     */
+    prev = qatomic_rcu_read(&ht->prev);
+    if (unlikely(prev != NULL)) {
+        qht_map_statistics(prev, stats);
+    }
+    qht_map_statistics(map, stats);
+}
+
 void qht_statistics_destroy(struct qht_stats *stats)
 {
     qdist_destroy(&stats->occupancy);
@@ -50,6 +50,17 @@ static int in_drain_call_rcu;
 static QemuMutex rcu_registry_lock;
 static QemuMutex rcu_sync_lock;
 
+/*
+ * Force readers out of their read-side critical sections when this many
+ * callbacks are awaiting a grace period; see wait_for_readers().  Without
+ * this, a burst of callbacks (e.g. FlatView churn during device hotplug)
+ * can pile up behind a single long-running reader.
+ */
+#define RCU_CALL_FORCE_SIZE      1024
+
+static int rcu_call_count;
+static unsigned long rcu_forced_notifies;
+
 /*
  * Check whether a quiescent state was crossed between the beginning of
  * update_counter_and_wait and now.
@@ -106,8 +117,10 @@ static void wait_for_readers(void)
                  * get some extra futex wakeups.
                  */
                 qatomic_set(&index->waiting, false);
-            } else if (qatomic_read(&in_drain_call_rcu)) {
+            } else if (qatomic_read(&in_drain_call_rcu) ||
+                       qatomic_read(&rcu_call_count) >= RCU_CALL_FORCE_SIZE) {
                 notifier_list_notify(&index->force_rcu, NULL);
+                qatomic_set(&rcu_forced_notifies, rcu_forced_notifies + 1);
             }
         }
 
@@ -181,7 +194,6 @@ void synchronize_rcu(void)
  */
 static struct rcu_head dummy;
 static struct rcu_head *head = &dummy, **tail = &dummy.next;
-static int rcu_call_count;
 static QemuEvent rcu_call_ready_event;
 
 static void enqueue(struct rcu_head *node)
@@ -313,6 +325,16 @@ void call_rcu1(struct rcu_head *node, void (*func)(struct rcu_head *node))
     qemu_event_set(&rcu_call_ready_event);
 }
 
+void rcu_call_stats(uint64_t *pending, uint64_t *forced_notifies)
+{
+    /*
+     * rcu_call_count does not include the batch that the call_rcu thread
+     * has already claimed and is waiting a grace period for.
+     */
+    *pending = MAX(qatomic_read(&rcu_call_count), 0);
+    *forced_notifies = qatomic_read(&rcu_forced_notifies);
+}
+
 
 struct rcu_drain {
     struct rcu_head rcu;
@@ -72,8 +72,74 @@ struct ThreadPool {
     int pending_threads; /* threads created but not running yet */
     int min_threads;
     int max_threads;
+
+    /* Protected by thread_pool_registry_lock.  */
+    QLIST_ENTRY(ThreadPool) registry;
 };
 
+/*
+ * All pools register here so that idle workers can steal requests from a
+ * saturated pool in another AioContext instead of letting them queue behind
+ * its thread limit.  The registry lock is acquired before any pool lock and
+ * must never be taken while a pool lock is held.
+ */
+static QemuMutex thread_pool_registry_lock;
+static QLIST_HEAD(, ThreadPool) thread_pool_registry =
+    QLIST_HEAD_INITIALIZER(thread_pool_registry);
+
+static void __attribute__((constructor)) thread_pool_registry_init(void)
+{
+    qemu_mutex_init(&thread_pool_registry_lock);
+}
+
+/*
+ * Take a queued request from a pool whose workers are all busy and which
+ * cannot spawn more of them.  Called without any pool lock held.
+ */
+static ThreadPoolElement *thread_pool_steal_request(ThreadPool *pool)
+{
+    ThreadPool *victim;
+
+    QEMU_LOCK_GUARD(&thread_pool_registry_lock);
+    QLIST_FOREACH(victim, &thread_pool_registry, registry) {
+        if (victim == pool) {
+            continue;
+        }
+        WITH_QEMU_LOCK_GUARD(&victim->lock) {
+            if (victim->idle_threads == 0 &&
+                victim->cur_threads >= victim->max_threads &&
+                !QTAILQ_EMPTY(&victim->request_list)) {
+                ThreadPoolElement *req = QTAILQ_FIRST(&victim->request_list);
+
+                QTAILQ_REMOVE(&victim->request_list, req, reqs);
+                req->state = THREAD_ACTIVE;
+                trace_thread_pool_steal(pool, victim, req);
+                return req;
+            }
+        }
+    }
+    return NULL;
+}
+
+/* Wake an idle worker in some other pool so it can come and steal.  */
+static void thread_pool_kick_idle(ThreadPool *pool)
+{
+    ThreadPool *victim;
+
+    QEMU_LOCK_GUARD(&thread_pool_registry_lock);
+    QLIST_FOREACH(victim, &thread_pool_registry, registry) {
+        if (victim == pool) {
+            continue;
+        }
+        WITH_QEMU_LOCK_GUARD(&victim->lock) {
+            if (victim->idle_threads > 0) {
+                qemu_cond_signal(&victim->request_cond);
+                return;
+            }
+        }
+    }
+}
+
 static void *worker_thread(void *opaque)
 {
     ThreadPool *pool = opaque;
@@ -87,6 +153,30 @@ static void *worker_thread(void *opaque)
         int ret;
 
         if (QTAILQ_EMPTY(&pool->request_list)) {
+            ThreadPoolElement *stolen;
+
+            /*
+             * Before going idle, help out a saturated pool in another
+             * AioContext.  Completion still runs in the home context of
+             * the pool the request was submitted to.
+             */
+            qemu_mutex_unlock(&pool->lock);
+            stolen = thread_pool_steal_request(pool);
+            if (stolen) {
+                ret = stolen->func(stolen->arg);
+
+                stolen->ret = ret;
+                /* Write ret before state.  */
+                smp_wmb();
+                stolen->state = THREAD_DONE;
+
+                qemu_bh_schedule(stolen->pool->completion_bh);
+            }
+            qemu_mutex_lock(&pool->lock);
+            if (stolen) {
+                continue;
+            }
+
             pool->idle_threads++;
             ret = qemu_cond_timedwait(&pool->request_cond, &pool->lock, 10000);
             pool->idle_threads--;
@@ -244,6 +334,7 @@ BlockAIOCB *thread_pool_submit_aio(ThreadPoolFunc *func, void *arg,
     ThreadPoolElement *req;
     AioContext *ctx = qemu_get_current_aio_context();
     ThreadPool *pool = aio_get_thread_pool(ctx);
+    bool saturated;
 
     /* Assert that the thread submitting work is the same running the pool */
     assert(pool->ctx == qemu_get_current_aio_context());
@@ -262,9 +353,15 @@ BlockAIOCB *thread_pool_submit_aio(ThreadPoolFunc *func, void *arg,
     if (pool->idle_threads == 0 && pool->cur_threads < pool->max_threads) {
         spawn_thread(pool);
     }
+    saturated = pool->idle_threads == 0 &&
+                pool->cur_threads >= pool->max_threads;
     QTAILQ_INSERT_TAIL(&pool->request_list, req, reqs);
     qemu_mutex_unlock(&pool->lock);
     qemu_cond_signal(&pool->request_cond);
+    if (saturated) {
+        /* This pool cannot grow; let another pool's idle worker steal.  */
+        thread_pool_kick_idle(pool);
+    }
     return &req->common;
 }
 
@@ -340,6 +437,10 @@ static void thread_pool_init_one(ThreadPool *pool, AioContext *ctx)
     QTAILQ_INIT(&pool->request_list);
 
     thread_pool_update_params(pool, ctx);
+
+    qemu_mutex_lock(&thread_pool_registry_lock);
+    QLIST_INSERT_HEAD(&thread_pool_registry, pool, registry);
+    qemu_mutex_unlock(&thread_pool_registry_lock);
 }
 
 ThreadPool *thread_pool_new(AioContext *ctx)
@@ -357,6 +458,11 @@ void thread_pool_free(ThreadPool *pool)
 
     assert(QLIST_EMPTY(&pool->head));
 
+    /* Stop workers of other pools from choosing this one as a victim */
+    qemu_mutex_lock(&thread_pool_registry_lock);
+    QLIST_REMOVE(pool, registry);
+    qemu_mutex_unlock(&thread_pool_registry_lock);
+
     qemu_mutex_lock(&pool->lock);
 
     /* Stop new threads from spawning */